@@ -386,6 +386,12 @@ internal enum Event : ushort
             WClientOnRenderEnd = 11064,
             WClientCreateIRT = 11065,
             WClientPotentialIRTResource = 11066,
+            SwPixelShaderCacheLookup = 11067,
+            SwShaderEffectBand = 11068,
+            DirtyRegionStats = 11069,
+            PrecomputeStats = 11070,
+            SwRealizationCacheStats = 11071,
+            GlyphAlphaCacheStats = 11072,
             WClientUIContextDispatchBegin = 12001,
             WClientUIContextDispatchEnd = 12002,
             WClientUIContextPost = 12003,
@@ -993,6 +999,24 @@ internal static Guid GetGuidForEvent(Event arg)
                 case Event.WClientPotentialIRTResource:
                     // 4055bbd6-ba41-4bd0-bc0d-6b67965229be
                     return new Guid(0x4055BBD6, 0xBA41, 0x4BD0, 0xBC, 0xD, 0x6B, 0x67, 0x96, 0x52, 0x29, 0xBE);
+                case Event.SwPixelShaderCacheLookup:
+                    // 3e45cc1f-20a4-408a-92f7-9c49642aa320
+                    return new Guid(0x3E45CC1F, 0x20A4, 0x408A, 0x92, 0xF7, 0x9C, 0x49, 0x64, 0x2A, 0xA3, 0x20);
+                case Event.SwShaderEffectBand:
+                    // e0fdde0b-f82f-4406-a17e-bef7beddb17d
+                    return new Guid(0xE0FDDE0B, 0xF82F, 0x4406, 0xA1, 0x7E, 0xBE, 0xF7, 0xBE, 0xDD, 0xB1, 0x7D);
+                case Event.DirtyRegionStats:
+                    // 70e987f0-7745-43ac-b648-5caa69a48403
+                    return new Guid(0x70E987F0, 0x7745, 0x43AC, 0xB6, 0x48, 0x5C, 0xAA, 0x69, 0xA4, 0x84, 0x3);
+                case Event.PrecomputeStats:
+                    // cf8c0018-4b9d-4bc2-a3d5-21c4491c90ea
+                    return new Guid(0xCF8C0018, 0x4B9D, 0x4BC2, 0xA3, 0xD5, 0x21, 0xC4, 0x49, 0x1C, 0x90, 0xEA);
+                case Event.SwRealizationCacheStats:
+                    // de62f121-32ad-4e5e-861c-23c7c41ca08f
+                    return new Guid(0xDE62F121, 0x32AD, 0x4E5E, 0x86, 0x1C, 0x23, 0xC7, 0xC4, 0x1C, 0xA0, 0x8F);
+                case Event.GlyphAlphaCacheStats:
+                    // 766d4c26-a3d9-4d20-b2e2-1bba78f8b4f7
+                    return new Guid(0x766D4C26, 0xA3D9, 0x4D20, 0xB2, 0xE2, 0x1B, 0xBA, 0x78, 0xF8, 0xB4, 0xF7);
                 case Event.WClientUIContextDispatchBegin:
                 case Event.WClientUIContextDispatchEnd:
                     // 2481a374-999f-4ad2-9f22-6b7c8e2a5db0
@@ -1478,6 +1502,18 @@ internal static ushort GetTaskForEvent(Event arg)
                     return 145;
                 case Event.WClientPotentialIRTResource:
                     return 146;
+                case Event.SwPixelShaderCacheLookup:
+                    return 148;
+                case Event.SwShaderEffectBand:
+                    return 149;
+                case Event.DirtyRegionStats:
+                    return 150;
+                case Event.PrecomputeStats:
+                    return 151;
+                case Event.SwRealizationCacheStats:
+                    return 152;
+                case Event.GlyphAlphaCacheStats:
+                    return 153;
                 case Event.WClientUIContextDispatchBegin:
                 case Event.WClientUIContextDispatchEnd:
                     return 20;
@@ -1549,6 +1585,12 @@ internal static byte GetOpcodeForEvent(Event arg)
                 case Event.WClientScheduleRender:
                 case Event.WClientCreateIRT:
                 case Event.WClientPotentialIRTResource:
+                case Event.SwPixelShaderCacheLookup:
+                case Event.SwShaderEffectBand:
+                case Event.DirtyRegionStats:
+                case Event.PrecomputeStats:
+                case Event.SwRealizationCacheStats:
+                case Event.GlyphAlphaCacheStats:
                 case Event.WClientUIContextPost:
                 case Event.WClientUIContextAbort:
                 case Event.WClientUIContextPromote:
@@ -1985,6 +2027,12 @@ internal static byte GetVersionForEvent(Event arg)
                 case Event.WClientOnRenderEnd:
                 case Event.WClientCreateIRT:
                 case Event.WClientPotentialIRTResource:
+                case Event.SwPixelShaderCacheLookup:
+                case Event.SwShaderEffectBand:
+                case Event.DirtyRegionStats:
+                case Event.PrecomputeStats:
+                case Event.SwRealizationCacheStats:
+                case Event.GlyphAlphaCacheStats:
                     return 0;
                 case Event.WClientCreateVisual:
                 case Event.WClientAppCtor:
@@ -1108,6 +1108,18 @@ EXTERN_C __declspec(selectany) const GUID WClientCreateIRTId = {0xd56e7b1e, 0xe2
 EXTERN_C __declspec(selectany) const GUID WClientPotentialIRTResourceId = {0x4055bbd6, 0xba41, 0x4bd0, {0xbc, 0x0d, 0x6b, 0x67, 0x96, 0x52, 0x29, 0xbe}};
 #define TPenThreadPoolThreadAcquisition 0x93
 EXTERN_C __declspec(selectany) const GUID PenThreadPoolThreadAcquisitionId = {0x6c325c36, 0x4d5f, 0x4328, {0xb1, 0xc6, 0xe1, 0x64, 0x79, 0x6d, 0xfe, 0x2b}};
+#define TSwPixelShaderCache 0x94
+EXTERN_C __declspec(selectany) const GUID SwPixelShaderCacheId = {0x3e45cc1f, 0x20a4, 0x408a, {0x92, 0xf7, 0x9c, 0x49, 0x64, 0x2a, 0xa3, 0x20}};
+#define TSwShaderEffectBand 0x95
+EXTERN_C __declspec(selectany) const GUID SwShaderEffectBandId = {0xe0fdde0b, 0xf82f, 0x4406, {0xa1, 0x7e, 0xbe, 0xf7, 0xbe, 0xdd, 0xb1, 0x7d}};
+#define TDirtyRegionStats 0x96
+EXTERN_C __declspec(selectany) const GUID DirtyRegionStatsId = {0x70e987f0, 0x7745, 0x43ac, {0xb6, 0x48, 0x5c, 0xaa, 0x69, 0xa4, 0x84, 0x03}};
+#define TPrecomputeStats 0x97
+EXTERN_C __declspec(selectany) const GUID PrecomputeStatsId = {0xcf8c0018, 0x4b9d, 0x4bc2, {0xa3, 0xd5, 0x21, 0xc4, 0x49, 0x1c, 0x90, 0xea}};
+#define TSwRealizationCacheStats 0x98
+EXTERN_C __declspec(selectany) const GUID SwRealizationCacheStatsId = {0xde62f121, 0x32ad, 0x4e5e, {0x86, 0x1c, 0x23, 0xc7, 0xc4, 0x1c, 0xa0, 0x8f}};
+#define TGlyphAlphaCacheStats 0x99
+EXTERN_C __declspec(selectany) const GUID GlyphAlphaCacheStatsId = {0x766d4c26, 0xa3d9, 0x4d20, {0xb2, 0xe2, 0x1b, 0xba, 0x78, 0xf8, 0xb4, 0xf7}};
 //
 // Keyword
 //
@@ -1782,6 +1794,18 @@ EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR WClientCreateIRT = {0x2b39
 #define WClientCreateIRT_value 0x2b39
 EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR WClientPotentialIRTResource = {0x2b3a, 0x0, 0x10, 0x12, 0x0, 0x92, 0x8000000000001000};
 #define WClientPotentialIRTResource_value 0x2b3a
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR SwPixelShaderCacheLookup = {0x2b3b, 0x0, 0x10, 0x4, 0x0, 0x94, 0x8000000000001002};
+#define SwPixelShaderCacheLookup_value 0x2b3b
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR SwShaderEffectBand = {0x2b3c, 0x0, 0x10, 0x4, 0x0, 0x95, 0x8000000000001002};
+#define SwShaderEffectBand_value 0x2b3c
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR DirtyRegionStats = {0x2b3d, 0x0, 0x10, 0x4, 0x0, 0x96, 0x8000000000001002};
+#define DirtyRegionStats_value 0x2b3d
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR PrecomputeStats = {0x2b3e, 0x0, 0x10, 0x4, 0x0, 0x97, 0x8000000000001002};
+#define PrecomputeStats_value 0x2b3e
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR SwRealizationCacheStats = {0x2b3f, 0x0, 0x10, 0x4, 0x0, 0x98, 0x8000000000001002};
+#define SwRealizationCacheStats_value 0x2b3f
+EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR GlyphAlphaCacheStats = {0x2b40, 0x0, 0x10, 0x4, 0x0, 0x99, 0x8000000000001002};
+#define GlyphAlphaCacheStats_value 0x2b40
 EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR WClientUIContextDispatchBegin = {0x2ee1, 0x3, 0x10, 0x4, 0x1, 0x14, 0x8000000000002002};
 #define WClientUIContextDispatchBegin_value 0x2ee1
 EXTERN_C __declspec(selectany) const EVENT_DESCRIPTOR WClientUIContextDispatchEnd = {0x2ee2, 0x2, 0x10, 0x4, 0x2, 0x14, 0x8000000000002002};
@@ -6419,6 +6443,90 @@ EXTERN_C __declspec(selectany) REGHANDLE Microsoft_Windows_WPFHandle = (REGHANDL
         MofTemplate_p(Microsoft_Windows_WPFHandle, &WClientPotentialIRTResource, &WClientPotentialIRTResourceId, Pointer)\
         : ERROR_SUCCESS\
 
+//
+// Enablement check macro for SwPixelShaderCacheLookup
+//
+
+#define EventEnabledSwPixelShaderCacheLookup() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for SwPixelShaderCacheLookup
+//
+#define EventWriteSwPixelShaderCacheLookup(Hit, Hits, Misses, Entries)\
+        EventEnabledSwPixelShaderCacheLookup() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &SwPixelShaderCacheLookup, &SwPixelShaderCacheId, Hit, Hits, Misses, Entries)\
+        : ERROR_SUCCESS\
+
+//
+// Enablement check macro for SwShaderEffectBand
+//
+
+#define EventEnabledSwShaderEffectBand() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for SwShaderEffectBand
+//
+#define EventWriteSwShaderEffectBand(Band, FirstRow, Rows, Microseconds)\
+        EventEnabledSwShaderEffectBand() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &SwShaderEffectBand, &SwShaderEffectBandId, Band, FirstRow, Rows, Microseconds)\
+        : ERROR_SUCCESS\
+
+//
+// Enablement check macro for DirtyRegionStats
+//
+
+#define EventEnabledDirtyRegionStats() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for DirtyRegionStats
+//
+#define EventWriteDirtyRegionStats(RectCount, RectBudget, PixelsChanged, PixelsRedrawn)\
+        EventEnabledDirtyRegionStats() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &DirtyRegionStats, &DirtyRegionStatsId, RectCount, RectBudget, PixelsChanged, PixelsRedrawn)\
+        : ERROR_SUCCESS\
+
+//
+// Enablement check macro for PrecomputeStats
+//
+
+#define EventEnabledPrecomputeStats() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for PrecomputeStats
+//
+#define EventWritePrecomputeStats(NodesInTree, NodesVisited, NodesProcessed, BoundsUpdated)\
+        EventEnabledPrecomputeStats() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &PrecomputeStats, &PrecomputeStatsId, NodesInTree, NodesVisited, NodesProcessed, BoundsUpdated)\
+        : ERROR_SUCCESS\
+
+//
+// Enablement check macro for SwRealizationCacheStats
+//
+
+#define EventEnabledSwRealizationCacheStats() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for SwRealizationCacheStats
+//
+#define EventWriteSwRealizationCacheStats(ResidentKB, Hits, Misses, Evictions)\
+        EventEnabledSwRealizationCacheStats() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &SwRealizationCacheStats, &SwRealizationCacheStatsId, ResidentKB, Hits, Misses, Evictions)\
+        : ERROR_SUCCESS\
+
+//
+// Enablement check macro for GlyphAlphaCacheStats
+//
+
+#define EventEnabledGlyphAlphaCacheStats() ((Microsoft_Windows_WPFEnableBits[0] & 0x00200000) != 0)
+
+//
+// Event Macro for GlyphAlphaCacheStats
+//
+#define EventWriteGlyphAlphaCacheStats(ResidentKB, Hits, Misses, Evictions)\
+        EventEnabledGlyphAlphaCacheStats() ?\
+        MofTemplate_qqqq(Microsoft_Windows_WPFHandle, &GlyphAlphaCacheStats, &GlyphAlphaCacheStatsId, ResidentKB, Hits, Misses, Evictions)\
+        : ERROR_SUCCESS\
+
 //
 // Enablement check macro for WClientUIContextDispatchBegin
 //
@@ -160,7 +160,11 @@ ScanOpFunc GetOp_SrcOver_or_SrcOverAL(
 
         case MilPixelFormat::BGR32bpp:    // See Notes above
         case MilPixelFormat::PBGRA32bpp:
-            if (CCPUInfo::HasSSE2())    
+            if (CCPUInfo::HasAVX2())
+            {
+                return SrcOverAL_32bppPARGB_32bppPARGB_AVX2;
+            }
+            else if (CCPUInfo::HasSSE2())    
             {
                 return SrcOverAL_32bppPARGB_32bppPARGB_SSE2;
             }
@@ -186,7 +190,10 @@ ScanOpFunc GetOp_SrcOver_or_SrcOverAL(
             return SrcOver_32bppRGB_32bppRGB;
             
         case MilPixelFormat::PBGRA32bpp:
-            return SrcOver_32bppRGB_32bppPARGB;
+            // The AVX2 conversion to 32bppARGB does the same as this SrcOver.
+            return CCPUInfo::HasAVX2() ?
+                Convert_32RGB_32bppARGB_AVX2 :
+                SrcOver_32bppRGB_32bppPARGB;
 
         default:
             return NULL;
@@ -287,7 +294,9 @@ ScanOpFunc GetOp_ConvertFormat_InterchangeToNonHalftoned(
 
     case MilPixelFormat::BGR24bpp:
         Assert(GetNearestInterchangeFormat(fmt) == MilPixelFormat::BGRA32bpp);
-        pfnRet = Quantize_32bppARGB_24;
+        pfnRet = CCPUInfo::HasAVX2() ?
+            Quantize_32bppARGB_24_AVX2 :
+            Quantize_32bppARGB_24;
         break;
 
     case MilPixelFormat::BGR32bpp:
@@ -295,12 +304,17 @@ ScanOpFunc GetOp_ConvertFormat_InterchangeToNonHalftoned(
         // We could spec this to be a NOP. But this way could be considered more consistent.
         // (and it's up to higher-level code to NOP this out when it would make no difference.)
 
-        pfnRet = Quantize_32bppARGB_32RGB;
+        // The AVX2 conversion from 32bppRGB does the same as this quantize.
+        pfnRet = CCPUInfo::HasAVX2() ?
+            Convert_32RGB_32bppARGB_AVX2 :
+            Quantize_32bppARGB_32RGB;
         break;
 
     case MilPixelFormat::PBGRA32bpp:
         Assert(GetNearestInterchangeFormat(fmt) == MilPixelFormat::BGRA32bpp);
-        pfnRet = AlphaMultiply_32bppARGB;
+        pfnRet = CCPUInfo::HasAVX2() ?
+            AlphaMultiply_32bppARGB_AVX2 :
+            AlphaMultiply_32bppARGB;
         break;
 
     case MilPixelFormat::RGB24bpp:
@@ -461,17 +475,23 @@ ScanOpFunc GetOp_ConvertFormat_ToInterchange(
 
     case MilPixelFormat::BGR24bpp:
         Assert(GetNearestInterchangeFormat(fmt) == MilPixelFormat::BGRA32bpp);
-        pfnRet = Convert_24_32bppARGB;
+        pfnRet = CCPUInfo::HasAVX2() ?
+            Convert_24_32bppARGB_AVX2 :
+            Convert_24_32bppARGB;
         break;
 
     case MilPixelFormat::BGR32bpp:
         Assert(GetNearestInterchangeFormat(fmt) == MilPixelFormat::BGRA32bpp);
-        pfnRet = Convert_32RGB_32bppARGB;
+        pfnRet = CCPUInfo::HasAVX2() ?
+            Convert_32RGB_32bppARGB_AVX2 :
+            Convert_32RGB_32bppARGB;
         break;
 
     case MilPixelFormat::PBGRA32bpp:
         Assert(GetNearestInterchangeFormat(fmt) == MilPixelFormat::BGRA32bpp);
-        pfnRet = AlphaDivide_32bppPARGB;
+        pfnRet = CCPUInfo::HasAVX2() ?
+            AlphaDivide_32bppPARGB_AVX2 :
+            AlphaDivide_32bppPARGB;
         break;
 
     case MilPixelFormat::RGB24bpp:
@@ -234,8 +234,10 @@ VOID FASTCALL Convert_555_32bppARGB(const PipelineParams *, const ScanOpParams *
 VOID FASTCALL Convert_565_32bppARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_1555_32bppARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_24_32bppARGB(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL Convert_24_32bppARGB_AVX2(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_24BGR_32bppARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_32RGB_32bppARGB(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL Convert_32RGB_32bppARGB_AVX2(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_32bppGray_128bppABGR(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_48_64bppARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Convert_16bppGray_64bppARGB(const PipelineParams *, const ScanOpParams *);
@@ -256,6 +258,8 @@ VOID FASTCALL Quantize_32bppARGB_555(const PipelineParams *, const ScanOpParams
 VOID FASTCALL Quantize_32bppARGB_565(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Quantize_32bppARGB_1555(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Quantize_32bppARGB_24(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL Quantize_32bppARGB_24_AVX2(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL Quantize_32bppPARGB_24(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Quantize_32bppARGB_24BGR(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Quantize_32bppARGB_32RGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL Quantize_64bppARGB_48(const PipelineParams *, const ScanOpParams *);
@@ -322,6 +326,7 @@ VOID FASTCALL SrcOverAL_32bppPARGB_565_MMX(const PipelineParams *, const ScanOpP
 VOID FASTCALL SrcOverAL_32bppPARGB_32bppPARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL SrcOverAL_32bppPARGB_32bppPARGB_MMX(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL SrcOverAL_32bppPARGB_32bppPARGB_SSE2(const PipelineParams *pPP, const ScanOpParams *pSOP);
+VOID FASTCALL SrcOverAL_32bppPARGB_32bppPARGB_AVX2(const PipelineParams *pPP, const ScanOpParams *pSOP);
 
 // SrcOverAL_VA: "VA" stands for "vector alpha"
 VOID FASTCALL SrcOverAL_VA_32bppPARGB_32bppPARGB(const PipelineParams *, const ScanOpParams *);
@@ -329,12 +334,14 @@ VOID FASTCALL SrcOverAL_VA_32bppPARGB_32bppPARGB(const PipelineParams *, const S
 // AlphaMultiply: Multiply each component by the alpha value. (Binary operation)
 
 VOID FASTCALL AlphaMultiply_32bppARGB(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL AlphaMultiply_32bppARGB_AVX2(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL AlphaMultiply_64bppARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL AlphaMultiply_128bppABGR(const PipelineParams *, const ScanOpParams *);
 
 // AlphaDivide: Divide each component by the alpha value. (Binary operation)
 
 VOID FASTCALL AlphaDivide_32bppPARGB(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL AlphaDivide_32bppPARGB_AVX2(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL AlphaDivide_64bppPARGB(const PipelineParams *, const ScanOpParams *);
 VOID FASTCALL AlphaDivide_128bppPABGR(const PipelineParams *, const ScanOpParams *);
 
@@ -195,6 +195,15 @@ protected:
         AssertNoExpensiveResources();
     }
 
+    // Called by the builder after it has replaced the operations at uIndex
+    // and uIndex+1 with a single fused operation at uIndex. Derived classes
+    // which remember operation indices must adjust them.
+
+    virtual VOID OnOperationsFused(UINT uIndex)
+    {
+        UNREFERENCED_PARAMETER(uIndex);
+    }
+
     INT_PTR ConvertPipelinePointerToOffset(__in_ecount(1) const VOID **ppvPointer);
     __out_ecount(1) VOID **ConvertOffsetToPipelinePointer(INT_PTR ofsPointer);
 
@@ -14,6 +14,34 @@
 //------------------------------------------------------------------------------
 #include "precomp.hpp"
 
+bool ScanPipelineBuilder::sm_fFusionEnabled = true;
+volatile LONG ScanPipelineBuilder::sm_cFusedPipelines = 0;
+volatile LONG ScanPipelineBuilder::sm_cUnfusedPipelines = 0;
+
+//
+// Fusions which apply to any pipeline.
+//
+// Converting an opaque format to 32bppARGB sets alpha to 255, which makes a
+// following AlphaMultiply a copy; the fused operation is the conversion
+// alone. AlphaDivide followed by a 24bpp Quantize becomes a single pass.
+//
+
+static const ScanOpFusion sc_rgCommonFusions[] =
+{
+    { Convert_555_32bppARGB,        AlphaMultiply_32bppARGB,        Convert_555_32bppARGB,          ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_555_32bppARGB,        AlphaMultiply_32bppARGB_AVX2,   Convert_555_32bppARGB,          ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_565_32bppARGB,        AlphaMultiply_32bppARGB,        Convert_565_32bppARGB,          ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_565_32bppARGB,        AlphaMultiply_32bppARGB_AVX2,   Convert_565_32bppARGB,          ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_24_32bppARGB,         AlphaMultiply_32bppARGB,        Convert_24_32bppARGB,           ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_24_32bppARGB_AVX2,    AlphaMultiply_32bppARGB_AVX2,   Convert_24_32bppARGB_AVX2,      ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_24BGR_32bppARGB,      AlphaMultiply_32bppARGB,        Convert_24BGR_32bppARGB,        ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_24BGR_32bppARGB,      AlphaMultiply_32bppARGB_AVX2,   Convert_24BGR_32bppARGB,        ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_32RGB_32bppARGB,      AlphaMultiply_32bppARGB,        Convert_32RGB_32bppARGB,        ScanOpFusion::FK_BINARY_BINARY, true },
+    { Convert_32RGB_32bppARGB_AVX2, AlphaMultiply_32bppARGB_AVX2,   Convert_32RGB_32bppARGB_AVX2,   ScanOpFusion::FK_BINARY_BINARY, true },
+    { AlphaDivide_32bppPARGB,       Quantize_32bppARGB_24,          Quantize_32bppPARGB_24,         ScanOpFusion::FK_BINARY_BINARY, true },
+    { AlphaDivide_32bppPARGB_AVX2,  Quantize_32bppARGB_24_AVX2,     Quantize_32bppPARGB_24,         ScanOpFusion::FK_BINARY_BINARY, true },
+};
+
 
 //+-------------------------------------------------------------------------
 //
@@ -40,6 +68,8 @@ ScanPipelineBuilder::ScanPipelineBuilder(
     m_pSP = pSP;
     m_pIntermediateBuffers = pIntermediateBuffers;
     m_uiIntermediateBuffers = 0;
+    m_rgExtraFusions = NULL;
+    m_cExtraFusions = 0;
 
     for (int i=0; i<NUM_SCAN_PIPELINE_INTERMEDIATE_BUFFERS; i++)
     {
@@ -150,6 +180,8 @@ ScanPipelineBuilder::End()
 
     Assert(m_pSP->m_rgofsDestPointers.GetCount() > 0);
 
+    IFC( FuseOperations() );
+
 Cleanup:
     RRETURN(hr);
 }
@@ -847,3 +879,286 @@ Cleanup:
 
 
 
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    ScanPipelineBuilder::GetFusionCounts
+//
+//  Synopsis:  Returns the number of pipelines built so far in which End()
+//             fused at least one pair of operations, and the number in which
+//             it fused none.
+//
+//------------------------------------------------------------------------------
+
+VOID ScanPipelineBuilder::GetFusionCounts(
+    __out_ecount(1) UINT *pcFusedPipelines,
+    __out_ecount(1) UINT *pcUnfusedPipelines
+    )
+{
+    *pcFusedPipelines = static_cast<UINT>(sm_cFusedPipelines);
+    *pcUnfusedPipelines = static_cast<UINT>(sm_cUnfusedPipelines);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    ScanPipelineBuilder::FuseOperations
+//
+//  Synopsis:  Replaces pairs of adjacent operations with fused operations,
+//             using the common fusion table and then any fusions supplied by
+//             the derived builder.
+//
+//  Notes:     Called by End() once all buffer references are final. A fused
+//             operation can itself be the first or second half of another
+//             fusion, so after each fusion the previous pair is re-examined.
+//
+//------------------------------------------------------------------------------
+
+HRESULT ScanPipelineBuilder::FuseOperations()
+{
+    HRESULT hr = S_OK;
+    UINT cFusions = 0;
+
+    if (sm_fFusionEnabled)
+    {
+        UINT uIndex = 0;
+
+        while (uIndex + 1 < GetOpCount())
+        {
+            bool fFused;
+
+            IFC( TryFuseOperations(
+                uIndex,
+                sc_rgCommonFusions,
+                ARRAYSIZE(sc_rgCommonFusions),
+                &fFused
+                ) );
+
+            if (!fFused && m_cExtraFusions > 0)
+            {
+                IFC( TryFuseOperations(
+                    uIndex,
+                    m_rgExtraFusions,
+                    m_cExtraFusions,
+                    &fFused
+                    ) );
+            }
+
+            if (fFused)
+            {
+                cFusions++;
+
+                if (uIndex > 0)
+                {
+                    uIndex--;
+                }
+            }
+            else
+            {
+                uIndex++;
+            }
+        }
+    }
+
+    InterlockedIncrement(cFusions > 0 ? &sm_cFusedPipelines : &sm_cUnfusedPipelines);
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    ScanPipelineBuilder::TryFuseOperations
+//
+//  Synopsis:  If the operations at uIndex and uIndex+1 match one of the given
+//             fusions, replace them with the fused operation at uIndex.
+//
+//------------------------------------------------------------------------------
+
+HRESULT ScanPipelineBuilder::TryFuseOperations(
+    UINT uIndex,
+    __in_ecount(cFusions) const ScanOpFusion *rgFusions,
+    UINT cFusions,
+    __out_ecount(1) bool *pfFused
+    )
+{
+    HRESULT hr = S_OK;
+
+    *pfFused = false;
+
+    Assert(uIndex + 1 < GetOpCount());
+
+    PipelineItem *pFirst = &(m_pSP->m_rgPipeline[uIndex]);
+    PipelineItem *pSecond = &(m_pSP->m_rgPipeline[uIndex + 1]);
+
+    for (UINT i = 0; i < cFusions; i++)
+    {
+        const ScanOpFusion &fusion = rgFusions[i];
+
+        if (   (pFirst->m_pfnScanOp != fusion.m_pfnFirst)
+            || (pSecond->m_pfnScanOp != fusion.m_pfnSecond))
+        {
+            continue;
+        }
+
+        // The first operation must hand its result to the second through an
+        // intermediate buffer. (References to the original source and
+        // ultimate destination are NULL until UpdatePipelinePointers sets
+        // them.)
+
+        const VOID *pvIntermediate = pFirst->m_Params.m_pvDest;
+
+        if (   (pvIntermediate == NULL)
+            || (pSecond->m_Params.m_pvSrc1 != pvIntermediate)
+            || (pSecond->m_Params.m_pvSrc2 == pvIntermediate))
+        {
+            continue;
+        }
+
+        // The fused operation doesn't write the intermediate data, so no later
+        // operation may read it.
+
+        if (   (pSecond->m_Params.m_pvDest != pvIntermediate)
+            && IsBufferReferencedAfter(uIndex + 1, pvIntermediate))
+        {
+            continue;
+        }
+
+        INT_PTR ofsMovedPointer = -1;
+
+        if (fusion.m_eKind == ScanOpFusion::FK_BINARY_BINARY)
+        {
+            // The fused operation reads the first operation's source.
+
+            pSecond->m_Params.m_pvSrc1 = pFirst->m_Params.m_pvSrc1;
+            ofsMovedPointer = m_pSP->ConvertPipelinePointerToOffset(&(pFirst->m_Params.m_pvSrc1));
+        }
+        else
+        {
+            Assert(fusion.m_eKind == ScanOpFusion::FK_UNARY_PTERNARY);
+            Assert(pFirst->m_Params.m_pvSrc1 == NULL);
+        }
+
+        pSecond->m_pfnScanOp = fusion.m_pfnFused;
+        pSecond->m_Params.m_posd =
+            fusion.m_fUseFirstOSD ? pFirst->m_Params.m_posd : pSecond->m_Params.m_posd;
+
+        IFC( RemoveFusedOperation(uIndex, ofsMovedPointer) );
+
+        m_pSP->OnOperationsFused(uIndex);
+
+        *pfFused = true;
+        break;
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    ScanPipelineBuilder::IsBufferReferencedAfter
+//
+//  Synopsis:  Returns true if any operation after uIndex uses the given
+//             intermediate buffer.
+//
+//------------------------------------------------------------------------------
+
+bool ScanPipelineBuilder::IsBufferReferencedAfter(
+    UINT uIndex,
+    __in_ecount(1) const VOID *pvBuffer
+    ) const
+{
+    for (UINT i = uIndex + 1; i < GetOpCount(); i++)
+    {
+        const ScanOpParams &params = m_pSP->m_rgPipeline[i].m_Params;
+
+        if (   (params.m_pvDest == pvBuffer)
+            || (params.m_pvSrc1 == pvBuffer)
+            || (params.m_pvSrc2 == pvBuffer))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  AdjustOffsetsForRemovedItem
+//
+//  Synopsis:  Updates pipeline pointer offsets after the item at ofsItem has
+//             been removed from the pipeline array.
+//
+//------------------------------------------------------------------------------
+
+static VOID AdjustOffsetsForRemovedItem(
+    __inout_ecount(cOffsets) INT_PTR *rgofsPointers,
+    UINT cOffsets,
+    INT_PTR ofsItem,
+    INT_PTR ofsMovedPointer
+    )
+{
+    for (UINT i = 0; i < cOffsets; i++)
+    {
+        if (rgofsPointers[i] >= ofsItem + static_cast<INT_PTR>(sizeof(PipelineItem)))
+        {
+            rgofsPointers[i] -= sizeof(PipelineItem);
+        }
+        else if (rgofsPointers[i] >= ofsItem)
+        {
+            // A reference from the removed item was moved into the same field
+            // of the next item, which now takes its place. So the offset is
+            // unchanged.
+
+            Assert(rgofsPointers[i] == ofsMovedPointer);
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    ScanPipelineBuilder::RemoveFusedOperation
+//
+//  Synopsis:  Removes the operation at uIndex, which has been merged into the
+//             operation after it, and updates the pointer offsets recorded by
+//             AddBufferReference.
+//
+//------------------------------------------------------------------------------
+
+HRESULT ScanPipelineBuilder::RemoveFusedOperation(
+    UINT uIndex,
+    INT_PTR ofsMovedPointer
+        // Offset of the removed item's pointer that was moved to the next
+        // item, or -1.
+    )
+{
+    HRESULT hr = S_OK;
+
+    INT_PTR ofsItem = static_cast<INT_PTR>(uIndex * sizeof(PipelineItem));
+
+    IFC( m_pSP->m_rgPipeline.RemoveAt(uIndex) );
+
+    if (m_pSP->m_rgofsDestPointers.GetCount() > 0)
+    {
+        AdjustOffsetsForRemovedItem(
+            &(m_pSP->m_rgofsDestPointers.First()),
+            m_pSP->m_rgofsDestPointers.GetCount(),
+            ofsItem,
+            ofsMovedPointer
+            );
+    }
+
+    if (m_pSP->m_rgofsSrcPointers.GetCount() > 0)
+    {
+        AdjustOffsetsForRemovedItem(
+            &(m_pSP->m_rgofsSrcPointers.First()),
+            m_pSP->m_rgofsSrcPointers.GetCount(),
+            ofsItem,
+            ofsMovedPointer
+            );
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
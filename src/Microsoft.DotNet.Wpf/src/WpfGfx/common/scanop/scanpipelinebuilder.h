@@ -32,6 +32,39 @@ inline bool IsIntermediateBuffer(BufferLocation bloc)
     return (bloc >= BL_INTERMEDIATEBUFFER_FIRST) && (bloc <= BL_INTERMEDIATEBUFFER_LAST);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Structure:  ScanOpFusion
+//
+//  Synopsis:   Describes a pair of adjacent scan operations which End() can
+//              replace with a single fused operation, so that the
+//              intermediate buffer between them is neither written nor
+//              re-read. See ScanPipelineBuilder::FuseOperations.
+//
+//------------------------------------------------------------------------------
+
+struct ScanOpFusion
+{
+    enum Kind {
+        FK_UNARY_PTERNARY,  // A unary operation on the blend source,
+                            // followed by a blend which reads it as
+                            // m_pvSrc1. The fused operation takes the
+                            // blend's buffers.
+
+        FK_BINARY_BINARY    // Two binary operations, where the second reads
+                            // the intermediate buffer written by the first.
+                            // The fused operation reads the first's source and
+                            // writes the second's destination.
+    };
+
+    ScanOpFunc m_pfnFirst;
+    ScanOpFunc m_pfnSecond;
+    ScanOpFunc m_pfnFused;
+    Kind m_eKind;
+    bool m_fUseFirstOSD;    // The fused operation takes the op-specific data
+                            // of the first operation (otherwise the second).
+};
+
 // ScanPipelineBuilder: Holds the intermediate state and logic used to build the blending
 //          pipeline.
 
@@ -80,6 +113,19 @@ public:
 
     HRESULT End();
 
+    // Fusion of adjacent operations in End(). Enabled by default; disabling
+    // it is a debugging aid.
+
+    static VOID EnableFusion(bool fEnable)
+    {
+        sm_fFusionEnabled = fEnable;
+    }
+
+    static VOID GetFusionCounts(
+        __out_ecount(1) UINT *pcFusedPipelines,
+        __out_ecount(1) UINT *pcUnfusedPipelines
+        );
+
     //
     // AddOp_<type>_*
     //
@@ -183,6 +229,31 @@ protected:
         __deref_out_ecount(1) PipelineItem **ppPI
         );
 
+    VOID SetExtraFusions(
+        __in_ecount(cFusions) const ScanOpFusion *rgFusions,
+        UINT cFusions
+        )
+    {
+        m_rgExtraFusions = rgFusions;
+        m_cExtraFusions = cFusions;
+    }
+
+    HRESULT FuseOperations();
+    HRESULT TryFuseOperations(
+        UINT uIndex,
+        __in_ecount(cFusions) const ScanOpFusion *rgFusions,
+        UINT cFusions,
+        __out_ecount(1) bool *pfFused
+        );
+    bool IsBufferReferencedAfter(
+        UINT uIndex,
+        __in_ecount(1) const VOID *pvBuffer
+        ) const;
+    HRESULT RemoveFusedOperation(
+        UINT uIndex,
+        INT_PTR ofsMovedPointer
+        );
+
     CScanPipeline *m_pSP;
 
     CSPIntermediateBuffers *m_pIntermediateBuffers;  // The intermediate scan-line buffers
@@ -205,6 +276,14 @@ protected:
                                                 // intermediate buffer. (-1
                                                 // otherwise). Used in End().
 
+    // Fusions specific to a derived builder, tried after the common ones.
+
+    const ScanOpFusion *m_rgExtraFusions;
+    UINT m_cExtraFusions;
+
+    static bool sm_fFusionEnabled;
+    static volatile LONG sm_cFusedPipelines;
+    static volatile LONG sm_cUnfusedPipelines;
 };
 
 
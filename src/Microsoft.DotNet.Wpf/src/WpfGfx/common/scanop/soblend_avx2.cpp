@@ -0,0 +1,125 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//
+//      AVX2-optimized blending functions. See soblend.cpp for C equivalents
+//      (and more documentation). Results are bit-exact with the C versions.
+//
+
+#include "precomp.hpp"
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+#include "immintrin.h"
+#endif
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  SrcOverAL_32bppPARGB_32bppPARGB_AVX2
+//
+//  Synopsis:  SrcOverAL blend 32bppPARGB over 32bppPARGB, 8 pixels at a time.
+//
+//  Notes:     Uses the same divide-by-255 approximation as the C version:
+//
+//                 temp = (255 - alpha(source)) * color(pDestIn) + 0x80
+//             pDestOut = color(source) + ((temp >> 8) + temp) >> 8
+//
+//             with the final add saturated, which matches the superluminosity
+//             handling of the C version. As in the C version, pDestOut is not
+//             written for pixels where the source is zero.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+SrcOverAL_32bppPARGB_32bppPARGB_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS_BLEND(ARGB, ARGB)
+
+    UINT uiCount = pPP->m_uiCount;
+    Assert(uiCount>0);
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_cmpeq_epi32(zero, zero);
+    const __m256i roundbits = _mm256_set1_epi16(0x80);
+
+    // Spread the alpha byte of each pixel over the four 16-bit channels of
+    // that pixel, for the low and high pixel pairs of each 128-bit lane.
+    const __m256i alphaLow = _mm256_setr_epi8(
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1
+        );
+    const __m256i alphaHigh = _mm256_setr_epi8(
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1
+        );
+
+    while (uiCount >= 8)
+    {
+        __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc));
+
+        // Zero source pixels leave the destination untouched.
+        __m256i writeMask = _mm256_xor_si256(_mm256_cmpeq_epi32(src, zero), ones);
+
+        if (!_mm256_testz_si256(writeMask, writeMask))
+        {
+            __m256i destIn = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pDestIn));
+
+            // 255 - x for every byte; only the alpha bytes are used.
+            __m256i invAlpha = _mm256_xor_si256(src, ones);
+
+            __m256i low = _mm256_unpacklo_epi8(destIn, zero);
+            __m256i high = _mm256_unpackhi_epi8(destIn, zero);
+
+            low = _mm256_mullo_epi16(low, _mm256_shuffle_epi8(invAlpha, alphaLow));
+            high = _mm256_mullo_epi16(high, _mm256_shuffle_epi8(invAlpha, alphaHigh));
+
+            low = _mm256_add_epi16(low, roundbits);
+            high = _mm256_add_epi16(high, roundbits);
+
+            low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+            high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+            __m256i result = _mm256_adds_epu8(src, _mm256_packus_epi16(low, high));
+
+            _mm256_maskstore_epi32(reinterpret_cast<int *>(pDestOut), writeMask, result);
+        }
+
+        pSrc += 8;
+        pDestIn += 8;
+        pDestOut += 8;
+        uiCount -= 8;
+    }
+
+    if (uiCount)
+    {
+        //
+        // Blend the remaining few pixels
+        //
+
+        PipelineParams oPipelineParams = *pPP;
+        ScanOpParams oScanOpParams = *pSOP;
+
+        oScanOpParams.m_pvSrc2 = pDestIn;
+        oScanOpParams.m_pvDest = pDestOut;
+        oScanOpParams.m_pvSrc1 = pSrc;
+        oPipelineParams.m_uiCount = uiCount;
+
+        SrcOverAL_32bppPARGB_32bppPARGB(
+            &oPipelineParams, &oScanOpParams);
+    }
+#else
+    SrcOverAL_32bppPARGB_32bppPARGB(pPP, pSOP);
+#endif
+}
+
+
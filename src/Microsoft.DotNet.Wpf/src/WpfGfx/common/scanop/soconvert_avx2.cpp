@@ -0,0 +1,335 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//
+//      AVX2-optimized 32bpp format conversion and AlphaMultiply/AlphaDivide
+//      operations. See soconvert.cpp, soquantize.cpp and soalphamultiply.cpp
+//      for C equivalents (and more documentation). Results are bit-exact with
+//      the C versions.
+//
+//      Each operation processes 8 pixels per iteration and hands the last
+//      few pixels of the scan to its C version.
+//
+
+#include "precomp.hpp"
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+#include "immintrin.h"
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  FinishScan
+//
+//  Synopsis:  Runs the C version of an operation on the remaining pixels of a
+//             binary operation's scan.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+FinishScan(
+    ScanOpFunc pfnOp,
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP,
+    const VOID *pvSrc,
+    VOID *pvDest,
+    UINT uiCount
+    )
+{
+    if (uiCount)
+    {
+        PipelineParams oPipelineParams = *pPP;
+        ScanOpParams oScanOpParams = *pSOP;
+
+        oScanOpParams.m_pvSrc1 = pvSrc;
+        oScanOpParams.m_pvDest = pvDest;
+        oPipelineParams.m_uiCount = uiCount;
+
+        pfnOp(&oPipelineParams, &oScanOpParams);
+    }
+}
+#endif // !defined(_ARM_) && !defined(_ARM64_)
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  Convert_32RGB_32bppARGB_AVX2
+//
+//  Synopsis:  Set the alpha of every pixel to 255.
+//
+//  Notes:     Quantize_32bppARGB_32RGB and SrcOver_32bppRGB_32bppPARGB do the
+//             same thing with the same parameters, so this is used for those
+//             too.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+Convert_32RGB_32bppARGB_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS(ARGB, ARGB)
+    UINT uiCount = pPP->m_uiCount;
+
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<INT>(MIL_ALPHA_MASK));
+
+    while (uiCount >= 8)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDest), _mm256_or_si256(pixels, alphaMask));
+
+        pSrc += 8;
+        pDest += 8;
+        uiCount -= 8;
+    }
+
+    FinishScan(Convert_32RGB_32bppARGB, pPP, pSOP, pSrc, pDest, uiCount);
+#else
+    Convert_32RGB_32bppARGB(pPP, pSOP);
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  Convert_24_32bppARGB_AVX2
+//
+//  Synopsis:  Convert from 24bppRGB to 32bppARGB.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+Convert_24_32bppARGB_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS(BYTE, ARGB)
+    UINT uiCount = pPP->m_uiCount;
+
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<INT>(MIL_ALPHA_MASK));
+
+    // The low lane holds source bytes 0-15 and the high lane bytes 8-23, so
+    // that the 24 bytes of 8 pixels are read without reading past them.
+    const __m256i expand = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1
+        );
+
+    while (uiCount >= 8)
+    {
+        __m256i bytes = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(pSrc + 8)),
+            1
+            );
+
+        __m256i pixels = _mm256_or_si256(_mm256_shuffle_epi8(bytes, expand), alphaMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDest), pixels);
+
+        pSrc += 8 * 3;
+        pDest += 8;
+        uiCount -= 8;
+    }
+
+    FinishScan(Convert_24_32bppARGB, pPP, pSOP, pSrc, pDest, uiCount);
+#else
+    Convert_24_32bppARGB(pPP, pSOP);
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  Quantize_32bppARGB_24_AVX2
+//
+//  Synopsis:  Quantize from 32bppARGB to 24bppRGB.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+Quantize_32bppARGB_24_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS(ARGB, BYTE)
+    UINT uiCount = pPP->m_uiCount;
+
+    // Pack the 4 pixels of each lane into its low 12 bytes.
+    const __m256i pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+        );
+
+    while (uiCount >= 8)
+    {
+        __m256i pixels = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc)),
+            pack
+            );
+
+        __m128i low = _mm256_castsi256_si128(pixels);
+        __m128i high = _mm256_extracti128_si256(pixels, 1);
+
+        // The 4 junk bytes of the low lane are overwritten by the high lane,
+        // which is written in pieces so that nothing past the 24 bytes of the
+        // 8 pixels is touched.
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pDest), low);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(pDest + 12), high);
+        *reinterpret_cast<UNALIGNED UINT32 *>(pDest + 20) = static_cast<UINT32>(_mm_extract_epi32(high, 2));
+
+        pSrc += 8;
+        pDest += 8 * 3;
+        uiCount -= 8;
+    }
+
+    FinishScan(Quantize_32bppARGB_24, pPP, pSOP, pSrc, pDest, uiCount);
+#else
+    Quantize_32bppARGB_24(pPP, pSOP);
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  AlphaMultiply_32bppARGB_AVX2
+//
+//  Synopsis:  AlphaMultiply from 32bppARGB (to 32bppPARGB).
+//
+//  Notes:     Computes ((c*a + 0x80) + ((c*a + 0x80) >> 8)) >> 8 for every
+//             color channel, like MyPremultiply. That formula also produces
+//             the C version's results for alpha 0 and 255, so those need no
+//             special casing.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+AlphaMultiply_32bppARGB_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS(ARGB, ARGB)
+    UINT uiCount = pPP->m_uiCount;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i roundbits = _mm256_set1_epi16(0x80);
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<INT>(MIL_ALPHA_MASK));
+
+    // Spread the alpha byte of each pixel over the four 16-bit channels of
+    // that pixel, for the low and high pixel pairs of each 128-bit lane.
+    const __m256i alphaLow = _mm256_setr_epi8(
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1,
+        3, -1, 3, -1, 3, -1, 3, -1, 7, -1, 7, -1, 7, -1, 7, -1
+        );
+    const __m256i alphaHigh = _mm256_setr_epi8(
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1,
+        11, -1, 11, -1, 11, -1, 11, -1, 15, -1, 15, -1, 15, -1, 15, -1
+        );
+
+    while (uiCount >= 8)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc));
+
+        __m256i low = _mm256_unpacklo_epi8(pixels, zero);
+        __m256i high = _mm256_unpackhi_epi8(pixels, zero);
+
+        low = _mm256_mullo_epi16(low, _mm256_shuffle_epi8(pixels, alphaLow));
+        high = _mm256_mullo_epi16(high, _mm256_shuffle_epi8(pixels, alphaHigh));
+
+        low = _mm256_add_epi16(low, roundbits);
+        high = _mm256_add_epi16(high, roundbits);
+
+        low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+        // Keep the original alpha.
+        __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(low, high), pixels, alphaMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDest), result);
+
+        pSrc += 8;
+        pDest += 8;
+        uiCount -= 8;
+    }
+
+    FinishScan(AlphaMultiply_32bppARGB, pPP, pSOP, pSrc, pDest, uiCount);
+#else
+    AlphaMultiply_32bppARGB(pPP, pSOP);
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  AlphaDivide_32bppPARGB_AVX2
+//
+//  Synopsis:  AlphaDivide from 32bppPARGB (to 32bppARGB).
+//
+//  Notes:     Uses UnpremultiplyTable, like Unpremultiply. The table entries
+//             for alpha 0 and 255 produce the C version's results for those
+//             alphas, so they need no special casing.
+//
+//------------------------------------------------------------------------------
+
+VOID FASTCALL
+AlphaDivide_32bppPARGB_AVX2(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+#if !defined(_ARM_) && !defined(_ARM64_)
+    DEFINE_POINTERS(ARGB, ARGB)
+    UINT uiCount = pPP->m_uiCount;
+
+    const __m256i channelMask = _mm256_set1_epi32(0xff);
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<INT>(MIL_ALPHA_MASK));
+
+    while (uiCount >= 8)
+    {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pSrc));
+
+        __m256i factor = _mm256_i32gather_epi32(
+            reinterpret_cast<const int *>(UnpremultiplyTable),
+            _mm256_srli_epi32(pixels, MIL_ALPHA_SHIFT),
+            sizeof(ARGB)
+            );
+
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, MIL_BLUE_SHIFT), channelMask);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, MIL_GREEN_SHIFT), channelMask);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, MIL_RED_SHIFT), channelMask);
+
+        b = _mm256_min_epu32(_mm256_srli_epi32(_mm256_mullo_epi32(b, factor), 16), channelMask);
+        g = _mm256_min_epu32(_mm256_srli_epi32(_mm256_mullo_epi32(g, factor), 16), channelMask);
+        r = _mm256_min_epu32(_mm256_srli_epi32(_mm256_mullo_epi32(r, factor), 16), channelMask);
+
+        __m256i result = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_and_si256(pixels, alphaMask),
+                _mm256_slli_epi32(r, MIL_RED_SHIFT)
+                ),
+            _mm256_or_si256(
+                _mm256_slli_epi32(g, MIL_GREEN_SHIFT),
+                _mm256_slli_epi32(b, MIL_BLUE_SHIFT)
+                )
+            );
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pDest), result);
+
+        pSrc += 8;
+        pDest += 8;
+        uiCount -= 8;
+    }
+
+    FinishScan(AlphaDivide_32bppPARGB, pPP, pSOP, pSrc, pDest, uiCount);
+#else
+    AlphaDivide_32bppPARGB(pPP, pSOP);
+#endif
+}
+
+
@@ -140,6 +140,41 @@ Quantize_32bppARGB_24(
     }
 }
 
+// Quantize from 32bppPARGB to 24bppRGB. This is AlphaDivide_32bppPARGB
+// followed by Quantize_32bppARGB_24, in one pass (see sc_rgCommonFusions).
+
+VOID FASTCALL
+Quantize_32bppPARGB_24(
+    const PipelineParams *pPP,
+    const ScanOpParams *pSOP
+    )
+{
+    DEFINE_POINTERS(ARGB, BYTE)
+    UINT uiCount = pPP->m_uiCount;
+
+    while (uiCount--)
+    {
+        GpCC c;
+        c.argb = *pSrc++;
+        if (c.a != 255)
+        {
+            if (c.a != 0)
+            {
+                c.argb = Unpremultiply(c.argb);
+            }
+            else
+            {
+                c.argb = 0;
+            }
+        }
+
+        pDest[0] = (BYTE) (c.argb >> MIL_BLUE_SHIFT);
+        pDest[1] = (BYTE) (c.argb >> MIL_GREEN_SHIFT);
+        pDest[2] = (BYTE) (c.argb >> MIL_RED_SHIFT);
+        pDest += 3;
+    }
+}
+
 // Quantize from 32bppARGB to 24bppBGR
 
 VOID FASTCALL
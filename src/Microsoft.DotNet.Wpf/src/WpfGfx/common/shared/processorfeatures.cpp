@@ -13,6 +13,7 @@
 //
 
 #include "precomp.hpp"
+#include <intrin.h>
 
 // We are not concerned of architecture other than X86.
 
@@ -21,6 +22,7 @@ bool CCPUInfo::m_fHasSSE       = false;
 bool CCPUInfo::m_fHasSSE2      = false;
 bool CCPUInfo::m_fHasCMPXCHG8B = false;
 bool CCPUInfo::m_fHasSSE2ForEffects = false;
+bool CCPUInfo::m_fHasAVX2      = false;
 
 #if DBG
 bool CCPUInfo::m_fDbgIsInitialized = false;
@@ -37,6 +39,46 @@ bool CCPUInfo::m_fDbgIsInitialized = false;
 //
 //-----------------------------------------------------------------------------
 
+//+----------------------------------------------------------------------------
+//
+//  Function:
+//      DetectAVX2
+//
+//  Synopsis:
+//      Check for AVX2 instructions and OS support of YMM register state.
+//      IsProcessorFeaturePresent does not report AVX2 on all supported
+//      OS versions, so query cpuid directly.
+//
+//-----------------------------------------------------------------------------
+
+static bool DetectAVX2()
+{
+    int rgInfo[4];
+
+    __cpuid(rgInfo, 0);
+    if (rgInfo[0] < 7)
+    {
+        return false;
+    }
+
+    // Leaf 1, ECX: bit 27 is OSXSAVE, bit 28 is AVX.
+    __cpuid(rgInfo, 1);
+    const int c_OSXSAVEandAVX = (1 << 27) | (1 << 28);
+    if ((rgInfo[2] & c_OSXSAVEandAVX) != c_OSXSAVEandAVX)
+    {
+        return false;
+    }
+
+    // XCR0 bits 1 and 2: OS saves XMM and YMM state.
+    if ((_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    // Leaf 7, subleaf 0, EBX: bit 5 is AVX2.
+    __cpuidex(rgInfo, 7, 0);
+    return (rgInfo[1] & (1 << 5)) != 0;
+}
 
 void CCPUInfo::Initialize()
 {
@@ -57,6 +99,10 @@ void CCPUInfo::Initialize()
     m_fHasSSE2ForEffects = true;
 #endif
 
+#if defined(_X86_) || defined(_AMD64_)
+    m_fHasAVX2 = m_fHasSSE2ForEffects && DetectAVX2();
+#endif
+
 #if DBG
     m_fDbgIsInitialized = true;
 #endif
@@ -52,7 +52,27 @@ public:
         AssertIsInitialized();
         return m_fHasSSE2ForEffects;
     }
+
+    // Valid for both 32- and 64-bit builds.  Requires the OS to preserve
+    // the upper halves of YMM registers across context switches.
+    static bool HasAVX2()
+    {
+        AssertIsInitialized();
+        return m_fHasAVX2;
+    }
     
+    // Bit mask of the features above, for keying data that depends on them.
+    static UINT GetFeatureMask()
+    {
+        AssertIsInitialized();
+        return (m_fHasMMX            ? 0x01 : 0)
+             | (m_fHasSSE            ? 0x02 : 0)
+             | (m_fHasSSE2           ? 0x04 : 0)
+             | (m_fHasCMPXCHG8B      ? 0x08 : 0)
+             | (m_fHasSSE2ForEffects ? 0x10 : 0)
+             | (m_fHasAVX2           ? 0x20 : 0);
+    }
+
     static void AssertIsInitialized()
     {
 #if DBG
@@ -67,6 +87,7 @@ private:
     static bool m_fHasSSE2; // supports SSE2 instructions (Pentium 4+)
     static bool m_fHasCMPXCHG8B; // supports cmpxchg8b instruction
     static bool m_fHasSSE2ForEffects; // supports SSE2 (both X86 and AMD64)
+    static bool m_fHasAVX2; // supports AVX2 and the OS saves YMM state (both X86 and AMD64)
 
 #if DBG
     static bool m_fDbgIsInitialized;
@@ -0,0 +1,182 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//      Helpers for executing independent batches of work on the process
+//      thread pool.
+//
+//-----------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+volatile UINT CParallelWorkPool::s_uMaxConcurrency = 0;
+volatile UINT CParallelWorkPool::s_uProcessorCount = 0;
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CParallelWorkPool::SetMaxConcurrency
+//
+//  Synopsis:  Limit the number of threads that work on a single batch.  Zero
+//             restores the default of one thread per logical processor.
+//
+//-----------------------------------------------------------------------------
+
+void
+CParallelWorkPool::SetMaxConcurrency(
+    UINT uMaxConcurrency
+    )
+{
+    s_uMaxConcurrency = min(uMaxConcurrency, c_uMaxConcurrencyLimit);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CParallelWorkPool::GetMaxConcurrency
+//
+//  Synopsis:  Return the number of threads, including the calling thread,
+//             that may work on a single batch.
+//
+//-----------------------------------------------------------------------------
+
+UINT
+CParallelWorkPool::GetMaxConcurrency()
+{
+    UINT uMaxConcurrency = s_uMaxConcurrency;
+
+    if (uMaxConcurrency == 0)
+    {
+        // Racing threads compute the same value, so no lock is needed.
+        if (s_uProcessorCount == 0)
+        {
+            SYSTEM_INFO si;
+            GetSystemInfo(&si);
+
+            s_uProcessorCount = static_cast<UINT>(si.dwNumberOfProcessors);
+        }
+
+        uMaxConcurrency = min(s_uProcessorCount, c_uMaxConcurrencyLimit);
+    }
+
+    return max(uMaxConcurrency, 1u);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CParallelWorkPool::Execute
+//
+//  Synopsis:  Execute every item in the batch and wait for completion.
+//
+//  Returns:   The first failure reported by an item, or S_OK.  Once an item
+//             fails the remaining unstarted items are skipped.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CParallelWorkPool::Execute(
+    UINT cItems,
+    __inout_ecount(1) IParallelWorkItems *pItems
+    )
+{
+    HRESULT hr = S_OK;
+    PTP_WORK pWork = NULL;
+
+    WorkContext context;
+    context.pItems = pItems;
+    context.cItems = cItems;
+    context.nNextItem = 0;
+    context.hrFirstFailure = S_OK;
+
+    UINT cThreads = min(cItems, GetMaxConcurrency());
+
+    if (cThreads > 1)
+    {
+        pWork = CreateThreadpoolWork(&CParallelWorkPool::WorkCallback, &context, NULL);
+    }
+
+    if (pWork)
+    {
+        // The calling thread is one of the workers, so only submit the rest.
+        for (UINT i = 1; i < cThreads; i++)
+        {
+            SubmitThreadpoolWork(pWork);
+        }
+    }
+
+    ExecuteItems(&context);
+
+    if (pWork)
+    {
+        WaitForThreadpoolWorkCallbacks(pWork, FALSE);
+        CloseThreadpoolWork(pWork);
+    }
+
+    hr = static_cast<HRESULT>(context.hrFirstFailure);
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CParallelWorkPool::ExecuteItems
+//
+//  Synopsis:  Claim and execute items until the batch is exhausted.
+//
+//-----------------------------------------------------------------------------
+
+void
+CParallelWorkPool::ExecuteItems(
+    __inout_ecount(1) WorkContext *pContext
+    )
+{
+    for (;;)
+    {
+        LONG nItem = InterlockedIncrement(&pContext->nNextItem) - 1;
+
+        if (static_cast<UINT>(nItem) >= pContext->cItems
+            || FAILED(pContext->hrFirstFailure))
+        {
+            break;
+        }
+
+        HRESULT hr = pContext->pItems->Execute(static_cast<UINT>(nItem));
+
+        if (FAILED(hr))
+        {
+            InterlockedCompareExchange(&pContext->hrFirstFailure, hr, S_OK);
+        }
+    }
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CParallelWorkPool::WorkCallback
+//
+//  Synopsis:  Thread pool entry point.
+//
+//  Notes:     Items run milcore rasterization code, which expects single
+//             precision floating point like the render threads that submit
+//             them.  Thread pool threads do not start in that mode, so it is
+//             set for the duration of the callback.
+//
+//-----------------------------------------------------------------------------
+
+VOID CALLBACK
+CParallelWorkPool::WorkCallback(
+    __inout PTP_CALLBACK_INSTANCE pInstance,
+    __inout_opt PVOID pvContext,
+    __inout PTP_WORK pWork
+    )
+{
+    UNREFERENCED_PARAMETER(pInstance);
+    UNREFERENCED_PARAMETER(pWork);
+
+    CFloatFPU oGuard;
+
+    ExecuteItems(static_cast<WorkContext *>(pvContext));
+}
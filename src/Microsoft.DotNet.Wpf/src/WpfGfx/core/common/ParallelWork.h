@@ -0,0 +1,88 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//      Helpers for executing independent batches of work on the process
+//      thread pool.
+//
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+//+----------------------------------------------------------------------------
+//
+//  Class:     IParallelWorkItems
+//
+//  Synopsis:  A batch of independent work items.  Execute is called exactly
+//             once for every index in [0, cItems), from an arbitrary thread
+//             and in no particular order.  Implementations must not assume
+//             anything about which items run concurrently.
+//
+//-----------------------------------------------------------------------------
+
+class IParallelWorkItems
+{
+public:
+    virtual HRESULT Execute(UINT uItem) = 0;
+};
+
+//+----------------------------------------------------------------------------
+//
+//  Class:     CParallelWorkPool
+//
+//  Synopsis:  Executes a batch of IParallelWorkItems on the process thread
+//             pool.  The calling thread participates in the work and
+//             Execute does not return until every item has completed.
+//
+//  Notes:     If thread pool work cannot be created, or the effective
+//             concurrency is one, the items are executed serially on the
+//             calling thread.
+//
+//-----------------------------------------------------------------------------
+
+class CParallelWorkPool
+{
+public:
+
+    // Upper bound on the number of threads working on a single batch.
+    static const UINT c_uMaxConcurrencyLimit = 64;
+
+    static HRESULT Execute(
+        UINT cItems,
+        __inout_ecount(1) IParallelWorkItems *pItems
+        );
+
+    // A value of zero selects the number of logical processors.
+    static void SetMaxConcurrency(UINT uMaxConcurrency);
+
+    static UINT GetMaxConcurrency();
+
+private:
+
+    struct WorkContext
+    {
+        IParallelWorkItems *pItems;
+        UINT cItems;
+        volatile LONG nNextItem;
+        volatile LONG hrFirstFailure;
+    };
+
+    static void ExecuteItems(
+        __inout_ecount(1) WorkContext *pContext
+        );
+
+    static VOID CALLBACK WorkCallback(
+        __inout PTP_CALLBACK_INSTANCE pInstance,
+        __inout_opt PVOID pvContext,
+        __inout PTP_WORK pWork
+        );
+
+    static volatile UINT s_uMaxConcurrency;
+    static volatile UINT s_uProcessorCount;
+};
@@ -91,6 +91,8 @@
 
 #include "renderoptions.h"
 
+#include "ParallelWork.h"
+
 //
 // Logging support flags
 //
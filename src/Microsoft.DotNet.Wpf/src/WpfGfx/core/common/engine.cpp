@@ -28,6 +28,11 @@ DeclareTag(tagMILStepRenderingDisableBreak, "MIL", "MIL Step Rendering - Disable
 
 UINT CCommonRegistryData::m_uResCheckInSeconds = 15 * 60;
 bool CCommonRegistryData::m_fGPUThrottlingDisabled = false;
+UINT CCommonRegistryData::m_uDirtyRegionRectBudget = 0;
+
+// Upper limit for DirtyRegionRectBudget; every dirty rectangle costs a walk of
+// the visual tree, so larger budgets are never a win.
+static const UINT c_uMaxDirtyRegionRectBudget = 1024;
 
 //can be overriden by HKLM\Software\Microsoft\Avalon.Graphics\DisableInstrumentationBreaking(DWORD) = !0
 
@@ -228,6 +233,13 @@ CCommonRegistryData::InitializeFromRegistry()
         {
             m_fGPUThrottlingDisabled = true;
         }
+
+        dwTemp = 0;
+
+        if (RegReadDWORD(hRegAvalonGraphicsLocalMachine, _T("DirtyRegionRectBudget"), &dwTemp))
+        {
+            m_uDirtyRegionRectBudget = min(static_cast<UINT>(dwTemp), c_uMaxDirtyRegionRectBudget);
+        }
     }
 
     // NOTICE-2006/07/19-milesc  Given that most of the registry keys previously 
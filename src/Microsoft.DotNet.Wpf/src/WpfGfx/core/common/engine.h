@@ -95,6 +95,16 @@ public:
         return m_fGPUThrottlingDisabled;
     }
 
+    //
+    // Maximum number of rectangles in a banded dirty region.  Values up to
+    // CDirtyRegion2::MaxDirtyRegionCount (the default is zero) select the
+    // classic dirty region that merges by overhead.
+    //
+    static UINT GetDirtyRegionRectBudget()
+    {
+        return m_uDirtyRegionRectBudget;
+    }
+
 private:
 #if PRERELEASE
     static HRESULT InitializeDWMKeysFromRegistry();    
@@ -103,6 +113,7 @@ private:
 private:
     static UINT m_uResCheckInSeconds;
     static bool m_fGPUThrottlingDisabled;
+    static UINT m_uDirtyRegionRectBudget;
 };
 
 
@@ -16,6 +16,9 @@
 
 extern WarpPlatform::LockHandle g_LockJitterAccess;
 
+static IJitterCodeCache *g_pJitterCodeCache = NULL;
+static bool g_fJitterUseVEX = false;
+
 //+------------------------------------------------------------------------------
 //
 //  Member:
@@ -46,6 +49,8 @@ CJitterAccess::Enter(UINT16 usCallParametersSize)
 
     IFC(CProgram::Create(usCallParametersSize, &pProgram));
 
+    pProgram->SetMode(sc_uidUseVEX, g_fJitterUseVEX);
+
     WarpPlatform::BeginCompile(pProgram);
     pProgram = NULL;
 
@@ -116,7 +121,7 @@ CJitterAccess::Compile(__deref_out UINT8 **ppBinaryCode)
 {
     CProgram * pProgram = WarpPlatform::GetCurrentProgram();
     WarpAssert(pProgram);
-    return pProgram->Compile(ppBinaryCode);
+    return pProgram->Compile(ppBinaryCode, g_pJitterCodeCache);
 }
 
 //+------------------------------------------------------------------------------
@@ -151,6 +156,49 @@ CJitterAccess::CodeFree(__in void *pBinaryCode)
     CJitterSupport::CodeFree(pBinaryCode);
 }
 
+//+------------------------------------------------------------------------------
+//
+//  Member:
+//      CJitterAccess::SetCodeCache
+//
+//  Synopsis:
+//      Install persistent storage for compiled programs, or remove it when
+//      pCodeCache is NULL. When installed, CJitterAccess::Compile looks the
+//      program up in the storage before compiling and stores newly compiled
+//      programs there.
+//
+//-------------------------------------------------------------------------------
+void
+CJitterAccess::SetCodeCache(__in_opt IJitterCodeCache *pCodeCache)
+{
+    WarpPlatform::AcquireLock(g_LockJitterAccess);
+    g_pJitterCodeCache = pCodeCache;
+    WarpPlatform::ReleaseLock(g_LockJitterAccess);
+}
+
+//+------------------------------------------------------------------------------
+//
+//  Member:
+//      CJitterAccess::SetUseVEX
+//
+//  Synopsis:
+//      Set the initial value of sc_uidUseVEX mode for programs started by
+//      following CJitterAccess::Enter calls. The client should only enable
+//      it when the processor and OS support AVX.
+//
+//      The mode only changes the encoding of 128-bit operations, to the
+//      non-destructive three-operand VEX forms; variables and generated code
+//      stay XMM-wide.
+//
+//-------------------------------------------------------------------------------
+void
+CJitterAccess::SetUseVEX(bool fUseVEX)
+{
+    WarpPlatform::AcquireLock(g_LockJitterAccess);
+    g_fJitterUseVEX = fUseVEX;
+    WarpPlatform::ReleaseLock(g_LockJitterAccess);
+}
+
 
 //+------------------------------------------------------------------------------
 //
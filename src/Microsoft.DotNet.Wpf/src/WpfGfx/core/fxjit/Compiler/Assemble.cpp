@@ -16,9 +16,10 @@
 
 static const UINT32 uPageSize = 4096;
 
-CAssembleContext::CAssembleContext(CMapper const & mapper, bool fUseNegativeStackOffsets)
+CAssembleContext::CAssembleContext(CMapper const & mapper, bool fUseNegativeStackOffsets, bool fUseVEX)
 : m_mapper(mapper)
 {
+    m_fUseVEX = fUseVEX;
     m_uOperatorFlags = 0;
     m_uEspOffset = fUseNegativeStackOffsets ? 128 : 0;
 }
@@ -209,19 +210,34 @@ CAssembleContext::GetOffset(UINT32 uVarID) const
 CAssemblePass2::CAssemblePass2(
         CMapper const & mapper,
         bool fUseNegativeStackOffsets,
+        bool fUseVEX,
         UINT8 * pData,
         INT_PTR uStatic4Offset,
         INT_PTR uStatic8Offset,
-        INT_PTR uStatic16Offset
+        INT_PTR uStatic16Offset,
+        __in_opt CCodeAddressLog * pAddressLog
         )
-        : CAssembleContext(mapper, fUseNegativeStackOffsets)
+        : CAssembleContext(mapper, fUseNegativeStackOffsets, fUseVEX)
         , m_pData(pData)
         , m_uStatic4Offset(uStatic4Offset)
         , m_uStatic8Offset(uStatic8Offset)
         , m_uStatic16Offset(uStatic16Offset)
+        , m_pAddressLog(pAddressLog)
 {
 }
 
+void
+CAssemblePass2::NoteAddressField(UINT_PTR uTarget, AddressField field)
+{
+    if (m_pAddressLog)
+    {
+        UINT32 cbField = field == AddressField_Absolute64 ? 8 : 4;
+        WarpAssert(m_uCount >= cbField);
+
+        m_pAddressLog->Add(m_uCount - cbField, uTarget, field);
+    }
+}
+
 void*
 CAssemblePass2::Place(void* pData, UINT32 dataType)
 {
@@ -16,6 +16,7 @@
 class COperator;
 class CVarState;
 class CMapper;
+class CCodeAddressLog;
 
 //+-----------------------------------------------------------------------------
 //
@@ -42,7 +43,7 @@ class CMapper;
 class CAssembleContext : public CCoder86
 {
 public:
-    CAssembleContext(CMapper const & mapper, bool fUseNegativeStackOffsets);
+    CAssembleContext(CMapper const & mapper, bool fUseNegativeStackOffsets, bool fUseVEX);
     void AssemblePrologue(
         __in UINT32 uFrameSize,
         __in UINT32 uFrameAlignment
@@ -70,6 +71,10 @@ public:
 
     UINT32 GetEspOffset() const { return m_uEspOffset; }
 
+    // True if SSE operations can be encoded with VEX prefix,
+    // see COperator::AssembleBinary().
+    bool UseVEX() const { return m_fUseVEX; }
+
 public:
     // Offset from ebp to 1st argument, see AssemblePrologue().
 #if WPFGFX_FXJIT_X86
@@ -88,6 +93,7 @@ protected:
     UINT32 m_uEspOffset;
 
 private:
+    bool m_fUseVEX;
     COperator *m_pCurrentOperator;
     UINT32 m_uOperatorFlags;
 };
@@ -106,7 +112,7 @@ private:
 class CAssemblePass1 : public CAssembleContext
 {
 public:
-    CAssemblePass1(CMapper const & mapper, bool fUseNegativeStackOffsets) : CAssembleContext(mapper, fUseNegativeStackOffsets) {}
+    CAssemblePass1(CMapper const & mapper, bool fUseNegativeStackOffsets, bool fUseVEX) : CAssembleContext(mapper, fUseNegativeStackOffsets, fUseVEX) {}
 
     void Emit(UINT32 /*data*/) {m_uCount++;}
     void Emit4(UINT32 /*data*/) {m_uCount += 4;}
@@ -123,6 +129,7 @@ public:
         m_uCount += uDelta;
     }
     UINT_PTR GetBase() const {return 0;}
+    void NoteAddressField(UINT_PTR /*uTarget*/, AddressField /*field*/) {}
     void* Place(void* pData, UINT32 /*dataType*/) {return pData;}
 };
 
@@ -143,10 +150,12 @@ public:
     CAssemblePass2(
         CMapper const & mapper,
         bool fUseNegativeStackOffsets,
+        bool fUseVEX,
         UINT8 * pData,
         INT_PTR uStatic4Offset,
         INT_PTR uStatic8Offset,
-        INT_PTR uStatic16Offset
+        INT_PTR uStatic16Offset,
+        __in_opt CCodeAddressLog * pAddressLog
         );
     void Emit(UINT32 data) {m_pData[m_uCount++] = static_cast<UINT8>(data);}
     void Emit4(UINT32 data)
@@ -201,6 +210,8 @@ public:
         return reinterpret_cast<UINT_PTR>(m_pData);
     }
 
+    void NoteAddressField(UINT_PTR uTarget, AddressField field);
+
     void* Place(void* pData, UINT32 dataType);
 
 private:
@@ -208,5 +219,6 @@ private:
     INT_PTR const m_uStatic4Offset;
     INT_PTR const m_uStatic8Offset;
     INT_PTR const m_uStatic16Offset;
+    CCodeAddressLog * const m_pAddressLog;
 };
 
@@ -0,0 +1,548 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+----------------------------------------------------------------------------
+//
+
+//
+//  Abstract:
+//      Persistent code cache support: program fingerprint and
+//      serialization of generated code.
+//
+//-----------------------------------------------------------------------------
+#include "precomp.h"
+
+static const UINT64 sc_ullFnvOffsetBasis = 0xCBF29CE484222325ull;
+static const UINT64 sc_ullFnvPrime = 0x00000100000001B3ull;
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      HashBytes
+//
+//  Synopsis:
+//      Accumulate FNV-1a hash of given data.
+//
+//------------------------------------------------------------------------------
+static UINT64
+HashBytes(
+    UINT64 ullHash,
+    __in_bcount(cbData) void const * pData,
+    UINT32 cbData
+    )
+{
+    UINT8 const * pBytes = static_cast<UINT8 const *>(pData);
+    for (UINT32 i = 0; i < cbData; i++)
+    {
+        ullHash = (ullHash ^ pBytes[i]) * sc_ullFnvPrime;
+    }
+    return ullHash;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetStaticDataSize
+//
+//  Synopsis:
+//      Return the size of static data referred by an operator of
+//      given data type, or zero if the type does not use static data.
+//
+//------------------------------------------------------------------------------
+static UINT32
+GetStaticDataSize(UINT32 dataType)
+{
+    switch (dataType)
+    {
+    case ofDataR32:
+    case ofDataM32:
+    case ofDataI32:
+    case ofDataF32:
+        return sizeof(uu32x1);
+
+    case ofDataM64:
+    case ofDataI64:
+        return sizeof(uu32x2);
+
+    case ofDataI128:
+    case ofDataF128:
+        return sizeof(uu32x4);
+    }
+
+    return 0;
+}
+
+CCodeAddressLog::CCodeAddressLog(__in CProgram * pProgram)
+    : m_pProgram(pProgram)
+{
+    m_prgEntries = NULL;
+    m_uCount = 0;
+    m_uAllocated = 0;
+    m_fOverflow = false;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CCodeAddressLog::Add
+//
+//  Synopsis:
+//      Append an entry. The storage is taken from program flush memory
+//      so that it is released together with the program.
+//
+//------------------------------------------------------------------------------
+void
+CCodeAddressLog::Add(UINT32 uOffset, UINT_PTR uTarget, AddressField field)
+{
+    if (m_fOverflow)
+        return;
+
+    if (m_uCount == m_uAllocated)
+    {
+        UINT32 uAllocated = m_uAllocated ? m_uAllocated * 2 : 64;
+        Entry * prgEntries = reinterpret_cast<Entry*>(
+            m_pProgram->AllocMem(uAllocated * sizeof(Entry))
+            );
+        if (prgEntries == NULL)
+        {
+            m_fOverflow = true;
+            return;
+        }
+
+        for (UINT32 i = 0; i < m_uCount; i++)
+        {
+            prgEntries[i] = m_prgEntries[i];
+        }
+
+        m_prgEntries = prgEntries;
+        m_uAllocated = uAllocated;
+    }
+
+    Entry & entry = m_prgEntries[m_uCount++];
+    entry.m_uOffset = uOffset;
+    entry.m_field = field;
+    entry.m_uTarget = uTarget;
+}
+
+CProgramFingerprint::CProgramFingerprint(
+    __out_bcount_opt(cbBuffer) UINT8 * pBuffer,
+    UINT32 cbBuffer
+    )
+    : m_pBuffer(pBuffer)
+    , m_cbBuffer(cbBuffer)
+{
+    m_cbSize = 0;
+    m_ullHash = sc_ullFnvOffsetBasis;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CProgramFingerprint::AddBytes
+//
+//  Synopsis:
+//      Append data to the fingerprint.
+//
+//------------------------------------------------------------------------------
+void
+CProgramFingerprint::AddBytes(
+    __in_bcount(cbData) void const * pData,
+    UINT32 cbData
+    )
+{
+    UINT8 const * pBytes = static_cast<UINT8 const *>(pData);
+
+    m_ullHash = HashBytes(m_ullHash, pBytes, cbData);
+
+    if (m_pBuffer)
+    {
+        for (UINT32 i = 0; i < cbData && m_cbSize + i < m_cbBuffer; i++)
+        {
+            m_pBuffer[m_cbSize + i] = pBytes[i];
+        }
+    }
+
+    m_cbSize += cbData;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CProgram::WriteFingerprint
+//
+//  Synopsis:
+//      Describe the program as accumulated by prototype routine, together
+//      with operation modes that affect code generation.
+//
+//      Pointers into flush memory differ from run to run, so static data is
+//      described by contents and linked operators by their order.
+//
+//------------------------------------------------------------------------------
+void
+CProgram::WriteFingerprint(__inout CProgramFingerprint & fingerprint) const
+{
+    fingerprint.AddValue(sc_uCodeImageVersion);
+    fingerprint.AddValue(sizeof(void*));
+    fingerprint.AddValue(m_usCallParametersSize);
+
+    UINT32 uModes =
+        (m_fEBP_Allowed             ? 0x01 : 0) |
+        (m_fEnableShuffling         ? 0x02 : 0) |
+        (m_fEnableMemShuffling      ? 0x04 : 0) |
+        (m_fEnableTotalBubbling     ? 0x08 : 0) |
+        (m_fUseNegativeStackOffsets ? 0x10 : 0) |
+        (m_fUseSSE41                ? 0x20 : 0) |
+        (m_fAvoidMOVDs              ? 0x40 : 0) |
+        (m_fUseVEX                  ? 0x80 : 0);
+    fingerprint.AddValue(uModes);
+
+    fingerprint.AddValue(m_uVarsCount);
+    for (UINT32 i = 0; i < m_uVarsCount; i++)
+    {
+        fingerprint.AddValue(m_prgVarDesc[i].varType);
+    }
+
+    fingerprint.AddValue(m_uOperatorsCount);
+    for (UINT32 i = 0; i < m_uOperatorsCount; i++)
+    {
+        COperator const * pOperator = m_prgOperators[i];
+
+        fingerprint.AddValue(pOperator->m_ot);
+        fingerprint.AddValue(pOperator->HasImmediateByte() ? pOperator->m_bImmediateByte : 0);
+        fingerprint.AddValue(pOperator->m_refType);
+        fingerprint.AddValue(pOperator->m_vResult);
+        fingerprint.AddValue(pOperator->m_vOperand1);
+        fingerprint.AddValue(pOperator->m_vOperand2);
+        fingerprint.AddValue(pOperator->m_vOperand3);
+
+        UINT32 cbStatic = pOperator->m_refType == RefType_Static
+            ? GetStaticDataSize(pOperator->GetDataType())
+            : 0;
+
+        if (cbStatic)
+        {
+            fingerprint.AddBytes(pOperator->m_pData, cbStatic);
+        }
+        else
+        {
+            // Offset or external address; the latter makes the code
+            // unsuitable for the cache anyway, see StoreCachedCode().
+            fingerprint.AddValue(pOperator->m_uDisplacement);
+        }
+
+        if (pOperator->IsControl() && pOperator->m_ot != otReturn)
+        {
+            COperator const * pLinked = static_cast<COperator const *>(pOperator->m_pLinkedOperator);
+            fingerprint.AddValue(pLinked ? pLinked->m_uOrder : UINT32(-1));
+        }
+        else
+        {
+            fingerprint.AddValue(pOperator->m_immediateData);
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CProgram::ComputeFingerprint
+//
+//  Synopsis:
+//      Make up the fingerprint of the program and its hash, which is the key
+//      the code is cached under. The fingerprint is allocated in program
+//      flush memory.
+//
+//------------------------------------------------------------------------------
+__checkReturn HRESULT
+CProgram::ComputeFingerprint(
+    __deref_out_bcount(*pcbFingerprint) UINT8 ** ppFingerprint,
+    __out UINT32 * pcbFingerprint,
+    __out UINT64 * pullKey
+    )
+{
+    HRESULT hr = S_OK;
+
+    CProgramFingerprint sizer(NULL, 0);
+    WriteFingerprint(sizer);
+
+    UINT8 * pFingerprint = AllocMem(sizer.GetSize());
+    IFCOOM(pFingerprint);
+
+    {
+        CProgramFingerprint fingerprint(pFingerprint, sizer.GetSize());
+        WriteFingerprint(fingerprint);
+
+        WarpAssert(fingerprint.GetSize() == sizer.GetSize());
+
+        *ppFingerprint = pFingerprint;
+        *pcbFingerprint = fingerprint.GetSize();
+        *pullKey = fingerprint.GetHash();
+    }
+
+Cleanup:
+    return hr;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CProgram::LoadCachedCode
+//
+//  Synopsis:
+//      Fetch the image for given key from the cache, validate it and
+//      place its code into executable memory.
+//
+//      The checks here only reject images that are damaged or were made for
+//      another program; the storage is responsible for rejecting images it
+//      did not write itself, see IJitterCodeCache.
+//
+//  Returns:
+//      true if ppBinaryCode received usable code; false if the program
+//      should be compiled.
+//
+//------------------------------------------------------------------------------
+bool
+CProgram::LoadCachedCode(
+    __in IJitterCodeCache * pCodeCache,
+    UINT64 ullKey,
+    __in_bcount(cbFingerprint) UINT8 const * pFingerprint,
+    UINT32 cbFingerprint,
+    __deref_out UINT8 ** ppBinaryCode
+    )
+{
+    bool fLoaded = false;
+    UINT8 * pImage = NULL;
+    UINT32 cbImage = 0;
+    UINT8 * pCode = NULL;
+
+    if (pCodeCache->LoadImage(ullKey, &pImage, &cbImage) != S_OK || pImage == NULL)
+        goto Cleanup;
+
+    if (cbImage < sizeof(CodeImageHeader))
+        goto Cleanup;
+
+    {
+        CodeImageHeader header;
+        UINT8 * pHeader = reinterpret_cast<UINT8*>(&header);
+        for (UINT32 i = 0; i < sizeof(header); i++)
+        {
+            pHeader[i] = pImage[i];
+        }
+
+        if (header.uSignature != sc_uCodeImageSignature
+            || header.uVersion != sc_uCodeImageVersion
+            || header.ullKey != ullKey
+            || header.cbFingerprint != cbFingerprint
+            || header.cbCode == 0
+            || header.uCodeSize > header.cbCode)
+            goto Cleanup;
+
+        UINT32 cbPayload = cbImage - sizeof(CodeImageHeader);
+        if (cbFingerprint > cbPayload
+            || header.cRelocations > (cbPayload - cbFingerprint) / sizeof(UINT32)
+            || cbPayload - cbFingerprint - header.cRelocations * sizeof(UINT32) != header.cbCode)
+            goto Cleanup;
+
+        UINT8 const * pPayload = pImage + sizeof(CodeImageHeader);
+        if (HashBytes(sc_ullFnvOffsetBasis, pPayload, cbPayload) != header.ullChecksum)
+            goto Cleanup;
+
+        // The key is a 64-bit hash; compare the whole description.
+        for (UINT32 i = 0; i < cbFingerprint; i++)
+        {
+            if (pPayload[i] != pFingerprint[i])
+                goto Cleanup;
+        }
+
+        UINT8 const * pRelocations = pPayload + cbFingerprint;
+        UINT8 const * pStoredCode = pRelocations + header.cRelocations * sizeof(UINT32);
+
+        if (FAILED(CJitterSupport::CodeAllocate(header.cbCode, &pCode)))
+            goto Cleanup;
+
+        for (UINT32 i = 0; i < header.cbCode; i++)
+        {
+            pCode[i] = pStoredCode[i];
+        }
+
+        for (UINT32 i = 0; i < header.cRelocations; i++)
+        {
+            UINT32 uOffset;
+            UINT8 * pOffset = reinterpret_cast<UINT8*>(&uOffset);
+            for (UINT32 j = 0; j < sizeof(uOffset); j++)
+            {
+                pOffset[j] = pRelocations[i * sizeof(UINT32) + j];
+            }
+
+            if (uOffset > header.cbCode - sizeof(UINT32))
+                goto Cleanup;
+
+            UINT8 * pField = pCode + uOffset;
+            UINT32 uTargetOffset =
+                  (UINT32)pField[0]
+                | ((UINT32)pField[1] <<  8)
+                | ((UINT32)pField[2] << 16)
+                | ((UINT32)pField[3] << 24);
+
+            if (uTargetOffset >= header.cbCode)
+                goto Cleanup;
+
+            UINT_PTR uTarget = reinterpret_cast<UINT_PTR>(pCode) + uTargetOffset;
+
+#if WPFGFX_FXJIT_X86
+#else // _AMD64_
+            // 4-byte absolute address is sign-extended by CPU.
+            if (uTarget >= 0x80000000)
+                goto Cleanup;
+#endif
+
+            pField[0] = static_cast<UINT8>(uTarget      );
+            pField[1] = static_cast<UINT8>(uTarget >>  8);
+            pField[2] = static_cast<UINT8>(uTarget >> 16);
+            pField[3] = static_cast<UINT8>(uTarget >> 24);
+        }
+
+        m_uCodeSize = header.uCodeSize;
+        m_cbBinaryCode = header.cbCode;
+    }
+
+    *ppBinaryCode = pCode;
+    pCode = NULL;
+    fLoaded = true;
+
+Cleanup:
+    if (pCode)
+    {
+        CJitterSupport::CodeFree(pCode);
+    }
+    if (pImage)
+    {
+        WarpPlatform::FreeMemory(pImage);
+    }
+    return fLoaded;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CProgram::StoreCachedCode
+//
+//  Synopsis:
+//      Make up persistent image of just assembled code and pass it to the
+//      cache.
+//
+//      Code that refers to memory outside of itself (external routines,
+//      client data given by address) is skipped: such addresses change
+//      from run to run.
+//
+//------------------------------------------------------------------------------
+void
+CProgram::StoreCachedCode(
+    __in IJitterCodeCache * pCodeCache,
+    UINT64 ullKey,
+    __in_bcount(cbFingerprint) UINT8 const * pFingerprint,
+    UINT32 cbFingerprint,
+    __in UINT8 const * pBinaryCode
+    )
+{
+    UINT8 * pImage = NULL;
+
+    if (m_pAddressLog == NULL || m_pAddressLog->WasOverflow())
+        goto Cleanup;
+
+    {
+        UINT_PTR uBase = reinterpret_cast<UINT_PTR>(pBinaryCode);
+        UINT32 cRelocations = 0;
+
+        for (UINT32 i = 0; i < m_pAddressLog->GetCount(); i++)
+        {
+            CCodeAddressLog::Entry const & entry = m_pAddressLog->GetEntry(i);
+
+            if (entry.m_uTarget < uBase || entry.m_uTarget - uBase >= m_cbBinaryCode)
+                goto Cleanup;
+
+            if (entry.m_field == AddressField_Absolute32)
+            {
+                cRelocations++;
+            }
+            else if (entry.m_field != AddressField_Relative32)
+            {
+                // Relative fields need no fixup; 8-byte absolute fields
+                // are not expected to refer inside of the code.
+                goto Cleanup;
+            }
+        }
+
+        UINT32 cbPayload = cbFingerprint + cRelocations * sizeof(UINT32) + m_cbBinaryCode;
+        UINT32 cbImage = sizeof(CodeImageHeader) + cbPayload;
+
+        pImage = static_cast<UINT8*>(WarpPlatform::AllocateMemory(cbImage));
+        if (pImage == NULL)
+            goto Cleanup;
+
+        UINT8 * pPayload = pImage + sizeof(CodeImageHeader);
+        UINT8 * pRelocations = pPayload + cbFingerprint;
+        UINT8 * pCode = pRelocations + cRelocations * sizeof(UINT32);
+
+        for (UINT32 i = 0; i < cbFingerprint; i++)
+        {
+            pPayload[i] = pFingerprint[i];
+        }
+
+        for (UINT32 i = 0; i < m_cbBinaryCode; i++)
+        {
+            pCode[i] = pBinaryCode[i];
+        }
+
+        for (UINT32 i = 0, iRelocation = 0; i < m_pAddressLog->GetCount(); i++)
+        {
+            CCodeAddressLog::Entry const & entry = m_pAddressLog->GetEntry(i);
+
+            if (entry.m_field != AddressField_Absolute32)
+                continue;
+
+            UINT32 uOffset = entry.m_uOffset;
+            UINT8 const * pOffset = reinterpret_cast<UINT8 const *>(&uOffset);
+            for (UINT32 j = 0; j < sizeof(uOffset); j++)
+            {
+                pRelocations[iRelocation * sizeof(UINT32) + j] = pOffset[j];
+            }
+            iRelocation++;
+
+            // Replace the address with the offset of the target.
+            UINT32 uTargetOffset = static_cast<UINT32>(entry.m_uTarget - uBase);
+            UINT8 * pField = pCode + uOffset;
+            pField[0] = static_cast<UINT8>(uTargetOffset      );
+            pField[1] = static_cast<UINT8>(uTargetOffset >>  8);
+            pField[2] = static_cast<UINT8>(uTargetOffset >> 16);
+            pField[3] = static_cast<UINT8>(uTargetOffset >> 24);
+        }
+
+        CodeImageHeader header;
+        header.uSignature = sc_uCodeImageSignature;
+        header.uVersion = sc_uCodeImageVersion;
+        header.ullKey = ullKey;
+        header.ullChecksum = HashBytes(sc_ullFnvOffsetBasis, pPayload, cbPayload);
+        header.cbCode = m_cbBinaryCode;
+        header.uCodeSize = m_uCodeSize;
+        header.cRelocations = cRelocations;
+        header.cbFingerprint = cbFingerprint;
+
+        UINT8 const * pHeader = reinterpret_cast<UINT8 const *>(&header);
+        for (UINT32 i = 0; i < sizeof(header); i++)
+        {
+            pImage[i] = pHeader[i];
+        }
+
+        pCodeCache->StoreImage(ullKey, pImage, cbImage);
+    }
+
+Cleanup:
+    if (pImage)
+    {
+        WarpPlatform::FreeMemory(pImage);
+    }
+}
+
@@ -0,0 +1,141 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+----------------------------------------------------------------------------
+//
+
+//
+//  Abstract:
+//      Definitions of persistent code image layout and class CCodeAddressLog.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CCodeAddressLog
+//
+//  Synopsis:
+//      Accumulates the locations of address fields in binary code
+//      as reported by CAssemblePass2::NoteAddressField().
+//
+//      CProgram uses the log to decide whether generated code can be
+//      moved to another place in memory, and to make up relocation
+//      table for persistent code image.
+//
+//------------------------------------------------------------------------------
+class CCodeAddressLog : public CFlushObject
+{
+public:
+    struct Entry
+    {
+        UINT32 m_uOffset;       // offset of the field in binary code
+        AddressField m_field;
+        UINT_PTR m_uTarget;     // address the field refers to
+    };
+
+    CCodeAddressLog(__in CProgram * pProgram);
+
+    void Add(UINT32 uOffset, UINT_PTR uTarget, AddressField field);
+
+    // True if some entry could not be stored; the log is then incomplete.
+    bool WasOverflow() const { return m_fOverflow; }
+
+    UINT32 GetCount() const { return m_uCount; }
+
+    Entry const & GetEntry(UINT32 uIndex) const
+    {
+        WarpAssert(uIndex < m_uCount);
+        return m_prgEntries[uIndex];
+    }
+
+private:
+    CProgram * const m_pProgram;
+    Entry * m_prgEntries;
+    UINT32 m_uCount;
+    UINT32 m_uAllocated;
+    bool m_fOverflow;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CProgramFingerprint
+//
+//  Synopsis:
+//      Receives the description of a program written by
+//      CProgram::WriteFingerprint(). Keeps the running hash of it, and a
+//      copy of it when given a buffer; without one it only counts the size.
+//
+//------------------------------------------------------------------------------
+class CProgramFingerprint
+{
+public:
+    CProgramFingerprint(
+        __out_bcount_opt(cbBuffer) UINT8 * pBuffer,
+        UINT32 cbBuffer
+        );
+
+    void AddBytes(
+        __in_bcount(cbData) void const * pData,
+        UINT32 cbData
+        );
+
+    void AddValue(UINT64 ullValue)
+    {
+        AddBytes(&ullValue, sizeof(ullValue));
+    }
+
+    UINT32 GetSize() const { return m_cbSize; }
+    UINT64 GetHash() const { return m_ullHash; }
+
+private:
+    UINT8 * const m_pBuffer;
+    UINT32 const m_cbBuffer;
+    UINT32 m_cbSize;
+    UINT64 m_ullHash;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Struct:
+//      CodeImageHeader
+//
+//  Synopsis:
+//      Leading part of persistent code image passed to IJitterCodeCache.
+//
+//      Image layout:
+//          CodeImageHeader header;
+//          UINT8  rgFingerprint[header.cbFingerprint];
+//          UINT32 rgRelocations[header.cRelocations];
+//          UINT8  rgCode[header.cbCode];
+//
+//      The fingerprint is the full description of the program the code was
+//      generated for; ullKey is only its hash. An image is used only if its
+//      fingerprint equals the one of the program being compiled.
+//
+//      Every relocation is the offset of 4-byte absolute address field in
+//      rgCode. In the image such a field holds the offset of the target
+//      within rgCode; on loading it is replaced by actual address.
+//
+//------------------------------------------------------------------------------
+struct CodeImageHeader
+{
+    UINT32 uSignature;
+    UINT32 uVersion;
+    UINT64 ullKey;
+    UINT64 ullChecksum;     // FNV-1a hash of fingerprint, relocations and code
+    UINT32 cbCode;          // size of code and static data
+    UINT32 uCodeSize;       // size of code, see CProgram::GetCodeSize()
+    UINT32 cRelocations;
+    UINT32 cbFingerprint;
+};
+
+static const UINT32 sc_uCodeImageSignature = 'CJXF';
+
+// Change on every modification that affects generated code or image layout.
+static const UINT32 sc_uCodeImageVersion = 3;
+
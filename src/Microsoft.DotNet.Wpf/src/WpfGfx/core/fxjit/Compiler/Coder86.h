@@ -493,6 +493,24 @@ enum OpCode : UINT32
     pinsrd    = OPCODE(Prefix_660F, 0x3A22),
 };
 
+//+-----------------------------------------------------------------------------
+//
+//  Enum:
+//      AddressField
+//
+//  Synopsis:
+//      Describes the encoding of a field in binary code that holds
+//      a memory address rather than a stack offset or immediate data.
+//      See CCoder86::NoteAddressField().
+//
+//-----------------------------------------------------------------------------
+enum AddressField
+{
+    AddressField_Absolute32 = 0,    // 4-byte absolute address
+    AddressField_Absolute64 = 1,    // 8-byte absolute address
+    AddressField_Relative32 = 2,    // 4-byte offset from the end of instruction
+};
+
 //+-----------------------------------------------------------------------------
 //
 //  Class:
@@ -539,10 +557,89 @@ public:
     virtual void Emit4(UINT32 data) = 0;
     virtual void EmitOpcode(UINT32 opcode) = 0;
     virtual UINT_PTR GetBase() const = 0;
+
+    // Called right after emitting a field that refers to uTarget address,
+    // so that the field occupies the bytes just before GetCount().
+    virtual void NoteAddressField(UINT_PTR uTarget, AddressField field) = 0;
+
     UINT32 GetCount() const {return m_uCount;}
     void SetCount(UINT32 uCount) {m_uCount = uCount;}
 
 private:
+    // Value of vexReg argument meaning legacy (not VEX) encoding.
+    static const UINT32 sc_uNoVexReg = 0xFFFFFFFF;
+
+    //
+    //      void EmitVexOpcode()
+    // Emit the opcode of SSE instruction with VEX prefix in place of
+    // legacy 66/F2/F3, REX and 0F/0F38/0F3A prefixes.
+    //
+    // The prefix is 2 bytes long (C5) when the opcode is in 0F map and
+    // REX.X, REX.B and REX.W are not required, otherwise 3 bytes (C4):
+    //      C5: [~R ~vvvv L pp]
+    //      C4: [~R ~X ~B mmmmm] [W ~vvvv L pp]
+    // vvvv is the additional source register; it makes the instruction
+    // non-destructive: "op dst, src1, src2" instead of "op dst, src".
+    // L = 0 selects 128-bit operation that zeroes upper half of YMM
+    // register, so there is no transition penalty against legacy code.
+    // L is never set: the jitter has no 256-bit variable types, no YMM
+    // register allocation or spilling, and emits no vzeroupper, so it
+    // must not produce VEX.256 code.
+    //
+    void EmitVexOpcode(UINT32 opcode, UINT32 vexReg)
+    {
+        C_ASSERT(Prefix_None == 0 && Prefix_F20F == 1 && Prefix_F30F == 2 && Prefix_660F == 3);
+        static const UINT32 pps[4] = { 0, 3, 2, 1 };
+
+        UINT32 prefix = (opcode & OpcPrefix) >> OpcShiftPrefix;
+        UINT32 byte1 = (opcode & OpcByte1) >> OpcShiftByte1;
+        UINT32 map = 1;
+        if (prefix != Prefix_None && (opcode & OpcIsLong))
+        {
+            WarpAssert(byte1 == 0x38 || byte1 == 0x3A);
+            map = byte1 == 0x38 ? 2 : 3;
+        }
+        else
+        {
+            WarpAssert(prefix != Prefix_None || byte1 == 0x0F);
+        }
+
+        UINT32 rex = 0;
+#if WPFGFX_FXJIT_X86
+#else //_AMD64_
+        rex = (opcode & OpcREX) >> OpcShiftREX;
+#endif
+        // In 32-bit mode ~R and ~X must be set, otherwise C4 and C5
+        // would be decoded as LES and LDS.
+        UINT32 vvvvLpp = ((~vexReg & 0xF) << 3) | pps[prefix];
+
+        if (map == 1 && (rex & 0xB) == 0)
+        {
+            Emit(0xC5);
+            Emit(((~rex & 4) << 5) | vvvvLpp);
+        }
+        else
+        {
+            Emit(0xC4);
+            Emit(((~rex & 7) << 5) | map);
+            Emit(((rex & 8) << 4) | vvvvLpp);
+        }
+
+        Emit((opcode & OpcByte2) >> OpcShiftByte2);
+    }
+
+    void EmitOpcodeOrVex(UINT32 opcode, UINT32 vexReg)
+    {
+        if (vexReg == sc_uNoVexReg)
+        {
+            EmitOpcode(opcode);
+        }
+        else
+        {
+            EmitVexOpcode(opcode, vexReg);
+        }
+    }
+
     //
     // Emit basic single register instruction.
     //
@@ -568,7 +665,7 @@ private:
     //
     // Emit basic register-register instruction.
     //
-    void EmitCmdRegReg(UINT32 opcode, UINT32 dstReg, UINT32 srcReg, UINT32 immSize, UINT32 immData)
+    void EmitCmdRegReg(UINT32 opcode, UINT32 dstReg, UINT32 srcReg, UINT32 immSize, UINT32 immData, UINT32 vexReg = sc_uNoVexReg)
     {
         if (opcode & OpcReversed)
         {
@@ -582,7 +679,7 @@ private:
         if (dstReg & 8) { opcode |= REX_R; dstReg &= 7; }
         if (srcReg & 8) { opcode |= REX_B; srcReg &= 7; }
 #endif
-        EmitOpcode(opcode);
+        EmitOpcodeOrVex(opcode, vexReg);
 
         UINT8 mod = 3;
 
@@ -627,7 +724,7 @@ private:
     // also has a number of tricky exceptions commented in the code below.
     //
 
-    void EmitCmdRegMem(UINT32 opcode, UINT32 dstReg, memptr & srcMem, UINT32 immSize, UINT32 immData)
+    void EmitCmdRegMem(UINT32 opcode, UINT32 dstReg, memptr & srcMem, UINT32 immSize, UINT32 immData, UINT32 vexReg = sc_uNoVexReg)
     {
         // Check for IA-32 addressing mode limitation:
         // ESP (or RSP in 64-bit mode) can not be used as an index register.
@@ -654,7 +751,7 @@ private:
         UINT8 mod = 0;
         UINT8 r_m = base;
 
-        EmitOpcode(opcode);
+        EmitOpcodeOrVex(opcode, vexReg);
 
 
         if (index == gpr_none)
@@ -737,6 +834,19 @@ private:
             WarpAssert(GetBase() == 0 || (disp >= -(INT_PTR)0x80000000 && disp < (INT_PTR)0x80000000));
             Emit4(static_cast<UINT32>(disp));
 #endif
+
+            // Without base register the displacement is an address.
+            if (srcMem.m_base == gpr_none && srcMem.m_nDisplacement != 0)
+            {
+#if WPFGFX_FXJIT_X86
+                NoteAddressField(srcMem.m_nDisplacement, AddressField_Absolute32);
+#else //_AMD64_
+                NoteAddressField(
+                    srcMem.m_nDisplacement,
+                    srcMem.m_index == gpr_none ? AddressField_Relative32 : AddressField_Absolute32
+                    );
+#endif
+            }
         }
 
         switch (immSize)
@@ -799,6 +909,24 @@ public:
         EmitCmdMemReg(opcode, dst, src.IndexInGroup(), immSize, immData);
     }
 
+    //
+    // VEX-encoded three-operand forms of SSE instructions: dst = src1 op src2.
+    // The opcode is given in legacy form, like in cmd() above.
+    // Requires AVX support; only valid for instructions that take
+    // the first source from the destination register in legacy encoding.
+    //
+    void vcmd(UINT32 opcode, CRegID dst, CRegID src1, CRegID src2, UINT32 immSize = 0, UINT32 immData = 0)
+    {
+        WarpAssert((opcode & OpcReversed) == 0);
+        EmitCmdRegReg(opcode, dst.IndexInGroup(), src2.IndexInGroup(), immSize, immData, src1.IndexInGroup());
+    }
+
+    void vcmd(UINT32 opcode, CRegID dst, CRegID src1, memptr src2, UINT32 immSize = 0, UINT32 immData = 0)
+    {
+        WarpAssert((opcode & OpcReversed) == 0);
+        EmitCmdRegMem(opcode, dst.IndexInGroup(), src2, immSize, immData, src1.IndexInGroup());
+    }
+
     void cmd(UINT32 opcode, RegGPR dst, RegGPR src, UINT32 immSize = 0, UINT32 immData = 0)
     {
         EmitCmdRegReg(opcode, dst, src, immSize, immData);
@@ -837,6 +965,16 @@ public:
 #endif
     }
 
+    void movImmAddress(RegGPR dst, UINT_PTR address)
+    {
+        movImmWhole(dst, address);
+#if WPFGFX_FXJIT_X86
+        NoteAddressField(address, AddressField_Absolute32);
+#else //_AMD64_
+        NoteAddressField(address, AddressField_Absolute64);
+#endif
+    }
+
     void movImm(dword dst, int value) { EmitCmdRegMem(OPCODE(Prefix_None, 0xC7), 0, dst, 4, value); }
 
     void addImm(RegGPR dst, UINT32 imm)  { EmitCmdRegImm(OPCODE(Prefix_None, 0x83), OPCODE(Prefix_None, 0x81), 0, dst, imm); }
@@ -977,6 +1115,7 @@ public:
         Emit(0xE8);
         INT_PTR offset = label - (GetCount() + 4) - GetBase();
         Emit4(offset);
+        NoteAddressField(label, AddressField_Relative32);
     }
 #endif //WPFGFX_FXJIT_X86
 
@@ -226,7 +226,7 @@ COperator::AssembleIrregular(CAssembleContext & actx)
             }
 #else // _AMD64_
             actx.subImmWhole (gsp, uEspOffset + 4*sizeof(void*));
-            actx.movImmWhole(gax, m_uDisplacement);
+            actx.movImmAddress(gax, m_uDisplacement);
             actx.call(CRegID(gax));
             actx.addImmWhole (gsp, uEspOffset + 4*sizeof(void*));
 #endif
@@ -278,6 +278,16 @@ COperator::AssembleBinary(CAssembleContext & actx)
         }
     }
 
+    //
+    // VEX encoding lets SSE operations take the first source from other
+    // register than the result, which saves preliminary move when result
+    // and first operand have not been coalesced.
+    //
+    bool fUseVEX = actx.UseVEX()
+                && (dataType == ofDataI128 || dataType == ofDataF128 || dataType == ofDataF32)
+                && (opCode & OpcReversed) == 0
+                && m_rResult != m_rOperand1;
+
     switch (m_refType)
     {
     case RefType_Direct:
@@ -293,6 +303,10 @@ COperator::AssembleBinary(CAssembleContext & actx)
                 {
                     actx.cmd(opCode, m_rResult, src2, immSize, immData);
                 }
+                else if (fUseVEX)
+                {
+                    actx.vcmd(opCode, m_rResult, m_rOperand1, src2, immSize, immData);
+                }
                 else if (CanSwapOperands() && m_rResult == src2)
                 {
                     actx.cmd(opCode, m_rResult, m_rOperand1, immSize, immData);
@@ -305,12 +319,19 @@ COperator::AssembleBinary(CAssembleContext & actx)
             }
             else
             {
+                UINT32 offset = actx.GetOffset(m_vOperand2);
+
+                if (fUseVEX)
+                {
+                    actx.vcmd(opCode, m_rResult, m_rOperand1, actx.FramePtr(offset), immSize, immData);
+                    break;
+                }
+
                 if (m_rResult != m_rOperand1)
                 {
                     actx.cmd(movCode, m_rResult, m_rOperand1);
                 }
 
-                UINT32 offset = actx.GetOffset(m_vOperand2);
                 actx.cmd(opCode, m_rResult, actx.FramePtr(offset), immSize, immData);
             }
         }
@@ -323,11 +344,19 @@ COperator::AssembleBinary(CAssembleContext & actx)
             //
             WarpAssert(m_vOperand2 == 0);
 
+            memptr src2(actx.Place(m_pData, dataType));
+
+            if (fUseVEX)
+            {
+                actx.vcmd(opCode, m_rResult, m_rOperand1, src2, immSize, immData);
+                break;
+            }
+
             if (m_rResult != m_rOperand1)
             {
                 actx.cmd(movCode, m_rResult, m_rOperand1);
             }
-            actx.cmd(opCode, m_rResult, memptr(actx.Place(m_pData, dataType)), immSize, immData);
+            actx.cmd(opCode, m_rResult, src2, immSize, immData);
         }
         break;
     case RefType_Base:
@@ -339,11 +368,18 @@ COperator::AssembleBinary(CAssembleContext & actx)
             //
             WarpAssert(m_vOperand2 != 0);
 
+            RegGPR pBase = RegGPROperand2();
+
+            if (fUseVEX)
+            {
+                actx.vcmd(opCode, m_rResult, m_rOperand1, memptr(pBase, m_uDisplacement), immSize, immData);
+                break;
+            }
+
             if (m_rResult != m_rOperand1)
             {
                 actx.cmd(movCode, m_rResult, m_rOperand1, 0 ,0);
             }
-            RegGPR pBase = RegGPROperand2();
             actx.cmd(opCode, m_rResult, memptr(pBase, m_uDisplacement), immSize, immData);
         }
         break;
@@ -354,23 +390,23 @@ COperator::AssembleBinary(CAssembleContext & actx)
             // data reside in memory pointed to by m_uDisplacement plus
             // index with given scale.
             //
-            if (m_rResult != m_rOperand1)
-            {
-                actx.cmd(movCode, m_rResult, m_rOperand1);
-            }
-
             WarpAssert(m_vOperand2 != 0);
-            if (m_rOperand3 == 0)
+
+            memptr src2 = m_rOperand3 == 0
+                ? memptr(m_pData, RegGPROperand2(), (Scale32)m_refType)
+                : memptr(RegGPROperand2(), RegGPROperand3(), (Scale32)m_refType, m_uDisplacement);
+
+            if (fUseVEX)
             {
-                RegGPR index = RegGPROperand2();
-                actx.cmd(opCode, m_rResult, memptr(m_pData, index, (Scale32)m_refType), immSize, immData);
+                actx.vcmd(opCode, m_rResult, m_rOperand1, src2, immSize, immData);
+                break;
             }
-            else
+
+            if (m_rResult != m_rOperand1)
             {
-                RegGPR base = RegGPROperand2();
-                RegGPR index = RegGPROperand3();
-                actx.cmd(opCode, m_rResult, memptr(base, index, (Scale32)m_refType, m_uDisplacement), immSize, immData);
+                actx.cmd(movCode, m_rResult, m_rOperand1);
             }
+            actx.cmd(opCode, m_rResult, src2, immSize, immData);
         }
         break;
     }
@@ -653,12 +689,17 @@ case otPtrAssignMemberIndexed:
 #if WPFGFX_FXJIT_X86
 #else // _AMD64_
 case otUINT64ImmAssign:
+    {
+        RegGPR dst  = RegGPRResult();
+        actx.movImmWhole(dst, m_uDisplacement);
+    }
+    break;
 #endif
 
 case otPtrAssignImm:
     {
         RegGPR dst  = RegGPRResult();
-        actx.movImmWhole(dst, m_uDisplacement);
+        actx.movImmAddress(dst, m_uDisplacement);
     }
     break;
 
@@ -18,6 +18,8 @@ struct OpSpan;
 struct SpanLink;
 class CSpanList;
 class CBitArray;
+class CCodeAddressLog;
+class CProgramFingerprint;
 
 #define MAX_FLOWS 5
 
@@ -233,7 +235,10 @@ public:
     UINT_PTR SnapData(float const& src) { return SnapData((uu32x1&)src); }
     UINT_PTR SnapData(UINT32 const& src) { return SnapData((uu32x1&)src); }
 
-    __checkReturn HRESULT Compile(__deref_out UINT8 ** pBinaryCode );
+    __checkReturn HRESULT Compile(
+        __deref_out UINT8 ** pBinaryCode,
+        __in_opt IJitterCodeCache * pCodeCache
+        );
 
     UINT32 GetCodeSize() const { return m_uCodeSize; }
 
@@ -417,6 +422,28 @@ private:
 
     __checkReturn HRESULT Assemble(__deref_out UINT8 ** ppBinaryCode);
 
+    // persistent code cache
+    void WriteFingerprint(__inout CProgramFingerprint & fingerprint) const;
+    __checkReturn HRESULT ComputeFingerprint(
+        __deref_out_bcount(*pcbFingerprint) UINT8 ** ppFingerprint,
+        __out UINT32 * pcbFingerprint,
+        __out UINT64 * pullKey
+        );
+    bool LoadCachedCode(
+        __in IJitterCodeCache * pCodeCache,
+        UINT64 ullKey,
+        __in_bcount(cbFingerprint) UINT8 const * pFingerprint,
+        UINT32 cbFingerprint,
+        __deref_out UINT8 ** ppBinaryCode
+        );
+    void StoreCachedCode(
+        __in IJitterCodeCache * pCodeCache,
+        UINT64 ullKey,
+        __in_bcount(cbFingerprint) UINT8 const * pFingerprint,
+        UINT32 cbFingerprint,
+        __in UINT8 const * pBinaryCode
+        );
+
     struct Flow
     {
         Flow();
@@ -462,6 +489,12 @@ private:
 
     UINT32 m_uCodeSize;
 
+    // size of code and static data
+    UINT32 m_cbBinaryCode;
+
+    // address fields gathered on assembling, only when code is to be cached
+    CCodeAddressLog * m_pAddressLog;
+
     // static variable control
     StaticStorage<uu32x1> m_storage4;
     StaticStorage<uu32x2> m_storage8;
@@ -499,6 +532,7 @@ private:
     bool m_fEnableMemShuffling;
     bool m_fEnableTotalBubbling;
     bool m_fUseNegativeStackOffsets;
+    bool m_fUseVEX;
 
 public:
     bool m_fUseSSE41;
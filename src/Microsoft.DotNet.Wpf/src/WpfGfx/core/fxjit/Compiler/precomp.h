@@ -27,6 +27,7 @@
 #include "Program.h"
 #include "Coder86.h"
 #include "Assemble.h"
+#include "CodeCache.h"
 #include "ShuffleRegs.h"
 #include "BitArray.h"
 #include "Mapper.h"
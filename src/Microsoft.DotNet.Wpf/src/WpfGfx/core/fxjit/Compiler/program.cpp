@@ -119,12 +119,17 @@ CProgram::CProgram(
 
     m_fUseNegativeStackOffsets = false;
 
+    // VEX encoding requires AVX; the client enables it per processor.
+    m_fUseVEX = false;
+
     m_fUseSSE41 = false;
     m_fAvoidMOVDs = false;
 
     m_fReturnPresents = false;
 
     m_uCodeSize = 0;
+    m_cbBinaryCode = 0;
+    m_pAddressLog = NULL;
 }
 
 __checkReturn HRESULT
@@ -193,6 +198,10 @@ CProgram::SetMode(UINT32 uParameterIdx, INT32 nParameterValue)
     case CJitterAccess::sc_uidAvoidMOVDs:
         m_fAvoidMOVDs = nParameterValue != 0;
         break;
+
+    case CJitterAccess::sc_uidUseVEX:
+        m_fUseVEX = nParameterValue != 0;
+        break;
     }
 }
 
@@ -408,13 +417,20 @@ CProgram::AddReturnOperator()
 //      Generate binary code to implement an algorithm accumulated in
 //      current program with AddOperator calls.
 //
+//      When pCodeCache is given, the code is fetched from it if possible;
+//      otherwise newly generated code is stored there.
+//
 //-------------------------------------------------------------------------------
 __checkReturn HRESULT
 CProgram::Compile(
-    __deref_out UINT8 ** ppBinaryCode
+    __deref_out UINT8 ** ppBinaryCode,
+    __in_opt IJitterCodeCache * pCodeCache
     )
 {
     HRESULT hr = S_OK;
+    UINT64 ullCacheKey = 0;
+    UINT8 * pFingerprint = NULL;
+    UINT32 cbFingerprint = 0;
 
     // Add return operator at the end of the program unless it is present already.
 
@@ -426,6 +442,20 @@ CProgram::Compile(
         IFC(E_OUTOFMEMORY);
     }
 
+    if (pCodeCache)
+    {
+        IFC(ComputeFingerprint(&pFingerprint, &cbFingerprint, &ullCacheKey));
+
+        if (LoadCachedCode(pCodeCache, ullCacheKey, pFingerprint, cbFingerprint, ppBinaryCode))
+        {
+            goto Cleanup;
+        }
+
+        UINT8 *pMem = AllocMem(sizeof(CCodeAddressLog));
+        IFCOOM(pMem);
+        m_pAddressLog = new(pMem) CCodeAddressLog(this);
+    }
+
     IFC(BuildSpanGraph());
     IFC(BuildDependencyGraph());
 
@@ -452,6 +482,11 @@ CProgram::Compile(
 
     IFC(Assemble(ppBinaryCode));
 
+    if (pCodeCache)
+    {
+        StoreCachedCode(pCodeCache, ullCacheKey, pFingerprint, cbFingerprint, *ppBinaryCode);
+    }
+
 #if DBG_DUMP
     if (IsDumpEnabled()) DumpSpans();
 #endif
@@ -1448,7 +1483,7 @@ CProgram::Assemble(
     }
 
     {
-        CAssemblePass1 coder1(mapper, m_fUseNegativeStackOffsets);
+        CAssemblePass1 coder1(mapper, m_fUseNegativeStackOffsets, m_fUseVEX);
         coder1.AssemblePrologue(mapper.GetFrameSize(), mapper.GetFrameAlignment());
 
 #if DBG_DUMP
@@ -1473,6 +1508,7 @@ CProgram::Assemble(
         );
 
     IFC(CJitterSupport::CodeAllocate(uSizeToAlloc, &pCode));
+    m_cbBinaryCode = uSizeToAlloc;
 
     m_storage4.CopyData(pCode);
     m_storage8.CopyData(pCode);
@@ -1485,10 +1521,12 @@ CProgram::Assemble(
         CAssemblePass2 coder2(
             mapper,
             m_fUseNegativeStackOffsets,
+            m_fUseVEX,
             pCode,
             m_storage4.GetAddressDelta(),
             m_storage8.GetAddressDelta(),
-            m_storage16.GetAddressDelta()
+            m_storage16.GetAddressDelta(),
+            m_pAddressLog
             );
         coder2.AssemblePrologue(mapper.GetFrameSize(), mapper.GetFrameAlignment());
 
@@ -12,6 +12,7 @@
 //
 //-----------------------------------------------------------------------------
 #include "precomp.h"
+#include <intrin.h>
 
 //
 // Macros
@@ -196,11 +197,15 @@ Cleanup:
 //  Synopsis:
 //     Release implementation
 //
+//  Notes:
+//     Compilers are shared between resources and render threads, so the
+//     count is changed atomically.
+//
 //-------------------------------------------------------------------------
 UINT32 
 CPixelShaderCompiler::Release()
 {
-    UINT32 cRef = --m_cRefs;
+    UINT32 cRef = static_cast<UINT32>(_InterlockedDecrement(&m_cRefs));
     if (cRef == 0)
     {
         delete this;
@@ -219,7 +224,7 @@ CPixelShaderCompiler::Release()
 UINT32 
 CPixelShaderCompiler::AddRef()
 {
-    return ++m_cRefs;
+    return static_cast<UINT32>(_InterlockedIncrement(&m_cRefs));
 }
 
 //-------------------------------------------------------------------------
@@ -14,6 +14,45 @@
 
 #pragma once
 
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      IJitterCodeCache
+//
+//  Synopsis:
+//      Persistent storage for compiled programs supplied by jitter client.
+//
+//      Images are opaque to the storage. Each one carries the full
+//      description of the program it was made for, and the jitter rejects
+//      images that are malformed or describe another program. It cannot
+//      tell a well formed image with hostile code from its own, though:
+//      whatever LoadImage returns ends up executed. The storage must only
+//      return images it wrote itself, kept where no one else can change
+//      them and authenticated when read back.
+//
+//      Both routines are called under the jitter lock.
+//
+//------------------------------------------------------------------------------
+class IJitterCodeCache
+{
+public:
+    // Fetch the image stored for given key. Returns S_FALSE when there is
+    // no image. On success the image is allocated with
+    // WarpPlatform::AllocateMemory and is freed by the jitter.
+    virtual __checkReturn HRESULT LoadImage(
+        UINT64 ullKey,
+        __deref_out_bcount(*pcbImage) UINT8 **ppImage,
+        __out UINT32 *pcbImage
+        ) = 0;
+
+    // Store the image for given key. Failures are ignored by the jitter.
+    virtual void StoreImage(
+        UINT64 ullKey,
+        __in_bcount(cbImage) UINT8 const *pImage,
+        UINT32 cbImage
+        ) = 0;
+};
+
 //+-----------------------------------------------------------------------------
 //
 //  Class:
@@ -34,6 +73,9 @@ public:
     static UINT32 GetCodeSize();
     static void CodeFree(__in void *pBinaryCode);
 
+    static void SetCodeCache(__in_opt IJitterCodeCache *pCodeCache);
+    static void SetUseVEX(bool fUseVEX);
+
     static void SplitFlow();
     static void SetFlow(UINT32 uFlowID);
     static void ReverseFlow(UINT32 uFlowID);
@@ -55,6 +97,9 @@ public:
     static const int sc_uidUseSSE41 = 4;
     static const int sc_uidAvoidMOVDs = 5;
     static const int sc_uidEnableMemShuffling = 6;
+    static const int sc_uidUseVEX = 7;     // encode SSE operations with VEX prefix;
+                                           // vectors stay 128 bits wide, there is
+                                           // no 256-bit (YMM) code generation
 };
 
 
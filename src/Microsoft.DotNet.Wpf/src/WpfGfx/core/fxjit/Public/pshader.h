@@ -96,7 +96,7 @@ private:
         );
 
 private:
-    unsigned              m_cRefs;
+    volatile long         m_cRefs;
     RDPSTrans            *m_pTranslated;
     CTextureVariables    *m_pTextureVariables;
     GenerateColorsEffect *m_pfn;
@@ -133,6 +133,15 @@ public:
     HRESULT Flatten( 
         IN bool fWithTangents);   // Return tangents with the points if true
 
+    // Flattening with a step count computed up front and points evaluated in
+    // batches, instead of adaptive forward differencing.  Both keep the same
+    // tolerance.  Disabled by default; enabled at startup only when the
+    // EnableAnalyticBezierFlattening registry value is set.
+    static VOID EnableAnalyticFlattening(bool fEnable)
+    {
+        sm_fAnalyticFlatteningEnabled = fEnable;
+    }
+
 private:
     // Disallow copy constructor
     CBezierFlattener(__in_ecount(1) const CBezierFlattener &)
@@ -148,6 +157,18 @@ protected:
 
     bool TryDoubleTheStep();
 
+    HRESULT FlattenAnalytic();
+
+    UINT GetAnalyticStepCount() const;
+
+#if DBG
+    void DbgAssertAnalyticFlatteningWithinTolerance(
+        __in_ecount(4) const GpPointR *rgCoefficients,
+            // The curve in the power basis
+        UINT cSteps) const;
+            // Number of uniform steps it was flattened with
+#endif
+
     // Flattening defining data
     CFlatteningSink *m_pSink;           // The recipient of the flattening data
     double          m_rTolerance;       // Prescribed tolerance
@@ -160,6 +181,8 @@ protected:
     int             m_cSteps;           // The number of steps left to the end of the curve
     double          m_rParameter;       // Parameter value
     double          m_rStepSize;        // Steps size in parameter domain
+
+    static bool     sm_fAnalyticFlatteningEnabled;
 };
 
 
@@ -305,23 +305,20 @@ public:
     }
 
     // Other public methods
-    bool StartAt(
-        __in_ecount(1) const MilPoint2F &ptFirst
-            // The figure's first point
-        )
-    {
-        m_ptCurrent = GpPointR(ptFirst, &m_oMatrix);
-        return (m_fAborted = (m_ptCurrent * m_ptCurrent < m_rSquaredThreshold));
-    }
 
-    // Exactly the same as StartAt, but with a double-precision point
-    // To be consolidated when we move to double precision points throughout
-    HRESULT StartAtR(
-        __in_ecount(1) const GpPointR &ptFirst
+    // Start a figure.  Virtual so that CPreparedHitTest can record the
+    // pieces of a stroke and the figures of the fills annotating it.
+    virtual HRESULT StartAtR(
+        __in_ecount(1) const GpPointR &ptFirst,
             // The figure's first point
+        bool fResetWinding = true
+            // False for the figures of one fill, whose windings add up
         )
     {
-        m_iWinding = 0;
+        if (fResetWinding)
+        {
+            m_iWinding = 0;
+        }
         m_ptCurrent = GpPointR(ptFirst, &m_oMatrix);
         m_fAborted = (m_ptCurrent * m_ptCurrent < m_rSquaredThreshold);
 
@@ -0,0 +1,583 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_geometry
+//      $Keywords:
+//
+//  $Description:
+//      Hit testing many points against the same shape
+//
+//  $ENDTAG
+//
+//  Classes:
+//      CPreparedHitTest
+//
+//------------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+MtDefine(CPreparedHitTest, MILRender, "CPreparedHitTest");
+
+// Shapes with fewer edges are tested against all of them
+const UINT MIN_EDGES_TO_INDEX = 32;
+
+// The number of bands aims at this many edges per band, up to a maximum
+const UINT EDGES_PER_BAND = 4;
+const UINT MAX_BANDS = 4096;
+
+// Edges that span many bands are listed in each of them.  If the index would
+// hold more than this many entries per edge, the bands are made taller.
+const UINT MAX_BAND_ENTRIES_PER_EDGE = 16;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CHitTestRecorder
+//
+//  Synopsis:
+//      A hit tester that records the segments it is given instead of testing
+//      them
+//
+//  Notes:
+//      It takes the place of the CHitTest that HitTestFill traverses and that
+//      CHitTestSink drives while widening, so the recorded segments are those
+//      a direct hit test would see.  It never reports a hit, so the widener
+//      and the sink run to completion.
+//
+//------------------------------------------------------------------------------
+class CHitTestRecorder  :   public CHitTest
+{
+public:
+    CHitTestRecorder(
+        __inout_ecount(1) CPreparedHitTest &hitTest
+            // The recipient of the segments
+        )
+        : CHitTest(GpPointR(0, 0), NULL, 0),
+          m_refHitTest(hitTest)
+    {
+    }
+
+    virtual ~CHitTestRecorder() {}
+
+    // CHitTest overrides
+    virtual HRESULT StartAtR(
+        __in_ecount(1) const GpPointR &ptFirst,
+            // The piece's first point
+        bool = true
+            // Winding is not tracked here
+        )
+    {
+        m_ptCurrent = GpPointR(ptFirst, &m_oMatrix);
+        RRETURN(m_refHitTest.StartRing(m_ptCurrent));
+    }
+
+    virtual HRESULT AcceptPoint(
+        __in_ecount(1) const GpPointR &ptEnd,
+            // The segment's endpoint
+        GpReal,
+            // Ignored here
+        __out_ecount(1) bool &fHit
+            // Never set to true here
+        )
+    {
+        fHit = false;
+        m_ptCurrent = ptEnd;
+        RRETURN(m_refHitTest.AddPoint(ptEnd));
+    }
+
+// Data
+protected:
+    CPreparedHitTest &m_refHitTest;     // The recipient of the segments
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::CPreparedHitTest
+//
+//  Synopsis:
+//      Constructor
+//
+//------------------------------------------------------------------------------
+CPreparedHitTest::CPreparedHitTest(
+    MilFillMode::Enum eFillMode,
+        // Fill mode of the shape
+    bool fStroke,
+        // True if testing the stroke
+    double rThreshold
+        // Distance considered a hit - absolute
+    )
+    : m_eFillMode(eFillMode),
+      m_fStroke(fStroke),
+      m_rThreshold(rThreshold),
+      m_rTop(0),
+      m_rBandHeight(0),
+      m_cBands(0)
+{
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::Create
+//
+//  Synopsis:
+//      Record and index the segments that hit testing a shape's fill or
+//      stroke would test
+//
+//  Notes:
+//      The fill is traversed as CShapeBase::HitTestFiguresFill does, and the
+//      stroke is widened as CShapeBase::HitTestStroke does.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CPreparedHitTest::Create(
+    __in_ecount(1) const CShapeBase &shape,
+        // The shape to hit test
+    __in_ecount_opt(1) const CPlainPen *pPen,
+        // Pen, hit test the stroke if not NULL
+    double rThreshold,
+        // Distance considered a hit - absolute
+    __deref_out_ecount(1) CPreparedHitTest **ppHitTest
+        // The prepared hit test
+    )
+{
+    HRESULT hr = S_OK;
+    CPreparedHitTest *pHitTest = NULL;
+
+    Assert(ppHitTest);
+    *ppHitTest = NULL;
+
+    IFCOOM(pHitTest = new CPreparedHitTest(shape.GetFillMode(), pPen != NULL, rThreshold));
+
+    {
+        CHitTestRecorder recorder(*pHitTest);
+
+        if (pPen)
+        {
+            CHitTestSink sink(recorder);
+
+            IFC(shape.WidenToSink(*pPen, NULL, DEFAULT_FLATTENING_TOLERANCE, IN OUT sink));
+        }
+        else
+        {
+            for (UINT i = 0;  i < shape.GetFigureCount();  i++)
+            {
+                const IFigureData &figure = shape.GetFigure(i);
+                if (!figure.IsEmpty()  &&  figure.IsFillable())
+                {
+                    IFC(recorder.StartAtR(GpPointR(figure.GetStartPoint())));
+                    IFC(recorder.TraverseForward(figure));
+                    if (!figure.IsClosed())
+                    {
+                        // The closing segment, as in CHitTest::EndAt
+                        IFC(recorder.DoLine(figure.GetStartPoint()));
+                    }
+                }
+            }
+        }
+    }
+
+    pHitTest->EndRing();
+    IFC(pHitTest->BuildIndex());
+
+    *ppHitTest = pHitTest;
+    pHitTest = NULL;
+
+Cleanup:
+    delete pHitTest;
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::StartRing
+//
+//  Synopsis:
+//      Start recording a new ring
+//
+//------------------------------------------------------------------------------
+HRESULT
+CPreparedHitTest::StartRing(
+    __in_ecount(1) const GpPointR &pt)
+        // The ring's first point
+{
+    HRESULT hr = S_OK;
+    Ring ring;
+
+    EndRing();
+
+    ring.uFirstPoint = m_rgPoints.GetCount();
+    ring.cPoints = 0;
+    ring.fTestInside = !m_fStroke;
+
+    IFC(m_rgRings.Add(ring));
+    IFC(AddPoint(pt));
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::AddPoint
+//
+//  Synopsis:
+//      Add a point to the current ring
+//
+//------------------------------------------------------------------------------
+HRESULT
+CPreparedHitTest::AddPoint(
+    __in_ecount(1) const GpPointR &pt)
+        // The ring's next point
+{
+    HRESULT hr = S_OK;
+
+    if (m_rgRings.GetCount() == 0)
+    {
+        // Segments are always preceded by a start point; tolerate it anyway
+        Assert(false);
+        IFC(StartRing(pt));
+    }
+    else
+    {
+        IFC(m_rgPoints.Add(pt));
+        m_rgRings.Last().cPoints++;
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::EndRing
+//
+//  Synopsis:
+//      Finish recording the current ring, if any
+//
+//  Notes:
+//      CHitTestSink checks the winding number of the pieces it closes (quads,
+//      wedges and round or triangular caps) but not of the open ones (flat
+//      caps and side switches).  The pieces it closes end exactly at their
+//      start point.
+//
+//------------------------------------------------------------------------------
+void
+CPreparedHitTest::EndRing()
+{
+    if (m_fStroke  &&  m_rgRings.GetCount() > 0)
+    {
+        Ring &ring = m_rgRings.Last();
+
+        ring.fTestInside =
+            ring.cPoints > 2  &&
+            m_rgPoints[ring.uFirstPoint] == m_rgPoints[ring.uFirstPoint + ring.cPoints - 1];
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::GetBand
+//
+//  Synopsis:
+//      Get the band containing a given y, clamped to the index
+//
+//------------------------------------------------------------------------------
+UINT
+CPreparedHitTest::GetBand(
+    double y) const   // The y coordinate
+{
+    Assert(m_cBands > 0);
+
+    double r = (y - m_rTop) / m_rBandHeight;
+
+    if (!(r > 0))
+    {
+        return 0;
+    }
+    else if (r >= m_cBands)
+    {
+        return m_cBands - 1;
+    }
+
+    return static_cast<UINT>(r);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::BuildIndex
+//
+//  Synopsis:
+//      List the edges and bucket them into horizontal bands
+//
+//  Notes:
+//      Each edge is listed in every band that its vertical extent, grown by
+//      twice the threshold, overlaps.  The lists are in edge order, so the
+//      edges of each ring are consecutive.
+//
+//      If the shape is small or has a non-finite coordinate, it is left
+//      unindexed and every point is tested against all the edges.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CPreparedHitTest::BuildIndex()
+{
+    HRESULT hr = S_OK;
+    UINT i;
+    UINT *pBandStart;
+    UINT *pBandEdges;
+    UINT cEntries;
+    UINT cMaxEntries;
+    double rMinY = 0;
+    double rMaxY = 0;
+    double rSlack;
+    bool fFinite = true;
+
+    // List the edges
+    for (i = 0;  i < m_rgRings.GetCount();  i++)
+    {
+        const Ring &ring = m_rgRings[i];
+
+        for (UINT j = 1;  j < ring.cPoints;  j++)
+        {
+            Edge edge;
+            edge.uStartPoint = ring.uFirstPoint + j - 1;
+            edge.uRing = i;
+
+            IFC(m_rgEdges.Add(edge));
+        }
+    }
+
+    if (m_rgEdges.GetCount() < MIN_EDGES_TO_INDEX)
+    {
+        goto Cleanup;
+    }
+
+    // Get the vertical extent
+    for (i = 0;  i < m_rgPoints.GetCount();  i++)
+    {
+        double y = m_rgPoints[i].Y;
+
+        if (!_finite(y))
+        {
+            fFinite = false;
+            break;
+        }
+
+        if (i == 0  ||  y < rMinY)
+        {
+            rMinY = y;
+        }
+        if (i == 0  ||  y > rMaxY)
+        {
+            rMaxY = y;
+        }
+    }
+
+    if (!fFinite)
+    {
+        goto Cleanup;
+    }
+
+    // CHitTest never tests with a threshold smaller than sqrt(SQ_LENGTH_FUZZ)
+    rSlack = 2 * max(m_rThreshold, sqrt(SQ_LENGTH_FUZZ));
+
+    m_rTop = rMinY - rSlack;
+    m_cBands = min(max(m_rgEdges.GetCount() / EDGES_PER_BAND, 1U), MAX_BANDS);
+
+    IFC(UIntMult(m_rgEdges.GetCount(), MAX_BAND_ENTRIES_PER_EDGE, &cMaxEntries));
+
+    // Choose the number of bands, halving it until the index is small enough
+    for (;;)
+    {
+        m_rBandHeight = (rMaxY + rSlack - m_rTop) / m_cBands;
+        cEntries = 0;
+
+        for (i = 0;  i < m_rgEdges.GetCount()  &&  cEntries <= cMaxEntries;  i++)
+        {
+            const GpPointR *pt = &m_rgPoints[m_rgEdges[i].uStartPoint];
+
+            cEntries += GetBand(max(pt[0].Y, pt[1].Y) + rSlack) -
+                        GetBand(min(pt[0].Y, pt[1].Y) - rSlack) + 1;
+        }
+
+        if (cEntries <= cMaxEntries  ||  m_cBands == 1)
+        {
+            break;
+        }
+
+        m_cBands /= 2;
+    }
+
+    if (!(m_rBandHeight > 0))
+    {
+        // Can only happen if the extent is too large to subdivide
+        m_cBands = 0;
+        goto Cleanup;
+    }
+
+    // Count the edges in each band, then turn the counts into start indices
+    IFC(m_rgBandStart.AddMultiple(m_cBands + 1, &pBandStart));
+    ZeroMemory(pBandStart, (m_cBands + 1) * sizeof(*pBandStart));
+
+    for (i = 0;  i < m_rgEdges.GetCount();  i++)
+    {
+        const GpPointR *pt = &m_rgPoints[m_rgEdges[i].uStartPoint];
+        UINT uLast = GetBand(max(pt[0].Y, pt[1].Y) + rSlack);
+
+        for (UINT uBand = GetBand(min(pt[0].Y, pt[1].Y) - rSlack);  uBand <= uLast;  uBand++)
+        {
+            pBandStart[uBand + 1]++;
+        }
+    }
+
+    for (i = 0;  i < m_cBands;  i++)
+    {
+        pBandStart[i + 1] += pBandStart[i];
+    }
+
+    Assert(pBandStart[m_cBands] == cEntries);
+
+    // Fill the lists, using pBandStart[i] as band i-1's insertion point
+    IFC(m_rgBandEdges.AddMultiple(cEntries, &pBandEdges));
+
+    for (i = 0;  i < m_rgEdges.GetCount();  i++)
+    {
+        const GpPointR *pt = &m_rgPoints[m_rgEdges[i].uStartPoint];
+        UINT uLast = GetBand(max(pt[0].Y, pt[1].Y) + rSlack);
+
+        for (UINT uBand = GetBand(min(pt[0].Y, pt[1].Y) - rSlack);  uBand <= uLast;  uBand++)
+        {
+            pBandEdges[pBandStart[uBand]++] = i;
+        }
+    }
+
+    // The insertion points have advanced to the next band's start; shift back
+    for (i = m_cBands;  i > 0;  i--)
+    {
+        pBandStart[i] = pBandStart[i - 1];
+    }
+    pBandStart[0] = 0;
+
+Cleanup:
+    if (FAILED(hr))
+    {
+        m_cBands = 0;
+    }
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CPreparedHitTest::HitTest
+//
+//  Synopsis:
+//      Find if a given point is in or near the fill or stroke
+//
+//  Notes:
+//      Each candidate edge goes through the same CHitTest tests as in a direct
+//      hit test, so the point is a hit if it is near any edge.  Otherwise the
+//      winding number is summed over the candidate edges: the edges left out
+//      can't cross the point's rightward ray, so they would add nothing.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CPreparedHitTest::HitTest(
+    __in_ecount(1) const MilPoint2F &ptHit,
+        // The point
+    __out_ecount(1) BOOL &fHit
+        // = TRUE if the point is in or near the fill or stroke
+    ) const
+{
+    HRESULT hr = S_OK;
+    const UINT *pCandidates = NULL;
+    UINT cCandidates = m_rgEdges.GetCount();
+    UINT uRing = 0;
+    int iWinding = 0;
+
+    fHit = FALSE;
+
+    if (m_cBands > 0  &&  !_isnan(ptHit.Y))
+    {
+        if (ptHit.Y < m_rTop  ||  ptHit.Y >= m_rTop + m_cBands * m_rBandHeight)
+        {
+            // Too far above or below all the edges
+            goto Cleanup;
+        }
+
+        UINT uBand = GetBand(ptHit.Y);
+        pCandidates = m_rgBandEdges.GetDataBuffer() + m_rgBandStart[uBand];
+        cCandidates = m_rgBandStart[uBand + 1] - m_rgBandStart[uBand];
+    }
+
+    {
+        CHitTest tester(GpPointR(ptHit), NULL, m_rThreshold);
+
+        for (UINT i = 0;  i < cCandidates;  i++)
+        {
+            const Edge &edge = m_rgEdges[pCandidates ? pCandidates[i] : i];
+
+            if (m_fStroke  &&  edge.uRing != uRing)
+            {
+                // Each piece of the stroke has its own winding number
+                if (iWinding != 0  &&  m_rgRings[uRing].fTestInside)
+                {
+                    fHit = TRUE;
+                    goto Cleanup;
+                }
+
+                iWinding = 0;
+                uRing = edge.uRing;
+            }
+
+            IFC(tester.StartAtR(m_rgPoints[edge.uStartPoint]));
+            if (tester.WasAborted())
+            {
+                fHit = TRUE;
+                goto Cleanup;
+            }
+
+            IFC(tester.DoLineR(m_rgPoints[edge.uStartPoint + 1]));
+            if (tester.WasAborted())
+            {
+                fHit = TRUE;
+                goto Cleanup;
+            }
+
+            iWinding += tester.GetWindingNumber();
+        }
+    }
+
+    if (m_fStroke)
+    {
+        fHit = (iWinding != 0  &&  m_rgRings[uRing].fTestInside);
+    }
+    else if (m_eFillMode == MilFillMode::Winding)
+    {
+        fHit = (iWinding != 0);
+    }
+    else
+    {
+        Assert(m_eFillMode == MilFillMode::Alternate);
+        fHit = ((iWinding & 1) != 0);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
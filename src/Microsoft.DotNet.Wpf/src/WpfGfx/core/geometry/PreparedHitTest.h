@@ -0,0 +1,139 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_geometry
+//      $Keywords:
+//
+//  $Description:
+//      Hit testing many points against the same shape
+//
+//  $ENDTAG
+//
+//  Classes:
+//      CPreparedHitTest
+//
+//------------------------------------------------------------------------------
+
+MtExtern(CPreparedHitTest);
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CPreparedHitTest
+//
+//  Synopsis:
+//      The fill or stroke of a shape, flattened once and indexed for hit
+//      testing many points
+//
+//  Notes:
+//      CShapeBase::HitTestFill and HitTestStroke feed the shape's boundary to a
+//      CHitTest one line segment at a time, flattening curves and widening the
+//      stroke again for every point tested.  This class records those line
+//      segments once, as rings of points:
+//
+//      - For the fill, one ring per fillable figure.  All the rings contribute
+//        to a single winding number.
+//      - For the stroke, one ring per piece that CHitTestSink tests: the
+//        quads, wedges and caps of the widened path.  Each closed piece is
+//        tested for containment on its own.
+//
+//      A point can only be near a segment, or have its rightward ray cross it,
+//      if the segment's vertical extent (grown by the threshold) contains the
+//      point.  So the segments are bucketed into horizontal bands, and a point
+//      is tested with CHitTest's own per-segment tests against the segments in
+//      its band only.  Since the recorded segments are the ones the direct hit
+//      test sees, the results agree with it up to floating point rounding.
+//
+//------------------------------------------------------------------------------
+class CPreparedHitTest
+{
+public:
+
+    DECLARE_METERHEAP_ALLOC(ProcessHeap, Mt(CPreparedHitTest));
+
+    static HRESULT Create(
+        __in_ecount(1) const CShapeBase &shape,
+            // The shape to hit test
+        __in_ecount_opt(1) const CPlainPen *pPen,
+            // Pen, hit test the stroke if not NULL
+        double rThreshold,
+            // Distance considered a hit - absolute
+        __deref_out_ecount(1) CPreparedHitTest **ppHitTest
+            // The prepared hit test
+        );
+
+    HRESULT HitTest(
+        __in_ecount(1) const MilPoint2F &ptHit,
+            // The point
+        __out_ecount(1) BOOL &fHit
+            // = TRUE if the point is in or near the fill or stroke
+        ) const;
+
+    // Recording, called while setting up
+    HRESULT StartRing(
+        __in_ecount(1) const GpPointR &pt);
+            // The ring's first point
+
+    HRESULT AddPoint(
+        __in_ecount(1) const GpPointR &pt);
+            // The ring's next point
+
+private:
+
+    CPreparedHitTest(
+        MilFillMode::Enum eFillMode,
+            // Fill mode of the shape
+        bool fStroke,
+            // True if testing the stroke
+        double rThreshold
+            // Distance considered a hit - absolute
+        );
+
+    void EndRing();
+
+    HRESULT BuildIndex();
+
+    UINT GetBand(
+        double y) const;   // The y coordinate
+
+    // Data
+private:
+
+    struct Ring
+    {
+        UINT uFirstPoint;       // Index of the ring's first point
+        UINT cPoints;           // Number of points
+        bool fTestInside;       // True if the winding number counts (stroke)
+    };
+
+    struct Edge
+    {
+        UINT uStartPoint;       // Index of the start point; the end point follows
+        UINT uRing;             // The ring the edge belongs to
+    };
+
+    MilFillMode::Enum   m_eFillMode;        // Fill mode of the shape
+    bool                m_fStroke;          // True if testing the stroke
+    double              m_rThreshold;       // Distance considered a hit
+
+    DynArray<GpPointR>  m_rgPoints;         // The rings' points
+    DynArray<Ring>      m_rgRings;          // The rings
+    DynArray<Edge>      m_rgEdges;          // The rings' edges, in ring order
+
+    // The index: m_rgBandEdges[m_rgBandStart[i] .. m_rgBandStart[i+1]) are
+    // the indices of the edges that may matter to points in band i
+    double              m_rTop;             // Top of the first band
+    double              m_rBandHeight;      // Height of each band
+    UINT                m_cBands;           // Number of bands, 0 if not indexed
+    DynArray<UINT>      m_rgBandStart;      // Start of each band's edge list
+    DynArray<UINT>      m_rgBandEdges;      // Edge indices, by band
+};
+
@@ -89,6 +89,24 @@ public:
         return false;
     }    
 
+    // Figure-parallel processing (see WidenToShape) calls GetFigure for
+    // disjoint figures from several threads.  A shape allows that by
+    // returning NULL if GetFigure keeps no traversal state, or else a copy
+    // that one worker thread can use.  The default declines with E_NOTIMPL.
+    virtual HRESULT CloneForWorkerThread(
+        __deref_out_ecount_opt(1) CShapeBase **ppShape) const
+    {
+        *ppShape = NULL;
+        return E_NOTIMPL;
+    }
+
+    // Widening of shapes with many figures on the parallel work pool.
+    // Disabled by default; enabled at startup on multiprocessor machines.
+    static VOID EnableParallelWidening(bool fEnable)
+    {
+        sm_fParallelWideningEnabled = fEnable;
+    }
+
     virtual HRESULT GetTightBounds(
         __out_ecount(1) CMilRectF &rect
         ) const
@@ -294,6 +312,17 @@ public:
             // = TRUE if the point is close to the boundary
         ) const;
 
+    HRESULT PrepareHitTest(
+        __in_ecount_opt(1) const CPlainPen *pPen,
+            // The pen, hit test the stroke if not NULL
+        IN double rThreshold,
+            // Distance considered near
+        IN bool fRelative,
+            // True if the threshold is relative
+        __deref_out_ecount(1) CPreparedHitTest **ppHitTest
+            // For hit testing many points as HitTestFill/HitTestStroke would
+        ) const;
+
     HRESULT GetRelativeTightBoundsNoBadNumber(
         __out_ecount(1) CMilRectF &rect,           // The bounds of this shape
         __in_ecount_opt(1) const CPlainPen  *pPen,    // The pen
@@ -416,6 +445,23 @@ private:
         ) const;
 
     BOOL GetPointOnShape(__out_ecount(1) MilPoint2F *point) const;
+
+    HRESULT WidenToShapeInParallel(
+        __in_ecount(1) const CPlainPen &pen,
+            // The pen
+        double rTolerance,
+            // Approximation tolerance - absolute
+        __inout_ecount(1) CShape &widened,
+            // The widened shape, populated here
+        __in_ecount_opt(1) const CMILMatrix *pMatrix,
+            // Render transform (NULL OK)
+        __in_ecount_opt(1) const CMILSurfaceRect *prcViewable,
+            // Viewable region (NULL OK)
+        __out_ecount(1) bool *pfWidened
+            // Set to false if the shape should be widened serially instead
+        ) const;
+
+    static bool sm_fParallelWideningEnabled;
 };
 
 
@@ -21,8 +21,169 @@
 
 #include "precomp.hpp"
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+#include "immintrin.h"
+#endif
+
 #pragma optimize("t", on)
 
+// The analytic flattener evaluates and emits points in batches of this many.
+static const UINT c_cAnalyticFlatteningBatch = 16;
+
+// The HFD flattener never halves its step below TWICE_MIN_BEZIER_STEP_SIZE/2,
+// which caps it at 1024 steps.  The analytic flattener uses the same cap.
+static const UINT c_cMaxAnalyticFlatteningSteps = 1024;
+
+bool CBezierFlattener::sm_fAnalyticFlatteningEnabled = false;
+
+C_ASSERT(sizeof(GpPointR) == 2 * sizeof(double));
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      EvaluateCubic
+//
+//  Synopsis:
+//      Evaluate a cubic in the power basis, and optionally its derivative, at
+//      the parameters uFirst * rStepSize, (uFirst + 1) * rStepSize, ...
+//
+//  Notes:
+//      The point is a + t(b + t(c + td)) and the derivative b + t(2c + 3td),
+//      both by Horner's rule.  EvaluateCubic_AVX2 produces identical values.
+//
+//------------------------------------------------------------------------------
+static void
+EvaluateCubic(
+    __in_ecount(4) const GpPointR *rgCoefficients,
+        // a, b, c, d
+    UINT uFirst,
+        // Index of the first parameter
+    double rStepSize,
+        // Parameter step
+    UINT cPoints,
+        // Number of points to evaluate
+    __out_ecount(cPoints) GpPointR *rgPoints,
+        // The points
+    __out_ecount_opt(cPoints) GpPointR *rgDerivatives
+        // The derivatives there (NULL OK)
+    )
+{
+    const GpPointR &a = rgCoefficients[0];
+    const GpPointR &b = rgCoefficients[1];
+    const GpPointR &c = rgCoefficients[2];
+    const GpPointR &d = rgCoefficients[3];
+
+    for (UINT i = 0;  i < cPoints;  i++)
+    {
+        double t = static_cast<double>(uFirst + i) * rStepSize;
+
+        rgPoints[i].X = a.X + t * (b.X + t * (c.X + t * d.X));
+        rgPoints[i].Y = a.Y + t * (b.Y + t * (c.Y + t * d.Y));
+
+        if (rgDerivatives)
+        {
+            rgDerivatives[i].X = b.X + t * (2 * c.X + t * (3 * d.X));
+            rgDerivatives[i].Y = b.Y + t * (2 * c.Y + t * (3 * d.Y));
+        }
+    }
+}
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      EvaluateCubic_AVX2
+//
+//  Synopsis:
+//      AVX version of EvaluateCubic, 4 parameters at a time
+//
+//------------------------------------------------------------------------------
+static void
+EvaluateCubic_AVX2(
+    __in_ecount(4) const GpPointR *rgCoefficients,
+        // a, b, c, d
+    UINT uFirst,
+        // Index of the first parameter
+    double rStepSize,
+        // Parameter step
+    UINT cPoints,
+        // Number of points to evaluate
+    __out_ecount(cPoints) GpPointR *rgPoints,
+        // The points
+    __out_ecount_opt(cPoints) GpPointR *rgDerivatives
+        // The derivatives there (NULL OK)
+    )
+{
+    const GpPointR &a = rgCoefficients[0];
+    const GpPointR &b = rgCoefficients[1];
+    const GpPointR &c = rgCoefficients[2];
+    const GpPointR &d = rgCoefficients[3];
+
+    __m256d vAX = _mm256_set1_pd(a.X);
+    __m256d vAY = _mm256_set1_pd(a.Y);
+    __m256d vBX = _mm256_set1_pd(b.X);
+    __m256d vBY = _mm256_set1_pd(b.Y);
+    __m256d vCX = _mm256_set1_pd(c.X);
+    __m256d vCY = _mm256_set1_pd(c.Y);
+    __m256d vDX = _mm256_set1_pd(d.X);
+    __m256d vDY = _mm256_set1_pd(d.Y);
+    __m256d vTwoCX = _mm256_set1_pd(2 * c.X);
+    __m256d vTwoCY = _mm256_set1_pd(2 * c.Y);
+    __m256d vThreeDX = _mm256_set1_pd(3 * d.X);
+    __m256d vThreeDY = _mm256_set1_pd(3 * d.Y);
+    __m256d vStep = _mm256_set1_pd(rStepSize);
+    __m256d vLaneIndex = _mm256_set_pd(3, 2, 1, 0);
+
+    UINT i = 0;
+
+    for (;  i + 4 <= cPoints;  i += 4)
+    {
+        __m256d vT = _mm256_mul_pd(
+            _mm256_add_pd(_mm256_set1_pd(static_cast<double>(uFirst + i)), vLaneIndex),
+            vStep
+            );
+
+        __m256d vX = _mm256_add_pd(vAX, _mm256_mul_pd(vT,
+                     _mm256_add_pd(vBX, _mm256_mul_pd(vT,
+                     _mm256_add_pd(vCX, _mm256_mul_pd(vT, vDX))))));
+        __m256d vY = _mm256_add_pd(vAY, _mm256_mul_pd(vT,
+                     _mm256_add_pd(vBY, _mm256_mul_pd(vT,
+                     _mm256_add_pd(vCY, _mm256_mul_pd(vT, vDY))))));
+
+        // Interleave to x0 y0 x1 y1 | x2 y2 x3 y3
+        __m256d vLo = _mm256_unpacklo_pd(vX, vY);
+        __m256d vHi = _mm256_unpackhi_pd(vX, vY);
+        _mm256_storeu_pd(&rgPoints[i].X, _mm256_permute2f128_pd(vLo, vHi, 0x20));
+        _mm256_storeu_pd(&rgPoints[i + 2].X, _mm256_permute2f128_pd(vLo, vHi, 0x31));
+
+        if (rgDerivatives)
+        {
+            vX = _mm256_add_pd(vBX, _mm256_mul_pd(vT,
+                 _mm256_add_pd(vTwoCX, _mm256_mul_pd(vT, vThreeDX))));
+            vY = _mm256_add_pd(vBY, _mm256_mul_pd(vT,
+                 _mm256_add_pd(vTwoCY, _mm256_mul_pd(vT, vThreeDY))));
+
+            vLo = _mm256_unpacklo_pd(vX, vY);
+            vHi = _mm256_unpackhi_pd(vX, vY);
+            _mm256_storeu_pd(&rgDerivatives[i].X, _mm256_permute2f128_pd(vLo, vHi, 0x20));
+            _mm256_storeu_pd(&rgDerivatives[i + 2].X, _mm256_permute2f128_pd(vLo, vHi, 0x31));
+        }
+    }
+
+    if (i < cPoints)
+    {
+        EvaluateCubic(
+            rgCoefficients,
+            uFirst + i,
+            rStepSize,
+            cPoints - i,
+            rgPoints + i,
+            rgDerivatives ? rgDerivatives + i : NULL
+            );
+    }
+}
+#endif
+
 
 /////////////////////////////////////////////////////////////////////////////////
 //
@@ -119,6 +280,12 @@ CBezierFlattener::Flatten(
 
     m_fWithTangents = fWithTangents;
 
+    if (sm_fAnalyticFlatteningEnabled)
+    {
+        IFC(FlattenAnalytic());
+        goto Cleanup;
+    }
+
     m_cSteps = 1;
 
     m_rParameter = 0;
@@ -173,6 +340,174 @@ CBezierFlattener::Flatten(
 Cleanup:
     RRETURN(hr);
 }
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CBezierFlattener::FlattenAnalytic
+//
+//  Synopsis:
+//      Flatten this curve with uniform steps
+//
+//  Notes:
+//      The number of steps is computed up front (see GetAnalyticStepCount),
+//      so there is no per-step halving and doubling, and the points are
+//      independent of each other.  They are evaluated directly from the power
+//      basis in batches, with AVX where available.  The sink sees the same
+//      sequence of calls as from Flatten: the interior points in order, then
+//      the last control point.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CBezierFlattener::FlattenAnalytic()
+{
+    HRESULT hr = S_OK;
+    bool fAbort = false;
+    GpPointR rgCoefficients[4];
+    GpPointR rgPoints[c_cAnalyticFlatteningBatch];
+    GpPointR rgTangents[c_cAnalyticFlatteningBatch];
+    UINT cSteps = GetAnalyticStepCount();
+    double rStepSize = 1.0 / cSteps;
+
+    // The power basis f(t) = a + bt + ct^2 + dt^3
+    rgCoefficients[0] = m_ptB[0];
+    rgCoefficients[1] = (m_ptB[1] - m_ptB[0]) * 3;
+    rgCoefficients[2] = (m_ptB[0] - m_ptB[1] * 2 + m_ptB[2]) * 3;
+    rgCoefficients[3] = m_ptB[3] - m_ptB[0] + (m_ptB[1] - m_ptB[2]) * 3;
+
+#if DBG
+    DbgAssertAnalyticFlatteningWithinTolerance(rgCoefficients, cSteps);
+#endif
+
+    for (UINT uFirst = 1;  uFirst < cSteps;  uFirst += c_cAnalyticFlatteningBatch)
+    {
+        UINT cPoints = min(c_cAnalyticFlatteningBatch, cSteps - uFirst);
+        GpPointR *pTangents = m_fWithTangents ? rgTangents : NULL;
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+        if (CCPUInfo::HasAVX2())
+        {
+            EvaluateCubic_AVX2(rgCoefficients, uFirst, rStepSize, cPoints, rgPoints, pTangents);
+        }
+        else
+#endif
+        {
+            EvaluateCubic(rgCoefficients, uFirst, rStepSize, cPoints, rgPoints, pTangents);
+        }
+
+        for (UINT i = 0;  i < cPoints;  i++)
+        {
+            if (m_fWithTangents)
+            {
+                IFC(m_pSink->AcceptPointAndTangent(rgPoints[i], rgTangents[i], false /* not the last point */));
+            }
+            else
+            {
+                IFC(m_pSink->AcceptPoint(rgPoints[i], (uFirst + i) * rStepSize, fAbort));
+                if (fAbort)
+                    goto Cleanup;
+            }
+        }
+    }
+
+    // Last point
+    if (m_fWithTangents)
+    {
+        IFC(m_pSink->AcceptPointAndTangent(m_ptB[3], GetLastTangent(), true /* last point */));
+    }
+    else
+    {
+        IFC(m_pSink->AcceptPoint(m_ptB[3], 1, fAbort));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CBezierFlattener::GetAnalyticStepCount
+//
+//  Synopsis:
+//      Get the number of uniform steps that flatten this curve within
+//      tolerance
+//
+//  Notes:
+//      Flatten keeps the approximate norms of e2 and e3 within m_rTolerance.
+//      With a step h these are f" * h^2 at the ends of the step.  f" is linear
+//      in t, so on [0,1] its approximate norm is largest at an end, where it
+//      is M = 6 max(|p0 - 2p1 + p2|, |p1 - 2p2 + p3|).  Uniform steps with
+//      M * h^2 <= m_rTolerance therefore meet the same bound everywhere, which
+//      takes ceil(sqrt(M / m_rTolerance)) steps.
+//
+//------------------------------------------------------------------------------
+UINT
+CBezierFlattener::GetAnalyticStepCount() const
+{
+    UINT cSteps = 1;
+    double rStartNorm = (m_ptB[0] - m_ptB[1] * 2 + m_ptB[2]).ApproxNorm();
+    double rEndNorm = (m_ptB[1] - m_ptB[2] * 2 + m_ptB[3]).ApproxNorm();
+    double rSteps = sqrt(6 * max(rStartNorm, rEndNorm) / m_rTolerance);
+
+    // NaNs fail the comparison and get a single step, as they do in Flatten
+    if (rSteps > 1)
+    {
+        cSteps = (rSteps < c_cMaxAnalyticFlatteningSteps) ?
+                 static_cast<UINT>(ceil(rSteps)) :
+                 c_cMaxAnalyticFlatteningSteps;
+    }
+
+    return cSteps;
+}
+
+#if DBG
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CBezierFlattener::DbgAssertAnalyticFlatteningWithinTolerance
+//
+//  Synopsis:
+//      Check that every chord of the uniform flattening is within tolerance
+//      of the curve at its parameter midpoint
+//
+//------------------------------------------------------------------------------
+void
+CBezierFlattener::DbgAssertAnalyticFlatteningWithinTolerance(
+    __in_ecount(4) const GpPointR *rgCoefficients,
+        // The curve in the power basis
+    UINT cSteps
+        // Number of uniform steps it was flattened with
+    ) const
+{
+    // Capped step counts don't promise the tolerance
+    if (cSteps >= c_cMaxAnalyticFlatteningSteps)
+    {
+        return;
+    }
+
+    // m_rTolerance is 6 times the prescribed tolerance, see Initialize
+    double rTolerance = m_rTolerance / 6;
+    double rHalfStep = 0.5 / cSteps;
+    GpPointR ptStart = m_ptB[0];
+
+    for (UINT i = 1;  i <= cSteps;  i++)
+    {
+        GpPointR ptEnd;
+        GpPointR ptMiddle;
+
+        EvaluateCubic(rgCoefficients, i, 2 * rHalfStep, 1, &ptEnd, NULL);
+        EvaluateCubic(rgCoefficients, 2 * i - 1, rHalfStep, 1, &ptMiddle, NULL);
+
+        GpPointR vecError = ptMiddle - (ptStart + ptEnd) * .5;
+        double rAllowed = rTolerance + FUZZ_DOUBLE * (1 + ptMiddle.ApproxNorm());
+
+        // Ignore NaNs
+        Assert(!(vecError.ApproxNorm() > rAllowed));
+
+        ptStart = ptEnd;
+    }
+}
+#endif
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
@@ -29,6 +29,7 @@ class CScanner;
 class CFillTessellator;
 class CTessellator;
 class CAnimationPath;
+class CPreparedHitTest;
 class CStartMarker;
 class CEndMarker;
 class CParallelogram;
@@ -59,6 +60,7 @@ class CLooseRectClip;
 #include "Tessellate.h"
 #include "cpen.h"
 #include "strokefigure.h"
+#include "PreparedHitTest.h"
 #include "LineShape.h"
 #include "bezier.h"
 #include "Area.h"
@@ -55,6 +55,13 @@ const WORD CHAIN_INHERITTED_MASK = CHAIN_REVERSED | CHAIN_SHAPE_MASK;
 
 const int MAX_VERTEX_COUNT =        0xfffe;
 
+// The active list is indexed by a search tree once it holds this many chains,
+// and the index is dropped when the list shrinks below half of that.  Below
+// that a linear walk is as fast.
+const UINT MIN_CHAINS_TO_INDEX =    32;
+
+bool CScanner::CActiveList::sm_fIndexEnabled = true;
+
 
 //  Implementation of helper classes
 
@@ -1208,6 +1215,9 @@ CScanner::CChain::Initialize(
 
     m_candidateHeapIndex = NULL_INDEX;
 
+    m_pTreeParent = m_pTreeLeft = m_pTreeRight = NULL;
+    m_uTreePriority = 0;
+
     if (MilFillMode::Winding == eFillMode)
     {
         m_pClassifyMethod = &CScanner::CChain::ClassifyWinding;
@@ -2540,8 +2550,55 @@ CScanner::CActiveList::Locate(
 {
     Assert(pNew);                        // No point inserting a null or empty chain;
     Assert(pNew->GetHead());
-        
+
     const CVertex *pNewHead = pNew->GetHead();
+    bool fIsOnChain;
+
+    if (m_pRoot)
+    {
+        fIsOnChain = LocateInTree(pNewHead, pLeft, pRight);
+
+#if DBG
+        // The chains are ordered along the sweep line, so the test is monotone
+        // and the tree must find the same location as the walk
+        CChain *pDbgLeft;
+        CChain *pDbgRight;
+        bool fDbgIsOnChain = LocateLinear(pNewHead, pDbgLeft, pDbgRight);
+
+        Assert(pDbgLeft == pLeft);
+        Assert(pDbgRight == pRight);
+        Assert(fDbgIsOnChain == fIsOnChain);
+#endif
+    }
+    else
+    {
+        fIsOnChain = LocateLinear(pNewHead, pLeft, pRight);
+    }
+
+    return fIsOnChain;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::LocateLinear
+//
+//  Synopsis:
+//      Locate a new chain's head by walking the list from the left
+//
+//  Returns:
+//      True if the head lies on pRight
+//
+//------------------------------------------------------------------------------
+bool
+CScanner::CActiveList::LocateLinear(
+    __in_ecount(1) const CVertex *pNewHead,
+        // The head of the new chain
+    __deref_out_ecount(1) CChain *&pLeft,
+        // The chain on the left of the location (possibly NULL)
+    __deref_out_ecount(1) CChain *&pRight) const
+        // The chain on the right of or at the location
+{
     bool fIsOnChain = false;
     pLeft = NULL;
     pRight = m_pLeftmost;
@@ -2561,6 +2618,57 @@ CScanner::CActiveList::Locate(
     return fIsOnChain;
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::LocateInTree
+//
+//  Synopsis:
+//      Locate a new chain's head by descending the search tree
+//
+//  Returns:
+//      True if the head lies on pRight
+//
+//  Notes:
+//      Finds the leftmost chain that doesn't have the head on its right, as
+//      LocateLinear does.  The last chain the descent passes on the left of
+//      the head is that chain's left neighbor.
+//
+//------------------------------------------------------------------------------
+bool
+CScanner::CActiveList::LocateInTree(
+    __in_ecount(1) const CVertex *pNewHead,
+        // The head of the new chain
+    __deref_out_ecount(1) CChain *&pLeft,
+        // The chain on the left of the location (possibly NULL)
+    __deref_out_ecount(1) CChain *&pRight) const
+        // The chain on the right of or at the location
+{
+    bool fIsOnChain = false;
+    CChain *pNode = m_pRoot;
+
+    pLeft = NULL;
+    pRight = NULL;
+
+    while (pNode)
+    {
+        SCANNER_LOCATION location = pNode->LocateVertex(pNewHead);
+        if (location == SCANNER_RIGHT)
+        {
+            pLeft = pNode;
+            pNode = pNode->m_pTreeRight;
+        }
+        else
+        {
+            pRight = pNode;
+            fIsOnChain = (location == SCANNER_INCIDENT);
+            pNode = pNode->m_pTreeLeft;
+        }
+    }
+
+    return fIsOnChain;
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
@@ -2596,6 +2704,29 @@ CScanner::CActiveList::Insert(
     {
         m_pLeftmost = pLeft;
     }
+
+    // Update the count and the index
+    for (CChain *pChain = pLeft;  ;  pChain = pChain->GetRight())
+    {
+        Assert(pChain);
+        m_cChains++;
+
+        if (m_pRoot)
+        {
+            InsertInTree(pChain, pPrevious, pNext);
+            pPrevious = pChain;
+        }
+
+        if (pChain == pRight)
+        {
+            break;
+        }
+    }
+
+    if (!m_pRoot  &&  sm_fIndexEnabled  &&  m_cChains >= MIN_CHAINS_TO_INDEX)
+    {
+        BuildTree();
+    }
 }
 
 //+-----------------------------------------------------------------------------
@@ -2623,6 +2754,33 @@ CScanner::CActiveList::Remove(
 
     CChain *pPrevious = pFirst->GetLeft();
     CChain *pNext = pLast->GetRight();
+    CChain *pChain;
+    UINT cRemoved = 0;
+
+    for (pChain = pFirst;  pChain != pNext;  pChain = pChain->GetRight())
+    {
+        Assert(pChain);
+        cRemoved++;
+    }
+
+    Assert(cRemoved <= m_cChains);
+    m_cChains -= cRemoved;
+
+    if (m_pRoot)
+    {
+        if (m_cChains < MIN_CHAINS_TO_INDEX / 2)
+        {
+            // Drop the index; the chains' tree links are ignored from now on
+            m_pRoot = NULL;
+        }
+        else
+        {
+            for (pChain = pFirst;  pChain != pNext;  pChain = pChain->GetRight())
+            {
+                RemoveFromTree(pChain);
+            }
+        }
+    }
 
     if (NULL == pPrevious)
     {
@@ -2642,7 +2800,305 @@ CScanner::CActiveList::Remove(
     pLast->SetRight(NULL);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::BuildTree
+//
+//  Synopsis:
+//      Build the search tree over the current list
+//
+//  Notes:
+//      The list is the in-order sequence, so this is the linear time Cartesian
+//      tree construction: each chain is added at the bottom of the right spine
+//      and climbs it past the chains of lower priority, which become its left
+//      subtree.
+//
+//------------------------------------------------------------------------------
+void
+CScanner::CActiveList::BuildTree()
+{
+    CChain *pLastAdded = NULL;
+
+    m_pRoot = NULL;
+
+    for (CChain *pChain = m_pLeftmost;  pChain;  pChain = pChain->GetRight())
+    {
+        CChain *pAbove = pLastAdded;
+        CChain *pBelow = NULL;
+
+        pChain->m_uTreePriority = NextPriority();
+
+        while (pAbove  &&  pAbove->m_uTreePriority < pChain->m_uTreePriority)
+        {
+            pBelow = pAbove;
+            pAbove = pAbove->m_pTreeParent;
+        }
+
+        pChain->m_pTreeLeft = pBelow;
+        pChain->m_pTreeRight = NULL;
+        pChain->m_pTreeParent = pAbove;
+
+        if (pBelow)
+        {
+            pBelow->m_pTreeParent = pChain;
+        }
+
+        if (pAbove)
+        {
+            pAbove->m_pTreeRight = pChain;
+        }
+        else
+        {
+            m_pRoot = pChain;
+        }
+
+        pLastAdded = pChain;
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::InsertInTree
+//
+//  Synopsis:
+//      Insert a chain in the search tree between its list neighbors
+//
+//  Notes:
+//      The new chain goes down as a leaf just after pPrevious in the in-order
+//      sequence: as its right child if it has none, otherwise as the left child
+//      of its successor pNext, which then has none.  It then rotates up to
+//      restore the heap order of the priorities.
+//
+//------------------------------------------------------------------------------
+void
+CScanner::CActiveList::InsertInTree(
+    __inout_ecount(1) CChain *pNew,
+        // The chain to insert
+    __inout_ecount_opt(1) CChain *pPrevious,
+        // Its left neighbor in the list (NULL OK)
+    __inout_ecount_opt(1) CChain *pNext)
+        // Its right neighbor in the list (NULL OK)
+{
+    pNew->m_pTreeLeft = NULL;
+    pNew->m_pTreeRight = NULL;
+    pNew->m_uTreePriority = NextPriority();
+
+    if (pPrevious  &&  !pPrevious->m_pTreeRight)
+    {
+        pPrevious->m_pTreeRight = pNew;
+        pNew->m_pTreeParent = pPrevious;
+    }
+    else if (pNext)
+    {
+        Assert(!pNext->m_pTreeLeft);
+        pNext->m_pTreeLeft = pNew;
+        pNew->m_pTreeParent = pNext;
+    }
+    else
+    {
+        Assert(!m_pRoot);
+        m_pRoot = pNew;
+        pNew->m_pTreeParent = NULL;
+    }
+
+    while (pNew->m_pTreeParent  &&
+           pNew->m_pTreeParent->m_uTreePriority < pNew->m_uTreePriority)
+    {
+        RotateUp(pNew);
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::RemoveFromTree
+//
+//  Synopsis:
+//      Remove a chain from the search tree
+//
+//  Notes:
+//      The chain rotates down below its higher priority child until it has at
+//      most one child, which then takes its place.
+//
+//------------------------------------------------------------------------------
+void
+CScanner::CActiveList::RemoveFromTree(
+    __inout_ecount(1) CChain *pChain)
+        // The chain to remove
+{
+    while (pChain->m_pTreeLeft  &&  pChain->m_pTreeRight)
+    {
+        if (pChain->m_pTreeLeft->m_uTreePriority > pChain->m_pTreeRight->m_uTreePriority)
+        {
+            RotateUp(pChain->m_pTreeLeft);
+        }
+        else
+        {
+            RotateUp(pChain->m_pTreeRight);
+        }
+    }
+
+    CChain *pChild = pChain->m_pTreeLeft ? pChain->m_pTreeLeft : pChain->m_pTreeRight;
+    CChain *pParent = pChain->m_pTreeParent;
+
+    if (pChild)
+    {
+        pChild->m_pTreeParent = pParent;
+    }
+
+    if (!pParent)
+    {
+        m_pRoot = pChild;
+    }
+    else if (pParent->m_pTreeLeft == pChain)
+    {
+        pParent->m_pTreeLeft = pChild;
+    }
+    else
+    {
+        pParent->m_pTreeRight = pChild;
+    }
+
+    pChain->m_pTreeParent = pChain->m_pTreeLeft = pChain->m_pTreeRight = NULL;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::RotateUp
+//
+//  Synopsis:
+//      Rotate a chain above its parent in the search tree, preserving the
+//      in-order sequence
+//
+//------------------------------------------------------------------------------
+void
+CScanner::CActiveList::RotateUp(
+    __inout_ecount(1) CChain *pChain)
+        // The chain to rotate above its parent
+{
+    CChain *pParent = pChain->m_pTreeParent;
+    Assert(pParent);
+
+    CChain *pGrandparent = pParent->m_pTreeParent;
+
+    if (pParent->m_pTreeLeft == pChain)
+    {
+        pParent->m_pTreeLeft = pChain->m_pTreeRight;
+        if (pChain->m_pTreeRight)
+        {
+            pChain->m_pTreeRight->m_pTreeParent = pParent;
+        }
+        pChain->m_pTreeRight = pParent;
+    }
+    else
+    {
+        Assert(pParent->m_pTreeRight == pChain);
+
+        pParent->m_pTreeRight = pChain->m_pTreeLeft;
+        if (pChain->m_pTreeLeft)
+        {
+            pChain->m_pTreeLeft->m_pTreeParent = pParent;
+        }
+        pChain->m_pTreeLeft = pParent;
+    }
+
+    pParent->m_pTreeParent = pChain;
+    pChain->m_pTreeParent = pGrandparent;
+
+    if (!pGrandparent)
+    {
+        m_pRoot = pChain;
+    }
+    else if (pGrandparent->m_pTreeLeft == pParent)
+    {
+        pGrandparent->m_pTreeLeft = pChain;
+    }
+    else
+    {
+        pGrandparent->m_pTreeRight = pChain;
+    }
+}
+
 #if DBG
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CScanner::CActiveList::ValidateTree
+//
+//  Synopsis:
+//      Check that the search tree, if any, is a heap ordered treap whose
+//      in-order sequence is the list
+//
+//  Notes:
+//      A debugging utility
+//
+//------------------------------------------------------------------------------
+void
+CScanner::CActiveList::ValidateTree() const
+{
+    UINT cChains = 0;
+
+    for (const CChain *p = m_pLeftmost;  p;  p = p->GetRight())
+    {
+        cChains++;
+    }
+    Assert(cChains == m_cChains);
+
+    if (!m_pRoot)
+    {
+        return;
+    }
+
+    Assert(!m_pRoot->m_pTreeParent);
+
+    // Start at the leftmost node of the tree
+    const CChain *pNode = m_pRoot;
+    while (pNode->m_pTreeLeft)
+    {
+        pNode = pNode->m_pTreeLeft;
+    }
+
+    for (const CChain *pChain = m_pLeftmost;  pChain;  pChain = pChain->GetRight())
+    {
+        Assert(pNode == pChain);
+        if (pNode != pChain)
+        {
+            Dump();
+            break;
+        }
+
+        if (pNode->m_pTreeParent)
+        {
+            Assert(pNode->m_pTreeParent->m_pTreeLeft == pNode  ||
+                   pNode->m_pTreeParent->m_pTreeRight == pNode);
+            Assert(pNode->m_pTreeParent->m_uTreePriority >= pNode->m_uTreePriority);
+        }
+
+        // Move to the in-order successor
+        if (pNode->m_pTreeRight)
+        {
+            pNode = pNode->m_pTreeRight;
+            while (pNode->m_pTreeLeft)
+            {
+                pNode = pNode->m_pTreeLeft;
+            }
+        }
+        else
+        {
+            while (pNode->m_pTreeParent  &&  pNode->m_pTreeParent->m_pTreeRight == pNode)
+            {
+                pNode = pNode->m_pTreeParent;
+            }
+            pNode = pNode->m_pTreeParent;
+        }
+    }
+
+    Assert(!pNode);
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
@@ -2742,6 +3198,8 @@ CScanner::CActiveList::Validate(__in_ecount(1) const CVertex *pV)  const
     CChain  *pChain;
     const CChain  *pLeft = m_pLeftmost? m_pLeftmost->GetLeft() : NULL;
 
+    ValidateTree();
+
     for (pChain = m_pLeftmost;   pChain;  pChain = pChain->GetRight())
     {
         // Validate the chain
@@ -849,6 +849,9 @@ class CVertex;
 
     class CChain
     {
+        // The active list maintains the search tree links
+        friend class CActiveList;
+
     private:
         // Disallows the copy constructor & assignment
         CChain(const CChain &)
@@ -1344,6 +1347,13 @@ class CVertex;
 
         UINT              m_candidateHeapIndex;   // Index of this chain in the candidate heap.
 
+        // Links in the active list's search tree, valid only while the active
+        // list is indexed (see CActiveList)
+        CChain            *m_pTreeParent;
+        CChain            *m_pTreeLeft;
+        CChain            *m_pTreeRight;
+        UINT              m_uTreePriority;        // Heap priority in the treap
+
         // Chains cannot have virtual functions because they are allocated by a pool allocator,
         // which cannot set a v-table pointer. The following is a substitute for virtual methods
         // for classifying, to differentiate between the 2 fill modes
@@ -1820,6 +1830,15 @@ class CVertex;
     //      Since we may have to dynamically remove entries anywhere in the
     //      list, it is implemented as a doubly linked list.
     //
+    //      When many chains are active, the list is also indexed by a treap (a
+    //      randomized balanced binary tree) whose in-order sequence is the
+    //      list.  The tree is ordered by position in the list, not by a key,
+    //      since the chains' positions along the sweep line change as it moves
+    //      while their order doesn't.  Locate descends the tree with the same
+    //      LocateVertex test as the linear walk, in O(log n) tests instead of
+    //      O(n), and Insert and Remove keep it in sync.  The list links stay
+    //      authoritative for everybody else.
+    //
     //--------------------------------------------------------------------------
     class CActiveList
     {
@@ -1828,6 +1847,14 @@ class CVertex;
         CActiveList()
         {
             m_pLeftmost = NULL;
+            m_pRoot = NULL;
+            m_cChains = 0;
+            m_uRandom = 0x2545F491;
+        }
+
+        static VOID EnableIndex(bool fEnable)
+        {
+            sm_fIndexEnabled = fEnable;
         }
 
         ~CActiveList()
@@ -1888,7 +1915,60 @@ class CVertex;
                 // The candidate list
 #endif
     protected:
+        bool LocateLinear(
+            __in_ecount(1) const CVertex *pNewHead,
+                // The head of the new chain
+            __deref_out_ecount(1) CChain *&pLeft,
+                // The chain on the left of the location
+            __deref_out_ecount(1) CChain *&pRight) const;
+                // The chain on the right of or at the location
+
+        bool LocateInTree(
+            __in_ecount(1) const CVertex *pNewHead,
+                // The head of the new chain
+            __deref_out_ecount(1) CChain *&pLeft,
+                // The chain on the left of the location
+            __deref_out_ecount(1) CChain *&pRight) const;
+                // The chain on the right of or at the location
+
+        void BuildTree();
+
+        void InsertInTree(
+            __inout_ecount(1) CChain *pNew,
+                // The chain to insert
+            __inout_ecount_opt(1) CChain *pPrevious,
+                // Its left neighbor in the list (NULL OK)
+            __inout_ecount_opt(1) CChain *pNext);
+                // Its right neighbor in the list (NULL OK)
+
+        void RemoveFromTree(
+            __inout_ecount(1) CChain *pChain);
+                // The chain to remove
+
+        void RotateUp(
+            __inout_ecount(1) CChain *pChain);
+                // The chain to rotate above its parent
+
+        UINT NextPriority()
+        {
+            // xorshift32
+            m_uRandom ^= m_uRandom << 13;
+            m_uRandom ^= m_uRandom >> 17;
+            m_uRandom ^= m_uRandom << 5;
+            return m_uRandom;
+        }
+
+#if DBG
+        void ValidateTree() const;
+#endif
+
         CChain      *m_pLeftmost;        // The leftmost active chain
+        CChain      *m_pRoot;            // The root of the search tree, NULL
+                                         // when the list is not indexed
+        UINT        m_cChains;           // The number of active chains
+        UINT        m_uRandom;           // Treap priority generator state
+
+        static bool sm_fIndexEnabled;
 
     };  // End of definition of CActiveList
 
@@ -1979,6 +2059,13 @@ public:
 
     HRESULT Scan();
 
+    // Indexing of large active lists (see CActiveList).  Enabled by default;
+    // disabling it is a debugging and benchmarking aid.
+    static VOID EnableActiveListIndex(bool fEnable)
+    {
+        CActiveList::EnableIndex(fEnable);
+    }
+
 protected:
     HRESULT 
     ConvertToInteger30(
@@ -1380,6 +1380,54 @@ CShape::AddShape(
 Cleanup:
     RRETURN(hr);
 }
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CShape::MoveFiguresFrom
+//
+//  Synopsis:
+//      Append the figures of another shape, taking ownership of them, and
+//      leave that shape empty
+//
+//  Notes:
+//      Only the other shape's embedded cached figure is copied.  The figures
+//      take this shape's fill state, exactly as if they had been added here.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CShape::MoveFiguresFrom(
+    __inout_ecount(1) CShape &shape)   // The shape to empty into this one
+{
+    HRESULT hr = S_OK;
+
+    CFigureData *pFigure = NULL;
+
+    for (UINT i = 0;  i < shape.m_rgFigures.GetCount();  i++)
+    {
+        if (shape.m_rgFigures[i] == &shape.m_oCachedFigure)
+        {
+            IFC(AddFigure(pFigure));
+
+            Assert(pFigure);  // Otherwise AddFigure should have failed
+
+            IFC(pFigure->Copy(shape.m_oCachedFigure));
+            pFigure->SetFillable(m_fFillState);
+        }
+        else
+        {
+            IFC(AddAndTakeOwnership(shape.m_rgFigures[i]));
+
+            // This shape owns the figure now
+            shape.m_rgFigures[i] = NULL;
+        }
+    }
+
+Cleanup:
+    // Figures that were not moved are deleted with the rest
+    shape.Reset();
+
+    RRETURN(hr);
+}
 
 
 //+-----------------------------------------------------------------------------
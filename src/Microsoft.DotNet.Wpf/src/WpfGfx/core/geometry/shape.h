@@ -102,6 +102,14 @@ public:
         return (1 == GetFigureCount() && GetFigure(0).IsAxisAlignedRectangle());
     }
 
+    virtual HRESULT CloneForWorkerThread(
+        __deref_out_ecount_opt(1) CShapeBase **ppShape) const
+    {
+        // GetFigure keeps no state, so workers can share this shape
+        *ppShape = NULL;
+        return S_OK;
+    }
+
     // Other methods
     HRESULT Copy(
         __in_ecount(1) const CShape &other);     // The shape to copy
@@ -236,6 +244,9 @@ public:
     HRESULT AddShape(
         __in_ecount(1) const CShape &shape);   // The shape to add
 
+    HRESULT MoveFiguresFrom(
+        __inout_ecount(1) CShape &shape);      // The shape to empty into this one
+
     HRESULT AddShapeData(
         __in_ecount(1) const IShapeData    &shape,          // The shape to add
         __in_ecount_opt(1) const CMILMatrix *pMatrix=NULL); // Transformation to apply to the input
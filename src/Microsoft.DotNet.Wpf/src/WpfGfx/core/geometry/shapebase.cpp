@@ -27,6 +27,15 @@
 
 MtDefine(CShapeBase, MILRender, "CShapeBase");
 
+// Parallel widening hands each work item a contiguous run of at least this
+// many figures, so that the cost of widening them outweighs the thread pool
+// handoff and the merge into the result.
+static const UINT c_cMinFiguresPerWideningItem = 64;
+
+static const UINT c_uWideningItemsPerThread = 2;
+
+bool CShapeBase::sm_fParallelWideningEnabled = false;
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // Implementation of CShapeBase
@@ -134,9 +143,16 @@ CShapeBase::WidenToShape(
 {
     HRESULT hr;
     double rAbsoluteTolerance;
+    bool fWidened = false;
 
     IFC(GetAbsoluteTolerance(rTolerance, fRelative, &pen, pMatrix, OUT rAbsoluteTolerance));
 
+    if (sm_fParallelWideningEnabled)
+    {
+        IFC(WidenToShapeInParallel(pen, rAbsoluteTolerance, widened, pMatrix, prcViewable, OUT &fWidened));
+    }
+
+    if (!fWidened)
     {
         CShapeWideningSink sink(widened);
         IFC(WidenToSink(pen, pMatrix, rAbsoluteTolerance, sink, prcViewable));
@@ -146,6 +162,182 @@ Cleanup:
 }
 //+-----------------------------------------------------------------------------
 //
+//  Class:
+//      CWideningWork
+//
+//  Synopsis:
+//      Widens contiguous runs of a shape's figures, each into its own shape.
+//      Every figure is widened independently of the others (dashes restart
+//      with each figure), so the runs are independent too, and appending
+//      the results in run order reproduces the serial output.
+//
+//      That relies on the workers computing in the same floating point
+//      precision as the render thread; CParallelWorkPool sets it for every
+//      item it runs.
+//
+//------------------------------------------------------------------------------
+class CWideningWork : public IParallelWorkItems
+{
+public:
+    CWideningWork(
+        __in_ecount(1) const CShapeBase *pShape,
+        __in_ecount(cItems) CShapeBase * const *rgpWorkerShapes,
+        UINT cItems,
+        __in_ecount(1) const CPlainPen &pen,
+        double rTolerance,
+        __in_ecount_opt(1) const CMILMatrix *pMatrix,
+        __in_ecount_opt(1) const CMILSurfaceRect *prcViewable,
+        __inout_ecount(cItems) CShape *rgWidened
+        )
+        : m_pen(pen)
+    {
+        m_pShape = pShape;
+        m_rgpWorkerShapes = rgpWorkerShapes;
+        m_cItems = cItems;
+        m_rTolerance = rTolerance;
+        m_pMatrix = pMatrix;
+        m_prcViewable = prcViewable;
+        m_rgWidened = rgWidened;
+    }
+
+    HRESULT Execute(UINT uItem) override
+    {
+        HRESULT hr = S_OK;
+        const CShapeBase *pShape = m_rgpWorkerShapes[uItem] ? m_rgpWorkerShapes[uItem] : m_pShape;
+        UINT cFigures = pShape->GetFigureCount();
+        UINT uFirst = static_cast<UINT>((static_cast<UINT64>(cFigures) * uItem) / m_cItems);
+        UINT uEnd = static_cast<UINT>((static_cast<UINT64>(cFigures) * (uItem + 1)) / m_cItems);
+        bool fEmpty = false;
+
+        CShapeWideningSink sink(m_rgWidened[uItem]);
+        CWidener oWidener(m_rTolerance);
+
+        IFC(oWidener.Initialize(m_pen, &sink, m_pMatrix, m_prcViewable, OUT fEmpty));
+        if (fEmpty)
+        {
+            goto Cleanup;
+        }
+
+        for (UINT i = uFirst;  i < uEnd;  i++)
+        {
+            IFC(oWidener.Widen(pShape->GetFigure(i), NULL, NULL));
+        }
+
+    Cleanup:
+        RRETURN(hr);
+    }
+
+private:
+    const CShapeBase *m_pShape;
+    CShapeBase * const *m_rgpWorkerShapes;  // Per item copies of m_pShape,
+                                            // NULL entries share m_pShape
+    UINT m_cItems;
+    const CPlainPen &m_pen;
+    double m_rTolerance;
+    const CMILMatrix *m_pMatrix;
+    const CMILSurfaceRect *m_prcViewable;
+    CShape *m_rgWidened;
+};
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CShapeBase::WidenToShapeInParallel
+//
+//  Synopsis:
+//      Widen the figures of this shape on the parallel work pool
+//
+//  Notes:
+//      Declines (*pfWidened = false) when the shape has too few figures, when
+//      the pen has line shapes, when the widening would produce nothing, or
+//      when the shape doesn't support concurrent GetFigure calls.  The caller
+//      then widens serially, which also handles the trivial cases.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CShapeBase::WidenToShapeInParallel(
+    __in_ecount(1) const CPlainPen &pen,
+        // The pen
+    double rTolerance,
+        // Approximation tolerance - absolute
+    __inout_ecount(1) CShape &widened,
+        // The widened shape, populated here
+    __in_ecount_opt(1) const CMILMatrix *pMatrix,
+        // Render transform (NULL OK)
+    __in_ecount_opt(1) const CMILSurfaceRect *prcViewable,
+        // Viewable region (NULL OK)
+    __out_ecount(1) bool *pfWidened
+        // Set to false if the shape should be widened serially instead
+    ) const
+{
+    HRESULT hr = S_OK;
+    UINT cItems = 0;
+    CShapeBase **rgpWorkerShapes = NULL;
+    CShape *rgWidened = NULL;
+
+    *pfWidened = false;
+
+    cItems = min(CParallelWorkPool::GetMaxConcurrency() * c_uWideningItemsPerThread,
+                 GetFigureCount() / c_cMinFiguresPerWideningItem);
+
+    if (cItems < 2
+        || (prcViewable && prcViewable->IsEmpty())
+        || pen.IsEmpty())
+    {
+        goto Cleanup;
+    }
+
+#ifdef LINE_SHAPES_ENABLED
+    if (pen.GetStartShape() || pen.GetEndShape())
+    {
+        // Markers are laid out by the serial widener
+        goto Cleanup;
+    }
+#endif // LINE_SHAPES_ENABLED
+
+    IFCOOM(rgpWorkerShapes = new CShapeBase *[cItems]);
+    ZeroMemory(rgpWorkerShapes, cItems * sizeof(rgpWorkerShapes[0]));
+
+    for (UINT i = 0;  i < cItems;  i++)
+    {
+        hr = CloneForWorkerThread(&rgpWorkerShapes[i]);
+        if (hr == E_NOTIMPL)
+        {
+            hr = S_OK;
+            goto Cleanup;
+        }
+        IFC(hr);
+    }
+
+    IFCOOM(rgWidened = new CShape[cItems]);
+
+    {
+        CWideningWork work(this, rgpWorkerShapes, cItems, pen, rTolerance, pMatrix, prcViewable, rgWidened);
+        IFC(CParallelWorkPool::Execute(cItems, &work));
+    }
+
+    // Append the results in figure order
+    for (UINT i = 0;  i < cItems;  i++)
+    {
+        IFC(widened.MoveFiguresFrom(rgWidened[i]));
+    }
+
+    *pfWidened = true;
+
+Cleanup:
+    if (rgpWorkerShapes)
+    {
+        for (UINT i = 0;  i < cItems;  i++)
+        {
+            delete rgpWorkerShapes[i];
+        }
+        delete [] rgpWorkerShapes;
+    }
+    delete [] rgWidened;
+
+    RRETURN(hr);
+}
+//+-----------------------------------------------------------------------------
+//
 //  Synopsis:
 //      Widen this path into a widening sink
 //
@@ -1017,7 +1209,8 @@ CShapeBase::HitTestFiguresFill(
         const IFigureData &figure = GetFigure(i); 
         if (!figure.IsEmpty()  &&  figure.IsFillable())
         {
-            if (tester.StartAt(figure.GetStartPoint()))
+            IFC(tester.StartAtR(GpPointR(figure.GetStartPoint()), false /* keep the winding */));
+            if (tester.WasAborted())
             {
                 // We have a hit near the figure's start point
                 break;
@@ -1104,6 +1297,45 @@ Cleanup:
     RRETURN(hr);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CShapeBase::PrepareHitTest
+//
+//  Synopsis:
+//      Set up for hit testing many points against the fill or stroke of this
+//      shape
+//
+//  Notes:
+//      Each point tested with the result gets the answer that HitTestFill (or
+//      HitTestStroke, with the pen) would give with the same threshold and no
+//      transformation, up to rounding, without flattening or widening the
+//      shape again.
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CShapeBase::PrepareHitTest(
+    __in_ecount_opt(1) const CPlainPen *pPen,
+        // The pen, hit test the stroke if not NULL
+    IN double rThreshold,
+        // Distance considered near
+    IN bool fRelative,
+        // True if the threshold is relative
+    __deref_out_ecount(1) CPreparedHitTest **ppHitTest
+        // For hit testing many points as HitTestFill/HitTestStroke would
+    ) const
+{
+    HRESULT hr;
+    double rAbsoluteTolerance;
+
+    IFC(GetAbsoluteTolerance(rThreshold, fRelative, NULL, NULL, OUT rAbsoluteTolerance));
+
+    IFC(CPreparedHitTest::Create(*this, pPen, rAbsoluteTolerance, ppHitTest));
+
+Cleanup:
+    RRETURN(hr);
+}
 
 //+-----------------------------------------------------------------------------
 //
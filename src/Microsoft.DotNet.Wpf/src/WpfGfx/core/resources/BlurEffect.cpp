@@ -18,11 +18,22 @@
 MtDefine(BlurEffectResource, MILRender, "BlurEffect Resource");
 MtDefine(CMilBlurEffectDuce, BlurEffectResource, "CMilBlurEffectDuce");
 MtDefine(BoxBlurLineBuffer, BlurEffectResource, "BoxBlurLineBuffer");
+MtDefine(ApproximateGaussianBlurBuffer, BlurEffectResource, "ApproximateGaussianBlurBuffer");
 
 CMilPixelShaderDuce* CMilBlurEffectDuce::s_pBlurPixelShaders[4] = { 0 };
+INIT_ONCE CMilBlurEffectDuce::s_initOncePixelShaders = INIT_ONCE_STATIC_INIT;
 
-GenerateColorsBlur CMilBlurEffectDuce::s_pfnBlurFunctionBox = NULL;
-GenerateColorsBlur CMilBlurEffectDuce::s_pfnBlurFunctionGaussian = NULL;
+GenerateColorsBlur volatile CMilBlurEffectDuce::s_pfnBlurFunctionBox = NULL;
+GenerateColorsBlur volatile CMilBlurEffectDuce::s_pfnBlurFunctionGaussian = NULL;
+
+//
+// Passed to the INIT_ONCE callbacks that create shared effect resources
+//
+struct BlurEffectStaticInitialization
+{
+    CComposition *pComposition;
+    HRESULT hr;
+};
 
 const f32x4 c_rZero = {0.0f, 0.0f, 0.0f, 0.0f};
 const u32x4 c_uZero = {0, 0, 0, 0};
@@ -114,6 +125,41 @@ HRESULT
 CMilBlurEffectDuce::Initialize()
 {
     HRESULT hr = S_OK;
+    BlurEffectStaticInitialization init = { m_pComposition, S_OK };
+
+    if (!InitOnceExecuteOnce(&s_initOncePixelShaders, &CMilBlurEffectDuce::CreatePixelShaders, &init, NULL))
+    {
+        // A failed initialization is tried again by the next effect.
+        IFC(FAILED(init.hr) ? init.hr : E_FAIL);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilBlurEffectDuce::CreatePixelShaders
+//
+// Synopsis:
+//      INIT_ONCE callback creating the blur pixel shaders shared by all
+//      effects.
+//
+//-----------------------------------------------------------------------------
+
+BOOL CALLBACK
+CMilBlurEffectDuce::CreatePixelShaders(
+    __inout PINIT_ONCE pInitOnce,
+    __inout PVOID pvParameter,
+    __deref_opt_out PVOID *ppvContext
+    )
+{
+    HRESULT hr = S_OK;
+    BlurEffectStaticInitialization *pInit = static_cast<BlurEffectStaticInitialization *>(pvParameter);
+    CComposition *pComposition = pInit->pComposition;
+
+    UNREFERENCED_PARAMETER(pInitOnce);
+    UNREFERENCED_PARAMETER(ppvContext);
 
     //
     // Map the shader byte code for the blur shader. 
@@ -122,50 +168,47 @@ CMilBlurEffectDuce::Initialize()
     CMilPixelShaderDuce* pVertical = NULL;
     CMilPixelShaderDuce* pHorizontalMulti = NULL;
     CMilPixelShaderDuce* pVerticalMulti = NULL;
+
+    //
+    // Shaders are organized as follows into the s_pShaderByteCodes array.
+    //
+    //   Position  Shader
+    //    0        Horizontal
+    //    1        Vertical
+    //    2        Horizontal multi-input
+    //    3        Vertical multi-input
     
-    if (s_pBlurPixelShaders[0] == NULL)
-    {
-        //
-        // Shaders are organized as follows into the s_pShaderByteCodes array.
-        //
-        //   Position  Shader
-        //    0        Horizontal
-        //    1        Vertical
-        //    2        Horizontal multi-input
-        //    3        Vertical multi-input
-        
-        BYTE* pShaderByteCode = NULL;
-        UINT shaderByteCodeSize = 0;
-        IFC(LockResource(PS_BlurH, &pShaderByteCode, &shaderByteCodeSize));
-        IFC(CMilPixelShaderDuce::Create(m_pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pHorizontal));
-        
-        pShaderByteCode = NULL;
-        shaderByteCodeSize = 0;
-        IFC(LockResource(PS_BlurV, &pShaderByteCode, &shaderByteCodeSize));
-        IFC(CMilPixelShaderDuce::Create(m_pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pVertical));
-        
-        pShaderByteCode = NULL;
-        shaderByteCodeSize = 0;
-        IFC(LockResource(PS_BlurHMulti, &pShaderByteCode, &shaderByteCodeSize));
-        IFC(CMilPixelShaderDuce::Create(m_pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pHorizontalMulti));
-        
-        pShaderByteCode = NULL;
-        shaderByteCodeSize = 0;
-        IFC(LockResource(PS_BlurVMulti, &pShaderByteCode, &shaderByteCodeSize));
-        IFC(CMilPixelShaderDuce::Create(m_pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pVerticalMulti));
+    BYTE* pShaderByteCode = NULL;
+    UINT shaderByteCodeSize = 0;
+    IFC(LockResource(PS_BlurH, &pShaderByteCode, &shaderByteCodeSize));
+    IFC(CMilPixelShaderDuce::Create(pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pHorizontal));
+    
+    pShaderByteCode = NULL;
+    shaderByteCodeSize = 0;
+    IFC(LockResource(PS_BlurV, &pShaderByteCode, &shaderByteCodeSize));
+    IFC(CMilPixelShaderDuce::Create(pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pVertical));
+    
+    pShaderByteCode = NULL;
+    shaderByteCodeSize = 0;
+    IFC(LockResource(PS_BlurHMulti, &pShaderByteCode, &shaderByteCodeSize));
+    IFC(CMilPixelShaderDuce::Create(pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pHorizontalMulti));
+    
+    pShaderByteCode = NULL;
+    shaderByteCodeSize = 0;
+    IFC(LockResource(PS_BlurVMulti, &pShaderByteCode, &shaderByteCodeSize));
+    IFC(CMilPixelShaderDuce::Create(pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pVerticalMulti));
 
-        s_pBlurPixelShaders[0] = pHorizontal; // Transitioning ref to static array
-        pHorizontal = NULL;
+    s_pBlurPixelShaders[0] = pHorizontal; // Transitioning ref to static array
+    pHorizontal = NULL;
 
-        s_pBlurPixelShaders[1] = pVertical; // Transitioning ref to static array
-        pVertical = NULL;
+    s_pBlurPixelShaders[1] = pVertical; // Transitioning ref to static array
+    pVertical = NULL;
 
-        s_pBlurPixelShaders[2] = pHorizontalMulti; // Transitioning ref to static array
-        pHorizontalMulti = NULL;
+    s_pBlurPixelShaders[2] = pHorizontalMulti; // Transitioning ref to static array
+    pHorizontalMulti = NULL;
 
-        s_pBlurPixelShaders[3] = pVerticalMulti; // Transitioning ref to static array
-        pVerticalMulti = NULL;
-    }
+    s_pBlurPixelShaders[3] = pVerticalMulti; // Transitioning ref to static array
+    pVerticalMulti = NULL;
         
 Cleanup:
     if (FAILED(hr))
@@ -175,7 +218,10 @@ Cleanup:
         ReleaseInterface(pHorizontalMulti);
         ReleaseInterface(pVerticalMulti);
     }
-    RRETURN(hr);
+
+    pInit->hr = hr;
+
+    return SUCCEEDED(hr);
 }
 
 
@@ -618,12 +664,33 @@ CMilBlurEffectDuce::ApplyEffectSw(
 
                 case MilKernelType::Gaussian:
                 {
-                    IFC(ApplyGaussianBlurSw(pInputBuffer,
-                                            pIntermediateBuffer,
-                                            uIntermediateWidth,
-                                            uIntermediateHeight,
-                                            radius
-                                            ));
+                    //
+                    // The exact kernel costs O(radius) per pixel. When approximation
+                    // was enabled with the EnableApproximateSwGaussianBlur switch and
+                    // quality was not requested, large radii are approximated by box
+                    // passes, which cost O(1) per pixel but don't match the exact
+                    // output.
+                    //
+                    if (g_fApproximateSwGaussianBlur &&
+                        m_data.m_RenderingBias != MilEffectRenderingBias::Quality &&
+                        radius >= MIN_APPROXIMATE_GAUSSIAN_RADIUS)
+                    {
+                        IFC(ApplyApproximateGaussianBlurSw(pInputBuffer,
+                                                           pIntermediateBuffer,
+                                                           uIntermediateWidth,
+                                                           uIntermediateHeight,
+                                                           radius
+                                                           ));
+                    }
+                    else
+                    {
+                        IFC(ApplyGaussianBlurSw(pInputBuffer,
+                                                pIntermediateBuffer,
+                                                uIntermediateWidth,
+                                                uIntermediateHeight,
+                                                radius
+                                                ));
+                    }
                 }
                 break;
 
@@ -694,6 +761,7 @@ CMilBlurEffectDuce::ApplyGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight *
                                         )
 {
     HRESULT hr = S_OK;
+    float *pGaussianWeights = NULL;
     
     if (s_pfnBlurFunctionGaussian == NULL)
     {
@@ -701,7 +769,7 @@ CMilBlurEffectDuce::ApplyGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight *
         Assert(s_pfnBlurFunctionGaussian);
     }
 
-    float *pGaussianWeights = reinterpret_cast<float*>WPFAlloc(ProcessHeap, Mt(CMilBlurEffectDuce), (sizeof(float) * (2*radius + 1)));
+    pGaussianWeights = reinterpret_cast<float*>WPFAlloc(ProcessHeap, Mt(CMilBlurEffectDuce), (sizeof(float) * (2*radius + 1)));
     IFCOOM(pGaussianWeights);
 
     CalculateGaussianSamplingWeightsFullKernel(radius, &pGaussianWeights);
@@ -731,7 +799,7 @@ CMilBlurEffectDuce::ApplyGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight *
     arguments.pGaussianWeights = pGaussianWeights;
     arguments.vertical = 1;
 
-    (*s_pfnBlurFunctionGaussian)(&arguments);
+    IFC(ExecuteBlurPass(s_pfnBlurFunctionGaussian, &arguments));
 
     // Do horizontal pass from intermediate back into source
     pPassInputBuffer = pIntermediateBuffer;
@@ -754,10 +822,501 @@ CMilBlurEffectDuce::ApplyGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight *
     arguments.pGaussianWeights = pGaussianWeights;
     arguments.vertical = 0;
 
-    (*s_pfnBlurFunctionGaussian)(&arguments);
-    
-    WPFFree(ProcessHeap, pGaussianWeights);
+    IFC(ExecuteBlurPass(s_pfnBlurFunctionGaussian, &arguments));
     
+Cleanup:
+    if (pGaussianWeights)
+    {
+        WPFFree(ProcessHeap, pGaussianWeights);
+    }
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Class:     CBlurPassBandWork
+//
+//  Synopsis:  Executes a compiled blur pass on bands of output lines.  Every
+//             output line of a pass only depends on the pass input, so the
+//             bands are independent.
+//
+//-----------------------------------------------------------------------------
+
+class CBlurPassBandWork : public IParallelWorkItems
+{
+public:
+    CBlurPassBandWork(
+        GenerateColorsBlur pfnBlurFunction,
+        __in const GenerateColorsBlurParams *pArguments,
+        UINT cLinesPerBand
+        )
+    {
+        m_pfnBlurFunction = pfnBlurFunction;
+        m_pArguments = pArguments;
+        m_cLinesPerBand = cLinesPerBand;
+    }
+
+    HRESULT Execute(UINT uBand) override
+    {
+        GenerateColorsBlurParams arguments = *m_pArguments;
+        UINT firstLine = uBand * m_cLinesPerBand;
+
+        Assert(firstLine < m_pArguments->nOutputLines);
+
+        //
+        // Source and destination advance by one line per output line in both
+        // the vertical and horizontal passes.
+        //
+        arguments.pargbSource += firstLine * arguments.sourceWidth;
+        arguments.pargbDestination += firstLine * arguments.sourceWidth;
+        arguments.nOutputLines = min(m_cLinesPerBand, m_pArguments->nOutputLines - firstLine);
+
+        (*m_pfnBlurFunction)(&arguments);
+
+        return S_OK;
+    }
+
+private:
+    GenerateColorsBlur m_pfnBlurFunction;
+    const GenerateColorsBlurParams *m_pArguments;
+    UINT m_cLinesPerBand;
+};
+
+//-----------------------------------------------------------------------------
+//
+// CMilBlurEffectDuce::ExecuteBlurPass
+//
+// Synopsis: 
+//          Executes a compiled Gaussian blur pass, splitting the output lines
+//          into bands that are processed on multiple threads when the pass is
+//          large enough.
+//-----------------------------------------------------------------------------
+HRESULT
+CMilBlurEffectDuce::ExecuteBlurPass(
+    GenerateColorsBlur pfnBlurFunction,
+    __in GenerateColorsBlurParams *pArguments
+    )
+{
+    HRESULT hr = S_OK;
+
+    // Box passes carry column sums from line to line and can't be split.
+    Assert(pArguments->pBoxBlurLineBuffer == NULL);
+
+    UINT cBands = min(pArguments->nOutputLines / MIN_LINES_PER_BLUR_BAND,
+                      2 * CParallelWorkPool::GetMaxConcurrency());
+
+    if (cBands > 1)
+    {
+        UINT cLinesPerBand = (pArguments->nOutputLines + cBands - 1) / cBands;
+        cBands = (pArguments->nOutputLines + cLinesPerBand - 1) / cLinesPerBand;
+
+        CBlurPassBandWork work(pfnBlurFunction, pArguments, cLinesPerBand);
+        IFC(CParallelWorkPool::Execute(cBands, &work));
+    }
+    else
+    {
+        (*pfnBlurFunction)(pArguments);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilBlurEffectDuce::CalculateApproximateGaussianBoxRadii
+//
+// Synopsis: 
+//          Computes the radii of APPROXIMATE_GAUSSIAN_BOX_PASSES box filters
+//          whose successive application approximates the Gaussian used for the
+//          given radius (standard deviation radius / 3).  The box widths are
+//          the two odd widths around the ideal width, mixed so that the total
+//          variance matches the Gaussian variance.  The sum of the box radii
+//          never exceeds the blur radius, so the approximation has the same
+//          footprint as the exact kernel.
+//-----------------------------------------------------------------------------
+void
+CMilBlurEffectDuce::CalculateApproximateGaussianBoxRadii(
+    UINT radius,
+    __out_ecount(APPROXIMATE_GAUSSIAN_BOX_PASSES) UINT *pBoxRadii
+    )
+{
+    const double cPasses = static_cast<double>(APPROXIMATE_GAUSSIAN_BOX_PASSES);
+    double sd = radius / 3.0;
+    double variance12 = 12.0 * sd * sd;
+
+    // A box of width w has variance (w^2 - 1) / 12.
+    UINT lowerWidth = static_cast<UINT>(floor(sqrt(variance12 / cPasses + 1.0)));
+    if (lowerWidth % 2 == 0)
+    {
+        lowerWidth--;
+    }
+    lowerWidth = max(lowerWidth, 1u);
+
+    double lowerWidthPasses =
+        (variance12 - cPasses * lowerWidth * lowerWidth - 4.0 * cPasses * lowerWidth - 3.0 * cPasses)
+        / (-4.0 * lowerWidth - 4.0);
+
+    UINT cLowerWidthPasses = static_cast<UINT>(max(0.0, floor(lowerWidthPasses + 0.5)));
+
+    UINT radiusSum = 0;
+    for (UINT i = 0; i < APPROXIMATE_GAUSSIAN_BOX_PASSES; i++)
+    {
+        UINT width = (i < cLowerWidthPasses) ? lowerWidth : lowerWidth + 2;
+        pBoxRadii[i] = (width - 1) / 2;
+        radiusSum += pBoxRadii[i];
+    }
+
+    // Keep the footprint within the radius the surface was inflated by.
+    for (UINT i = APPROXIMATE_GAUSSIAN_BOX_PASSES; radiusSum > radius; )
+    {
+        i = (i == 0) ? APPROXIMATE_GAUSSIAN_BOX_PASSES - 1 : i - 1;
+
+        if (pBoxRadii[i] > 0)
+        {
+            pBoxRadii[i]--;
+            radiusSum--;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//
+// BoxBlurSamples
+//
+// Synopsis: 
+//          Applies a box filter of the given radius along a run of cSamples
+//          samples. Each sample has cLanes independent channel values stored
+//          contiguously, so the same code filters a single row (4 lanes) or
+//          a strip of columns (4 lanes per column). Samples outside of the
+//          run are treated as zero.
+//
+//          A running sum per lane makes the cost independent of the radius.
+//-----------------------------------------------------------------------------
+static void
+BoxBlurSamples(
+    __in_ecount(cSamples * cLanes) const UINT *pInput,
+    __out_ecount(cSamples * cLanes) UINT *pOutput,
+    __out_ecount(cLanes) UINT *pSums,
+    UINT cSamples,
+    UINT cLanes,
+    UINT boxRadius
+    )
+{
+    // 16.16 reciprocal of the box width.  Rounding it down keeps the
+    // result of a box of 255s at 255.
+    UINT reciprocal = (1u << 16) / (2 * boxRadius + 1);
+
+    ZeroMemory(pSums, cLanes * sizeof(UINT));
+
+    for (UINT i = 0; i < boxRadius && i < cSamples; i++)
+    {
+        const UINT *pSample = pInput + i * cLanes;
+
+        for (UINT j = 0; j < cLanes; j++)
+        {
+            pSums[j] += pSample[j];
+        }
+    }
+
+    for (UINT i = 0; i < cSamples; i++)
+    {
+        if (i + boxRadius < cSamples)
+        {
+            const UINT *pEntering = pInput + (i + boxRadius) * cLanes;
+
+            for (UINT j = 0; j < cLanes; j++)
+            {
+                pSums[j] += pEntering[j];
+            }
+        }
+
+        UINT *pResult = pOutput + i * cLanes;
+
+        for (UINT j = 0; j < cLanes; j++)
+        {
+            pResult[j] = (pSums[j] * reciprocal + (1u << 15)) >> 16;
+        }
+
+        if (i >= boxRadius)
+        {
+            const UINT *pLeaving = pInput + (i - boxRadius) * cLanes;
+
+            for (UINT j = 0; j < cLanes; j++)
+            {
+                pSums[j] -= pLeaving[j];
+            }
+        }
+    }
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Class:     CApproximateGaussianBlurWork
+//
+//  Synopsis:  Executes one pass of the approximate Gaussian blur on strips
+//             of columns (vertical pass) or bands of rows (horizontal pass).
+//             Each work item unpacks its pixels into per-channel lanes, runs
+//             every box filter and packs the result.
+//
+//-----------------------------------------------------------------------------
+
+class CApproximateGaussianBlurWork : public IParallelWorkItems
+{
+public:
+    // Number of columns processed together by the vertical pass.
+    static const UINT c_uColumnsPerStrip = 16;
+
+    CApproximateGaussianBlurWork(
+        __in_ecount(sourceWidth * sourceHeight) const UINT *pSource,
+        __inout_ecount(sourceWidth * sourceHeight) UINT *pDestination,
+        UINT sourceWidth,
+        UINT sourceHeight,
+        UINT radius,
+        __in_ecount(cBoxPasses) const UINT *pBoxRadii,
+        UINT cBoxPasses,
+        bool fVertical,
+        UINT cLinesPerItem
+        )
+    {
+        m_pSource = pSource;
+        m_pDestination = pDestination;
+        m_sourceWidth = sourceWidth;
+        m_sourceHeight = sourceHeight;
+        m_radius = radius;
+        m_pBoxRadii = pBoxRadii;
+        m_cBoxPasses = cBoxPasses;
+        m_fVertical = fVertical;
+        m_cLinesPerItem = cLinesPerItem;
+    }
+
+    HRESULT Execute(UINT uItem) override
+    {
+        HRESULT hr = S_OK;
+        UINT *pBuffer = NULL;
+
+        //
+        // The vertical pass filters c_uColumnsPerStrip columns at once with
+        // every row a sample. The horizontal pass filters one row at a time
+        // with every column a sample.
+        //
+        UINT cSamples = m_fVertical ? m_sourceHeight : m_sourceWidth;
+        UINT firstLine = uItem * (m_fVertical ? c_uColumnsPerStrip : m_cLinesPerItem);
+        UINT cLines = m_fVertical ? m_sourceWidth : m_sourceHeight;
+        UINT cItemLines = min(m_fVertical ? c_uColumnsPerStrip : m_cLinesPerItem, cLines - firstLine);
+        UINT cLanes = 4 * (m_fVertical ? cItemLines : 1);
+
+        // Two sample buffers plus the running sums.
+        UINT cBufferElements;
+        IFC(UIntMult(cSamples, cLanes, &cBufferElements));
+        IFC(UIntMult(cBufferElements, 2, &cBufferElements));
+        IFC(UIntAdd(cBufferElements, cLanes, &cBufferElements));
+
+        UINT bufferSize;
+        IFC(UIntMult(cBufferElements, sizeof(UINT), &bufferSize));
+
+        pBuffer = static_cast<UINT *>(WPFAlloc(ProcessHeap, Mt(ApproximateGaussianBlurBuffer), bufferSize));
+        IFCOOM(pBuffer);
+
+        {
+            UINT *pSamples = pBuffer;
+            UINT *pFiltered = pBuffer + cSamples * cLanes;
+            UINT *pSums = pFiltered + cSamples * cLanes;
+
+            if (m_fVertical)
+            {
+                UnpackSamples(m_pSource + firstLine, m_sourceWidth, cSamples, cItemLines, pSamples);
+                FilterSamples(&pSamples, &pFiltered, pSums, cSamples, cLanes);
+
+                // Only lines at least radius from the edges are output.
+                PackSamples(pSamples + m_radius * cLanes,
+                            m_pDestination + m_radius * m_sourceWidth + firstLine,
+                            m_sourceWidth,
+                            m_sourceHeight - 2 * m_radius,
+                            cItemLines
+                            );
+            }
+            else
+            {
+                for (UINT line = firstLine; line < firstLine + cItemLines; line++)
+                {
+                    UnpackSamples(m_pSource + line * m_sourceWidth, 1, cSamples, 1, pSamples);
+                    FilterSamples(&pSamples, &pFiltered, pSums, cSamples, cLanes);
+
+                    PackSamples(pSamples + m_radius * cLanes,
+                                m_pDestination + line * m_sourceWidth + m_radius,
+                                1,
+                                m_sourceWidth - 2 * m_radius,
+                                1
+                                );
+                }
+            }
+        }
+
+    Cleanup:
+        if (pBuffer)
+        {
+            WPFFree(ProcessHeap, pBuffer);
+        }
+        RRETURN(hr);
+    }
+
+private:
+    //
+    // Expands cSamples groups of cPixels pixels, cSampleStride pixels
+    // apart, into one lane per channel.
+    //
+    static void UnpackSamples(
+        __in const UINT *pSource,
+        UINT cSampleStride,
+        UINT cSamples,
+        UINT cPixels,
+        __out_ecount(cSamples * cPixels * 4) UINT *pSamples
+        )
+    {
+        for (UINT i = 0; i < cSamples; i++)
+        {
+            const UINT *pPixel = pSource + i * cSampleStride;
+
+            for (UINT j = 0; j < cPixels; j++)
+            {
+                UINT argb = pPixel[j];
+
+                pSamples[0] = argb & 0xff;
+                pSamples[1] = (argb >> 8) & 0xff;
+                pSamples[2] = (argb >> 16) & 0xff;
+                pSamples[3] = argb >> 24;
+                pSamples += 4;
+            }
+        }
+    }
+
+    //
+    // Inverse of UnpackSamples.
+    //
+    static void PackSamples(
+        __in_ecount(cSamples * cPixels * 4) const UINT *pSamples,
+        __out UINT *pDestination,
+        UINT cSampleStride,
+        UINT cSamples,
+        UINT cPixels
+        )
+    {
+        for (UINT i = 0; i < cSamples; i++)
+        {
+            UINT *pPixel = pDestination + i * cSampleStride;
+
+            for (UINT j = 0; j < cPixels; j++)
+            {
+                pPixel[j] = pSamples[0]
+                          | (pSamples[1] << 8)
+                          | (pSamples[2] << 16)
+                          | (pSamples[3] << 24);
+                pSamples += 4;
+            }
+        }
+    }
+
+    //
+    // Runs every box filter, leaving the result in *ppSamples.
+    //
+    void FilterSamples(
+        __deref_inout UINT **ppSamples,
+        __deref_inout UINT **ppFiltered,
+        __inout UINT *pSums,
+        UINT cSamples,
+        UINT cLanes
+        )
+    {
+        for (UINT i = 0; i < m_cBoxPasses; i++)
+        {
+            BoxBlurSamples(*ppSamples, *ppFiltered, pSums, cSamples, cLanes, m_pBoxRadii[i]);
+
+            UINT *pTemp = *ppSamples;
+            *ppSamples = *ppFiltered;
+            *ppFiltered = pTemp;
+        }
+    }
+
+    const UINT *m_pSource;
+    UINT *m_pDestination;
+    UINT m_sourceWidth;
+    UINT m_sourceHeight;
+    UINT m_radius;
+    const UINT *m_pBoxRadii;
+    UINT m_cBoxPasses;
+    bool m_fVertical;
+    UINT m_cLinesPerItem;
+};
+
+//-----------------------------------------------------------------------------
+//
+// CMilBlurEffectDuce::ApplyApproximateGaussianBlurSw
+//
+// Synopsis: 
+//          Approximates the 2 pass Gaussian blur of ApplyGaussianBlurSw with
+//          iterated box filters of matching variance, which costs O(1) per
+//          pixel regardless of the radius. Output regions and buffer usage
+//          match ApplyGaussianBlurSw: the result is placed in
+//          pInputOutputBuffer and pIntermediateBuffer is used for staging.
+//          Both passes are split into independent strips and executed on
+//          multiple threads.
+//          Assumes that sourceWidth > 2 * radius + 1 and 
+//          sourceHeight > 2 * radius + 1
+//-----------------------------------------------------------------------------
+HRESULT
+CMilBlurEffectDuce::ApplyApproximateGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight * 4) BYTE * pInputOutputBuffer,
+                                                   __in_ecount(sourceWidth * sourceHeight * 4) BYTE * pIntermediateBuffer,
+                                                   UINT sourceWidth,
+                                                   UINT sourceHeight,
+                                                   UINT radius
+                                                   )
+{
+    HRESULT hr = S_OK;
+
+    UINT boxRadii[APPROXIMATE_GAUSSIAN_BOX_PASSES];
+    CalculateApproximateGaussianBoxRadii(radius, boxRadii);
+
+    // Clear top and bottom rows since the vertical blur pass won't fill them.
+    IFC(ClearMarginPixels(reinterpret_cast<UINT*>(pIntermediateBuffer), sourceWidth, sourceHeight, 0, radius, 0, radius));
+
+    // Do vertical pass from source into intermediate
+    {
+        CApproximateGaussianBlurWork work(reinterpret_cast<UINT *>(pInputOutputBuffer),
+                                          reinterpret_cast<UINT *>(pIntermediateBuffer),
+                                          sourceWidth,
+                                          sourceHeight,
+                                          radius,
+                                          boxRadii,
+                                          APPROXIMATE_GAUSSIAN_BOX_PASSES,
+                                          true,
+                                          0
+                                          );
+
+        UINT cStrips = (sourceWidth + CApproximateGaussianBlurWork::c_uColumnsPerStrip - 1)
+                       / CApproximateGaussianBlurWork::c_uColumnsPerStrip;
+
+        IFC(CParallelWorkPool::Execute(cStrips, &work));
+    }
+
+    // Do horizontal pass from intermediate back into source
+    {
+        CApproximateGaussianBlurWork work(reinterpret_cast<UINT *>(pIntermediateBuffer),
+                                          reinterpret_cast<UINT *>(pInputOutputBuffer),
+                                          sourceWidth,
+                                          sourceHeight,
+                                          radius,
+                                          boxRadii,
+                                          APPROXIMATE_GAUSSIAN_BOX_PASSES,
+                                          false,
+                                          MIN_LINES_PER_BLUR_BAND
+                                          );
+
+        UINT cBands = (sourceHeight + MIN_LINES_PER_BLUR_BAND - 1) / MIN_LINES_PER_BLUR_BAND;
+
+        IFC(CParallelWorkPool::Execute(cBands, &work));
+    }
+
 Cleanup:
     RRETURN(hr);
 }
@@ -1661,7 +2220,7 @@ Cleanup:
 
 
 HRESULT
-CMilBlurEffectDuce::InitializeBlurFunction(bool fGaussian, bool fColor, GenerateColorsBlur *pProgram)
+CMilBlurEffectDuce::InitializeBlurFunction(bool fGaussian, bool fColor, GenerateColorsBlur volatile *pProgram)
 {
     HRESULT hr = S_OK;
     
@@ -1675,6 +2234,14 @@ CMilBlurEffectDuce::InitializeBlurFunction(bool fGaussian, bool fColor, Generate
     IFC(CJitterAccess::Enter(sizeof(GenerateColorsBlurParams*)));
     fEnteredJitter = TRUE;
 
+    // The function is process-wide and compositions may render on several
+    // threads; another one may have compiled it while we waited for the
+    // jitter lock.
+    if (*pProgram != NULL)
+    {
+        goto Cleanup;
+    }
+
     // Disable the use of negative stack offsets.  This will likely increase generated code
     // size, but is more compatible with debugging and profiling. 
     CJitterAccess::SetMode(CJitterAccess::sc_uidUseNegativeStackOffsets, 0);
@@ -122,7 +122,7 @@ public:
         __deref_out_xcount(2*radius+1) float **ppSamplingWeights
         );
 
-    static HRESULT InitializeBlurFunction(bool fGaussian, bool fColor, GenerateColorsBlur *pProgram);
+    static HRESULT InitializeBlurFunction(bool fGaussian, bool fColor, GenerateColorsBlur volatile *pProgram);
 
     // These should probably both go in a utility class sometime.
     static HRESULT ClearMarginPixels(
@@ -212,6 +212,23 @@ private:
                                 UINT radius
                                 );
 
+    HRESULT ApplyApproximateGaussianBlurSw(__in_ecount(sourceWidth * sourceHeight * 4) BYTE * pInputOutputBuffer,
+                                           __in_ecount(sourceWidth * sourceHeight * 4) BYTE * pIntermediateBuffer,
+                                           UINT sourceWidth,
+                                           UINT sourceHeight,
+                                           UINT radius
+                                           );
+
+    static void CalculateApproximateGaussianBoxRadii(
+        UINT radius,
+        __out_ecount(APPROXIMATE_GAUSSIAN_BOX_PASSES) UINT *pBoxRadii
+        );
+
+    static HRESULT ExecuteBlurPass(
+        GenerateColorsBlur pfnBlurFunction,
+        __in GenerateColorsBlurParams *pArguments
+        );
+
     HRESULT ApplyBoxBlurSw(__in_ecount(sourceWidth * sourceHeight * 4) BYTE * pInputBuffer,
                            __in_ecount(sourceWidth * sourceHeight * 4) BYTE * pOutputBuffer,
                            UINT sourceWidth,
@@ -269,14 +286,36 @@ private:
 
     // The maximum supported radius for a blur effect.
     static const UINT MAX_RADIUS = 100;
+
+    // The smallest radius for which a software Gaussian blur with the
+    // Performance rendering bias is approximated by iterated box passes,
+    // if g_fApproximateSwGaussianBlur is set.
+    static const UINT MIN_APPROXIMATE_GAUSSIAN_RADIUS = 16;
+
+    // The number of box passes used to approximate a Gaussian blur.
+    static const UINT APPROXIMATE_GAUSSIAN_BOX_PASSES = 3;
+
+    // The minimum number of output lines in a band of a software blur pass
+    // executed on multiple threads.
+    static const UINT MIN_LINES_PER_BLUR_BAND = 32;
     
+    static BOOL CALLBACK CreatePixelShaders(
+        __inout PINIT_ONCE pInitOnce,
+        __inout PVOID pvParameter,
+        __deref_opt_out PVOID *ppvContext
+        );
+
     // Holds the pixel shader resources (a pair of horizontal and vertical, one
-    // each for single-texture input and for multi-texture input).
+    // each for single-texture input and for multi-texture input). They are
+    // shared by all compositions, which may render on different threads, so
+    // they are created once under s_initOncePixelShaders.
     static CMilPixelShaderDuce* s_pBlurPixelShaders[4];
+    static INIT_ONCE s_initOncePixelShaders;
 
-    // Holds the compiled SIMD code for the software blur and Gaussian functions
-    static GenerateColorsBlur s_pfnBlurFunctionBox;
-    static GenerateColorsBlur s_pfnBlurFunctionGaussian;
+    // Holds the compiled SIMD code for the software blur and Gaussian functions.
+    // Set under the jitter lock, see InitializeBlurFunction.
+    static GenerateColorsBlur volatile s_pfnBlurFunctionBox;
+    static GenerateColorsBlur volatile s_pfnBlurFunctionGaussian;
 
     // Column buffer required for box blur
     BYTE *m_pBoxBlurLineBuffer;
@@ -19,8 +19,18 @@ MtDefine(DropShadowEffectResource, MILRender, "DropShadowEffect Resource");
 MtDefine(CMilDropShadowEffectDuce, DropShadowEffectResource, "CMilDropShadowEffectDuce");
 
 CMilPixelShaderDuce* CMilDropShadowEffectDuce::s_pPixelShader = { 0 };
+INIT_ONCE CMilDropShadowEffectDuce::s_initOncePixelShader = INIT_ONCE_STATIC_INIT;
 
-GenerateColorsBlur CMilDropShadowEffectDuce::s_pfnBlurGaussianAndColor = NULL;
+GenerateColorsBlur volatile CMilDropShadowEffectDuce::s_pfnBlurGaussianAndColor = NULL;
+
+//
+// Passed to the INIT_ONCE callback that creates the shared pixel shader
+//
+struct DropShadowEffectStaticInitialization
+{
+    CComposition *pComposition;
+    HRESULT hr;
+};
 
 //-----------------------------------------------------------------------------
 //
@@ -43,36 +53,69 @@ HRESULT
 CMilDropShadowEffectDuce::Initialize()
 {
     HRESULT hr = S_OK;
+    DropShadowEffectStaticInitialization init = { m_pComposition, S_OK };
+
+    if (!InitOnceExecuteOnce(&s_initOncePixelShader, &CMilDropShadowEffectDuce::CreatePixelShader, &init, NULL))
+    {
+        // A failed initialization is tried again by the next effect.
+        IFC(FAILED(init.hr) ? init.hr : E_FAIL);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilDropShadowEffectDuce::CreatePixelShader
+//
+// Synopsis:
+//      INIT_ONCE callback creating the pixel shader shared by all effects.
+//
+//-----------------------------------------------------------------------------
+
+BOOL CALLBACK
+CMilDropShadowEffectDuce::CreatePixelShader(
+    __inout PINIT_ONCE pInitOnce,
+    __inout PVOID pvParameter,
+    __deref_opt_out PVOID *ppvContext
+    )
+{
+    HRESULT hr = S_OK;
+    DropShadowEffectStaticInitialization *pInit = static_cast<DropShadowEffectStaticInitialization *>(pvParameter);
+
+    UNREFERENCED_PARAMETER(pInitOnce);
+    UNREFERENCED_PARAMETER(ppvContext);
 
     //
     // Map the shader byte code for the blur shader. 
 
     CMilPixelShaderDuce* pDropShadowShader = NULL;
-    
-    if (s_pPixelShader == NULL)
-    {
-        //
-        // Shaders are organized as follows into the s_pShaderByteCodes array.
-        //
-        //   Position  Shader
-        //    0          ShadowShader
 
-        BYTE* pShaderByteCode = NULL;
-        UINT  shaderByteCodeSize = 0;
-        
-        IFC(LockResource(PS_DropShadow, &pShaderByteCode, &shaderByteCodeSize));
-        IFC(CMilPixelShaderDuce::Create(m_pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pDropShadowShader));
+    //
+    // Shaders are organized as follows into the s_pShaderByteCodes array.
+    //
+    //   Position  Shader
+    //    0          ShadowShader
 
-        s_pPixelShader = pDropShadowShader; // Transitioning ref to static pointer
-        pDropShadowShader = NULL;
-    }
+    BYTE* pShaderByteCode = NULL;
+    UINT  shaderByteCodeSize = 0;
+    
+    IFC(LockResource(PS_DropShadow, &pShaderByteCode, &shaderByteCodeSize));
+    IFC(CMilPixelShaderDuce::Create(pInit->pComposition, ShaderEffectShaderRenderMode::HardwareOnly, shaderByteCodeSize, pShaderByteCode, &pDropShadowShader));
+
+    s_pPixelShader = pDropShadowShader; // Transitioning ref to static pointer
+    pDropShadowShader = NULL;
         
 Cleanup:
     if (FAILED(hr))
     {
         ReleaseInterface(pDropShadowShader);
     }
-    RRETURN(hr);
+
+    pInit->hr = hr;
+
+    return SUCCEEDED(hr);
 }
 
 //-----------------------------------------------------------------------------
@@ -149,12 +149,21 @@ private:
 private:
     CMilDropShadowEffectDuce_Data m_data;
 
+    static BOOL CALLBACK CreatePixelShader(
+        __inout PINIT_ONCE pInitOnce,
+        __inout PVOID pvParameter,
+        __deref_opt_out PVOID *ppvContext
+        );
+
     //
-    // pointer to the pixel shader being used
+    // pointer to the pixel shader being used, shared by all compositions and
+    // created once under s_initOncePixelShader
     static CMilPixelShaderDuce* s_pPixelShader;
+    static INIT_ONCE s_initOncePixelShader;
 
-    // Holds the compiled SIMD code for the blur and color function
-    static GenerateColorsBlur s_pfnBlurGaussianAndColor;
+    // Holds the compiled SIMD code for the blur and color function. Set under
+    // the jitter lock, see CMilBlurEffectDuce::InitializeBlurFunction.
+    static GenerateColorsBlur volatile s_pfnBlurGaussianAndColor;
 
     CComposition* m_pComposition;
 };
@@ -0,0 +1,830 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//-----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//      Persistent storage for software effect code generated by the jitter.
+//
+//-----------------------------------------------------------------------------
+
+#include "precomp.hpp"
+#include <aclapi.h>
+#include <sddl.h>
+#include <shlobj.h>
+#include <wincrypt.h>
+
+MtDefine(CSwJitterCodeCache, MILRender, "CSwJitterCodeCache");
+
+extern HINSTANCE g_DllInstance;
+
+CSwJitterCodeCache *CSwJitterCodeCache::s_pCodeCache = NULL;
+
+static const UINT32 c_uSwJitterCodeCacheFileSignature = 'CJWS';
+
+// Under the user's local application data
+static const TCHAR c_szCacheParentName[] = _T("Microsoft");
+static const TCHAR c_szCacheDirectoryName[] = _T("WpfGfxJitterCache");
+
+// Holds the HMAC key, protected with DPAPI for the user
+static const TCHAR c_szSecretFileName[] = _T("cache.key");
+
+// Protected keys are a few hundred bytes
+static const DWORD c_cbMaxProtectedSecret = 4096;
+
+//+----------------------------------------------------------------------------
+//
+//  Function:  GetModuleTimeStamp
+//
+//  Synopsis:  Return the link time stamp of this module, which identifies
+//             the build of the jitter that produced cached code.
+//
+//-----------------------------------------------------------------------------
+
+static UINT32
+GetModuleTimeStamp()
+{
+    const BYTE *pModule = reinterpret_cast<const BYTE *>(g_DllInstance);
+    const IMAGE_DOS_HEADER *pDosHeader = reinterpret_cast<const IMAGE_DOS_HEADER *>(pModule);
+    const IMAGE_NT_HEADERS *pNtHeaders =
+        reinterpret_cast<const IMAGE_NT_HEADERS *>(pModule + pDosHeader->e_lfanew);
+
+    return pNtHeaders->FileHeader.TimeDateStamp;
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:  HResultFromNtStatus
+//
+//  Synopsis:  Convert a CNG status.  HRESULT_FROM_NT doesn't map success to
+//             S_OK.
+//
+//-----------------------------------------------------------------------------
+
+static HRESULT
+HResultFromNtStatus(NTSTATUS status)
+{
+    return BCRYPT_SUCCESS(status) ? S_OK : HRESULT_FROM_NT(status);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Function:  WriteFileReplacing
+//
+//  Synopsis:  Write a file under a temporary name and then rename it, so
+//             other processes never see a partial file.
+//
+//  Returns:   false if the file could not be written; the cache is best
+//             effort, so callers go on without it.
+//
+//-----------------------------------------------------------------------------
+
+static bool
+WriteFileReplacing(
+    __in PCTSTR pszPath,
+    __in_bcount(cbFirst) const void *pvFirst,
+    DWORD cbFirst,
+    __in_bcount_opt(cbSecond) const void *pvSecond,
+    DWORD cbSecond
+    )
+{
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    TCHAR szTempPath[MAX_PATH];
+    DWORD cbWritten = 0;
+    bool fFileWritten = false;
+
+    if (FAILED(StringCchPrintf(szTempPath, ARRAYSIZE(szTempPath), _T("%s.%u.tmp"), pszPath, GetCurrentProcessId())))
+    {
+        return false;
+    }
+
+    hFile = CreateFile(
+        szTempPath,
+        GENERIC_WRITE,
+        0,
+        NULL,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+        );
+
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    fFileWritten =
+           WriteFile(hFile, pvFirst, cbFirst, &cbWritten, NULL)
+        && cbWritten == cbFirst
+        && (   cbSecond == 0
+            || (   WriteFile(hFile, pvSecond, cbSecond, &cbWritten, NULL)
+                && cbWritten == cbSecond));
+
+    CloseHandle(hFile);
+
+    if (   !fFileWritten
+        || !MoveFileEx(szTempPath, pszPath, MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFile(szTempPath);
+        return false;
+    }
+
+    return true;
+}
+
+CSwJitterCodeCache::CSwJitterCodeCache()
+{
+    m_szDirectory[0] = 0;
+    m_hDirectory = INVALID_HANDLE_VALUE;
+    m_pUserSid = NULL;
+    m_hMacAlgorithm = NULL;
+    ZeroMemory(m_rgbSecret, sizeof(m_rgbSecret));
+    m_uFeatureMask = 0;
+    m_uModuleTimeStamp = 0;
+}
+
+CSwJitterCodeCache::~CSwJitterCodeCache()
+{
+    SecureZeroMemory(m_rgbSecret, sizeof(m_rgbSecret));
+
+    if (m_hMacAlgorithm)
+    {
+        BCryptCloseAlgorithmProvider(m_hMacAlgorithm, 0);
+    }
+
+    if (m_hDirectory != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hDirectory);
+    }
+
+    WPFFree(ProcessHeap, m_pUserSid);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::Initialize
+//
+//  Synopsis:  Create the process-wide cache and hand it to the jitter if the
+//             cache is enabled.  Must be called after the jitter lock is
+//             initialized.
+//
+//  Notes:     The cache stays off if its directory or key can't be set up
+//             safely.  Only running out of memory is reported.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::Initialize()
+{
+    HRESULT hr = S_OK;
+    CSwJitterCodeCache *pCodeCache = NULL;
+    DWORD dwEnable = 0;
+
+    Assert(s_pCodeCache == NULL);
+
+    {
+        // Open HKEY_CURRENT_USER\\Software\\Microsoft\\Avalon.Graphics
+        CDisplayRegKey keyGraphics(HKEY_CURRENT_USER, _T(""));
+
+        if (keyGraphics.IsValid())
+        {
+            keyGraphics.ReadDWORD(_T("EnableSwJitterCodeCache"), &dwEnable);
+        }
+    }
+
+    if (dwEnable == 0)
+    {
+        // The cache is opt-in.
+        goto Cleanup;
+    }
+
+    pCodeCache = new CSwJitterCodeCache();
+    IFCOOM(pCodeCache);
+
+    pCodeCache->m_uFeatureMask = CCPUInfo::GetFeatureMask();
+    pCodeCache->m_uModuleTimeStamp = GetModuleTimeStamp();
+
+    MIL_THR(pCodeCache->OpenDirectory());
+
+    if (SUCCEEDED(hr))
+    {
+        MIL_THR(pCodeCache->LoadSecret());
+    }
+
+    if (FAILED(hr))
+    {
+        if (hr != E_OUTOFMEMORY)
+        {
+            hr = S_OK;
+        }
+        goto Cleanup;
+    }
+
+    s_pCodeCache = pCodeCache;
+    pCodeCache = NULL;
+
+    CJitterAccess::SetCodeCache(s_pCodeCache);
+
+Cleanup:
+    delete pCodeCache;
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::DeInitialize
+//
+//  Synopsis:  Detach the cache from the jitter and release it.
+//
+//-----------------------------------------------------------------------------
+
+void
+CSwJitterCodeCache::DeInitialize()
+{
+    if (s_pCodeCache)
+    {
+        CJitterAccess::SetCodeCache(NULL);
+
+        delete s_pCodeCache;
+        s_pCodeCache = NULL;
+    }
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::OpenDirectory
+//
+//  Synopsis:  Create the cache directory under the user's local application
+//             data with access for the user and the system only, open it,
+//             and check that it is safe to use.
+//
+//  Notes:     The directory is held open without delete sharing for the life
+//             of the cache, so it can't be renamed and replaced after it has
+//             been checked.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::OpenDirectory()
+{
+    HRESULT hr = S_OK;
+    HANDLE hToken = NULL;
+    TOKEN_USER *pTokenUser = NULL;
+    DWORD cbTokenUser = 0;
+    PWSTR pszLocalAppData = NULL;
+    LPTSTR pszUserSid = NULL;
+    PSECURITY_DESCRIPTOR pSecurityDescriptor = NULL;
+    TCHAR szParent[MAX_PATH];
+    TCHAR szSDDL[256];
+    SECURITY_ATTRIBUTES sa;
+
+    //
+    // Find the user
+    //
+    IFCW32(OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken));
+
+    if (   GetTokenInformation(hToken, TokenUser, NULL, 0, &cbTokenUser)
+        || GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+    {
+        IFC(E_FAIL);
+    }
+
+    pTokenUser = static_cast<TOKEN_USER *>(WPFAlloc(ProcessHeap, Mt(CSwJitterCodeCache), cbTokenUser));
+    IFCOOM(pTokenUser);
+
+    IFCW32(GetTokenInformation(hToken, TokenUser, pTokenUser, cbTokenUser, &cbTokenUser));
+
+    {
+        DWORD cbSid = GetLengthSid(pTokenUser->User.Sid);
+
+        m_pUserSid = WPFAlloc(ProcessHeap, Mt(CSwJitterCodeCache), cbSid);
+        IFCOOM(m_pUserSid);
+
+        IFCW32(CopySid(cbSid, m_pUserSid, pTokenUser->User.Sid));
+    }
+
+    //
+    // Create the directory owned by the user, with a protected DACL so
+    // nothing is inherited from the parent
+    //
+    IFC(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &pszLocalAppData));
+
+    IFC(StringCchPrintf(szParent, ARRAYSIZE(szParent), _T("%s\\%s"), pszLocalAppData, c_szCacheParentName));
+    IFC(StringCchPrintf(m_szDirectory, ARRAYSIZE(m_szDirectory), _T("%s\\%s"), szParent, c_szCacheDirectoryName));
+
+    IFCW32(ConvertSidToStringSid(m_pUserSid, &pszUserSid));
+
+    IFC(StringCchPrintf(
+        szSDDL,
+        ARRAYSIZE(szSDDL),
+        _T("O:%sD:P(A;OICI;FA;;;%s)(A;OICI;FA;;;SY)"),
+        pszUserSid,
+        pszUserSid
+        ));
+
+    IFCW32(ConvertStringSecurityDescriptorToSecurityDescriptor(
+        szSDDL,
+        SDDL_REVISION_1,
+        &pSecurityDescriptor,
+        NULL
+        ));
+
+    sa.nLength = sizeof(sa);
+    sa.lpSecurityDescriptor = pSecurityDescriptor;
+    sa.bInheritHandle = FALSE;
+
+    // Failures, including existing directories, show up below.
+    CreateDirectory(szParent, NULL);
+    CreateDirectory(m_szDirectory, &sa);
+
+    m_hDirectory = CreateFile(
+        m_szDirectory,
+        FILE_LIST_DIRECTORY | READ_CONTROL,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT,
+        NULL
+        );
+
+    IFCW32(m_hDirectory != INVALID_HANDLE_VALUE);
+
+    // The directory may have been there already
+    IFC(CheckDirectorySecurity());
+
+Cleanup:
+    if (pSecurityDescriptor)
+    {
+        LocalFree(pSecurityDescriptor);
+    }
+
+    if (pszUserSid)
+    {
+        LocalFree(pszUserSid);
+    }
+
+    CoTaskMemFree(pszLocalAppData);
+
+    WPFFree(ProcessHeap, pTokenUser);
+
+    if (hToken)
+    {
+        CloseHandle(hToken);
+    }
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::CheckDirectorySecurity
+//
+//  Synopsis:  Fail unless the open cache directory is a real directory owned
+//             by the user, whose DACL is not inherited and allows access to
+//             no one but the user, the system and administrators.
+//
+//  Notes:     Inherit-only entries are checked too, since they apply to the
+//             files in the directory.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::CheckDirectorySecurity() const
+{
+    HRESULT hr = S_OK;
+    PSID pOwner = NULL;
+    PACL pDacl = NULL;
+    PSECURITY_DESCRIPTOR pSecurityDescriptor = NULL;
+    SECURITY_DESCRIPTOR_CONTROL control = 0;
+    DWORD dwRevision = 0;
+    BY_HANDLE_FILE_INFORMATION info;
+
+    IFCW32(GetFileInformationByHandle(m_hDirectory, &info));
+
+    if (   !(info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        || (info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+    {
+        IFC(E_ACCESSDENIED);
+    }
+
+    IFC(HRESULT_FROM_WIN32(GetSecurityInfo(
+        m_hDirectory,
+        SE_FILE_OBJECT,
+        OWNER_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION,
+        &pOwner,
+        NULL,
+        &pDacl,
+        NULL,
+        &pSecurityDescriptor
+        )));
+
+    IFCW32(GetSecurityDescriptorControl(pSecurityDescriptor, &control, &dwRevision));
+
+    if (   pOwner == NULL
+        || !EqualSid(pOwner, m_pUserSid)
+        || pDacl == NULL                    // Everyone has full access
+        || !(control & SE_DACL_PROTECTED))
+    {
+        IFC(E_ACCESSDENIED);
+    }
+
+    for (DWORD i = 0; i < pDacl->AceCount; i++)
+    {
+        ACE_HEADER *pAce = NULL;
+
+        IFCW32(GetAce(pDacl, i, reinterpret_cast<LPVOID *>(&pAce)));
+
+        if (pAce->AceType == ACCESS_DENIED_ACE_TYPE)
+        {
+            continue;
+        }
+
+        // Object and conditional entries aren't expected here
+        if (pAce->AceType != ACCESS_ALLOWED_ACE_TYPE)
+        {
+            IFC(E_ACCESSDENIED);
+        }
+
+        PSID pSid = &reinterpret_cast<ACCESS_ALLOWED_ACE *>(pAce)->SidStart;
+
+        if (   !EqualSid(pSid, m_pUserSid)
+            && !IsWellKnownSid(pSid, WinLocalSystemSid)
+            && !IsWellKnownSid(pSid, WinBuiltinAdministratorsSid))
+        {
+            IFC(E_ACCESSDENIED);
+        }
+    }
+
+Cleanup:
+    if (pSecurityDescriptor)
+    {
+        LocalFree(pSecurityDescriptor);
+    }
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::LoadSecret
+//
+//  Synopsis:  Read the HMAC key of this installation, or make one on first
+//             use.
+//
+//  Notes:     The key is protected with DPAPI, so only the user can read it
+//             and no one else can plant one.  If it can't be read, a new key
+//             replaces it; images made under the old key then fail
+//             authentication and are compiled and stored again.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::LoadSecret()
+{
+    HRESULT hr = S_OK;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    BYTE *pbProtected = NULL;
+    DWORD cbProtected = 0;
+    DATA_BLOB blobIn;
+    DATA_BLOB blobOut = { 0, NULL };
+    TCHAR szPath[MAX_PATH];
+    bool fLoaded = false;
+
+    IFC(HResultFromNtStatus(BCryptOpenAlgorithmProvider(
+        &m_hMacAlgorithm,
+        BCRYPT_SHA256_ALGORITHM,
+        NULL,
+        BCRYPT_ALG_HANDLE_HMAC_FLAG
+        )));
+
+    IFC(GetFilePath(c_szSecretFileName, szPath, ARRAYSIZE(szPath)));
+
+    pbProtected = static_cast<BYTE *>(WPFAlloc(ProcessHeap, Mt(CSwJitterCodeCache), c_cbMaxProtectedSecret));
+    IFCOOM(pbProtected);
+
+    hFile = CreateFile(
+        szPath,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        NULL
+        );
+
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        if (   ReadFile(hFile, pbProtected, c_cbMaxProtectedSecret, &cbProtected, NULL)
+            && cbProtected > 0
+            && cbProtected < c_cbMaxProtectedSecret)
+        {
+            blobIn.pbData = pbProtected;
+            blobIn.cbData = cbProtected;
+
+            if (   CryptUnprotectData(&blobIn, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &blobOut)
+                && blobOut.cbData == c_cbSecret)
+            {
+                memcpy(m_rgbSecret, blobOut.pbData, c_cbSecret);
+                fLoaded = true;
+            }
+        }
+
+        CloseHandle(hFile);
+        hFile = INVALID_HANDLE_VALUE;
+    }
+
+    if (blobOut.pbData)
+    {
+        SecureZeroMemory(blobOut.pbData, blobOut.cbData);
+        LocalFree(blobOut.pbData);
+        blobOut.pbData = NULL;
+    }
+
+    if (!fLoaded)
+    {
+        IFC(HResultFromNtStatus(BCryptGenRandom(
+            NULL,
+            m_rgbSecret,
+            c_cbSecret,
+            BCRYPT_USE_SYSTEM_PREFERRED_RNG
+            )));
+
+        blobIn.pbData = m_rgbSecret;
+        blobIn.cbData = c_cbSecret;
+
+        IFCW32(CryptProtectData(&blobIn, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &blobOut));
+
+        // Another process may be doing the same; the last key written wins
+        // and images stored under the others are replaced over time.
+        if (!WriteFileReplacing(szPath, blobOut.pbData, blobOut.cbData, NULL, 0))
+        {
+            IFC(E_FAIL);
+        }
+    }
+
+Cleanup:
+    if (blobOut.pbData)
+    {
+        LocalFree(blobOut.pbData);
+    }
+
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(hFile);
+    }
+
+    WPFFree(ProcessHeap, pbProtected);
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::GetFilePath
+//
+//  Synopsis:  Compose the name of a file in the cache directory.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::GetFilePath(
+    __in PCTSTR pszName,
+    __out_ecount(cchPath) PTSTR pszPath,
+    size_t cchPath
+    ) const
+{
+    RRETURN(StringCchPrintf(
+        pszPath,
+        cchPath,
+        _T("%s\\%s"),
+        m_szDirectory,
+        pszName
+        ));
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::GetImagePath
+//
+//  Synopsis:  Compose the name of the file holding the image for given key.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::GetImagePath(
+    UINT64 ullKey,
+    __out_ecount(cchPath) PTSTR pszPath,
+    size_t cchPath
+    ) const
+{
+    RRETURN(StringCchPrintf(
+        pszPath,
+        cchPath,
+        _T("%s\\%02x_%016I64x.fxjc"),
+        m_szDirectory,
+        m_uFeatureMask,
+        ullKey
+        ));
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::ComputeMac
+//
+//  Synopsis:  HMAC-SHA256 of a file header, up to the MAC, and the image.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CSwJitterCodeCache::ComputeMac(
+    __in const FileHeader &header,
+    __in_bcount(cbImage) UINT8 const *pImage,
+    UINT32 cbImage,
+    __out_bcount(c_cbMac) BYTE *pbMac
+    ) const
+{
+    HRESULT hr = S_OK;
+    BCRYPT_HASH_HANDLE hHash = NULL;
+
+    IFC(HResultFromNtStatus(BCryptCreateHash(
+        m_hMacAlgorithm,
+        &hHash,
+        NULL,
+        0,
+        const_cast<PUCHAR>(m_rgbSecret),
+        c_cbSecret,
+        0
+        )));
+
+    IFC(HResultFromNtStatus(BCryptHashData(
+        hHash,
+        reinterpret_cast<PUCHAR>(const_cast<FileHeader *>(&header)),
+        offsetof(FileHeader, rgbMac),
+        0
+        )));
+
+    IFC(HResultFromNtStatus(BCryptHashData(
+        hHash,
+        const_cast<PUCHAR>(pImage),
+        cbImage,
+        0
+        )));
+
+    IFC(HResultFromNtStatus(BCryptFinishHash(hHash, pbMac, c_cbMac, 0)));
+
+Cleanup:
+    if (hHash)
+    {
+        BCryptDestroyHash(hHash);
+    }
+
+    RRETURN(hr);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::LoadImage
+//
+//  Synopsis:  Read the image for given key.
+//
+//  Returns:   S_FALSE if there is no authentic file for the key.
+//
+//-----------------------------------------------------------------------------
+
+__checkReturn HRESULT
+CSwJitterCodeCache::LoadImage(
+    UINT64 ullKey,
+    __deref_out_bcount(*pcbImage) UINT8 **ppImage,
+    __out UINT32 *pcbImage
+    )
+{
+    HRESULT hr = S_OK;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    UINT8 *pImage = NULL;
+    TCHAR szPath[MAX_PATH];
+    FileHeader header;
+    BYTE rgbMac[c_cbMac];
+    BYTE bDifference = 0;
+    DWORD cbRead = 0;
+
+    *ppImage = NULL;
+    *pcbImage = 0;
+
+    IFC(GetImagePath(ullKey, szPath, ARRAYSIZE(szPath)));
+
+    hFile = CreateFile(
+        szPath,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL
+        );
+
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        hr = S_FALSE;
+        goto Cleanup;
+    }
+
+    if (   !ReadFile(hFile, &header, sizeof(header), &cbRead, NULL)
+        || cbRead != sizeof(header)
+        || header.uSignature != c_uSwJitterCodeCacheFileSignature
+        || header.uFeatureMask != m_uFeatureMask
+        || header.uModuleTimeStamp != m_uModuleTimeStamp
+        || header.ullKey != ullKey
+        || header.cbImage == 0
+        || header.cbImage > c_cbMaxImage)
+    {
+        hr = S_FALSE;
+        goto Cleanup;
+    }
+
+    pImage = static_cast<UINT8 *>(WarpPlatform::AllocateMemory(header.cbImage));
+    IFCOOM(pImage);
+
+    if (   !ReadFile(hFile, pImage, header.cbImage, &cbRead, NULL)
+        || cbRead != header.cbImage)
+    {
+        hr = S_FALSE;
+        goto Cleanup;
+    }
+
+    IFC(ComputeMac(header, pImage, header.cbImage, rgbMac));
+
+    for (UINT32 i = 0; i < c_cbMac; i++)
+    {
+        bDifference |= rgbMac[i] ^ header.rgbMac[i];
+    }
+
+    if (bDifference != 0)
+    {
+        // Not written by us under the current key
+        hr = S_FALSE;
+        goto Cleanup;
+    }
+
+    *ppImage = pImage;
+    *pcbImage = header.cbImage;
+    pImage = NULL;
+
+Cleanup:
+    if (pImage)
+    {
+        WarpPlatform::FreeMemory(pImage);
+    }
+
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(hFile);
+    }
+
+    RRETURN1(hr, S_FALSE);
+}
+
+//+----------------------------------------------------------------------------
+//
+//  Member:    CSwJitterCodeCache::StoreImage
+//
+//  Synopsis:  Write the image for given key with its MAC.
+//
+//-----------------------------------------------------------------------------
+
+void
+CSwJitterCodeCache::StoreImage(
+    UINT64 ullKey,
+    __in_bcount(cbImage) UINT8 const *pImage,
+    UINT32 cbImage
+    )
+{
+    HRESULT hr = S_OK;
+    TCHAR szPath[MAX_PATH];
+    FileHeader header;
+
+    if (cbImage == 0 || cbImage > c_cbMaxImage)
+    {
+        goto Cleanup;
+    }
+
+    IFC(GetImagePath(ullKey, szPath, ARRAYSIZE(szPath)));
+
+    header.uSignature = c_uSwJitterCodeCacheFileSignature;
+    header.uFeatureMask = m_uFeatureMask;
+    header.uModuleTimeStamp = m_uModuleTimeStamp;
+    header.cbImage = cbImage;
+    header.ullKey = ullKey;
+
+    IFC(ComputeMac(header, pImage, cbImage, header.rgbMac));
+
+    WriteFileReplacing(szPath, &header, sizeof(header), pImage, cbImage);
+
+Cleanup:
+    // The cache is best effort; the caller already has the code.
+    IGNORE_HR(hr);
+}
@@ -0,0 +1,113 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//-----------------------------------------------------------------------------
+//
+
+//
+//  Description:
+//      Persistent storage for software effect code generated by the jitter.
+//
+//-----------------------------------------------------------------------------
+
+MtExtern(CSwJitterCodeCache);
+
+//+----------------------------------------------------------------------------
+//
+//  Class:     CSwJitterCodeCache
+//
+//  Synopsis:  Keeps jitter code images in files so that blur kernels and
+//             software pixel shaders compiled by one process can be reused
+//             by later ones.
+//
+//             The cache is opt-in: it is enabled by the EnableSwJitterCodeCache
+//             registry value.  Images become executable code, so they are
+//             only kept in a directory under the user's local application
+//             data that is owned by the user and that no one else may write
+//             to, and each file is authenticated with an HMAC under a key
+//             known only to the user.  Files are also keyed by the processor
+//             features, and are ignored unless written by the same build of
+//             this module.
+//
+//-----------------------------------------------------------------------------
+
+class CSwJitterCodeCache : public IJitterCodeCache
+{
+public:
+    DECLARE_METERHEAP_ALLOC(ProcessHeap, Mt(CSwJitterCodeCache));
+
+    static HRESULT Initialize();
+    static void DeInitialize();
+
+    override __checkReturn HRESULT LoadImage(
+        UINT64 ullKey,
+        __deref_out_bcount(*pcbImage) UINT8 **ppImage,
+        __out UINT32 *pcbImage
+        );
+
+    override void StoreImage(
+        UINT64 ullKey,
+        __in_bcount(cbImage) UINT8 const *pImage,
+        UINT32 cbImage
+        );
+
+private:
+    CSwJitterCodeCache();
+    ~CSwJitterCodeCache();
+
+    HRESULT OpenDirectory();
+
+    HRESULT CheckDirectorySecurity() const;
+
+    HRESULT LoadSecret();
+
+    HRESULT GetFilePath(
+        __in PCTSTR pszName,
+        __out_ecount(cchPath) PTSTR pszPath,
+        size_t cchPath
+        ) const;
+
+    HRESULT GetImagePath(
+        UINT64 ullKey,
+        __out_ecount(cchPath) PTSTR pszPath,
+        size_t cchPath
+        ) const;
+
+    static const UINT32 c_cbMac = 32;       // HMAC-SHA256
+    static const UINT32 c_cbSecret = 32;
+
+    struct FileHeader
+    {
+        UINT32 uSignature;
+        UINT32 uFeatureMask;
+        UINT32 uModuleTimeStamp;
+        UINT32 cbImage;
+        UINT64 ullKey;
+        BYTE rgbMac[c_cbMac];       // Of the header up to here and the image
+    };
+
+    HRESULT ComputeMac(
+        __in const FileHeader &header,
+        __in_bcount(cbImage) UINT8 const *pImage,
+        UINT32 cbImage,
+        __out_bcount(c_cbMac) BYTE *pbMac
+        ) const;
+
+    // Images above this size are not expected and are treated as corrupt.
+    static const UINT32 c_cbMaxImage = 1024 * 1024;
+
+    TCHAR m_szDirectory[MAX_PATH];
+    HANDLE m_hDirectory;            // Held open so the directory can't be
+                                    // renamed or replaced while in use
+    PSID m_pUserSid;
+
+    BCRYPT_ALG_HANDLE m_hMacAlgorithm;
+    BYTE m_rgbSecret[c_cbSecret];
+
+    UINT m_uFeatureMask;
+    UINT32 m_uModuleTimeStamp;
+
+    static CSwJitterCodeCache *s_pCodeCache;
+};
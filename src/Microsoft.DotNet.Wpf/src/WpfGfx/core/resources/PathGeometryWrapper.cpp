@@ -1454,6 +1454,33 @@ void PathGeometryData::SetPathData(
     m_pCurFigure = GetFirstFigure();
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      PathGeometryData::CloneForWorkerThread
+//
+//  Synopsis:
+//      Create another view of the same path data.  GetFigure moves the
+//      figure cursor of this object, so each worker thread needs its own.
+//
+//------------------------------------------------------------------------------
+HRESULT
+PathGeometryData::CloneForWorkerThread(
+    __deref_out_ecount_opt(1) CShapeBase **ppShape
+    ) const
+{
+    HRESULT hr = S_OK;
+    PathGeometryData *pClone = NULL;
+
+    IFCOOM(pClone = new PathGeometryData);
+    pClone->SetPathData(m_pPath, m_nSize, m_fillRule, m_pMatrix);
+
+    *ppShape = pClone;
+
+Cleanup:
+    RRETURN(hr);
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
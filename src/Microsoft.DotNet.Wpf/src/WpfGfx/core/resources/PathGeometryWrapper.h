@@ -197,6 +197,9 @@ public:
         return (m_pPath->Flags & MilPathGeometryFlags::IsRegionData) != 0;
     }
 
+    virtual HRESULT CloneForWorkerThread(
+        __deref_out_ecount_opt(1) CShapeBase **ppShape) const;
+
     // Other methods
     bool NextFigure() const;
     bool PrevFigure() const;
@@ -24,6 +24,11 @@ extern HINSTANCE g_DllInstance;
 BYTE* CMilPixelShaderDuce::m_pPassThroughShaderBytecodeData;
 UINT  CMilPixelShaderDuce::m_cbPassThroughShaderBytecodeSize;
 
+CCriticalSection CMilPixelShaderDuce::s_csSwPixelShaderCache;
+DynArray<CMilPixelShaderDuce::SwPixelShaderCacheEntry> CMilPixelShaderDuce::s_rgSwPixelShaderCache;
+UINT CMilPixelShaderDuce::s_cSwPixelShaderCacheHits;
+UINT CMilPixelShaderDuce::s_cSwPixelShaderCacheMisses;
+
 //-----------------------------------------------------------------------------
 //
 // CMilPixelShaderDuce::Create
@@ -103,7 +108,7 @@ Cleanup:
 
 CMilPixelShaderDuce::~CMilPixelShaderDuce()
 {
-    ReleaseInterface(m_pSwPixelShaderCompiler);
+    ReleaseSwPixelShader();
     delete m_hwPixelShaderEffectCache;
     UnRegisterNotifiers();
 }
@@ -299,7 +304,7 @@ CMilPixelShaderDuce::GetSwPixelShader(__deref_out CPixelShaderCompiler **ppPixel
 
         if (m_data.m_cbPixelShaderBytecodeSize != 0)
         {
-            hr = CPixelShaderCompiler::Create(m_data.m_pPixelShaderBytecodeData, m_data.m_cbPixelShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler);
+            hr = AcquireCachedSwPixelShader(m_data.m_pPixelShaderBytecodeData, m_data.m_cbPixelShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler);
 
             if (FAILED(hr))
             {
@@ -313,7 +318,7 @@ CMilPixelShaderDuce::GetSwPixelShader(__deref_out CPixelShaderCompiler **ppPixel
  
                 // Use pass through shader instead.
                 IFC(EnsurePassThroughShaderResourceRead());
-                IFC(CPixelShaderCompiler::Create(reinterpret_cast<void *>(m_pPassThroughShaderBytecodeData), m_cbPassThroughShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler));
+                IFC(AcquireCachedSwPixelShader(reinterpret_cast<void *>(m_pPassThroughShaderBytecodeData), m_cbPassThroughShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler));
 
                 //
                 // Ignore the hardware shader set in m_data.
@@ -327,7 +332,7 @@ CMilPixelShaderDuce::GetSwPixelShader(__deref_out CPixelShaderCompiler **ppPixel
         {
             // If the user code did not send us a shader, treat it as a pass through or identity shader.
             IFC(EnsurePassThroughShaderResourceRead());
-            IFC(CPixelShaderCompiler::Create(reinterpret_cast<void *>(m_pPassThroughShaderBytecodeData), m_cbPassThroughShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler));
+            IFC(AcquireCachedSwPixelShader(reinterpret_cast<void *>(m_pPassThroughShaderBytecodeData), m_cbPassThroughShaderBytecodeSize, OUT &m_pSwPixelShaderCompiler));
         }
     }
 
@@ -338,6 +343,230 @@ Cleanup:
     RRETURN(hr);
 }
 
+//-----------------------------------------------------------------------------
+//
+// CMilPixelShaderDuce::ReleaseSwPixelShader
+//
+// Synopsis: 
+//    Drops this resource's use of its cached software pixel shader.
+//
+//-----------------------------------------------------------------------------
+
+void
+CMilPixelShaderDuce::ReleaseSwPixelShader()
+{
+    if (m_pSwPixelShaderCompiler != NULL)
+    {
+        ReleaseCachedSwPixelShader(m_pSwPixelShaderCompiler);
+        ReleaseInterface(m_pSwPixelShaderCompiler);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilPixelShaderDuce::InitializeSwPixelShaderCache
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CMilPixelShaderDuce::InitializeSwPixelShaderCache()
+{
+    RRETURN(s_csSwPixelShaderCache.Init());
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilPixelShaderDuce::DeInitializeSwPixelShaderCache
+//
+// Synopsis: 
+//    Releases any entries still in the cache. All resources should have
+//    released their shaders by now.
+//
+//-----------------------------------------------------------------------------
+
+void
+CMilPixelShaderDuce::DeInitializeSwPixelShaderCache()
+{
+    for (UINT i = 0; i < s_rgSwPixelShaderCache.GetCount(); i++)
+    {
+        ReleaseInterface(s_rgSwPixelShaderCache[i].pCompiler);
+        WPFFree(ProcessHeap, s_rgSwPixelShaderCache[i].pBytecode);
+    }
+    s_rgSwPixelShaderCache.Reset();
+
+    s_csSwPixelShaderCache.DeInit();
+}
+
+//-----------------------------------------------------------------------------
+//
+// HashSwPixelShaderBytecode
+//
+// Synopsis: 
+//    FNV-1a hash of the shader bytecode, used to find cache candidates
+//    before comparing the full bytecode.
+//
+//-----------------------------------------------------------------------------
+
+static UINT
+HashSwPixelShaderBytecode(
+    __in_bcount(cbBytecodeSize) const BYTE *pBytecode,
+    UINT cbBytecodeSize
+    )
+{
+    UINT uHash = 2166136261u;
+
+    for (UINT i = 0; i < cbBytecodeSize; i++)
+    {
+        uHash ^= pBytecode[i];
+        uHash *= 16777619u;
+    }
+
+    return uHash;
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilPixelShaderDuce::AcquireCachedSwPixelShader
+//
+// Synopsis: 
+//    Returns the compiled software pixel shader for the bytecode, compiling
+//    it only if no other resource has already done so. The caller becomes a
+//    user of the cache entry and must call ReleaseCachedSwPixelShader in
+//    addition to releasing the returned reference.
+//
+//    Lookups are reported through the SwPixelShaderCacheLookup ETW event.
+//
+//-----------------------------------------------------------------------------
+
+HRESULT
+CMilPixelShaderDuce::AcquireCachedSwPixelShader(
+    __in_bcount(cbBytecodeSize) void *pBytecode,
+    UINT cbBytecodeSize,
+    __deref_out CPixelShaderCompiler **ppPixelShaderCompiler
+    )
+{
+    HRESULT hr = S_OK;
+    CPixelShaderCompiler *pCompiler = NULL;
+    BYTE *pBytecodeCopy = NULL;
+    UINT uHash = HashSwPixelShaderBytecode(static_cast<BYTE *>(pBytecode), cbBytecodeSize);
+    bool fHit = false;
+
+    CGuard<CCriticalSection> guard(s_csSwPixelShaderCache);
+
+    for (UINT i = 0; i < s_rgSwPixelShaderCache.GetCount(); i++)
+    {
+        SwPixelShaderCacheEntry &entry = s_rgSwPixelShaderCache[i];
+
+        if (   entry.uHash == uHash
+            && entry.cbBytecodeSize == cbBytecodeSize
+            && memcmp(entry.pBytecode, pBytecode, cbBytecodeSize) == 0
+           )
+        {
+            entry.cUsers++;
+            pCompiler = entry.pCompiler;
+            pCompiler->AddRef();
+            fHit = true;
+            break;
+        }
+    }
+
+    if (fHit)
+    {
+        s_cSwPixelShaderCacheHits++;
+    }
+    else
+    {
+        s_cSwPixelShaderCacheMisses++;
+
+        //
+        // Compile while holding the lock so that resources created together
+        // with the same bytecode don't all compile it.
+        //
+        IFC(CPixelShaderCompiler::Create(pBytecode, cbBytecodeSize, OUT &pCompiler));
+
+        IFC(HrAlloc(
+            Mt(CMilPixelShaderDuce),
+            cbBytecodeSize,
+            reinterpret_cast<void**>(&pBytecodeCopy)
+            ));
+
+        RtlCopyMemory(pBytecodeCopy, pBytecode, cbBytecodeSize);
+
+        SwPixelShaderCacheEntry entry;
+        entry.uHash = uHash;
+        entry.cbBytecodeSize = cbBytecodeSize;
+        entry.pBytecode = pBytecodeCopy;
+        entry.pCompiler = pCompiler;
+        entry.cUsers = 1;
+
+        IFC(s_rgSwPixelShaderCache.Add(entry));
+
+        // The cache holds its own reference.
+        pCompiler->AddRef();
+        pBytecodeCopy = NULL;
+    }
+
+    EventWriteSwPixelShaderCacheLookup(
+        fHit ? 1 : 0,
+        s_cSwPixelShaderCacheHits,
+        s_cSwPixelShaderCacheMisses,
+        s_rgSwPixelShaderCache.GetCount()
+        );
+
+    *ppPixelShaderCompiler = pCompiler;  // Transitioning ref to out argument
+    pCompiler = NULL;
+
+Cleanup:
+    ReleaseInterface(pCompiler);
+
+    if (pBytecodeCopy)
+    {
+        WPFFree(ProcessHeap, pBytecodeCopy);
+    }
+
+    RRETURN(hr);
+}
+
+//-----------------------------------------------------------------------------
+//
+// CMilPixelShaderDuce::ReleaseCachedSwPixelShader
+//
+// Synopsis: 
+//    Ends one use of a shader returned by AcquireCachedSwPixelShader. The
+//    last use removes the shader from the cache.
+//
+//-----------------------------------------------------------------------------
+
+void
+CMilPixelShaderDuce::ReleaseCachedSwPixelShader(
+    __in CPixelShaderCompiler *pPixelShaderCompiler
+    )
+{
+    CGuard<CCriticalSection> guard(s_csSwPixelShaderCache);
+
+    for (UINT i = 0; i < s_rgSwPixelShaderCache.GetCount(); i++)
+    {
+        SwPixelShaderCacheEntry &entry = s_rgSwPixelShaderCache[i];
+
+        if (entry.pCompiler == pPixelShaderCompiler)
+        {
+            Assert(entry.cUsers > 0);
+
+            if (--entry.cUsers == 0)
+            {
+                ReleaseInterface(entry.pCompiler);
+                WPFFree(ProcessHeap, entry.pBytecode);
+
+                IGNORE_HR(s_rgSwPixelShaderCache.RemoveAtOrderNotPreserved(i));
+            }
+
+            return;
+        }
+    }
+
+    AssertMsg(false, "Software pixel shader not found in cache");
+}
+
 //-----------------------------------------------------------------------------
 //
 // CMilPixelShaderDuce::OnChanged
@@ -350,7 +579,7 @@ CMilPixelShaderDuce::OnChanged(
     NotificationEventArgs::Flags e
     )
 {
-    ReleaseInterface(m_pSwPixelShaderCompiler);
+    ReleaseSwPixelShader();
 
     // Delete hw cache... will force recreation of a hwshader next time
     // requested. 
@@ -75,6 +75,10 @@ public:
 
     byte GetShaderMajorVersion();
 
+    // These two methods should only be called at DLL load/unload
+    static HRESULT InitializeSwPixelShaderCache();
+    static void DeInitializeSwPixelShaderCache();
+
 protected:
     
      override virtual BOOL OnChanged(
@@ -97,7 +101,33 @@ private:
 
     static HRESULT EnsurePassThroughShaderResourceRead();
 
+    void ReleaseSwPixelShader();
+
+    static HRESULT AcquireCachedSwPixelShader(
+        __in_bcount(cbBytecodeSize) void *pBytecode,
+        UINT cbBytecodeSize,
+        __deref_out CPixelShaderCompiler **ppPixelShaderCompiler
+        );
+
+    static void ReleaseCachedSwPixelShader(
+        __in CPixelShaderCompiler *pPixelShaderCompiler
+        );
+
 private:
+    //
+    // Entry of the process wide cache of software pixel shaders. Every
+    // CMilPixelShaderDuce using the compiled shader counts as one user; the
+    // entry and its reference on the compiler go away with the last user.
+    //
+    struct SwPixelShaderCacheEntry
+    {
+        UINT uHash;
+        UINT cbBytecodeSize;
+        BYTE *pBytecode;
+        CPixelShaderCompiler *pCompiler;
+        UINT cUsers;
+    };
+
     CComposition            *m_pComposition;
     CMilPixelShaderDuce_Data m_data;
     bool                     m_ignoreHwShader;
@@ -109,6 +139,13 @@ private:
     CPixelShaderCompiler *m_pSwPixelShaderCompiler;
     static BYTE* m_pPassThroughShaderBytecodeData;
     static UINT  m_cbPassThroughShaderBytecodeSize;
+
+    // Software pixel shaders compiled by fxjit, shared by all resources with
+    // identical bytecode. s_csSwPixelShaderCache guards all of these.
+    static CCriticalSection s_csSwPixelShaderCache;
+    static DynArray<SwPixelShaderCacheEntry> s_rgSwPixelShaderCache;
+    static UINT s_cSwPixelShaderCacheHits;
+    static UINT s_cSwPixelShaderCacheMisses;
 };
 
 
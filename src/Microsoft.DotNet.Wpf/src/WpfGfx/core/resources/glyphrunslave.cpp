@@ -187,8 +187,13 @@ Cleanup:
 //      than ideal. The optimization this gives by avoiding excessive requests for
 //      the text rasterizer to produce new realizations is worth the cost, however.
 //
+//      When the glyphs of a new realization are rasterized in the background,
+//      the nearest realization that has its alpha maps is returned instead
+//      and a subsequent pass is requested to pick up the new one.
+//
 //  Returns:
-//      'true' on success, 'false' if no realizations are available and creation fails.
+//      'true' on success, 'false' if no realizations are available and creation fails,
+//      or while waiting for a realization with no placeholder to stand in.
 //
 //------------------------------------------------------------------------------
 bool
@@ -211,6 +216,7 @@ CGlyphRunResource::GetAvailableScale(
     *ppRealization = NULL;
 
     CGlyphRunRealization *pRealization = NULL;
+    IDWriteGlyphRunAnalysis *pBlendingAnalysis = NULL;
 
     bool fCreateNewRealization = false;
     bool fAnimationQuality = false;
@@ -220,6 +226,8 @@ CGlyphRunResource::GetAvailableScale(
 
     UTC_TIME currentRealizationFrame = m_pGlyphCache->GetCurrentRealizationFrame();
 
+    m_fAwaitingRealization = false;
+
     Assert(pScaleX);
     Assert(pScaleY);
     Assert(ppRealization);
@@ -673,15 +681,64 @@ CGlyphRunResource::GetAvailableScale(
                                                   sizeof(GlyphBlendingParameters)
                                                   );
         IFCOOM(m_pGlyphBlendingParameters);
+
+        IDWriteGlyphRunAnalysis *pAnalysisNoRef = pRealization->GetAnalysisNoRef();
+
+        if (pAnalysisNoRef == NULL)
+        {
+            //
+            // An assembled realization has no analysis of the whole run.
+            // The blending parameters depend on the font and the rendering
+            // mode, not on the glyphs, so analyze just the first glyph.
+            //
+            IFC(CreateGlyphRunAnalysis(
+                pRealization->GetScaleX(),
+                pRealization->GetScaleY(),
+                pRealization->IsAnimationQuality(),
+                pRealization->GetDWriteRenderingMode(),
+                min(static_cast<UINT32>(m_usGlyphCount), 1u),
+                &pBlendingAnalysis
+                ));
+
+            pAnalysisNoRef = pBlendingAnalysis;
+        }
         
-        IFC(CDisplaySet::CompileSettings(pDisplaySettings->pIDWriteRenderingParams, pDisplaySettings->PixelStructure, pRealization->GetAnalysisNoRef(), m_pGlyphBlendingParameters));
+        IFC(CDisplaySet::CompileSettings(pDisplaySettings->pIDWriteRenderingParams, pDisplaySettings->PixelStructure, pAnalysisNoRef, m_pGlyphBlendingParameters));
     }
 
     if (!pRealization->HasAlphaMaps())
     {
         EnhancedContrastTable *pECT = NULL;
+        bool fPending;
+
         IFC(GetEnhancedContrastTable(m_pGlyphBlendingParameters->ContrastEnhanceFactor, &pECT));
-        IFC(pRealization->EnsureValidAlphaMap(pECT));
+        IFC(EnsureAlphaMap(pRealization, pECT, &fPending));
+
+        if (fPending)
+        {
+            //
+            // Come back for the realization once its glyphs are in. Until
+            // then draw the nearest one we have.
+            //
+            IFC(m_pGlyphCache->RequestSubsequentPass(this));
+
+            CGlyphRunRealization *pPlaceholder = FindPlaceholderRealization(
+                pRealization->GetScaleX(),
+                pRealization->GetScaleY()
+                );
+
+            ReleaseInterface(pRealization);
+
+            if (!pPlaceholder)
+            {
+                m_fAwaitingRealization = true;
+                goto Cleanup;
+            }
+
+            pRealization = pPlaceholder;
+            pRealization->AddRef();
+            pRealization->UpdateLastUsedFrame();
+        }
     }
 
     *pScaleX = pRealization->GetScaleX();
@@ -715,8 +772,9 @@ CGlyphRunResource::GetAvailableScale(
 
 Cleanup:
     ReleaseInterface(pRealization);
+    ReleaseInterface(pBlendingAnalysis);
     
-    return SUCCEEDED(hr);
+    return SUCCEEDED(hr) && *ppRealization != NULL;
 }
 
 //============================================================================================================================
@@ -792,6 +850,128 @@ CGlyphRunResource::CreateRealization(
     IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis = NULL;
     IDWriteFontFace *pIDWriteFontFace = NULL;
 
+    IFC(CDWriteFontFaceCache::GetFontFace(m_pIDWriteFont, &pIDWriteFontFace));
+
+    DWRITE_RENDERING_MODE dwriteRenderingMode;
+    float scaleFactor = max(scaleX / m_muSize, scaleY / m_muSize);
+
+    GetDWriteRenderingMode(pIDWriteFontFace, textRenderingMode, fAnimationQuality, scaleFactor, pDisplaySettings, &dwriteRenderingMode);
+    
+    // Passing outline to DWrite will invariably return a bad HR, since we should handle
+    // all cases where we render geometric text separately (see ShouldUseGeometry).
+    Assert(dwriteRenderingMode != DWRITE_RENDERING_MODE_OUTLINE);
+
+    // Assembled realizations get an analysis of the whole run only if they
+    // have to fall back to it (see EnsureAlphaMap).
+    if (!IsAssembledRealization(fAnimationQuality))
+    {
+        IFC(CreateGlyphRunAnalysis(
+            scaleX,
+            scaleY,
+            fAnimationQuality,
+            dwriteRenderingMode,
+            m_usGlyphCount,
+            &pIDWriteGlyphRunAnalysis
+            ));
+    }
+
+    // Create the realization 
+    pRealization = new CGlyphRunRealization(scaleX, scaleY, fAnimationQuality, m_pGlyphCache);
+    IFCOOM(pRealization);
+    pRealization->AddRef();    
+    pRealization->SetAnalysis(pIDWriteGlyphRunAnalysis, dwriteRenderingMode);
+
+    DynArrayIA <CGlyphRunRealization*, 2> *pArrayToCreateIn = NULL;
+    if (fBiLevelRequested)
+    {
+        pArrayToCreateIn = &m_prgBiLevelRealizationArray;
+    }
+    else
+    {
+        pArrayToCreateIn = fAnimationQuality ? &m_prgAnimationQualityRealizationArray : 
+                                               &m_prgHighQualityRealizationArray;        
+    }
+
+    // Find an unused array index in the appropriate array to store the new realization
+    UINT realizationHandle = CMilSlaveGlyphCache::c_invalidHandleValue;
+    UINT count = pArrayToCreateIn->GetCount();
+    for (UINT n = 0; n < count; n++)
+    {
+        if ((*pArrayToCreateIn)[n] == NULL)
+        {
+            realizationHandle = n;
+            break;
+        }
+    }
+    
+    if (realizationHandle == CMilSlaveGlyphCache::c_invalidHandleValue)  // No empty places, create a new element
+    {
+        realizationHandle = pArrayToCreateIn->GetCount();
+        IFC( pArrayToCreateIn->Add(NULL) );
+    }
+    
+    Assert(realizationHandle < pArrayToCreateIn->GetCount());
+
+    // Include the realization into the list.
+    Assert((*pArrayToCreateIn)[realizationHandle] == NULL);
+    (*pArrayToCreateIn)[realizationHandle] = pRealization;
+    pRealization->AddRef();
+    
+
+    // Returning realization - note that reference is transferred to out argument.
+    *ppRealization = pRealization;
+    pRealization = NULL; 
+
+Cleanup:
+    ReleaseInterface(pRealization);
+    ReleaseInterface(pIDWriteGlyphRunAnalysis);
+    ReleaseInterface(pIDWriteFontFace);
+    
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::IsAssembledRealization
+//
+//  Synopsis:
+//      Whether realizations of this run get their alpha maps assembled from
+//      CGlyphAlphaCache. They only need an IDWriteGlyphRunAnalysis of the
+//      whole run if they fall back to it.
+//
+//------------------------------------------------------------------------------
+bool
+CGlyphRunResource::IsAssembledRealization(
+    bool fAnimationQuality
+    ) const
+{
+    return g_fAssembleGlyphRuns && !fAnimationQuality && !IsSideways();
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::CreateGlyphRunAnalysis
+//
+//  Synopsis:
+//      Creates a DWrite analysis of the first glyphCount glyphs of this run
+//      at the given scale
+//
+//------------------------------------------------------------------------------
+HRESULT
+CGlyphRunResource::CreateGlyphRunAnalysis(
+    float scaleX,
+    float scaleY,
+    bool fAnimationQuality,
+    DWRITE_RENDERING_MODE dwriteRenderingMode,
+    UINT32 glyphCount,
+    __deref_out IDWriteGlyphRunAnalysis **ppIDWriteGlyphRunAnalysis
+    )
+{
+    HRESULT hr = S_OK;
+    IDWriteFontFace *pIDWriteFontFace = NULL;
+
     DWRITE_MATRIX scaleTransform;
     memset(&scaleTransform, 0, sizeof(DWRITE_MATRIX));
 
@@ -825,11 +1005,93 @@ CGlyphRunResource::CreateRealization(
     IFC(CDWriteFontFaceCache::GetFontFace(m_pIDWriteFont, &pIDWriteFontFace));
     
     DWRITE_GLYPH_RUN glyphRun;
-    glyphRun.fontFace = pIDWriteFontFace;
-    glyphRun.fontEmSize = m_muSize;
-    glyphRun.glyphCount = m_usGlyphCount;
-    glyphRun.glyphIndices = m_pGlyphIndices;
-    glyphRun.glyphAdvances = m_pGlyphAdvances;
+    GetDWriteGlyphRun(pIDWriteFontFace, &glyphRun);
+
+    Assert(glyphCount <= glyphRun.glyphCount);
+    glyphRun.glyphCount = glyphCount;
+
+    IDWriteFactory *pIDWriteFactoryNoRef = m_pGlyphCache->GetDWriteFactoryNoRef();
+    Assert(pIDWriteFactoryNoRef != NULL);
+
+    // NOTE: There is some inconsistency in argument passing here - we hard-code the
+    // scale factor here to 1 and only pass the scale in via the transform argument.
+    // This means that glyphs with different muSizes scaled to the same size on-screen
+    // may be rendered differently by DWrite (different hinting, etc).
+    IFC(pIDWriteFactoryNoRef->CreateGlyphRunAnalysis(
+        &glyphRun,                              // glyphRun
+        1,                                      // pixelsPerDip,
+        &scaleTransform,                        // transform,
+        dwriteRenderingMode,
+        m_measuringMethod,
+        0.0,                                    // baseline is handled by GlyphRunPainter
+        0.0,
+        ppIDWriteGlyphRunAnalysis               // glyphRunAnalysis
+        ));
+
+Cleanup:
+    ReleaseInterface(pIDWriteFontFace);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::EnsureAnalysis
+//
+//  Synopsis:
+//      Gives a realization the analysis of the whole run it was created
+//      without
+//
+//------------------------------------------------------------------------------
+HRESULT
+CGlyphRunResource::EnsureAnalysis(
+    __in CGlyphRunRealization *pRealization
+    )
+{
+    HRESULT hr = S_OK;
+    IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis = NULL;
+
+    if (pRealization->GetAnalysisNoRef() == NULL)
+    {
+        IFC(CreateGlyphRunAnalysis(
+            pRealization->GetScaleX(),
+            pRealization->GetScaleY(),
+            pRealization->IsAnimationQuality(),
+            pRealization->GetDWriteRenderingMode(),
+            m_usGlyphCount,
+            &pIDWriteGlyphRunAnalysis
+            ));
+
+        pRealization->SetAnalysis(pIDWriteGlyphRunAnalysis, pRealization->GetDWriteRenderingMode());
+    }
+
+Cleanup:
+    ReleaseInterface(pIDWriteGlyphRunAnalysis);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::GetDWriteGlyphRun
+//
+//  Synopsis:
+//      Describes this glyph run to DWrite
+//
+//------------------------------------------------------------------------------
+void
+CGlyphRunResource::GetDWriteGlyphRun(
+    __in IDWriteFontFace *pIDWriteFontFace,
+    __out DWRITE_GLYPH_RUN *pGlyphRun
+    ) const
+{
+    pGlyphRun->fontFace = pIDWriteFontFace;
+    pGlyphRun->fontEmSize = m_muSize;
+    pGlyphRun->glyphCount = m_usGlyphCount;
+    pGlyphRun->glyphIndices = m_pGlyphIndices;
+    pGlyphRun->glyphAdvances = m_pGlyphAdvances;
 
     //
     // glyphOffsets is an array of 
@@ -851,90 +1113,111 @@ CGlyphRunResource::CreateRealization(
     C_ASSERT(FIELD_OFFSET(DWRITE_GLYPH_OFFSET, advanceOffset) == 0);
     C_ASSERT(FIELD_OFFSET(DWRITE_GLYPH_OFFSET, ascenderOffset) == 4);
 
-    glyphRun.glyphOffsets = reinterpret_cast<const DWRITE_GLYPH_OFFSET *>(m_pGlyphOffsets);
+    pGlyphRun->glyphOffsets = reinterpret_cast<const DWRITE_GLYPH_OFFSET *>(m_pGlyphOffsets);
 
-    glyphRun.bidiLevel = m_bidiLevel;
-    glyphRun.isSideways = IsSideways();
+    pGlyphRun->bidiLevel = m_bidiLevel;
+    pGlyphRun->isSideways = IsSideways();
+}
 
-    IDWriteFactory *pIDWriteFactoryNoRef = m_pGlyphCache->GetDWriteFactoryNoRef();
-    Assert(pIDWriteFactoryNoRef != NULL);
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::EnsureAlphaMap
+//
+//  Synopsis:
+//      Gets an alpha map for a realization of this glyph run.
+//
+//  Notes:
+//      With EnableGlyphRunAssembly set, realizations with a plain scale
+//      transform are assembled from the glyphs in the composition's
+//      CGlyphAlphaCache, so glyphs shared with other runs are not
+//      rasterized again. Glyphs are placed at quarter pixel phases and
+//      their textures summed, so the result is close to, but not the same
+//      as, that of IDWriteGlyphRunAnalysis. Animation quality realizations
+//      carry a small rotation to defeat hinting, and sideways runs are laid
+//      out vertically; both are still rasterized as a whole by
+//      IDWriteGlyphRunAnalysis.
+//
+//      With more than one worker thread, and unless the
+//      DisableAsyncGlyphRasterization switch is set, missing glyphs are
+//      rasterized in the background; *pfPending is then set and the
+//      realization is left without alpha maps until a later call. The
+//      glyph cache holds the run's glyphs for the realization until then.
+//
+//      Runs whose glyph outlines may overlap can't be assembled from
+//      separate glyphs without darkening the overlap, so they are
+//      rasterized as a whole too. Assembled realizations are created
+//      without an analysis of the whole run; it is only created here for
+//      them when they fall back.
+//
+//------------------------------------------------------------------------------
+HRESULT
+CGlyphRunResource::EnsureAlphaMap(
+    __in CGlyphRunRealization *pRealization,
+    __in_opt const EnhancedContrastTable *pECT,
+    __out bool *pfPending
+    )
+{
+    HRESULT hr = S_OK;
+    IDWriteFontFace *pIDWriteFontFace = NULL;
+    BYTE *pAlphaMap = NULL;
 
-    DWRITE_RENDERING_MODE dwriteRenderingMode;
-    float scaleFactor = max(scaleX / m_muSize, scaleY / m_muSize);
+    *pfPending = false;
 
-    GetDWriteRenderingMode(pIDWriteFontFace, textRenderingMode, fAnimationQuality, scaleFactor, pDisplaySettings, &dwriteRenderingMode);
-    
-    // Passing outline to DWrite will invariably return a bad HR, since we should handle
-    // all cases where we render geometric text separately (see ShouldUseGeometry).
-    Assert(dwriteRenderingMode != DWRITE_RENDERING_MODE_OUTLINE);
+    bool fRasterizeWholeRun = !IsAssembledRealization(pRealization->IsAnimationQuality());
 
-    // NOTE: There is some inconsistency in argument passing here - we hard-code the
-    // scale factor here to 1 and only pass the scale in via the transform argument.
-    // This means that glyphs with different muSizes scaled to the same size on-screen
-    // may be rendered differently by DWrite (different hinting, etc).
-    IFC(pIDWriteFactoryNoRef->CreateGlyphRunAnalysis(
-        &glyphRun,                              // glyphRun
-        1,                                      // pixelsPerDip,
-        &scaleTransform,                        // transform,
-        dwriteRenderingMode,
-        m_measuringMethod,
-        0.0,                                    // baseline is handled by GlyphRunPainter
-        0.0,
-        &pIDWriteGlyphRunAnalysis               // glyphRunAnalysis
-        ));
+    if (!fRasterizeWholeRun)
+    {
+        UINT32 textureSize;
+        RECT boundingBox;
+        bool fIsBiLevelOnly;
+        bool fOverlapping;
 
-    // Create the realization 
-    pRealization = new CGlyphRunRealization(scaleX, scaleY, fAnimationQuality, m_pGlyphCache);
-    IFCOOM(pRealization);
-    pRealization->AddRef();    
-    pRealization->SetAnalysis(pIDWriteGlyphRunAnalysis);
+        IFC(CDWriteFontFaceCache::GetFontFace(m_pIDWriteFont, &pIDWriteFontFace));
 
-    DynArrayIA <CGlyphRunRealization*, 2> *pArrayToCreateIn = NULL;
-    if (fBiLevelRequested)
-    {
-        pArrayToCreateIn = &m_prgBiLevelRealizationArray;
-    }
-    else
-    {
-        pArrayToCreateIn = fAnimationQuality ? &m_prgAnimationQualityRealizationArray : 
-                                               &m_prgHighQualityRealizationArray;        
-    }
+        DWRITE_GLYPH_RUN glyphRun;
+        GetDWriteGlyphRun(pIDWriteFontFace, &glyphRun);
+
+        IFC(m_pGlyphCache->GetGlyphAlphaCache()->RealizeRunAlphaMap(
+            pRealization,
+            m_pGlyphCache->GetDWriteFactoryNoRef(),
+            m_pIDWriteFont,
+            &glyphRun,
+            pRealization->GetScaleX(),
+            pRealization->GetScaleY(),
+            pRealization->GetDWriteRenderingMode(),
+            m_measuringMethod,
+            pECT,
+            g_fUseAsyncGlyphRasterization,
+            pfPending,
+            &fOverlapping,
+            &pAlphaMap,
+            &textureSize,
+            &boundingBox,
+            &fIsBiLevelOnly
+            ));
 
-    // Find an unused array index in the appropriate array to store the new realization
-    UINT realizationHandle = CMilSlaveGlyphCache::c_invalidHandleValue;
-    UINT count = pArrayToCreateIn->GetCount();
-    for (UINT n = 0; n < count; n++)
-    {
-        if ((*pArrayToCreateIn)[n] == NULL)
+        if (fOverlapping)
         {
-            realizationHandle = n;
-            break;
+            fRasterizeWholeRun = true;
+        }
+        else if (!*pfPending)
+        {
+            pRealization->SetAssembledAlphaMap(pAlphaMap, textureSize, boundingBox, fIsBiLevelOnly);
+            pAlphaMap = NULL;
         }
     }
-    
-    if (realizationHandle == CMilSlaveGlyphCache::c_invalidHandleValue)  // No empty places, create a new element
+
+    if (fRasterizeWholeRun)
     {
-        realizationHandle = pArrayToCreateIn->GetCount();
-        IFC( pArrayToCreateIn->Add(NULL) );
+        IFC(EnsureAnalysis(pRealization));
+        IFC(pRealization->EnsureValidAlphaMap(pECT));
     }
-    
-    Assert(realizationHandle < pArrayToCreateIn->GetCount());
-
-    // Include the realization into the list.
-    Assert((*pArrayToCreateIn)[realizationHandle] == NULL);
-    (*pArrayToCreateIn)[realizationHandle] = pRealization;
-    pRealization->AddRef();
-    
-
-    // Returning realization - note that reference is transferred to out argument.
-    *ppRealization = pRealization;
-    pRealization = NULL; 
 
 Cleanup:
-    ReleaseInterface(pRealization);
-    ReleaseInterface(pIDWriteGlyphRunAnalysis);
+    WPFFree(ProcessHeap, pAlphaMap);
     ReleaseInterface(pIDWriteFontFace);
-    
+
     RRETURN(hr);
 }
 
@@ -1172,6 +1455,67 @@ CGlyphRunResource::FindMatchingRealization(
     *pFoundIndex = foundIndex;
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunResource::FindPlaceholderRealization
+//
+//  Synopsis:
+//      Helper for GetAvailableScale(). Finds the realization with alpha maps
+//      whose scale is closest to the given one, to draw while a realization
+//      at that scale is being rasterized.
+//
+//  Returns:
+//      the realization, not AddRef'd, or NULL if none has alpha maps
+//
+//------------------------------------------------------------------------------
+CGlyphRunRealization *
+CGlyphRunResource::FindPlaceholderRealization(
+    float desiredScaleX,
+    float desiredScaleY
+    ) const
+{
+    const DynArrayIA <CGlyphRunRealization*, 2> *rgpArrays[] =
+    {
+        &m_prgHighQualityRealizationArray,
+        &m_prgAnimationQualityRealizationArray,
+        &m_prgBiLevelRealizationArray
+    };
+
+    CGlyphRunRealization *pBest = NULL;
+    double bestQuality = 0.0;
+
+    for (UINT i = 0; i < ARRAYSIZE(rgpArrays); i++)
+    {
+        const DynArrayIA <CGlyphRunRealization*, 2> *pRealizationArray = rgpArrays[i];
+
+        for (UINT h = 0; h < pRealizationArray->GetCount(); h++)
+        {
+            CGlyphRunRealization *pRealizationTemp = (*pRealizationArray)[h];
+
+            if (!pRealizationTemp || !pRealizationTemp->HasAlphaMaps())
+            {
+                continue;
+            }
+
+            double quality = InspectScaleQuality(
+                pRealizationTemp->GetScaleX(),
+                desiredScaleX,
+                pRealizationTemp->GetScaleY(),
+                desiredScaleY
+                );
+
+            if (!pBest || quality > bestQuality)
+            {
+                pBest = pRealizationTemp;
+                bestQuality = quality;
+            }
+        }
+    }
+
+    return pBest;
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
@@ -1544,13 +1888,20 @@ CGlyphRunRealization::CGlyphRunRealization(
 //------------------------------------------------------------------------------
 void
 CGlyphRunRealization::SetAnalysis(
-    __in IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis
+    __in_opt IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis,
+    DWRITE_RENDERING_MODE dwriteRenderingMode
     )
 {
     Assert(m_pIDWriteGlyphRunAnalysis == NULL);
     
     m_pIDWriteGlyphRunAnalysis = pIDWriteGlyphRunAnalysis;
-    pIDWriteGlyphRunAnalysis->AddRef();
+
+    if (pIDWriteGlyphRunAnalysis)
+    {
+        pIDWriteGlyphRunAnalysis->AddRef();
+    }
+
+    m_dwriteRenderingMode = dwriteRenderingMode;
 }
 
 //+-----------------------------------------------------------------------------
@@ -1566,6 +1917,9 @@ CGlyphRunRealization::~CGlyphRunRealization()
 {
     DeleteAlphaMap();
 
+    // In case the glyphs were still pending for this realization
+    m_pGlyphCacheNoRef->GetGlyphAlphaCache()->ReleasePins(this);
+
     delete m_pSWGlyphRun;
 
     for (int i = m_pD3DGlyphRuns.GetCount(); --i >= 0;)
@@ -1802,6 +2156,36 @@ Cleanup:
     RRETURN(hr);
 }   
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CGlyphRunRealization::SetAssembledAlphaMap
+//
+//  Synopsis:
+//      Takes ownership of an alpha map assembled by CGlyphAlphaCache in
+//      place of one from IDWriteGlyphRunAnalysis
+//
+//------------------------------------------------------------------------------
+void
+CGlyphRunRealization::SetAssembledAlphaMap(
+    __in_ecount_opt(textureSize) BYTE *pAlphaMap,
+    UINT32 textureSize,
+    __in const RECT &boundingBox,
+    bool fIsBiLevelOnly
+    )
+{
+    Assert(!m_fHasAlphaMaps);
+
+    m_pAlphaMap = pAlphaMap;
+    m_textureSize = textureSize;
+    m_alphaMapBoundingBox = boundingBox;
+
+    m_fHasAlphaMaps = true;
+    m_fIsBiLevelOnly = fIsBiLevelOnly;
+
+    m_pGlyphCacheNoRef->AddRealization(this, m_textureSize);
+}
+
 //+-----------------------------------------------------------------------------
 //
 // Deletes alpha map bitmaps, removes them from the CMilSlaveGlyphCache realization
@@ -87,6 +87,21 @@ public:
 
     void EnsureGeometry();
 
+    //
+    // True if the last GetAvailableScale found nothing to draw while the
+    // glyphs of a new realization are rasterized in the background. The
+    // caller may draw the geometry instead.
+    //
+    bool IsAwaitingRealization() const
+    {
+        return m_fAwaitingRealization;
+    }
+
+    void ResetAwaitingRealization()
+    {
+        m_fAwaitingRealization = false;
+    }
+
     CMilGeometryDuce *GetGeometryRes()
     {
         return m_pGeometry;            
@@ -156,6 +171,37 @@ private:
         __out CGlyphRunRealization **ppRealization
         );
 
+    HRESULT EnsureAlphaMap(
+        __in CGlyphRunRealization *pRealization,
+        __in_opt const EnhancedContrastTable *pECT,
+        __out bool *pfPending
+        );
+
+    bool IsAssembledRealization(bool fAnimationQuality) const;
+
+    HRESULT CreateGlyphRunAnalysis(
+        float scaleX,
+        float scaleY,
+        bool fAnimationQuality,
+        DWRITE_RENDERING_MODE dwriteRenderingMode,
+        UINT32 glyphCount,
+        __deref_out IDWriteGlyphRunAnalysis **ppIDWriteGlyphRunAnalysis
+        );
+
+    HRESULT EnsureAnalysis(
+        __in CGlyphRunRealization *pRealization
+        );
+
+    CGlyphRunRealization *FindPlaceholderRealization(
+        float desiredScaleX,
+        float desiredScaleY
+        ) const;
+
+    void GetDWriteGlyphRun(
+        __in IDWriteFontFace *pIDWriteFontFace,
+        __out DWRITE_GLYPH_RUN *pGlyphRun
+        ) const;
+
     static void DeleteRealizationInArray(__in DynArrayIA <CGlyphRunRealization*, 2> *pArray);
 
     void PurgeOldEntries(__in DynArrayIA <CGlyphRunRealization*, 2> *pRealizationArray);
@@ -268,6 +314,8 @@ private:
     
     CMilGeometryDuce *m_pGeometry;
 
+    bool m_fAwaitingRealization;
+
     static const double c_minAnimationDetectionBar;
 
     // ScaleGrid: allowed rasterization scales for scale animation.
@@ -317,7 +365,15 @@ public:
                          );
     virtual ~CGlyphRunRealization();
 
-    void SetAnalysis(__in IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis);
+    void SetAnalysis(
+        __in_opt IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis,
+        DWRITE_RENDERING_MODE dwriteRenderingMode
+        );
+
+    DWRITE_RENDERING_MODE GetDWriteRenderingMode() const
+    {
+        return m_dwriteRenderingMode;
+    }
 
     float GetScaleX() const { return m_scaleX; }
     float GetScaleY() const { return m_scaleY; }
@@ -380,6 +436,14 @@ public:
     }
 
     HRESULT EnsureValidAlphaMap(__in const EnhancedContrastTable *pECT);
+
+    void SetAssembledAlphaMap(
+        __in_ecount_opt(textureSize) BYTE *pAlphaMap,
+        UINT32 textureSize,
+        __in const RECT &boundingBox,
+        bool fIsBiLevelOnly
+        );
+
     bool HasAlphaMaps()
     {
         return m_fHasAlphaMaps;
@@ -424,8 +488,14 @@ private:
         );
 
     float m_scaleX, m_scaleY;
+
+    // NULL for an assembled realization until it has to fall back to
+    // rasterizing the run as a whole
     IDWriteGlyphRunAnalysis *m_pIDWriteGlyphRunAnalysis;
 
+    // The rendering mode m_pIDWriteGlyphRunAnalysis is created with
+    DWRITE_RENDERING_MODE m_dwriteRenderingMode;
+
     //
     // If this glyph run has m_fIsAnimationQuality set, these
     // values represent the scales for which this realization 
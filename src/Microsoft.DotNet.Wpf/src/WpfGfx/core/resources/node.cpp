@@ -273,12 +273,50 @@ CMilVisual::SetParent(
     // We expect that a node is first disconnected before it is connected to another
     // node.
     Assert(m_pParent == NULL || pParentNode == NULL);
+
+    if (pParentNode != NULL)
+    {
+        AdjustSubtreeNodeCounts(pParentNode, m_cSubtreeNodes, true);
+    }
+    else if (m_pParent != NULL)
+    {
+        AdjustSubtreeNodeCounts(m_pParent, m_cSubtreeNodes, false);
+    }
+
     m_pParent = pParentNode;
 
     // Note that the parent is not add-refed to avoid circular references.
     // The child is kept alive by the parent node and therefore addref'd by the parent. 
 }
 
+//---------------------------------------------------------------------------------
+// CMilVisual::AdjustSubtreeNodeCounts (static)
+//
+//      Adds or removes cNodes from the subtree node count of pNode and all
+//      its ancestors.
+//---------------------------------------------------------------------------------
+
+void
+CMilVisual::AdjustSubtreeNodeCounts(
+    __in CMilVisual *pNode,
+    UINT cNodes,
+    bool fAdd
+    )
+{
+    for (; pNode != NULL; pNode = pNode->m_pParent)
+    {
+        if (fAdd)
+        {
+            pNode->m_cSubtreeNodes += cNodes;
+        }
+        else
+        {
+            Assert(pNode->m_cSubtreeNodes > cNodes);
+            pNode->m_cSubtreeNodes -= cNodes;
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------
 // CMilVisual::InsertChildAt
 //---------------------------------------------------------------------------------
@@ -88,6 +88,7 @@ protected:
         m_dwDirtyRegionEnableCount = 0;
 #endif
         m_alpha = 1.0;
+        m_cSubtreeNodes = 1;
     }
 
     virtual ~CMilVisual();
@@ -108,6 +109,12 @@ public:
     {
         return m_Bounds;
     }
+
+    // Returns the number of visuals in the subtree rooted at this visual.
+    UINT GetSubtreeNodeCount() const
+    {
+        return m_cSubtreeNodes;
+    }
     
     HRESULT SetClip(
         __in_ecount_opt(1) CMilGeometryDuce *pClip
@@ -333,6 +340,12 @@ private:
     {
         return (m_pScrollBag != NULL);
     }
+
+    static void AdjustSubtreeNodeCounts(
+        __in CMilVisual *pNode,
+        UINT cNodes,
+        bool fAdd
+        );
     
     CComposition * m_pComposition;
     CMilScheduleRecord *m_pScheduleRecord;
@@ -440,6 +453,10 @@ private:
     // a user has set ScrollableAreaClip on the associated Visual
     // See comment on CPreComputeContext::ScrollableAreaHandling()   
     ScrollableAreaPropertyBag *m_pScrollBag;
+
+    // Number of visuals in the subtree rooted at this visual, including itself.
+    // Kept up to date by SetParent for precompute statistics.
+    UINT m_cSubtreeNodes;
     
 #if DBG==1
     UINT m_dwDirtyRegionEnableCount;
@@ -139,6 +139,8 @@ class CMilSlaveBitmap;
 #include "Effect.h"
 #include "ShaderEffect.h"
 #include "PixelShader.h"
+#include <bcrypt.h>             // Needed by JitterCodeCache.h
+#include "JitterCodeCache.h"
 #include "ImplicitInputBrush.h"
 #include "BlurEffect.h"
 #include "DropShadowEffect.h"
@@ -78,6 +78,11 @@ private:
         new (&m_rgFormatCachedEntry[0]) FormatCacheEntry();
         (&m_rgFormatCachedEntry[1])->~FormatCacheEntry();
         new (&m_rgFormatCachedEntry[1]) FormatCacheEntry();
+
+        if (m_pMipChain)
+        {
+            m_pMipChain->ReleaseLevels();
+        }
     }
 
 private:
@@ -167,6 +172,9 @@ private:
     // Cached bitmaps per color space (sRGB+scRGB)
     FormatCacheEntry m_rgFormatCachedEntry[2];
 
+    // Mip levels of the source, shared by the sRGB realizations
+    CSwBitmapMipChain *m_pMipChain;
+
 };
 
 
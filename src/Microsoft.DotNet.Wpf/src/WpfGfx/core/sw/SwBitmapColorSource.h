@@ -36,6 +36,8 @@ MtExtern(CSwBitmapColorSource);
 class CSwBitmapColorSource
     : public CMILRefCountBase
 {
+    friend class CSwRealizationManager;
+
 public:
 
     //+-------------------------------------------------------------------------
@@ -147,6 +149,7 @@ public:
 
     static HRESULT Create(
         __in_ecount_opt(1) IWGXBitmap *pBitmap,
+        __in_ecount_opt(1) CSwBitmapMipChain *pMipChain,
         __deref_out_ecount(1) CSwBitmapColorSource ** const ppSwBitmapCS
         );
 
@@ -155,7 +158,8 @@ private:
     DECLARE_METERHEAP_ALLOC(ProcessHeap, Mt(CSwBitmapColorSource));
 
     CSwBitmapColorSource(
-        __in_ecount_opt(1) IWGXBitmap *pBitmap
+        __in_ecount_opt(1) IWGXBitmap *pBitmap,
+        __in_ecount_opt(1) CSwBitmapMipChain *pMipChain
         );
     ~CSwBitmapColorSource();
 
@@ -171,6 +175,7 @@ public:
         ) const;
 
     /*override*/ HRESULT Realize(
+        __deref_out_ecount(1) IWGXBitmap **ppRealization
         );
 
 
@@ -249,7 +254,13 @@ private:
     HRESULT FillTexture();
     
     HRESULT FillTextureWithTransformedSource(
-        __in_ecount(1) IWGXBitmapSource *pIBitmapSource
+        __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+        __in_ecount_opt(1) IWICBitmapSource *pIUnconvertedSource
+        );
+
+    HRESULT FillTextureRectInStripes(
+        __in_ecount(1) IWICBitmapSource *pIUnconvertedSource,
+        __in_ecount(1) const CMilRectU &rcSource
         );
     
     VOID GetDirtyRects(
@@ -278,6 +289,10 @@ private:
 
     CSystemMemoryBitmap *m_pRealizationBitmap;  // Currently allocated/cached texture
 
+    CSwBitmapMipChain *m_pMipChain; // Reductions of the bitmap shared by all
+                                    // color sources in the same cache; heavy
+                                    // prefiltering starts from them
+
 
     UINT m_uBitmapWidth;            // Width of original source
     UINT m_uBitmapHeight;           // Height of original source
@@ -288,6 +303,19 @@ private:
                                 // useful realization of the current device
                                 // independent bitmap
 
+    //
+    // CSwRealizationManager bookkeeping, guarded by its lock
+    //
+
+    CSwBitmapColorSource *m_pMoreRecent;    // Neighbors in the list of
+    CSwBitmapColorSource *m_pLessRecent;    // realizations
+
+    UINT64 m_cbListedRealization;   // Bytes of m_pRealizationBitmap counted
+                                    // against the budget; 0 if not listed
+
+    UINT m_uLastUsedFrame;          // Frame this was last realized in
+    UINT m_cUses;                   // Realizations in progress
+
 #if DBG
 private:
 
@@ -0,0 +1,124 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_software
+//      $Keywords:
+//
+//  $Description:
+//      Definition for CSwBitmapMipChain which holds area-averaged reductions
+//      of a bitmap used as the starting point of heavy prefiltering
+//
+//  $ENDTAG
+//
+//------------------------------------------------------------------------------
+
+
+MtExtern(CSwBitmapMipChain);
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CSwBitmapMipChain
+//
+//  Synopsis:
+//      A chain of successively halved, area-averaged copies of a bitmap in a
+//      32bpp texture format.  Level N is built from level N-1 (level 0 being
+//      the bitmap itself), so a prefilter to a small size can start from a
+//      level close to that size instead of reading the full resolution
+//      source.
+//
+//      Levels are built on demand.  When the bitmap changes they are
+//      updated within the dirty rects it reports, or rebuilt when it reports
+//      none.
+//
+//------------------------------------------------------------------------------
+
+class CSwBitmapMipChain
+    : public CMILRefCountBase
+{
+public:
+
+    static HRESULT Create(
+        __deref_out_ecount(1) CSwBitmapMipChain ** const ppMipChain
+        );
+
+    HRESULT GetLevelForSize(
+        __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+        __in_ecount_opt(1) IWGXBitmap *pBitmap,
+        MilPixelFormat::Enum fmtTexture,
+        UINT uMinWidth,
+        UINT uMinHeight,
+        __deref_out_ecount_opt(1) IWGXBitmapSource **ppILevel
+        );
+
+    VOID ReleaseLevels();
+
+private:
+
+    DECLARE_METERHEAP_ALLOC(ProcessHeap, Mt(CSwBitmapMipChain));
+
+    CSwBitmapMipChain();
+    ~CSwBitmapMipChain();
+
+    static VOID GetLevelSize(
+        UINT uWidth,
+        UINT uHeight,
+        __out_ecount(1) UINT &uLevelWidth,
+        __out_ecount(1) UINT &uLevelHeight
+        );
+
+    static HRESULT GetSourceInTextureFormat(
+        __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+        MilPixelFormat::Enum fmtTexture,
+        __deref_out_ecount(1) IWGXBitmapSource **ppISource
+        );
+
+    HRESULT UpdateLevels(
+        __in_ecount(1) IWGXBitmapSource *pISourceInTextureFormat,
+        __in_ecount(cDirtyRects) MilRectU const *rgDirtyRects,
+        UINT cDirtyRects
+        );
+
+    static HRESULT BuildLevel(
+        __in_ecount(1) IWGXBitmapSource *pISource,
+        MilPixelFormat::Enum fmtTexture,
+        UINT uSourceWidth,
+        UINT uSourceHeight,
+        UINT uLevelWidth,
+        UINT uLevelHeight,
+        __deref_out_ecount(1) CSystemMemoryBitmap **ppLevel
+        );
+
+    static HRESULT FilterLevelRect(
+        __in_ecount(1) IWGXBitmapSource *pISource,
+        __in_ecount(1) CSystemMemoryBitmap *pLevel,
+        UINT uSourceWidth,
+        UINT uSourceHeight,
+        UINT uLevelWidth,
+        UINT uLevelHeight,
+        __in_ecount(1) MilRectU const &rcLevel
+        );
+
+private:
+
+    IWGXBitmapSource *m_pIBitmapSourceNoRef;    // Source the levels were
+                                                // built from
+
+    MilPixelFormat::Enum m_fmtLevels;   // Pixel format of all levels
+
+    UINT m_uCachedUniquenessToken;  // Uniqueness token if built from an
+                                    // IWGXBitmap
+
+    DynArrayIA<CSystemMemoryBitmap *, 4> m_rgLevels;    // m_rgLevels[i] is
+                                                        // level i+1
+};
+
+
@@ -0,0 +1,101 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_software
+//      $Keywords:
+//
+//  $Description:
+//      Definition for CSwRealizationManager which bounds the memory held by
+//      software bitmap realizations
+//
+//  $ENDTAG
+//
+//------------------------------------------------------------------------------
+
+class CSwBitmapColorSource;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CSwRealizationManager
+//
+//  Synopsis:
+//      Process-wide budget for the realization bitmaps of CSwBitmapColorSource.
+//
+//      Every color source holding a realization is kept in one list, most
+//      recently used first, and stamped with the frame it was last used in.
+//      When the bytes held exceed the budget, realizations are released from
+//      the least recently used end.  Realizations used in the current frame
+//      and ones being realized are never released; the budget may be
+//      exceeded until the next frame if a single frame needs more.
+//
+//      A released color source reports !IsValid(), so CSwBitmapCache drops
+//      it on next use and makes a new one.
+//
+//------------------------------------------------------------------------------
+
+class CSwRealizationManager
+{
+public:
+
+    static HRESULT Initialize(
+        UINT uBudgetMB      // Budget in megabytes, 0 for the default
+        );
+
+    static void DeInitialize();
+
+    static void AdvanceFrame();
+
+    static void BeginUse(
+        __inout_ecount(1) CSwBitmapColorSource *pbcs
+        );
+
+    static void EndUse(
+        __inout_ecount(1) CSwBitmapColorSource *pbcs,
+        bool fReused        // True if the realization was current
+        );
+
+    static void Remove(
+        __inout_ecount(1) CSwBitmapColorSource *pbcs
+        );
+
+private:
+
+    static void Unlink(
+        __inout_ecount(1) CSwBitmapColorSource *pbcs
+        );
+
+    static void LinkFirst(
+        __inout_ecount(1) CSwBitmapColorSource *pbcs
+        );
+
+    static void EvictOverBudget();
+
+    // Used unless the MaxSwRealizationCacheMB registry value says otherwise
+    static const UINT c_uDefaultBudgetMB = 256;
+
+    // s_csRealizations guards all of these and the list fields of every
+    // CSwBitmapColorSource
+    static CCriticalSection s_csRealizations;
+
+    static CSwBitmapColorSource *s_pMostRecent;     // Head of the list
+    static CSwBitmapColorSource *s_pLeastRecent;    // Tail of the list
+
+    static UINT64 s_cbBudget;           // Bytes allowed before evicting
+    static UINT64 s_cbResident;         // Bytes held by listed realizations
+    static UINT s_uFrame;               // Current frame
+
+    static UINT s_cHits;                // Realizations reused as they were
+    static UINT s_cMisses;              // Realizations created or refilled
+    static UINT s_cEvictions;           // Realizations released for budget
+};
+
+
@@ -93,7 +93,15 @@ struct CCoverageIntervalBuffer
 //     m_nPixelX: INT_MIN  |  0  |  1  |  3  |  4  | INT_MAX
 //   m_nCoverage: 0        |  4  |  8  |  4  |  0  | 0xdeadbeef
 //       m_pNext: -------->|---->|---->|---->|---->| NULL
-//              
+//
+//      Alternatively, after InitializeCells the buffer accumulates coverage
+//      in a flat array of per-pixel coverage deltas.  Adding an interval then
+//      touches at most four cells instead of walking the list.  Before the
+//      scanline is consumed, ResolveCells prefix-sums the deltas and builds
+//      the same interval list from runs of equal coverage, so consumers of
+//      m_pIntervalStart see identical per-pixel coverage.  Cell mode only
+//      records coverage within the pixel range given to InitializeCells.
+//
 //------------------------------------------------------------------------------
 class CCoverageBuffer
 {
@@ -105,6 +113,13 @@ public:
     VOID Initialize();
     VOID Destroy();
 
+    //
+    // Switch to accumulating coverage for pixels in [nPixelXLeft,
+    // nPixelXRight) in a flat cell array
+    //
+
+    HRESULT InitializeCells(INT nPixelXLeft, INT nPixelXRight);
+
     //
     // Setup the buffer so that it can accept another scanline
     //
@@ -127,8 +142,27 @@ public:
 
     HRESULT AddInterval(INT nSubpixelXLeft, INT nSubpixelXRight);
 
+    //
+    // Build the interval list from the accumulated cells.  Must be called
+    // before reading m_pIntervalStart; does nothing when not in cell mode.
+    //
+
+    HRESULT ResolveCells()
+    {
+        if (m_rgCells != NULL && m_nCellFirst <= m_nCellLast)
+        {
+            RRETURN(ResolveCellsToIntervals());
+        }
+
+        return S_OK;
+    }
+
 private:
 
+    VOID AddIntervalToCells(INT nSubpixelXLeft, INT nSubpixelXRight);
+
+    HRESULT ResolveCellsToIntervals();
+
     HRESULT Grow(
         __deref_out_ecount(1) CCoverageInterval **ppIntervalNew, 
         __deref_out_ecount(1) CCoverageInterval **ppIntervalEndMinus4
@@ -159,6 +193,17 @@ private:
 
     CCoverageIntervalBuffer m_pIntervalBufferBuiltin;
     CCoverageIntervalBuffer *m_pIntervalBufferCurrent;
+
+    // Cell mode state.  m_rgCells[i] holds the coverage delta for pixel
+    // m_nCellPixelXLeft + i; [m_nCellFirst, m_nCellLast] is the range of
+    // cells touched since the last resolve.
+
+    INT *m_rgCells;
+    INT m_nCellPixelXLeft;
+    INT m_nCellSubpixelXLeft;
+    INT m_nCellSubpixelXRight;
+    INT m_nCellFirst;
+    INT m_nCellLast;
        
     // Disable instrumentation checks within all methods of this class
     SET_MILINSTRUMENTATION_FLAGS(MILINSTRUMENTATIONFLAGS_DONOTHING);
@@ -190,6 +235,12 @@ CCoverageBuffer::AddInterval(INT nSubpixelXLeft, INT nSubpixelXRight)
     CCoverageInterval *pIntervalNew = m_pIntervalNew;
     CCoverageInterval *pIntervalEndMinus4 = m_pIntervalEndMinus4;
 
+    if (m_rgCells != NULL)
+    {
+        AddIntervalToCells(nSubpixelXLeft, nSubpixelXRight);
+        return S_OK;
+    }
+
     // Make sure we have enough room to add two intervals if
     // necessary:
 
@@ -342,6 +393,58 @@ Cleanup:
 }
 
 
+//-------------------------------------------------------------------------
+//
+//  Function:   CCoverageBuffer::AddIntervalToCells
+//
+//  Synopsis:   Add a subpixel resolution interval to the cell array.
+//
+//              The coverage of a pixel is the prefix sum of the cells up
+//              to and including it.  An interval covering pixels pl..pr
+//              contributes (8 - (left & 7)) to pl, 8 to the pixels in
+//              between and (right & 7) to pr, which takes four deltas:
+//
+//                  cell:   pl            pl+1         pr           pr+1
+//                  delta:  8-(left&7)    left&7       (right&7)-8  -(right&7)
+//
+//              Intervals are clipped to the cell range first.
+// 
+//-------------------------------------------------------------------------
+MIL_FORCEINLINE VOID
+CCoverageBuffer::AddIntervalToCells(INT nSubpixelXLeft, INT nSubpixelXRight)
+{
+    nSubpixelXLeft = max(nSubpixelXLeft, m_nCellSubpixelXLeft);
+    nSubpixelXRight = min(nSubpixelXRight, m_nCellSubpixelXRight);
+
+    if (nSubpixelXLeft < nSubpixelXRight)
+    {
+        nSubpixelXLeft -= m_nCellSubpixelXLeft;
+        nSubpixelXRight -= m_nCellSubpixelXLeft;
+
+        INT nCellLeft = nSubpixelXLeft >> c_nShift;
+        INT nCellRight = nSubpixelXRight >> c_nShift;
+
+        if (nCellLeft == nCellRight)
+        {
+            m_rgCells[nCellLeft] += nSubpixelXRight - nSubpixelXLeft;
+            m_rgCells[nCellLeft + 1] -= nSubpixelXRight - nSubpixelXLeft;
+        }
+        else
+        {
+            INT nCoverageLeft = c_nShiftSize - (nSubpixelXLeft & c_nShiftMask);
+            INT nCoverageRight = nSubpixelXRight & c_nShiftMask;
+
+            m_rgCells[nCellLeft] += nCoverageLeft;
+            m_rgCells[nCellLeft + 1] += c_nShiftSize - nCoverageLeft;
+            m_rgCells[nCellRight] += nCoverageRight - c_nShiftSize;
+            m_rgCells[nCellRight + 1] -= nCoverageRight;
+        }
+
+        m_nCellFirst = min(m_nCellFirst, nCellLeft);
+        m_nCellLast = max(m_nCellLast, nCellRight + 1);
+    }
+}
+
 //-------------------------------------------------------------------------
 //
 //  Function:   CCoverageBuffer::FillEdgesAlternating
@@ -349,6 +349,16 @@ BOOL IsPPAAMode(
     MilAntiAliasMode::Enum aam
     );
 
+VOID FASTCALL ScalePPAACoverage_32bppPBGRA(const PipelineParams *, const ScanOpParams *);
+
+// ScalePPAACoverage_32bppPBGRA fused with SrcOverAL_32bppPARGB_32bppPARGB
+// (PTernary operations, one per blend variant).
+
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_MMX(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_SSE2(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_AVX2(const PipelineParams *, const ScanOpParams *);
+
 // Helper function to downcast a CAntialiasedFiller without having to see its definition
 __ecount(1) OpSpecificData *DowncastFiller(
     __in_ecount(1) CAntialiasedFiller *pFiller
@@ -134,6 +134,20 @@ public:
     virtual ScanOpFunc GetScanOp() const override;
 
     void GenerateColors(INT x, INT y, __range(>=,1) UINT uiCount, __out_ecount_full(uiCount) GpCC *pargbDest) const;
+
+private:
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    __range(0, uiCount)
+    UINT GenerateColorsInTexture_AVX2(
+        __inout_ecount(1) FIX16 &x0,
+        __inout_ecount(1) FIX16 &y0,
+        FIX16 dx,
+        FIX16 dy,
+        UINT uiCount,
+        __out_ecount_part(uiCount, return) GpCC *pargbDest
+        ) const;
+#endif
 };
 
 /**************************************************************************
@@ -201,6 +215,15 @@ private:
         __out_ecount_full(uiCount) ARGB *pargbDest
         ) const;
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+    void InTile_Interpolation_AVX2(
+        INT u,
+        INT v,
+        UINT uiCount,
+        __out_ecount_full(uiCount) ARGB *pargbDest
+        ) const;
+#endif
+
 #if defined(_X86_)
     // Future Consideration:  SSE2 on 64-bit platforms.  SSE2 intrinsics are not
     // linking for 64bit.
@@ -27,6 +27,16 @@ MtExtern(CRadialGradientBrushSpan);
 MtExtern(CFocalGradientBrushSpan);
 MtExtern(CShaderEffectBrushSpan);
 
+VOID FASTCALL ColorSource_Constant_32bppPARGB(const PipelineParams *, const ScanOpParams *);
+
+// ColorSource_Constant_32bppPARGB fused with SrcOverAL_32bppPARGB_32bppPARGB
+// (PTernary operations, one per blend variant).
+
+VOID FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_MMX(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_SSE2(const PipelineParams *, const ScanOpParams *);
+VOID FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_AVX2(const PipelineParams *, const ScanOpParams *);
+
 //+-----------------------------------------------------------------------------
 //
 //  Class:
@@ -53,6 +63,14 @@ public:
         __in_ecount(1) const ScanOpParams *
         );
 
+    // ColorSource_Constant_32bppPARGB fused with a SrcOverAL 32bppPARGB
+    // blend. See RenderingBuilder's fusion table.
+    friend VOID ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(
+        __in_ecount(1) const PipelineParams *pPP,
+        __in_ecount(1) const ScanOpParams *pSOP,
+        ScanOpFunc pfnSrcOverAL
+        );
+
     ScanOpFunc GetScanOp() const override { return ColorSource_Constant_32bppPARGB; }
     MilPixelFormat::Enum GetPixelFormat() const override { return MilPixelFormat::PBGRA32bpp; }
 
@@ -188,12 +206,56 @@ private:
         __in INT nCount, 
         __out_ecount_full(nCount) ARGB *pArgbDest
         );
+
+    VOID GenerateSpan(
+        INT nTexturePositionIPC,
+        INT nXIncrement,
+        INT nCount,
+        __out_ecount_full(nCount) ARGB *pArgbDest
+        ) const;
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    __range(0, nCount)
+    UINT GenerateSpan_AVX2(
+        INT nTexturePositionIPC,
+        INT nXIncrement,
+        INT nCount,
+        __out_ecount_part(nCount, return) ARGB *pArgbDest
+        ) const;
+#endif
+
+    bool CopyColorsFromCachedRow(
+        INT nX,
+        INT nCount,
+        __out_ecount_full(nCount) ARGB *pArgbDest
+        ) const;
+
+    VOID UpdateCachedRow(
+        INT nX,
+        INT nCount,
+        __in_ecount(nCount) const ARGB *pArgbColors
+        );
+
+    VOID FreeCachedRow();
     
     friend VOID FASTCALL ColorSource_LinearGradient_32bppPARGB(
         __in_ecount(1) const PipelineParams *, 
         __in_ecount(1) const ScanOpParams *
         );
 
+private:
+
+    //
+    // When the gradient doesn't vary vertically every row of it is the same,
+    // so the colors of the widest span generated are kept and copied for
+    // later spans which lie within it.
+    //
+
+    ARGB *m_pargbCachedRow;
+    UINT m_cCachedRowPixelsAllocated;
+    INT m_nCachedRowX;
+    INT m_nCachedRowCount;
+
 protected:
 
     INT m_nM11;                     // Fixed point representation of
@@ -370,6 +432,16 @@ private:
         __in INT nCount, 
         __out_ecount_full(nCount) ARGB *pArgbDest
         );
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    __range(0, nCount)
+    UINT GenerateColors_AVX2(
+        INT nX,
+        INT nY,
+        INT nCount,
+        __out_ecount_part(nCount, return) ARGB *pArgbDest
+        ) const;
+#endif
     
     friend VOID FASTCALL ColorSource_RadialGradient_32bppPARGB(
         __in_ecount(1) const PipelineParams *, 
@@ -433,6 +505,16 @@ private:
         __out_ecount_full(nCount) ARGB *pArgbDest
         );
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+    __range(0, nCount)
+    UINT GenerateColors_AVX2(
+        INT nX,
+        INT nY,
+        INT nCount,
+        __out_ecount_part(nCount, return) ARGB *pArgbDest
+        ) const;
+#endif
+
     friend VOID FASTCALL ColorSource_FocalGradient_32bppPARGB(
         __in_ecount(1) const PipelineParams *, 
         __in_ecount(1) const ScanOpParams *
@@ -445,7 +527,7 @@ class CShaderEffectBrushSpan : public CColorSource
 {
 public:
     CShaderEffectBrushSpan();
-    ~CShaderEffectBrushSpan() override {}
+    ~CShaderEffectBrushSpan() override;
 
     DECLARE_METERHEAP_ALLOC(ProcessHeap, Mt(CShaderEffectBrushSpan));
 
@@ -471,11 +553,45 @@ private:
         __in_ecount(1) const PipelineParams *, 
         __in_ecount(1) const ScanOpParams *);
 
+    bool CopyColorsFromBand(
+        __in INT nX, 
+        __in INT nY, 
+        __in INT nCount, 
+        __out_ecount_full(nCount) ARGB *pArgbDest
+        );
+
+    HRESULT GenerateBand(
+        __in INT nX, 
+        __in INT nY, 
+        __in INT nCount
+        );
+
+    void FreeBand();
 
     CPixelShaderState m_pixelShaderState;
     CPixelShaderCompiler *m_pPixelShaderCompiler;
     GenerateColorsEffect *m_pfnGenerateColorsEffectWeakRef;
     CMILBrushShaderEffect *m_pShaderEffectBrushNoRef;
+
+    //
+    // Rows of colors generated ahead of the scan pipeline on the worker
+    // pool.  The band holds m_nBandRows rows of m_nBandCount pixels starting
+    // at (m_nBandX, m_nBandY).
+    //
+
+    ARGB *m_pargbBand;
+    UINT m_cBandPixelsAllocated;
+    INT m_nBandX;
+    INT m_nBandY;
+    INT m_nBandCount;
+    INT m_nBandRows;
+    INT m_nBandRowsUsed;
+
+    // Bottom of the shape's device bounds; rows below are never requested.
+    INT m_nShapeBottom;
+
+    // Set when requests don't follow the band, e.g. with complex clipping.
+    bool m_fBandingDisabled;
 };
 
 
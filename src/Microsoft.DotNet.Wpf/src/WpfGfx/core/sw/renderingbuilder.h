@@ -22,11 +22,11 @@ class RenderingBuilder : public ScanPipelineBuilder
 {
 public:
 
-    inline RenderingBuilder(
+    RenderingBuilder(
         __in_ecount(1) CScanPipelineRendering *pSP,
         __inout_ecount(1) CSPIntermediateBuffers *pIntermediateBuffers,
         BuilderMode eBuilderMode
-        ) : ScanPipelineBuilder(pSP, pIntermediateBuffers, eBuilderMode) {}
+        );
 
     HRESULT Append_EffectList(
         __in_ecount(1) IMILEffectList *pIEffectList,
@@ -103,6 +103,16 @@ protected:
         m_idxosdAAFiller = -1;
     }
 
+    virtual VOID OnOperationsFused(UINT uIndex)
+    {
+        // The operation at uIndex+1 and everything after it moved down by one.
+
+        if (m_idxosdAAFiller > static_cast<INT>(uIndex))
+        {
+            m_idxosdAAFiller--;
+        }
+    }
+
 private:
 
     friend class RenderingBuilder;
@@ -68,7 +68,9 @@
 
 // Realization
 
+#include "SwBitmapMipChain.h"
 #include "SwBitmapColorSource.h"
+#include "SwRealizationManager.h"
 
 // Caching
 
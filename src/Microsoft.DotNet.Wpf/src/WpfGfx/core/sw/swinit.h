@@ -24,6 +24,13 @@ void SwShutdown();
 
 extern bool g_fUseMMX;
 extern bool g_fUseSSE2;
+extern bool g_fPreferAVX2Spans;
+extern bool g_fUseBandedAARasterization;
+extern bool g_fUseAACoverageCells;
+extern UINT g_uMaxSwShaderEffectThreads;
+extern bool g_fAssembleGlyphRuns;
+extern bool g_fUseAsyncGlyphRasterization;
+extern bool g_fApproximateSwGaussianBlur;
 
 void HwShutdown();
 
@@ -14,6 +14,7 @@
 #include "precomp.hpp"
 
 MtDefine(CoverageIntervalBuffer, MILRawMemory, "CoverageIntervalBuffer");
+MtDefine(CoverageCells, MILRawMemory, "CoverageCells");
 
 //-------------------------------------------------------------------------
 //
@@ -39,6 +40,53 @@ CCoverageBuffer::Initialize()
     m_pIntervalStart = &m_pIntervalBufferBuiltin.m_interval[0];
     m_pIntervalNew = &m_pIntervalBufferBuiltin.m_interval[2];
     m_pIntervalEndMinus4 = &m_pIntervalBufferBuiltin.m_interval[INTERVAL_BUFFER_NUMBER - 4];
+
+    m_rgCells = NULL;
+    m_nCellPixelXLeft = 0;
+    m_nCellSubpixelXLeft = 0;
+    m_nCellSubpixelXRight = 0;
+    m_nCellFirst = INT_MAX;
+    m_nCellLast = INT_MIN;
+}
+
+//-------------------------------------------------------------------------
+//
+//  Function:   CCoverageBuffer::InitializeCells
+//
+//  Synopsis:   Switch the buffer to cell mode for the given pixel range.
+//              Coverage outside of the range is discarded, so the range
+//              must contain every pixel that will be output.
+// 
+//-------------------------------------------------------------------------
+HRESULT
+CCoverageBuffer::InitializeCells(INT nPixelXLeft, INT nPixelXRight)
+{
+    HRESULT hr = S_OK;
+    UINT cCells = 0;
+
+    Assert(m_rgCells == NULL);
+    Assert(nPixelXLeft < nPixelXRight);
+
+    // Intervals ending on the right edge write two cells past the last
+    // pixel.
+    IFC(IntToUInt(nPixelXRight - nPixelXLeft, &cCells));
+    IFC(UIntAdd(cCells, 2, &cCells));
+
+    IFC(HrMalloc(
+        Mt(CoverageCells),
+        sizeof(INT),
+        cCells,
+        (void **)&m_rgCells
+        ));
+
+    ZeroMemory(m_rgCells, cCells * sizeof(INT));
+
+    m_nCellPixelXLeft = nPixelXLeft;
+    m_nCellSubpixelXLeft = nPixelXLeft << c_nShift;
+    m_nCellSubpixelXRight = nPixelXRight << c_nShift;
+
+Cleanup:
+    RRETURN(hr);
 }
 
 //-------------------------------------------------------------------------
@@ -61,6 +109,12 @@ CCoverageBuffer::Destroy()
         GpFree(pIntervalBuffer);
         pIntervalBuffer = pIntervalBufferNext;
     }
+
+    if (m_rgCells != NULL)
+    {
+        GpFree(m_rgCells);
+        m_rgCells = NULL;
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -81,6 +135,165 @@ CCoverageBuffer::Reset()
     m_pIntervalBufferCurrent = &m_pIntervalBufferBuiltin;
     m_pIntervalNew = &m_pIntervalBufferBuiltin.m_interval[2];
     m_pIntervalEndMinus4 = &m_pIntervalBufferBuiltin.m_interval[INTERVAL_BUFFER_NUMBER - 4];
+
+    // Discard any cells that were never resolved.
+
+    if (m_rgCells != NULL && m_nCellFirst <= m_nCellLast)
+    {
+        ZeroMemory(&m_rgCells[m_nCellFirst], (m_nCellLast - m_nCellFirst + 1) * sizeof(INT));
+
+        m_nCellFirst = INT_MAX;
+        m_nCellLast = INT_MIN;
+    }
+}
+
+//-------------------------------------------------------------------------
+//
+//  Function:   PrefixSumCells
+//
+//  Synopsis:   Replace each cell by the sum of itself and all previous
+//              cells.
+// 
+//-------------------------------------------------------------------------
+static VOID
+PrefixSumCells(
+    __inout_ecount(cCells) INT *rgCells,
+    UINT cCells
+    )
+{
+    UINT i = 0;
+    INT nSum = 0;
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    if (CCPUInfo::HasSSE2ForEffects())
+    {
+        __m128i carry = _mm_setzero_si128();
+
+        for (; i + 4 <= cCells; i += 4)
+        {
+            // In-register scan of four cells, then add the running total
+            // of all previous groups.
+
+            __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i *>(&rgCells[i]));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi32(x, carry);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&rgCells[i]), x);
+
+            carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        nSum = _mm_cvtsi128_si32(carry);
+    }
+#endif
+
+    for (; i < cCells; i++)
+    {
+        nSum += rgCells[i];
+        rgCells[i] = nSum;
+    }
+}
+
+//-------------------------------------------------------------------------
+//
+//  Function:   CCoverageBuffer::ResolveCellsToIntervals
+//
+//  Synopsis:   
+//      Prefix-sum the touched cells to get per-pixel coverage and build the
+//      interval list with one interval per run of equal coverage.  The
+//      touched cells are cleared for the next scanline.
+//
+//-------------------------------------------------------------------------
+HRESULT
+CCoverageBuffer::ResolveCellsToIntervals()
+{
+    HRESULT hr = S_OK;
+
+    Assert(m_rgCells != NULL);
+    Assert(m_nCellFirst <= m_nCellLast);
+
+    // Cells may only be resolved into an empty list.
+    Assert(m_pIntervalStart->m_pNext->m_nPixelX == INT_MAX);
+
+    INT *rgCells = &m_rgCells[m_nCellFirst];
+    UINT cCells = static_cast<UINT>(m_nCellLast - m_nCellFirst + 1);
+    INT nPixelX = m_nCellPixelXLeft + m_nCellFirst;
+
+    CCoverageInterval *pInterval = m_pIntervalStart;
+    CCoverageInterval *pIntervalTail = pInterval->m_pNext;
+    CCoverageInterval *pIntervalNew = m_pIntervalNew;
+    CCoverageInterval *pIntervalEndMinus4 = m_pIntervalEndMinus4;
+    INT nCoverage = 0;
+    UINT i = 0;
+
+    PrefixSumCells(rgCells, cCells);
+
+    // The deltas of every interval sum to zero, so the last cell always
+    // closes the list with zero coverage.
+    Assert(rgCells[cCells - 1] == 0);
+
+    while (i < cCells)
+    {
+#if !defined(_ARM_) && !defined(_ARM64_)
+        if (CCPUInfo::HasSSE2ForEffects())
+        {
+            // Skip groups of four cells that continue the current run.
+
+            __m128i run = _mm_set1_epi32(nCoverage);
+
+            while (i + 4 <= cCells)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i *>(&rgCells[i]));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, run)) != 0xFFFF)
+                {
+                    break;
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(&rgCells[i]), _mm_setzero_si128());
+                i += 4;
+            }
+
+            if (i == cCells)
+            {
+                break;
+            }
+        }
+#endif
+
+        if (rgCells[i] != nCoverage)
+        {
+            if (pIntervalNew >= pIntervalEndMinus4)
+            {
+                IFC(Grow(&pIntervalNew, &pIntervalEndMinus4));
+            }
+
+            nCoverage = rgCells[i];
+            Assert(nCoverage >= 0 && nCoverage <= c_nShiftSizeSquared);
+
+            pIntervalNew->m_nPixelX = nPixelX + i;
+            pIntervalNew->m_nCoverage = nCoverage;
+            pIntervalNew->m_pNext = pIntervalTail;
+
+            pInterval->m_pNext = pIntervalNew;
+            pInterval = pIntervalNew;
+
+            pIntervalNew++;
+        }
+
+        rgCells[i] = 0;
+        i++;
+    }
+
+    Assert(nCoverage == 0);
+
+    m_pIntervalNew = pIntervalNew;
+
+    m_nCellFirst = INT_MAX;
+    m_nCellLast = INT_MIN;
+
+Cleanup:
+    RRETURN(hr);
 }
 
 //-------------------------------------------------------------------------
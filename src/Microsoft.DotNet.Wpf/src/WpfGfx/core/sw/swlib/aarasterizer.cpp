@@ -26,6 +26,13 @@ MtDefine(MAARasterizerInterval, MILRawMemory, "MAARasterizerInterval");
 // has not been thoroughly investigated.
 #define SORT_EDGES_INCLUDING_SLOPE  0
 
+// Banded rasterization splits tall paths into horizontal bands that are
+// rasterized concurrently.  It is only used with the EnableBandedSwRast
+// switch (see SwStartup).  Bands shorter than this many pixel rows aren't
+// worth the overhead of setting them up.
+const INT c_nMinAntialiasedBandRows = 64;
+const UINT c_uAntialiasedBandsPerThread = 2;
+
 
 /////////////////////////////////////////////////////////////////////////
 // The x86 C compiler insists on making a divide and modulus operation
@@ -249,6 +256,8 @@ AssertActiveListOrder(
 
 #endif
 
+class CAntialiasedBand;
+
 //+-----------------------------------------------------------------------------
 //
 //  Class:     CAntialiasedFiller
@@ -267,6 +276,11 @@ private:
     CMILSurfaceRect m_rcComplementBounds;
     float m_rComplementFactor;
 
+    // Pixel range of the coverage cells, empty when the coverage buffers
+    // use interval lists.
+    INT m_nCellPixelXLeft;
+    INT m_nCellPixelXRight;
+
 
     friend VOID FASTCALL ScalePPAACoverage_128bppPRGBA(
         __in_ecount(1) const PipelineParams *pPP,
@@ -288,6 +302,14 @@ private:
         __in_ecount(1) const PipelineParams *pPP,
         __in_ecount(1) const ScanOpParams *pSOP);
 
+    // ScalePPAACoverage_32bppPBGRA fused with a SrcOverAL 32bppPARGB blend.
+    // See RenderingBuilder's fusion table.
+    friend static VOID ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(
+        __in_ecount(1) const PipelineParams *pPP,
+        __in_ecount(1) const ScanOpParams *pSOP,
+        ScanOpFunc pfnSrcOverAL
+        );
+
     // Implementation of the last 4 32 bit ScalePPAACoverage variants.
     // Note that the input pixel formats are different for complement
     // & non-complement
@@ -331,6 +353,32 @@ public:
         m_coverageBuffer.Initialize();
 
         m_rComplementFactor = -1;
+
+        m_nCellPixelXLeft = 0;
+        m_nCellPixelXRight = 0;
+    }
+
+    //+------------------------------------------------------------------------
+    //
+    //  Member:    UseCoverageCells
+    //
+    //  Synopsis:  Accumulate coverage in flat per-pixel cell arrays instead
+    //             of interval lists.  Every output pixel must lie within
+    //             [nPixelXLeft, nPixelXRight).  Not supported for complement
+    //             rendering.
+    //
+    //-------------------------------------------------------------------------
+    HRESULT UseCoverageCells(
+        INT nPixelXLeft,
+        INT nPixelXRight
+        )
+    {
+        Assert(!CreateComplementGeometry());
+
+        m_nCellPixelXLeft = nPixelXLeft;
+        m_nCellPixelXRight = nPixelXRight;
+
+        RRETURN(m_coverageBuffer.InitializeCells(nPixelXLeft, nPixelXRight));
     }
 
     //+------------------------------------------------------------------------
@@ -391,16 +439,38 @@ public:
         MilFillMode::Enum fillMode
     );
 
+    // Like RasterizeEdges but rasterizes horizontal bands of the path
+    // concurrently.  Not supported for complement rendering.
+    HRESULT RasterizeEdgesBanded(
+        __in_ecount(cEdges) const CInactiveEdge *rgInactiveEdges,
+        UINT cEdges,
+        INT nSubpixelYTop,
+        INT nSubpixelYBottom,
+        UINT cBands,
+        MilFillMode::Enum fillMode
+        );
+
     // Like RasterizeEdges but for geometry with no edges.  Useful for complement only.
     HRESULT RasterizeNoEdges();
 
-    HRESULT FillEdges(
-        MilFillMode::Enum fillMode,
-        __in_ecount(1) const CEdge *active,
-        INT iCurrentY
-        );
-
     VOID GenerateOutput(INT iCurrentY);
+
+    HRESULT OutputCoverage(INT iCurrentY)
+    {
+        HRESULT hr = S_OK;
+
+        IFC(m_coverageBuffer.ResolveCells());
+        GenerateOutput(iCurrentY);
+
+    Cleanup:
+        RRETURN(hr);
+    }
+
+private:
+
+    VOID GenerateBandOutput(
+        __inout_ecount(1) CAntialiasedBand *pBand
+        );
 };
 
 //+-----------------------------------------------------------------------------
@@ -428,15 +498,22 @@ DowncastFiller(
 *   Given the active edge list for the current scan, do an alternate-mode
 *   antialiased fill.
 *
+*   TCoverageOutput is either CAntialiasedFiller, which emits the spans
+*   directly, or CAntialiasedBand, which records the coverage so that the
+*   spans can be emitted later.
+*
 * Created:
 *
 *   07/20/2003 ashrafm
 *
 \**************************************************************************/
 
+template <class TCoverageOutput>
 HRESULT
 MIL_FORCEINLINE
-CAntialiasedFiller::FillEdges(
+FillAntialiasedEdges(
+    __inout_ecount(1) TCoverageOutput *pOutput,
+    __inout_ecount(1) CCoverageBuffer *pCoverageBuffer,
     MilFillMode::Enum fillMode,
     __in_ecount(1) const CEdge *activeList,
     INT iCurrentY
@@ -448,20 +525,20 @@ CAntialiasedFiller::FillEdges(
 
     if (fillMode == MilFillMode::Winding)
     {
-        IFC(m_coverageBuffer.FillEdgesWinding(activeList, iCurrentY));
+        IFC(pCoverageBuffer->FillEdgesWinding(activeList, iCurrentY));
     }
     else
     {
         Assert(fillMode == MilFillMode::Alternate);
-        IFC(m_coverageBuffer.FillEdgesAlternating(activeList, iCurrentY));
+        IFC(pCoverageBuffer->FillEdgesAlternating(activeList, iCurrentY));
     }
 
     // If the next scan is done, output what's there:
 
     if (((iCurrentY + 1) & c_nShiftMask) == 0)
     {
-        GenerateOutput(iCurrentY);
-        m_coverageBuffer.Reset();
+        IFC(pOutput->OutputCoverage(iCurrentY));
+        pCoverageBuffer->Reset();
     }
 
 Cleanup:
@@ -778,6 +855,160 @@ VOID FASTCALL ScalePPAACoverage_32bppBGR(
         );
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Function:  ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl
+//
+//  Synopsis:  PTernary operation - ScalePPAACoverage_32bppPBGRA followed by
+//             the given SrcOverAL 32bppPARGB blend, without writing the scaled
+//             colors back to the blend source buffer.
+//
+//             Fully covered runs are blended straight from the blend source.
+//             Partially covered runs are scaled into a small stack buffer and
+//             blended from there. Both use pfnSrcOverAL, so the result is the
+//             same as running the two operations separately.
+//
+//------------------------------------------------------------------------------
+static VOID ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP,
+    ScanOpFunc pfnSrcOverAL
+    )
+{
+    const ARGB *pSrc = static_cast<const ARGB *>(pSOP->m_pvSrc1);
+    const ARGB *pDestIn = static_cast<const ARGB *>(pSOP->m_pvSrc2);
+    ARGB *pDestOut = static_cast<ARGB *>(pSOP->m_pvDest);
+
+    UINT nCount = pPP->m_uiCount;
+
+    INT nCurrent = pPP->m_iX;
+    INT nRight = nCurrent + nCount;
+    UINT uiConsecutivePixels;
+
+    Assert(nRight > nCurrent);
+
+    const CAntialiasedFiller *pAF = DYNCAST(CAntialiasedFiller, pSOP->m_posd);
+    Assert(pAF);
+    Assert(!pAF->CreateComplementGeometry());
+
+    const CCoverageInterval *pCoverage = pAF->m_coverageBuffer.m_pIntervalStart;
+
+    ARGB rgScaled[64];
+
+    PipelineParams ppRun = *pPP;
+    ScanOpParams sopRun;
+    sopRun.m_posd = NULL;
+
+    //
+    // Find the coverage information for the first pixel
+    //
+
+    while (pCoverage->m_pNext->m_nPixelX <= nCurrent)
+    {
+        pCoverage = pCoverage->m_pNext;
+    }
+
+    while (nCurrent < nRight)
+    {
+        uiConsecutivePixels = min(nRight, pCoverage->m_pNext->m_nPixelX) - nCurrent;
+
+        UINT uOffset = nCurrent - pPP->m_iX;
+
+        if (pCoverage->m_nCoverage == c_nShiftSizeSquared)
+        {
+            // Fully covered: the brush colors are blended as they are.
+
+            ppRun.m_iX = nCurrent;
+            ppRun.m_uiCount = uiConsecutivePixels;
+            sopRun.m_pvSrc1 = pSrc + uOffset;
+            sopRun.m_pvSrc2 = pDestIn + uOffset;
+            sopRun.m_pvDest = pDestOut + uOffset;
+
+            pfnSrcOverAL(&ppRun, &sopRun);
+        }
+        else
+        {
+            Assert(pCoverage->m_nCoverage > 0);
+
+            // Same scaling as ScalePPAACoverage_32bppPBGRA_Out_Slow.
+            UINT uScale = pCoverage->m_nCoverage*(256/(c_nShiftSize*c_nShiftSize));
+
+            UINT uDone = 0;
+
+            while (uDone < uiConsecutivePixels)
+            {
+                UINT uChunk = min(uiConsecutivePixels - uDone, static_cast<UINT>(ARRAYSIZE(rgScaled)));
+
+                for (UINT i = 0; i < uChunk; i++)
+                {
+                    UINT uColorSource = pSrc[uOffset + uDone + i];
+
+                    UINT uColorSource00aa00gg = (uColorSource >> 8) & 0x00ff00ff;
+                    UINT uColorSource00rr00bb = uColorSource & 0x00ff00ff;
+
+                    UINT uBlendedColoraa00gg00 = ((uColorSource00aa00gg * uScale + 0x00800080) & 0xff00ff00);
+                    UINT uBlendedColor00rr00bb = (((uColorSource00rr00bb * uScale + 0x00800080) >> 8) & 0x00ff00ff);
+
+                    rgScaled[i] = uBlendedColoraa00gg00 | uBlendedColor00rr00bb;
+                }
+
+                ppRun.m_iX = nCurrent + uDone;
+                ppRun.m_uiCount = uChunk;
+                sopRun.m_pvSrc1 = rgScaled;
+                sopRun.m_pvSrc2 = pDestIn + uOffset + uDone;
+                sopRun.m_pvDest = pDestOut + uOffset + uDone;
+
+                pfnSrcOverAL(&ppRun, &sopRun);
+
+                uDone += uChunk;
+            }
+        }
+
+        pCoverage = pCoverage->m_pNext;
+        nCurrent += uiConsecutivePixels;
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  ScalePPAACoverage_SrcOverAL_32bppPBGRA[_MMX|_SSE2|_AVX2]
+//
+//  Synopsis:  PTernary operations - ScalePPAACoverage_32bppPBGRA fused with
+//             the matching SrcOverAL_32bppPARGB_32bppPARGB variant.
+//
+
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB);
+}
+
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_MMX(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_MMX);
+}
+
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_SSE2(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_SSE2);
+}
+
+VOID FASTCALL ScalePPAACoverage_SrcOverAL_32bppPBGRA_AVX2(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ScalePPAACoverage_SrcOverAL_32bppPBGRA_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_AVX2);
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Function:  ScalePPAACoverage_Complement_32bppBGR
@@ -2677,19 +2908,27 @@ CAntialiasedFiller::RasterizeNoEdges()
 *       to traverse the edges and output the spans appropriately
 *   6.  Lather, rinse, and repeat
 *
+*   Every completed pixel row is handed to pOutput->OutputCoverage.  On
+*   return *pnSubpixelYEnd is the subpixel scan-line where rasterization
+*   stopped.
+*
 * Created:
 *
 *   03/25/2000 andrewgo
 *
 \**************************************************************************/
+template <class TCoverageOutput>
 HRESULT
-CAntialiasedFiller::RasterizeEdges(
+RasterizeAntialiasedEdges(
+    __inout_ecount(1) TCoverageOutput *pOutput,
+    __inout_ecount(1) CCoverageBuffer *pCoverageBuffer,
     __inout_ecount(1) CEdge *pEdgeActiveList,
     __inout_xcount(array terminated by an edge with StartY >= nSubpixelYBottom)
         CInactiveEdge *pInactiveEdgeArray,
     INT nSubpixelYCurrent,
     INT nSubpixelYBottom,
-    MilFillMode::Enum fillMode
+    MilFillMode::Enum fillMode,
+    __out_ecount(1) INT *pnSubpixelYEnd
     )
 {
     // Disable instrumentation checks for this function
@@ -2701,16 +2940,16 @@ CAntialiasedFiller::RasterizeEdges(
     INT nSubpixelYNextInactive;
     INT nSubpixelYNext;
 
-    InsertNewEdges(pEdgeActiveList, nSubpixelYCurrent, &pInactiveEdgeArray, &nSubpixelYNextInactive);
+    // A band of a path may start above its first edge.
 
-    if (CreateComplementGeometry())
+    if (pInactiveEdgeArray->Edge->StartY == nSubpixelYCurrent)
     {
-        // Generate spans for rows in complement above start of shape.
-        int yFirst = nSubpixelYCurrent >> c_nShift;
-        for (int y = m_rcComplementBounds.top; y < yFirst; ++y)
-        {
-            GenerateOutput(y << c_nShift);
-        }
+        InsertNewEdges(pEdgeActiveList, nSubpixelYCurrent, &pInactiveEdgeArray, &nSubpixelYNextInactive);
+    }
+    else
+    {
+        Assert(pInactiveEdgeArray->Edge->StartY > nSubpixelYCurrent);
+        nSubpixelYNextInactive = pInactiveEdgeArray->Edge->StartY;
     }
 
     while (nSubpixelYCurrent < nSubpixelYBottom)
@@ -2761,16 +3000,16 @@ CAntialiasedFiller::RasterizeEdges(
                 // Compute the coverage
                 for (int i = 0; i < c_nShiftSize; i++)
                 {
-                    IFC(m_coverageBuffer.AddInterval(pEdgeCurrent->X, pEdgeCurrent->Next->X));
+                    IFC(pCoverageBuffer->AddInterval(pEdgeCurrent->X, pEdgeCurrent->Next->X));
                 }
 
                 // Output the scans
                 while (nSubpixelYCurrent < nSubpixelYNext)
                 {
-                    GenerateOutput(nSubpixelYCurrent);
+                    IFC(pOutput->OutputCoverage(nSubpixelYCurrent));
                     nSubpixelYCurrent += c_nShiftSize;
                 }
-                m_coverageBuffer.Reset();
+                pCoverageBuffer->Reset();
             }
 
             Assert(nSubpixelYCurrent == nSubpixelYNext);
@@ -2800,7 +3039,7 @@ CAntialiasedFiller::RasterizeEdges(
             // Not two vertical edges, so fall back to the general case.
             //
 
-            IFC(FillEdges(fillMode, pEdgeActiveList, nSubpixelYCurrent));
+            IFC(FillAntialiasedEdges(pOutput, pCoverageBuffer, fillMode, pEdgeActiveList, nSubpixelYCurrent));
 
             // Advance nSubpixelYCurrent
             nSubpixelYCurrent += 1;
@@ -2830,9 +3069,58 @@ CAntialiasedFiller::RasterizeEdges(
 
     if ((nSubpixelYCurrent & c_nShiftMask) != 0)
     {
-        GenerateOutput(nSubpixelYCurrent);
+        IFC(pOutput->OutputCoverage(nSubpixelYCurrent));
+    }
+
+    *pnSubpixelYEnd = nSubpixelYCurrent;
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    CAntialiasedFiller::RasterizeEdges
+//
+//  Synopsis:  Rasterize the edges on the calling thread, emitting the spans
+//             of each pixel row as soon as its coverage is complete.
+//
+
+HRESULT
+CAntialiasedFiller::RasterizeEdges(
+    __inout_ecount(1) CEdge *pEdgeActiveList,
+    __inout_xcount(array terminated by an edge with StartY >= nSubpixelYBottom)
+        CInactiveEdge *pInactiveEdgeArray,
+    INT nSubpixelYCurrent,
+    INT nSubpixelYBottom,
+    MilFillMode::Enum fillMode
+    )
+{
+    HRESULT hr = S_OK;
+
+    Assert(pInactiveEdgeArray->Edge->StartY == nSubpixelYCurrent);
+
+    if (CreateComplementGeometry())
+    {
+        // Generate spans for rows in complement above start of shape.
+        int yFirst = nSubpixelYCurrent >> c_nShift;
+        for (int y = m_rcComplementBounds.top; y < yFirst; ++y)
+        {
+            GenerateOutput(y << c_nShift);
+        }
     }
 
+    IFC(RasterizeAntialiasedEdges(
+        this,
+        &m_coverageBuffer,
+        pEdgeActiveList,
+        pInactiveEdgeArray,
+        nSubpixelYCurrent,
+        nSubpixelYBottom,
+        fillMode,
+        &nSubpixelYCurrent
+        ));
+
     if (CreateComplementGeometry())
     {
         // Generate spans for scanlines in complement below start of shape.
@@ -2850,6 +3138,517 @@ Cleanup:
     RRETURN(hr);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Function:  AdvanceEdgeToY
+//
+//  Synopsis:  Advance an edge's DDA from its StartY down to nSubpixelY in
+//             one step.  The result is identical to advancing the DDA one
+//             scan-line at a time as AdvanceDDAAndUpdateActiveEdgeList does.
+//
+
+static VOID
+AdvanceEdgeToY(
+    __inout_ecount(1) CEdge *pEdge,
+    INT nSubpixelY
+    )
+{
+    Assert(nSubpixelY >= pEdge->StartY);
+    Assert(pEdge->ErrorUp < pEdge->ErrorDown);
+
+    LONGLONG llSteps = nSubpixelY - pEdge->StartY;
+    LONGLONG llError = pEdge->Error + llSteps * pEdge->ErrorUp;
+    LONGLONG llCarry = 0;
+
+    // Every time the error becomes non-negative it rolls over once.  Since
+    // ErrorUp < ErrorDown the error never needs more than one roll over per
+    // scan-line, so the number of roll overs is simply:
+
+    if (llError >= 0)
+    {
+        llCarry = llError / pEdge->ErrorDown + 1;
+        llError -= llCarry * pEdge->ErrorDown;
+    }
+
+    pEdge->X += static_cast<INT>(llSteps * pEdge->Dx + llCarry);
+    pEdge->Error = static_cast<INT>(llError);
+    pEdge->StartY = nSubpixelY;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:     CAntialiasedBand
+//
+//  Synopsis:  Coverage of one horizontal band of a path.  The band copies the
+//             edges that intersect it, advances them to the top of the band
+//             and rasterizes them into its own coverage buffer.  Instead of
+//             emitting spans, every completed pixel row is recorded so that
+//             CAntialiasedFiller can emit the spans in scan-line order on the
+//             calling thread.
+//
+
+struct CAntialiasedBandRow
+{
+    INT nSubpixelY;             // Scan-line passed to GenerateOutput
+    UINT uIntervalStart;        // Index of the row's head sentinel interval
+};
+
+class CAntialiasedBand
+{
+public:
+
+    CAntialiasedBand()
+    {
+        m_nSubpixelYTop = 0;
+        m_nSubpixelYBottom = 0;
+        m_coverageBuffer.Initialize();
+    }
+
+    ~CAntialiasedBand()
+    {
+        m_coverageBuffer.Destroy();
+    }
+
+    VOID SetBounds(
+        INT nSubpixelYTop,
+        INT nSubpixelYBottom
+        )
+    {
+        Assert(nSubpixelYTop < nSubpixelYBottom);
+
+        m_nSubpixelYTop = nSubpixelYTop;
+        m_nSubpixelYBottom = nSubpixelYBottom;
+    }
+
+    HRESULT InitializeCells(
+        INT nPixelXLeft,
+        INT nPixelXRight
+        )
+    {
+        RRETURN(m_coverageBuffer.InitializeCells(nPixelXLeft, nPixelXRight));
+    }
+
+    HRESULT Rasterize(
+        __in_ecount(cEdges) const CInactiveEdge *rgInactiveEdges,
+        UINT cEdges,
+        MilFillMode::Enum fillMode
+        );
+
+    HRESULT OutputCoverage(INT nSubpixelY);
+
+    UINT GetRowCount() const
+    {
+        return m_rgRows.GetCount();
+    }
+
+    __out_ecount(1) CCoverageInterval *GetRowCoverage(
+        UINT uRow,
+        __out_ecount(1) INT *pnSubpixelY
+        )
+    {
+        const CAntialiasedBandRow &row = m_rgRows[uRow];
+
+        *pnSubpixelY = row.nSubpixelY;
+        return &m_rgIntervals[row.uIntervalStart];
+    }
+
+private:
+
+    INT m_nSubpixelYTop;
+    INT m_nSubpixelYBottom;
+
+    CCoverageBuffer m_coverageBuffer;
+
+    // Recorded rows.  Each row is stored as a copy of its interval list
+    // including both sentinels.
+    DynArray<CCoverageInterval> m_rgIntervals;
+    DynArray<CAntialiasedBandRow> m_rgRows;
+
+    // Disable instrumentation checks within all methods of this class
+    SET_MILINSTRUMENTATION_FLAGS(MILINSTRUMENTATIONFLAGS_DONOTHING);
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    CAntialiasedBand::Rasterize
+//
+//  Synopsis:  Rasterize the part of the path that lies within the band.
+//
+//  Notes:     rgInactiveEdges is the sorted inactive array of the whole path.
+//             It is only read, so every band may use it concurrently.
+//
+
+HRESULT
+CAntialiasedBand::Rasterize(
+    __in_ecount(cEdges) const CInactiveEdge *rgInactiveEdges,
+    UINT cEdges,
+    MilFillMode::Enum fillMode
+    )
+{
+    HRESULT hr = S_OK;
+    CEdge *rgEdges = NULL;
+    CInactiveEdge *rgInactiveArray = NULL;
+    CEdge headEdge;
+    CEdge tailEdge;
+    UINT cBandEdges = 0;
+    UINT i;
+
+    // Count the edges that intersect the band.  The inactive array is sorted
+    // by StartY, so we can stop at the first edge that starts below the band.
+
+    for (i = 0; i < cEdges && rgInactiveEdges[i].Edge->StartY < m_nSubpixelYBottom; i++)
+    {
+        if (rgInactiveEdges[i].Edge->EndY > m_nSubpixelYTop)
+        {
+            cBandEdges++;
+        }
+    }
+
+    if (cBandEdges == 0)
+    {
+        goto Cleanup;
+    }
+
+    IFC(HrMalloc(
+        Mt(MAARasterizerEdge),
+        sizeof(CEdge),
+        cBandEdges,
+        (void **)&rgEdges
+        ));
+
+    {
+        UINT tempCount = 0;
+        IFC(UIntAdd(cBandEdges, 2, &tempCount));
+        IFC(HrMalloc(
+            Mt(MAARasterizerEdge),
+            sizeof(CInactiveEdge),
+            tempCount,
+            (void **)&rgInactiveArray
+            ));
+    }
+
+    tailEdge.X = INT_MAX;       // Terminator to active list
+#if SORT_EDGES_INCLUDING_SLOPE
+    tailEdge.Dx = INT_MAX;      // Terminator to active list
+#endif
+    tailEdge.StartY = INT_MAX;  // Terminator to inactive list
+    tailEdge.EndY = INT_MIN;
+
+    headEdge.X = INT_MIN;       // Beginning of active list
+    headEdge.Next = &tailEdge;
+
+    //
+    // Build a private inactive array for the band.  Edges that are already
+    // active at the top of the band are advanced to it, so they are
+    // inserted into the active list on the band's first scan-line.  As in
+    // InitializeInactiveArray the first entry is reserved as a head sentinel
+    // for the insertion sort and the last one points to the tail.
+    //
+
+    {
+        CEdge *pEdge = rgEdges;
+        CInactiveEdge *pInactiveEdge = rgInactiveArray + 1;
+
+        for (i = 0; i < cEdges && rgInactiveEdges[i].Edge->StartY < m_nSubpixelYBottom; i++)
+        {
+            if (rgInactiveEdges[i].Edge->EndY > m_nSubpixelYTop)
+            {
+                *pEdge = *rgInactiveEdges[i].Edge;
+
+                if (pEdge->StartY < m_nSubpixelYTop)
+                {
+                    AdvanceEdgeToY(pEdge, m_nSubpixelYTop);
+                }
+
+                pInactiveEdge->Edge = pEdge;
+                YX(pEdge->X, pEdge->StartY, &pInactiveEdge->Yx);
+
+                pEdge++;
+                pInactiveEdge++;
+            }
+        }
+
+        Assert(static_cast<UINT>(pEdge - rgEdges) == cBandEdges);
+
+        pInactiveEdge->Edge = &tailEdge;
+        rgInactiveArray->Yx = _I64_MIN;
+    }
+
+    if (cBandEdges > QUICKSORT_THRESHOLD)
+    {
+        QuickSortEdges(rgInactiveArray + 1, rgInactiveArray + cBandEdges);
+    }
+
+    InsertionSortEdges(rgInactiveArray + 1, cBandEdges);
+
+    ASSERTINACTIVEARRAY(rgInactiveArray + 1, cBandEdges);
+
+    {
+        INT nSubpixelYEnd;
+
+        IFC(RasterizeAntialiasedEdges(
+            this,
+            &m_coverageBuffer,
+            &headEdge,
+            rgInactiveArray + 1,
+            m_nSubpixelYTop,
+            m_nSubpixelYBottom,
+            fillMode,
+            &nSubpixelYEnd
+            ));
+    }
+
+    //
+    // The interval array may have moved while it grew, so the recorded rows
+    // are only linked once recording is complete.  Every row ends with its
+    // tail sentinel.
+    //
+
+    {
+        UINT cIntervals = m_rgIntervals.GetCount();
+        CCoverageInterval *rgIntervals = m_rgIntervals.GetDataBuffer();
+
+        for (i = 0; i < cIntervals; i++)
+        {
+            rgIntervals[i].m_pNext =
+                (rgIntervals[i].m_nPixelX == INT_MAX) ? NULL : &rgIntervals[i + 1];
+        }
+    }
+
+Cleanup:
+    if (rgInactiveArray != NULL)
+    {
+        GpFree(rgInactiveArray);
+    }
+
+    if (rgEdges != NULL)
+    {
+        GpFree(rgEdges);
+    }
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    CAntialiasedBand::OutputCoverage
+//
+//  Synopsis:  Record the coverage of a completed pixel row.  Rows without
+//             coverage don't produce any spans, so they are not recorded.
+//
+
+HRESULT
+CAntialiasedBand::OutputCoverage(
+    INT nSubpixelY
+    )
+{
+    HRESULT hr = S_OK;
+    const CCoverageInterval *pInterval = m_coverageBuffer.m_pIntervalStart;
+
+    IFC(m_coverageBuffer.ResolveCells());
+
+    if (pInterval->m_pNext->m_nPixelX != INT_MAX)
+    {
+        CAntialiasedBandRow row;
+        row.nSubpixelY = nSubpixelY;
+        row.uIntervalStart = m_rgIntervals.GetCount();
+
+        IFC(m_rgRows.Add(row));
+
+        // Copy the list including the head and tail sentinels.
+
+        do
+        {
+            IFC(m_rgIntervals.Add(*pInterval));
+            pInterval = pInterval->m_pNext;
+        } while (pInterval != NULL);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:     CAntialiasedBandWork
+//
+//  Synopsis:  Rasterizes every band of a path as an independent work item.
+//
+
+class CAntialiasedBandWork : public IParallelWorkItems
+{
+public:
+
+    CAntialiasedBandWork(
+        __inout_ecount(1) CAntialiasedBand *rgBands,
+        __in_ecount(cEdges) const CInactiveEdge *rgInactiveEdges,
+        UINT cEdges,
+        MilFillMode::Enum fillMode
+        )
+    {
+        m_rgBands = rgBands;
+        m_rgInactiveEdges = rgInactiveEdges;
+        m_cEdges = cEdges;
+        m_fillMode = fillMode;
+    }
+
+    HRESULT Execute(UINT uItem) override
+    {
+        return m_rgBands[uItem].Rasterize(m_rgInactiveEdges, m_cEdges, m_fillMode);
+    }
+
+private:
+
+    CAntialiasedBand *m_rgBands;
+    const CInactiveEdge *m_rgInactiveEdges;
+    UINT m_cEdges;
+    MilFillMode::Enum m_fillMode;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    CAntialiasedFiller::RasterizeEdgesBanded
+//
+//  Synopsis:  Split the path into horizontal bands and rasterize them
+//             concurrently on the worker pool.  Band boundaries are pixel
+//             aligned so that every pixel row is produced by exactly one
+//             band.
+//
+//             The span sink (clipper and scan pipeline) is not thread safe,
+//             so once all bands are done their recorded coverage is emitted
+//             in scan-line order on the calling thread.  The resulting spans
+//             and coverage are identical to RasterizeEdges.
+//
+
+HRESULT
+CAntialiasedFiller::RasterizeEdgesBanded(
+    __in_ecount(cEdges) const CInactiveEdge *rgInactiveEdges,
+    UINT cEdges,
+    INT nSubpixelYTop,
+    INT nSubpixelYBottom,
+    UINT cBands,
+    MilFillMode::Enum fillMode
+    )
+{
+    HRESULT hr = S_OK;
+    CAntialiasedBand *rgBands = NULL;
+
+    Assert(!CreateComplementGeometry());
+    Assert(cBands > 1);
+
+    INT nPixelYTop = nSubpixelYTop >> c_nShift;
+    INT nPixelRows = ((nSubpixelYBottom + c_nShiftMask) >> c_nShift) - nPixelYTop;
+
+    Assert(static_cast<UINT>(nPixelRows) >= cBands);
+
+    IFCOOM(rgBands = new CAntialiasedBand[cBands]);
+
+    {
+        INT nSubpixelYBandTop = nSubpixelYTop;
+
+        for (UINT i = 0; i < cBands; i++)
+        {
+            INT nSubpixelYBandBottom = nSubpixelYBottom;
+
+            if (i + 1 < cBands)
+            {
+                INT nPixelRowsAbove = static_cast<INT>(
+                    (static_cast<LONGLONG>(nPixelRows) * (i + 1)) / cBands
+                    );
+
+                nSubpixelYBandBottom = (nPixelYTop + nPixelRowsAbove) << c_nShift;
+            }
+
+            rgBands[i].SetBounds(nSubpixelYBandTop, nSubpixelYBandBottom);
+            nSubpixelYBandTop = nSubpixelYBandBottom;
+
+            if (m_nCellPixelXLeft < m_nCellPixelXRight)
+            {
+                IFC(rgBands[i].InitializeCells(m_nCellPixelXLeft, m_nCellPixelXRight));
+            }
+        }
+    }
+
+    {
+        CAntialiasedBandWork work(rgBands, rgInactiveEdges, cEdges, fillMode);
+
+        IFC(CParallelWorkPool::Execute(cBands, &work));
+    }
+
+    for (UINT i = 0; i < cBands; i++)
+    {
+        GenerateBandOutput(&rgBands[i]);
+    }
+
+Cleanup:
+    delete [] rgBands;
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:    CAntialiasedFiller::GenerateBandOutput
+//
+//  Synopsis:  Emit the spans for the rows recorded by a band.  The coverage
+//             buffer's list head is pointed at each recorded row in turn so
+//             that GenerateOutput and the ScalePPAACoverage operations see
+//             exactly the coverage the serial path would have produced.
+//
+
+VOID
+CAntialiasedFiller::GenerateBandOutput(
+    __inout_ecount(1) CAntialiasedBand *pBand
+    )
+{
+    CCoverageInterval *pIntervalStart = m_coverageBuffer.m_pIntervalStart;
+
+    for (UINT i = 0; i < pBand->GetRowCount(); i++)
+    {
+        INT nSubpixelY;
+
+        m_coverageBuffer.m_pIntervalStart = pBand->GetRowCoverage(i, &nSubpixelY);
+        GenerateOutput(nSubpixelY);
+    }
+
+    m_coverageBuffer.m_pIntervalStart = pIntervalStart;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:  GetAntialiasedBandCount
+//
+//  Synopsis:  Decide how many bands to rasterize a path with.  Returns 1 when
+//             the path should be rasterized serially.
+//
+
+static UINT
+GetAntialiasedBandCount(
+    INT nSubpixelYTop,
+    INT nSubpixelYBottom
+    )
+{
+    UINT cBands = 1;
+
+    if (g_fUseBandedAARasterization)
+    {
+        INT nPixelRows = ((nSubpixelYBottom + c_nShiftMask) >> c_nShift)
+                       - (nSubpixelYTop >> c_nShift);
+
+        // Use a couple of bands per thread so that a thread finishing a
+        // cheap band can pick up another one.
+
+        cBands = min(
+            CParallelWorkPool::GetMaxConcurrency() * c_uAntialiasedBandsPerThread,
+            static_cast<UINT>(nPixelRows / c_nMinAntialiasedBandRows)
+            );
+
+        cBands = max(cBands, 1u);
+    }
+
+    return cBands;
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Function:  RasterizePath
@@ -3060,6 +3859,14 @@ RasterizePath(
 
         pSpanSink->SetAntialiasedFiller(&filler);
 
+        // Every span is clipped to the clip bounds, so coverage cells only
+        // need to cover them.
+
+        if (g_fUseAACoverageCells && rComplementFactor < 0)
+        {
+            IFC(filler.UseCoverageCells(rc.left, rc.right));
+        }
+
         // 'yClipBottom' is in 28.4 format, and has to be converted
         // to the 30.2 (or 29.3) format we use for antialiasing:
 
@@ -3071,13 +3878,29 @@ RasterizePath(
 
         Assert(yBottom > iCurrentY);
 
-        IFC(filler.RasterizeEdges(
-            activeList,
-            inactiveArray,
-            iCurrentY,
-            yBottom,
-            fillMode
-            ));
+        UINT cBands = (rComplementFactor >= 0) ? 1 : GetAntialiasedBandCount(iCurrentY, yBottom);
+
+        if (cBands > 1)
+        {
+            IFC(filler.RasterizeEdgesBanded(
+                inactiveArray,
+                totalCount,
+                iCurrentY,
+                yBottom,
+                cBands,
+                fillMode
+                ));
+        }
+        else
+        {
+            IFC(filler.RasterizeEdges(
+                activeList,
+                inactiveArray,
+                iCurrentY,
+                yBottom,
+                fillMode
+                ));
+        }
     }
     else
     {
@@ -45,6 +45,10 @@
 
 #include "precomp.hpp"
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+#include "immintrin.h"
+#endif
+
 DeclarePerfAcc(ColorSource_Image_ScanOp);
 
 MtDefine(CIdentitySpan, MILRender, "CIdentitySpan");
@@ -721,9 +725,42 @@ void CNearestNeighborSpan::GenerateColors(
     INT ix;
     INT iy;
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+    const bool fUseAVX2 = CCPUInfo::HasAVX2();
+    UINT uiScalarCount = 0;     // Pixels left before the next AVX2 attempt
+#endif
+
     // For all pixels in the destination span...
     for (UINT i=0; i<uiCount; i++)
     {
+#if !defined(_ARM_) && !defined(_ARM64_)
+        if (fUseAVX2 && uiScalarCount-- == 0)
+        {
+            // Generate the run of pixels which map inside the texture 8 at a
+            // time. The next 8 pixels (or the rest of the span) contain at
+            // least one which needs the wrap mode, so they are done below.
+
+            UINT uiInside = GenerateColorsInTexture_AVX2(
+                x0,
+                y0,
+                dx,
+                dy,
+                uiCount - i,
+                pargbDest
+                );
+
+            i += uiInside;
+            pargbDest += uiInside;
+
+            if (i == uiCount)
+            {
+                break;
+            }
+
+            uiScalarCount = min(8u, uiCount - i) - 1;
+        }
+#endif
+
         // .. compute the position in source space.
 
         // round to the nearest neighbor
@@ -769,6 +806,95 @@ void CNearestNeighborSpan::GenerateColors(
     }
 }
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CNearestNeighborSpan::GenerateColorsInTexture_AVX2
+//
+//  Synopsis:
+//      Generates colors 8 at a time for as long as every pixel in the group of
+//      8 maps inside the texture, using gathers for the texel fetches. Advances
+//      x0 and y0 past the pixels generated and returns their count, which is a
+//      multiple of 8.
+//
+//------------------------------------------------------------------------------
+
+UINT CNearestNeighborSpan::GenerateColorsInTexture_AVX2(
+    __inout_ecount(1) FIX16 &x0,
+    __inout_ecount(1) FIX16 &y0,
+    FIX16 dx,
+    FIX16 dy,
+    UINT uiCount,
+    __out_ecount_part(uiCount, return) GpCC *pargbDest
+    ) const
+{
+    const INT *srcPtr0 = static_cast<const INT *>(m_pvBits);
+    INT stride = m_cbStride/sizeof(ARGB);
+
+    const __m256i vLane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Sample positions, pre-biased by a half so that the shift rounds to the
+    // nearest neighbor.
+
+    __m256i vX = _mm256_add_epi32(
+        _mm256_set1_epi32(x0 + FIX16_HALF),
+        _mm256_mullo_epi32(vLane, _mm256_set1_epi32(dx))
+        );
+    __m256i vY = _mm256_add_epi32(
+        _mm256_set1_epi32(y0 + FIX16_HALF),
+        _mm256_mullo_epi32(vLane, _mm256_set1_epi32(dy))
+        );
+
+    const __m256i vStepX = _mm256_slli_epi32(_mm256_set1_epi32(dx), 3);
+    const __m256i vStepY = _mm256_slli_epi32(_mm256_set1_epi32(dy), 3);
+
+    const __m256i vZero = _mm256_setzero_si256();
+    const __m256i vMaxX = _mm256_set1_epi32(static_cast<INT>(m_nWidth) - 1);
+    const __m256i vMaxY = _mm256_set1_epi32(static_cast<INT>(m_nHeight) - 1);
+    const __m256i vStride = _mm256_set1_epi32(stride);
+
+    UINT i = 0;
+
+    for (; i + 8 <= uiCount; i += 8)
+    {
+        __m256i vIX = _mm256_srai_epi32(vX, FIX16_SHIFT);
+        __m256i vIY = _mm256_srai_epi32(vY, FIX16_SHIFT);
+
+        __m256i vOutside = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpgt_epi32(vZero, vIX),
+                _mm256_cmpgt_epi32(vIX, vMaxX)
+                ),
+            _mm256_or_si256(
+                _mm256_cmpgt_epi32(vZero, vIY),
+                _mm256_cmpgt_epi32(vIY, vMaxY)
+                )
+            );
+
+        if (!_mm256_testz_si256(vOutside, vOutside))
+        {
+            break;
+        }
+
+        __m256i vIndex = _mm256_add_epi32(_mm256_mullo_epi32(vIY, vStride), vIX);
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(pargbDest + i),
+            _mm256_i32gather_epi32(srcPtr0, vIndex, sizeof(ARGB))
+            );
+
+        vX = _mm256_add_epi32(vX, vStepX);
+        vY = _mm256_add_epi32(vY, vStepY);
+    }
+
+    x0 += static_cast<INT>(i) * dx;
+    y0 += static_cast<INT>(i) * dy;
+
+    return i;
+}
+#endif
+
 //+-----------------------------------------------------------------------------
 //
 //  Class:
@@ -1643,6 +1769,15 @@ void CBilinearSpan::GenerateColors(
             // Postcondition:  horiz_min <= u+(N-1)*UIncrement < horiz_max
             // Postcondition:  vert_min <= v+(N-1)*VIncrement < vert_max
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+            // The AVX2 runs match the C path but not the x86 SSE2 one, so
+            // they are only taken when EnableAVX2ForSwRast asks for them.
+            if (!isFlipped && N >= 8 && g_fPreferAVX2Spans)
+            {
+                InTile_Interpolation_AVX2(u, v, N, pargbDest);
+            }
+            else
+#endif
 #if defined(_X86_)
             if (g_fUseSSE2 && N > SSE_THRESHOLD)
             {
@@ -2166,6 +2301,126 @@ void CBilinearSpan::FlippedTile_Interpolation_C(
     }
 }
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CBilinearSpan::InTile_Interpolation_AVX2
+//
+//  Synopsis:
+//      Handles bilinear interpolation within the canonical tile when no flip
+//      is in effect, 8 pixels at a time.
+//
+//  Notes:
+//      The caller guarantees that all four texels of every sample lie inside
+//      the texture, so the texels are fetched with gathers and no wrap checks.
+//      The arithmetic is that of getBilinearFilteredARGB, done per channel in
+//      32-bit lanes, so the results match FlippedTile_Interpolation_C exactly.
+//      The tail of fewer than 8 pixels is handed to the C version.
+//
+//------------------------------------------------------------------------------
+void CBilinearSpan::InTile_Interpolation_AVX2(
+    INT u,
+    INT v,
+    UINT uiCount,
+    __out_ecount_full(uiCount) ARGB *pargbDest
+    ) const
+{
+    Assert(!IsLargeTexture());
+
+    const INT *srcPtr0 = static_cast<const INT *>(m_pvBits);
+    INT stride = m_cbStride/sizeof(ARGB);
+
+    const __m256i vLane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256i vU = _mm256_add_epi32(
+        _mm256_set1_epi32(u),
+        _mm256_mullo_epi32(vLane, _mm256_set1_epi32(UIncrement))
+        );
+    __m256i vV = _mm256_add_epi32(
+        _mm256_set1_epi32(v),
+        _mm256_mullo_epi32(vLane, _mm256_set1_epi32(VIncrement))
+        );
+
+    const __m256i vStepU = _mm256_slli_epi32(_mm256_set1_epi32(UIncrement), 3);
+    const __m256i vStepV = _mm256_slli_epi32(_mm256_set1_epi32(VIncrement), 3);
+
+    const __m256i vStride = _mm256_set1_epi32(stride);
+    const __m256i vByteMask = _mm256_set1_epi32(0xff);
+    const __m256i vOne = _mm256_set1_epi32(1 << 8);
+    const __m256i vHalf2 = _mm256_set1_epi32(1 << 15);
+
+    UINT i = 0;
+
+    for (; i + 8 <= uiCount; i += 8)
+    {
+        __m256i vX1 = _mm256_srai_epi32(vU, 16);
+        __m256i vY1 = _mm256_srai_epi32(vV, 16);
+
+        __m256i vXFrac = _mm256_and_si256(_mm256_srli_epi32(vU, 8), vByteMask);
+        __m256i vYFrac = _mm256_and_si256(_mm256_srli_epi32(vV, 8), vByteMask);
+        __m256i vOneMinusYFrac = _mm256_sub_epi32(vOne, vYFrac);
+
+        // Index of A; B, C and D follow at +1, +stride and +stride+1.
+
+        __m256i vIndex = _mm256_add_epi32(_mm256_mullo_epi32(vY1, vStride), vX1);
+
+        __m256i vA = _mm256_i32gather_epi32(srcPtr0, vIndex, sizeof(ARGB));
+        __m256i vB = _mm256_i32gather_epi32(srcPtr0 + 1, vIndex, sizeof(ARGB));
+        __m256i vC = _mm256_i32gather_epi32(srcPtr0 + stride, vIndex, sizeof(ARGB));
+        __m256i vD = _mm256_i32gather_epi32(srcPtr0 + stride + 1, vIndex, sizeof(ARGB));
+
+        __m256i vResult = _mm256_setzero_si256();
+
+        for (INT iShift = 0; iShift < 32; iShift += 8)
+        {
+            __m256i vChannelA = _mm256_and_si256(_mm256_srli_epi32(vA, iShift), vByteMask);
+            __m256i vChannelB = _mm256_and_si256(_mm256_srli_epi32(vB, iShift), vByteMask);
+            __m256i vChannelC = _mm256_and_si256(_mm256_srli_epi32(vC, iShift), vByteMask);
+            __m256i vChannelD = _mm256_and_si256(_mm256_srli_epi32(vD, iShift), vByteMask);
+
+            // Interpolate in x along the A-B and C-D rows, then in y.
+
+            __m256i vTop = _mm256_add_epi32(
+                _mm256_slli_epi32(vChannelA, 8),
+                _mm256_mullo_epi32(_mm256_sub_epi32(vChannelB, vChannelA), vXFrac)
+                );
+            __m256i vBottom = _mm256_add_epi32(
+                _mm256_slli_epi32(vChannelC, 8),
+                _mm256_mullo_epi32(_mm256_sub_epi32(vChannelD, vChannelC), vXFrac)
+                );
+
+            __m256i vChannel = _mm256_add_epi32(
+                _mm256_add_epi32(
+                    _mm256_mullo_epi32(vOneMinusYFrac, vTop),
+                    _mm256_mullo_epi32(vYFrac, vBottom)
+                    ),
+                vHalf2
+                );
+
+            vChannel = _mm256_srli_epi32(vChannel, 16);
+
+            vResult = _mm256_or_si256(vResult, _mm256_slli_epi32(vChannel, iShift));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pargbDest + i), vResult);
+
+        vU = _mm256_add_epi32(vU, vStepU);
+        vV = _mm256_add_epi32(vV, vStepV);
+    }
+
+    if (i < uiCount)
+    {
+        FlippedTile_Interpolation_C(
+            u + static_cast<INT>(i)*UIncrement,
+            v + static_cast<INT>(i)*VIncrement,
+            uiCount - i,
+            pargbDest + i
+            );
+    }
+}
+#endif
+
 #if defined(_X86_)
 //+-----------------------------------------------------------------------------
 //
@@ -22,12 +22,18 @@
 
 #include "precomp.hpp"
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+#include "immintrin.h"
+#endif
+
 MtDefine(CConstantColorBrushSpan, MILRender, "CConstantColorBrushSpan");
 MtDefine(CLinearGradientBrushSpan, MILRender, "CLinearGradientBrushSpan");
 MtDefine(CLinearGradientBrushSpan_MMX, MILRender, "CLinearGradientBrushSpan_MMX");
 MtDefine(CRadialGradientBrushSpan, MILRender, "CRadialGradientBrushSpan");
 MtDefine(CFocalGradientBrushSpan, MILRender, "CFocalGradientBrushSpan");
 MtDefine(CShaderEffectBrushSpan, MILRender, "CShaderEffectBrushSpan");
+MtDefine(MShaderEffectBand, MILRawMemory, "MShaderEffectBand");
+MtDefine(MLinearGradientCachedRow, MILRawMemory, "MLinearGradientCachedRow");
 
 // # of fractional bits that we iterate across the texture with:
 
@@ -43,6 +49,98 @@ MtDefine(CShaderEffectBrushSpan, MILRender, "CShaderEffectBrushSpan");
 
 #define ONEDGETFRACTIONAL8BITS(x) (((x) >> (ONEDNUMFRACTIONALBITS - 8)) & 0xff)
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      SampleGradientTexture_AVX2
+//
+//  Synopsis:
+//      Looks up 8 fixed point gradient texture positions the way the C
+//      GenerateColors loops do and returns the interpolated colors.
+//
+//      fClampFirst chooses the first texel for negative indices, and
+//      fClampLast the last texel for indices at or beyond it. Otherwise the
+//      index wraps around the texture.
+//
+//------------------------------------------------------------------------------
+
+static MIL_FORCEINLINE __m256i
+SampleGradientTexture_AVX2(
+    __in_ecount(MAX_GRADIENTTEXEL_COUNT) const AGRB64TEXEL *pStartTexels,
+    __in_ecount(MAX_GRADIENTTEXEL_COUNT) const AGRB64TEXEL *pEndTexels,
+    __m256i vTexturePositionIPC,
+    bool fClampFirst,
+    bool fClampLast,
+    INT nTexelCountMinusOne
+    )
+{
+    __m256i vLastIndex = _mm256_set1_epi32(nTexelCountMinusOne);
+
+    __m256i vIndex = _mm256_srai_epi32(vTexturePositionIPC, ONEDNUMFRACTIONALBITS);
+    __m256i vWeightB = _mm256_and_si256(
+        _mm256_srli_epi32(vTexturePositionIPC, ONEDNUMFRACTIONALBITS - 8),
+        _mm256_set1_epi32(0xff)
+        );
+
+    if (fClampFirst)
+    {
+        __m256i vBelow = _mm256_cmpgt_epi32(_mm256_setzero_si256(), vIndex);
+        vIndex = _mm256_andnot_si256(vBelow, vIndex);
+        vWeightB = _mm256_andnot_si256(vBelow, vWeightB);
+    }
+
+    if (fClampLast)
+    {
+        __m256i vAbove = _mm256_cmpgt_epi32(vIndex, _mm256_set1_epi32(nTexelCountMinusOne - 1));
+        vIndex = _mm256_min_epi32(vIndex, vLastIndex);
+        vWeightB = _mm256_andnot_si256(vAbove, vWeightB);
+    }
+    else
+    {
+        vIndex = _mm256_and_si256(vIndex, vLastIndex);
+    }
+
+    __m256i vWeightA = _mm256_sub_epi32(_mm256_set1_epi32(256), vWeightB);
+
+    // Each texel is two DWORDs, A00rr00bb followed by A00aa00gg.
+
+    const int *pnStart = reinterpret_cast<const int *>(pStartTexels);
+    const int *pnEnd = reinterpret_cast<const int *>(pEndTexels);
+    __m256i vOffset = _mm256_slli_epi32(vIndex, 1);
+
+    __m256i vStartRB = _mm256_i32gather_epi32(pnStart, vOffset, 4);
+    __m256i vStartAG = _mm256_i32gather_epi32(pnStart + 1, vOffset, 4);
+    __m256i vEndRB = _mm256_i32gather_epi32(pnEnd, vOffset, 4);
+    __m256i vEndAG = _mm256_i32gather_epi32(pnEnd + 1, vOffset, 4);
+
+    __m256i vRound = _mm256_set1_epi32(0x00800080);
+
+    __m256i vRRRRBBBB = _mm256_add_epi32(
+        _mm256_add_epi32(
+            _mm256_mullo_epi32(vStartRB, vWeightA),
+            _mm256_mullo_epi32(vEndRB, vWeightB)
+            ),
+        vRound
+        );
+
+    __m256i vAAAAGGGG = _mm256_add_epi32(
+        _mm256_add_epi32(
+            _mm256_mullo_epi32(vStartAG, vWeightA),
+            _mm256_mullo_epi32(vEndAG, vWeightB)
+            ),
+        vRound
+        );
+
+    __m256i vHighBytes = _mm256_set1_epi32(static_cast<int>(0xff00ff00));
+
+    return _mm256_add_epi32(
+        _mm256_and_si256(vAAAAGGGG, vHighBytes),
+        _mm256_srli_epi32(_mm256_and_si256(vRRRRBBBB, vHighBytes), 8)
+        );
+}
+#endif
+
 //
 // sRGB color space spans.
 //
@@ -67,6 +165,105 @@ FASTCALL ColorSource_Constant_32bppPARGB(
     FillMemoryInt32(pSOP->m_pvDest, pPP->m_uiCount, pColorSource->m_Color);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ColorSource_Constant_SrcOverAL_32bppPARGB_Impl
+//
+//  Synopsis:
+//      PTernary operation - ColorSource_Constant_32bppPARGB followed by the
+//      given SrcOverAL 32bppPARGB blend, without filling the blend source
+//      buffer.
+//
+//      An opaque color is written straight to the destination and a fully
+//      transparent one writes nothing, as the blend would. Otherwise the
+//      color is blended from a small stack buffer with pfnSrcOverAL, so the
+//      result is the same as running the two operations separately.
+//
+//------------------------------------------------------------------------------
+
+VOID
+ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP,
+    ScanOpFunc pfnSrcOverAL
+    )
+{
+    const CConstantColorBrushSpan *pColorSource = DYNCAST(CConstantColorBrushSpan, pSOP->m_posd);
+    Assert(pColorSource);
+
+    ARGB color = pColorSource->m_Color;
+
+    if (color == 0)
+    {
+        // SrcOverAL doesn't write pixels whose source is zero.
+    }
+    else if ((color & MIL_ALPHA_MASK) == MIL_ALPHA_MASK)
+    {
+        FillMemoryInt32(pSOP->m_pvDest, pPP->m_uiCount, color);
+    }
+    else
+    {
+        const ARGB *pDestIn = static_cast<const ARGB *>(pSOP->m_pvSrc2);
+        ARGB *pDestOut = static_cast<ARGB *>(pSOP->m_pvDest);
+
+        ARGB rgColor[64];
+        UINT uFilled = min(pPP->m_uiCount, static_cast<UINT>(ARRAYSIZE(rgColor)));
+        FillMemoryInt32(rgColor, uFilled, color);
+
+        PipelineParams ppRun = *pPP;
+        ScanOpParams sopRun;
+        sopRun.m_pvSrc1 = rgColor;
+        sopRun.m_posd = NULL;
+
+        for (UINT uDone = 0; uDone < pPP->m_uiCount; uDone += uFilled)
+        {
+            ppRun.m_iX = pPP->m_iX + uDone;
+            ppRun.m_uiCount = min(pPP->m_uiCount - uDone, uFilled);
+            sopRun.m_pvSrc2 = pDestIn + uDone;
+            sopRun.m_pvDest = pDestOut + uDone;
+
+            pfnSrcOverAL(&ppRun, &sopRun);
+        }
+    }
+}
+
+VOID
+FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB);
+}
+
+VOID
+FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_MMX(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_MMX);
+}
+
+VOID
+FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_SSE2(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_SSE2);
+}
+
+VOID
+FASTCALL ColorSource_Constant_SrcOverAL_32bppPARGB_AVX2(
+    __in_ecount(1) const PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP
+    )
+{
+    ColorSource_Constant_SrcOverAL_32bppPARGB_Impl(pPP, pSOP, SrcOverAL_32bppPARGB_32bppPARGB_AVX2);
+}
+
 HRESULT 
 CConstantColorBrushSpan::Initialize(
     __in_ecount(1) const MilColorF *pColor
@@ -196,10 +393,15 @@ CGradientBrushSpan::InitializeTexture(
 CLinearGradientBrushSpan::CLinearGradientBrushSpan()
     : CGradientBrushSpan()
 {
+    m_pargbCachedRow = NULL;
+    m_cCachedRowPixelsAllocated = 0;
+    m_nCachedRowX = 0;
+    m_nCachedRowCount = 0;
 }
 
 CLinearGradientBrushSpan::~CLinearGradientBrushSpan()
 {
+    FreeCachedRow();
 }
 
 HRESULT 
@@ -254,6 +456,9 @@ CLinearGradientBrushSpan::Initialize(
         m_nXIncrement = m_nM11;
     }
 
+    // Colors cached for a previous gradient don't apply to this one
+    m_nCachedRowCount = 0;
+
     RRETURN(hr);
 }
 
@@ -327,9 +532,20 @@ FASTCALL ColorSource_LinearGradient_32bppPARGB(
 VOID 
 CLinearGradientBrushSpan::ReleaseExpensiveResources()
 {
-   // This class doesn't hold onto resources that need to be released
+    FreeCachedRow();
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::GenerateColors
+//
+//  Synopsis:
+//      Generates the colors of a span, copying them from the cached row when
+//      every row of the gradient is the same.
+//
+//------------------------------------------------------------------------------
+
 void 
 CLinearGradientBrushSpan::GenerateColors(
     __in INT nX, 
@@ -338,17 +554,15 @@ CLinearGradientBrushSpan::GenerateColors(
     __out_ecount_full(nCount) ARGB *pArgbDest
     )
 {
-    // Copy some class stuff to local variables for faster access in
-    // our inner loop:
+    // Without a vertical component the texture position depends only on x,
+    // so every row is the same. (Without a horizontal one GenerateSpan fills
+    // the span with a single color instead.)
+    bool fRowsMatch = (m_nM21 == 0) && (m_nXIncrement != 0);
 
-    const AGRB64TEXEL *pStartTexels = &m_rgStartTexelAgrb[0];
-    const AGRB64TEXEL *pEndTexels = &m_rgEndTexelAgrb[0];
-    
-    const AGRB64TEXEL *pStartTexel;
-    const AGRB64TEXEL *pEndTexel;
-    
-    UINT uWeightA = 256;
-    UINT uWeightB = 0;
+    if (fRowsMatch && CopyColorsFromCachedRow(nX, nCount, pArgbDest))
+    {
+        return;
+    }
 
     // Given our start point in device space, figure out the corresponding 
     // texture pixel.  Note that this is expressed as a fixed-point number 
@@ -365,10 +579,90 @@ CLinearGradientBrushSpan::GenerateColors(
         &nXIncrement
         );
 
+    GenerateSpan(nTexturePositionIPC, nXIncrement, nCount, pArgbDest);
+
+    if (fRowsMatch && (nCount > m_nCachedRowCount))
+    {
+        //
+        // In extend mode GenerateColorsInit picks one color for a span which
+        // leaves Fix16 range, and that depends on the extent of the span, so
+        // only spans whose positions all stay in range are cached.
+        //
+
+        LONGLONG llLastPositionIPC =
+              static_cast<LONGLONG>(nTexturePositionIPC)
+            + static_cast<LONGLONG>(nXIncrement) * static_cast<LONGLONG>(nCount - 1);
+
+        if (   (m_wrapMode != MilGradientWrapMode::Extend)
+            || (   (nXIncrement == m_nXIncrement)
+                && (llLastPositionIPC >= INT_MIN)))
+        {
+            UpdateCachedRow(nX, nCount, pArgbDest);
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::GenerateSpan
+//
+//  Synopsis:
+//      Generates nCount colors starting at the given texture position.
+//
+//      A zero increment (an axis aligned gradient whose stripes run along the
+//      span) gives the same color for the whole span, which is filled.
+//
+//------------------------------------------------------------------------------
+
+VOID
+CLinearGradientBrushSpan::GenerateSpan(
+    INT nTexturePositionIPC,
+    INT nXIncrement,
+    INT nCount,
+    __out_ecount_full(nCount) ARGB *pArgbDest
+    ) const
+{
+    // Copy some class stuff to local variables for faster access in
+    // our inner loop:
+
+    const AGRB64TEXEL *pStartTexels = &m_rgStartTexelAgrb[0];
+    const AGRB64TEXEL *pEndTexels = &m_rgEndTexelAgrb[0];
+    
+    const AGRB64TEXEL *pStartTexel;
+    const AGRB64TEXEL *pEndTexel;
+    
+    UINT uWeightA = 256;
+    UINT uWeightB = 0;
+
     BOOL extendMode = (m_wrapMode == MilGradientWrapMode::Extend);
     INT nTexelCountMinusOne = m_uTexelCountMinusOne;
 
-    do {
+    INT nFillCount = 0;
+
+    if (nXIncrement == 0)
+    {
+        nFillCount = nCount - 1;
+        nCount = 1;
+    }
+#if !defined(_ARM_) && !defined(_ARM64_)
+    else if (nCount >= 8 && CCPUInfo::HasAVX2())
+    {
+        UINT uGenerated = GenerateSpan_AVX2(
+            nTexturePositionIPC,
+            nXIncrement,
+            nCount,
+            pArgbDest
+            );
+
+        nTexturePositionIPC += static_cast<INT>(uGenerated) * nXIncrement;
+        pArgbDest += uGenerated;
+        nCount -= static_cast<INT>(uGenerated);
+    }
+#endif
+
+    while (nCount > 0)
+    {
         // We want to linearly interpolate between two pixels,
         // A and B (where A is the floor pixel, B the ceiling pixel).
         // 'uWeightA' is the fraction of pixel A that we want, and
@@ -426,7 +720,168 @@ CLinearGradientBrushSpan::GenerateColors(
 
         *pArgbDest++ = (aaaagggg & 0xff00ff00) + ((rrrrbbbb & 0xff00ff00) >> 8);
         nTexturePositionIPC += nXIncrement;
-    } while (--nCount != 0);
+        nCount--;
+    }
+
+    if (nFillCount > 0)
+    {
+        FillMemoryInt32(pArgbDest, nFillCount, pArgbDest[-1]);
+    }
+}
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::GenerateSpan_AVX2
+//
+//  Synopsis:
+//      Generates colors 8 at a time, with the same results as the C loop in
+//      GenerateSpan. Returns the number of colors generated, which is a
+//      multiple of 8.
+//
+//------------------------------------------------------------------------------
+
+UINT
+CLinearGradientBrushSpan::GenerateSpan_AVX2(
+    INT nTexturePositionIPC,
+    INT nXIncrement,
+    INT nCount,
+    __out_ecount_part(nCount, return) ARGB *pArgbDest
+    ) const
+{
+    bool fExtendMode = (m_wrapMode == MilGradientWrapMode::Extend);
+    INT nTexelCountMinusOne = static_cast<INT>(m_uTexelCountMinusOne);
+
+    __m256i vTexturePositionIPC = _mm256_add_epi32(
+        _mm256_set1_epi32(nTexturePositionIPC),
+        _mm256_mullo_epi32(
+            _mm256_set1_epi32(nXIncrement),
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+            )
+        );
+    __m256i vXIncrement = _mm256_slli_epi32(_mm256_set1_epi32(nXIncrement), 3);
+
+    UINT uGenerated = 0;
+
+    for (; uGenerated + 8 <= static_cast<UINT>(nCount); uGenerated += 8)
+    {
+        __m256i vColors = SampleGradientTexture_AVX2(
+            m_rgStartTexelAgrb,
+            m_rgEndTexelAgrb,
+            vTexturePositionIPC,
+            fExtendMode,
+            fExtendMode,
+            nTexelCountMinusOne
+            );
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pArgbDest + uGenerated), vColors);
+
+        vTexturePositionIPC = _mm256_add_epi32(vTexturePositionIPC, vXIncrement);
+    }
+
+    return uGenerated;
+}
+#endif
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::CopyColorsFromCachedRow
+//
+//  Synopsis:
+//      Copies the colors of a span from the cached row if it lies within it.
+//      Returns false otherwise.
+//
+//------------------------------------------------------------------------------
+
+bool
+CLinearGradientBrushSpan::CopyColorsFromCachedRow(
+    INT nX,
+    INT nCount,
+    __out_ecount_full(nCount) ARGB *pArgbDest
+    ) const
+{
+    if (   (m_nCachedRowCount == 0)
+        || (nX < m_nCachedRowX)
+        || (nX + nCount > m_nCachedRowX + m_nCachedRowCount))
+    {
+        return false;
+    }
+
+    RtlCopyMemory(
+        pArgbDest,
+        m_pargbCachedRow + (nX - m_nCachedRowX),
+        nCount * sizeof(ARGB)
+        );
+
+    return true;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::UpdateCachedRow
+//
+//  Synopsis:
+//      Replaces the cached row with the given span. If the buffer can't be
+//      grown the cache is left as it was; it is only an optimization.
+//
+//------------------------------------------------------------------------------
+
+VOID
+CLinearGradientBrushSpan::UpdateCachedRow(
+    INT nX,
+    INT nCount,
+    __in_ecount(nCount) const ARGB *pArgbColors
+    )
+{
+    UINT cPixels = static_cast<UINT>(nCount);
+
+    if (cPixels > m_cCachedRowPixelsAllocated)
+    {
+        FreeCachedRow();
+
+        // Round up so that rows growing a little at a time, like those of an
+        // ellipse, don't reallocate every time.
+        cPixels = (cPixels + 255) & ~255u;
+
+        m_pargbCachedRow = static_cast<ARGB *>(
+            WPFAlloc(ProcessHeap, Mt(MLinearGradientCachedRow), cPixels * sizeof(ARGB))
+            );
+
+        if (m_pargbCachedRow == NULL)
+        {
+            return;
+        }
+
+        m_cCachedRowPixelsAllocated = cPixels;
+    }
+
+    RtlCopyMemory(m_pargbCachedRow, pArgbColors, nCount * sizeof(ARGB));
+
+    m_nCachedRowX = nX;
+    m_nCachedRowCount = nCount;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CLinearGradientBrushSpan::FreeCachedRow
+//
+//------------------------------------------------------------------------------
+
+VOID
+CLinearGradientBrushSpan::FreeCachedRow()
+{
+    if (m_pargbCachedRow)
+    {
+        WPFFree(ProcessHeap, m_pargbCachedRow);
+        m_pargbCachedRow = NULL;
+    }
+
+    m_cCachedRowPixelsAllocated = 0;
+    m_nCachedRowCount = 0;
 }
 
 CLinearGradientBrushSpan_MMX::CLinearGradientBrushSpan_MMX()
@@ -877,38 +1332,66 @@ FASTCALL ColorSource_RadialGradient_32bppPARGB(
         DYNCAST(CRadialGradientBrushSpan, pSOP->m_posd);
     Assert(pColorSource);
 
+    INT nX = pPP->m_iX;
+    INT nCount = pPP->m_uiCount;
+    ARGB *pArgbDest = (ARGB*) pSOP->m_pvDest;
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    // The AVX2 kernel computes sample positions from the start of the span
+    // rather than accumulating them, so colors can differ by one from the
+    // loops below; it only runs when EnableAVX2ForSwRast asks for it.
+    if (nCount >= 8 && g_fPreferAVX2Spans)
+    {
+        UINT uGenerated = pColorSource->GenerateColors_AVX2(
+            nX,
+            pPP->m_iY,
+            nCount,
+            pArgbDest
+            );
+
+        nX += static_cast<INT>(uGenerated);
+        nCount -= static_cast<INT>(uGenerated);
+        pArgbDest += uGenerated;
+
+        if (nCount == 0)
+        {
+            return;
+        }
+    }
+#endif
+
 #if defined(_X86_)
     if (CCPUInfo::HasSSE())
     {
         pColorSource->GenerateColors<TypeSSE>(
-            pPP->m_iX,
+            nX,
             pPP->m_iY, 
-            pPP->m_uiCount, 
-            (ARGB*) pSOP->m_pvDest
+            nCount, 
+            pArgbDest
             );
     }
     else
     {
         pColorSource->GenerateColors<TypeNoSSE>(
-            pPP->m_iX,
+            nX,
             pPP->m_iY,
-            pPP->m_uiCount,
-            (ARGB*) pSOP->m_pvDest
+            nCount,
+            pArgbDest
             );
     }
 #elif defined(_AMD64_)
     pColorSource->GenerateColors<TypeSSE>(
-        pPP->m_iX,
+        nX,
         pPP->m_iY,
-        pPP->m_uiCount,
-        (ARGB*) pSOP->m_pvDest
+        nCount,
+        pArgbDest
         );
 #else
     pColorSource->GenerateColors<TypeNoSSE>(
-        pPP->m_iX,
+        nX,
         pPP->m_iY,
-        pPP->m_uiCount,
-        (ARGB*) pSOP->m_pvDest
+        nCount,
+        pArgbDest
         );
 #endif
 }
@@ -1091,6 +1574,93 @@ CRadialGradientBrushSpan::GenerateColors(
     } while (--nCount != 0);
 }
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CRadialGradientBrushSpan::GenerateColors_AVX2
+//
+//  Synopsis:
+//      Generates colors 8 at a time with the same math as the SSE version of
+//      GenerateColors. Returns the number of colors generated, which is a
+//      multiple of 8.
+//
+//      Positions are computed from the start of the span for each group of 8
+//      instead of being accumulated pixel by pixel, so they can differ from
+//      the C loop in the last bit, which very rarely moves a color by one.
+//
+//------------------------------------------------------------------------------
+
+UINT
+CRadialGradientBrushSpan::GenerateColors_AVX2(
+    INT nX,
+    INT nY,
+    INT nCount,
+    __out_ecount_part(nCount, return) ARGB *pArgbDest
+    ) const
+{
+    bool fExtendMode = (m_wrapMode == MilGradientWrapMode::Extend);
+    INT nTexelCountMinusOne = static_cast<INT>(m_uTexelCountMinusOne);
+
+    Assert((FIXED16_INT_MAX % m_uTexelCount) == static_cast<UINT>(nTexelCountMinusOne));
+
+    __m256 vM11 = _mm256_set1_ps(m_rM11);
+    __m256 vM12 = _mm256_set1_ps(m_rM12);
+
+    // The terms which don't change along the span
+    FLOAT y = static_cast<FLOAT>(nY);
+    __m256 vYM21 = _mm256_set1_ps(y * m_rM21);
+    __m256 vYM22 = _mm256_set1_ps(y * m_rM22);
+    __m256 vDx = _mm256_set1_ps(m_rDx);
+    __m256 vDy = _mm256_set1_ps(m_rDy);
+
+    __m256 vHalf = _mm256_set1_ps(0.5f);
+    __m256 vFix16IntMax = _mm256_set1_ps(static_cast<FLOAT>(FIXED16_INT_MAX));
+    __m256 vFix16One = _mm256_set1_ps(static_cast<FLOAT>(FIX16_ONE));
+
+    __m256i vX = _mm256_add_epi32(
+        _mm256_set1_epi32(nX),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+        );
+
+    UINT uGenerated = 0;
+
+    for (; uGenerated + 8 <= static_cast<UINT>(nCount); uGenerated += 8)
+    {
+        __m256 x = _mm256_cvtepi32_ps(vX);
+
+        __m256 vXPositionHPC = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, vM11), vYM21), vDx);
+        __m256 vYPositionHPC = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, vM12), vYM22), vDy);
+
+        __m256 vDistanceHPC = _mm256_sqrt_ps(
+            _mm256_add_ps(
+                _mm256_mul_ps(vXPositionHPC, vXPositionHPC),
+                _mm256_mul_ps(vYPositionHPC, vYPositionHPC)
+                )
+            );
+
+        // Clamping to FIXED16_INT_MAX chooses the last texel, see
+        // GenerateColors.
+        __m256 vDistanceIPC = _mm256_min_ps(_mm256_sub_ps(vDistanceHPC, vHalf), vFix16IntMax);
+
+        __m256i vColors = SampleGradientTexture_AVX2(
+            m_rgStartTexelAgrb,
+            m_rgEndTexelAgrb,
+            _mm256_cvtps_epi32(_mm256_mul_ps(vDistanceIPC, vFix16One)),
+            true,
+            fExtendMode,
+            nTexelCountMinusOne
+            );
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pArgbDest + uGenerated), vColors);
+
+        vX = _mm256_add_epi32(vX, _mm256_set1_epi32(8));
+    }
+
+    return uGenerated;
+}
+#endif
+
 CFocalGradientBrushSpan::CFocalGradientBrushSpan()
     : CRadialGradientBrushSpan()
 {
@@ -1194,11 +1764,39 @@ FASTCALL ColorSource_FocalGradient_32bppPARGB(
         DYNCAST(CFocalGradientBrushSpan, pSOP->m_posd);
     Assert(pColorSource);
 
+    INT nX = pPP->m_iX;
+    INT nCount = pPP->m_uiCount;
+    ARGB *pArgbDest = (ARGB*) pSOP->m_pvDest;
+
+#if !defined(_ARM_) && !defined(_ARM64_)
+    // The AVX2 kernel computes sample positions from the start of the span
+    // rather than accumulating them, so colors can differ by one from the
+    // loops below; it only runs when EnableAVX2ForSwRast asks for it.
+    if (nCount >= 8 && g_fPreferAVX2Spans)
+    {
+        UINT uGenerated = pColorSource->GenerateColors_AVX2(
+            nX,
+            pPP->m_iY,
+            nCount,
+            pArgbDest
+            );
+
+        nX += static_cast<INT>(uGenerated);
+        nCount -= static_cast<INT>(uGenerated);
+        pArgbDest += uGenerated;
+
+        if (nCount == 0)
+        {
+            return;
+        }
+    }
+#endif
+
     pColorSource->GenerateColors(
-        pPP->m_iX,
+        nX,
         pPP->m_iY,
-        pPP->m_uiCount,
-        (ARGB*) pSOP->m_pvDest
+        nCount,
+        pArgbDest
         );
 }
 
@@ -1616,6 +2214,166 @@ CFocalGradientBrushSpan::GenerateColors(
     } while (--nCount != 0);
 }
 
+#if !defined(_ARM_) && !defined(_ARM64_)
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CFocalGradientBrushSpan::GenerateColors_AVX2
+//
+//  Synopsis:
+//      Generates colors 8 at a time, solving the quadratic described in
+//      GenerateColors for all 8 sample points at once. Returns the number of
+//      colors generated, which is a multiple of 8.
+//
+//      As in CRadialGradientBrushSpan::GenerateColors_AVX2 the sample points
+//      aren't accumulated pixel by pixel, so the positions can differ from
+//      the C loop in the last bit.
+//
+//------------------------------------------------------------------------------
+
+UINT
+CFocalGradientBrushSpan::GenerateColors_AVX2(
+    INT nX,
+    INT nY,
+    INT nCount,
+    __out_ecount_part(nCount, return) ARGB *pArgbDest
+    ) const
+{
+    bool fExtendMode = (m_wrapMode == MilGradientWrapMode::Extend);
+    INT nTexelCountMinusOne = static_cast<INT>(m_uTexelCountMinusOne);
+
+    __m256 vM11 = _mm256_set1_ps(m_rM11);
+    __m256 vM12 = _mm256_set1_ps(m_rM12);
+
+    // The terms which don't change along the span
+    FLOAT y = static_cast<FLOAT>(nY);
+    __m256 vYM21 = _mm256_set1_ps(y * m_rM21);
+    __m256 vYM22 = _mm256_set1_ps(y * m_rM22);
+    __m256 vDx = _mm256_set1_ps(m_rDx);
+    __m256 vDy = _mm256_set1_ps(m_rDy);
+
+    __m256 vXFocal = _mm256_set1_ps(m_rXFocalHPC);
+    __m256 vYFocal = _mm256_set1_ps(m_rYFocalHPC);
+    __m256 vDeltaToRegionCenterX = _mm256_set1_ps(m_rXFocalHPC - m_rXFirstTexelRegionCenter);
+    __m256 vDeltaToRegionCenterY = _mm256_set1_ps(m_rYFocalHPC - m_rYFirstTexelRegionCenter);
+
+    __m256 vGradientSpanLength_x_2 = _mm256_set1_ps(m_flGradientSpanEnd * 2.0f);
+    __m256 vGradientSpanLength_sqr = _mm256_set1_ps(m_flGradientSpanEnd * m_flGradientSpanEnd);
+    __m256 vFirstTexelRegionRadiusSquared = _mm256_set1_ps(0.25f);
+    __m256 vSmallA = _mm256_set1_ps(0.0001f);
+
+    __m256 vZero = _mm256_setzero_ps();
+    __m256 vHalf = _mm256_set1_ps(0.5f);
+    __m256 vTwo = _mm256_set1_ps(2.0f);
+    __m256 vFour = _mm256_set1_ps(4.0f);
+    __m256 vMinusHalf = _mm256_set1_ps(-0.5f);
+    __m256 vFix16IntMax = _mm256_set1_ps(static_cast<FLOAT>(FIXED16_INT_MAX));
+    __m256 vFix16One = _mm256_set1_ps(static_cast<FLOAT>(FIX16_ONE));
+
+    __m256i vLastTexelPositionIPC = _mm256_set1_epi32(GpIntToFix16(nTexelCountMinusOne));
+
+    __m256i vX = _mm256_add_epi32(
+        _mm256_set1_epi32(nX),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+        );
+
+    UINT uGenerated = 0;
+
+    for (; uGenerated + 8 <= static_cast<UINT>(nCount); uGenerated += 8)
+    {
+        __m256 x = _mm256_cvtepi32_ps(vX);
+
+        __m256 vDeltaX = _mm256_sub_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, vM11), vYM21), vDx),
+            vXFocal
+            );
+        __m256 vDeltaY = _mm256_sub_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, vM12), vYM22), vDy),
+            vYFocal
+            );
+
+        __m256 vA = _mm256_add_ps(_mm256_mul_ps(vDeltaX, vDeltaX), _mm256_mul_ps(vDeltaY, vDeltaY));
+
+        // Sample points in the first half-texel region choose the first texel
+        __m256 vRegionX = _mm256_add_ps(vDeltaX, vDeltaToRegionCenterX);
+        __m256 vRegionY = _mm256_add_ps(vDeltaY, vDeltaToRegionCenterY);
+        __m256 vInFirstTexelRegion = _mm256_and_ps(
+            _mm256_cmp_ps(vA, vSmallA, _CMP_LT_OQ),
+            _mm256_cmp_ps(
+                _mm256_add_ps(_mm256_mul_ps(vRegionX, vRegionX), _mm256_mul_ps(vRegionY, vRegionY)),
+                vFirstTexelRegionRadiusSquared,
+                _CMP_LT_OQ
+                )
+            );
+
+        __m256 vB = _mm256_mul_ps(
+            vTwo,
+            _mm256_add_ps(_mm256_mul_ps(vXFocal, vDeltaX), _mm256_mul_ps(vYFocal, vDeltaY))
+            );
+
+        __m256 vSampleToOriginCrossOriginNorm = _mm256_sub_ps(
+            _mm256_mul_ps(vDeltaX, vYFocal),
+            _mm256_mul_ps(vDeltaY, vXFocal)
+            );
+
+        __m256 vDeterminant = _mm256_mul_ps(
+            vFour,
+            _mm256_sub_ps(
+                _mm256_mul_ps(vGradientSpanLength_sqr, vA),
+                _mm256_mul_ps(vSampleToOriginCrossOriginNorm, vSampleToOriginCrossOriginNorm)
+                )
+            );
+
+        // NaN for a negative determinant, which the comparison below catches
+        __m256 vGradientSpanPositionHPC = _mm256_div_ps(
+            _mm256_mul_ps(vA, vGradientSpanLength_x_2),
+            _mm256_sub_ps(_mm256_sqrt_ps(vDeterminant), vB)
+            );
+
+        __m256 vGradientSpanPositionIPC = _mm256_sub_ps(vGradientSpanPositionHPC, vHalf);
+
+        __m256 vOutsideGradient = _mm256_or_ps(
+            _mm256_cmp_ps(vGradientSpanPositionHPC, vZero, _CMP_NGE_UQ),
+            _mm256_cmp_ps(vGradientSpanPositionIPC, vFix16IntMax, _CMP_GT_OQ)
+            );
+
+        // GpRealToFix16, rounding halves up like GpRound
+        __m256 vScaled = _mm256_mul_ps(vGradientSpanPositionIPC, vFix16One);
+        __m256i vPositionIPC = _mm256_cvtps_epi32(vScaled);
+        __m256 vOffset = _mm256_sub_ps(_mm256_cvtepi32_ps(vPositionIPC), vScaled);
+        vPositionIPC = _mm256_sub_epi32(
+            vPositionIPC,
+            _mm256_castps_si256(_mm256_cmp_ps(vOffset, vMinusHalf, _CMP_LE_OQ))
+            );
+
+        vPositionIPC = _mm256_blendv_epi8(
+            vPositionIPC,
+            vLastTexelPositionIPC,
+            _mm256_castps_si256(vOutsideGradient)
+            );
+        vPositionIPC = _mm256_andnot_si256(
+            _mm256_castps_si256(vInFirstTexelRegion),
+            vPositionIPC
+            );
+
+        __m256i vColors = SampleGradientTexture_AVX2(
+            m_rgStartTexelAgrb,
+            m_rgEndTexelAgrb,
+            vPositionIPC,
+            true,
+            fExtendMode,
+            nTexelCountMinusOne
+            );
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(pArgbDest + uGenerated), vColors);
+
+        vX = _mm256_add_epi32(vX, _mm256_set1_epi32(8));
+    }
+
+    return uGenerated;
+}
+#endif
+
 
 VOID 
 FASTCALL ColorSource_ShaderEffect_32bppPARGB(
@@ -1635,6 +2393,105 @@ FASTCALL ColorSource_ShaderEffect_32bppPARGB(
         );
 }
 
+// Spans narrower than this are generated on the calling thread.
+static const INT c_nMinShaderEffectBandWidth = 64;
+
+// Rows generated by one work item.
+static const INT c_nShaderEffectRowsPerItem = 8;
+
+// Work items per thread, so that a thread finishing early can take another.
+static const UINT c_uShaderEffectItemsPerThread = 2;
+
+// Upper limit of the band buffer, in pixels.
+static const UINT c_uMaxShaderEffectBandPixels = 256 * 1024;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:     CShaderEffectBandWork
+//
+//  Synopsis:  Runs a compiled pixel shader on groups of rows of a band.  The
+//             generated code only reads the pixel shader state, so the rows
+//             are independent.
+//
+//------------------------------------------------------------------------------
+
+class CShaderEffectBandWork : public IParallelWorkItems
+{
+public:
+    CShaderEffectBandWork(
+        __in GenerateColorsEffect *pfnGenerateColors,
+        __in CPixelShaderState *pPixelShaderState,
+        INT nX,
+        INT nY,
+        INT nCount,
+        INT nRows,
+        __out_ecount(nCount * nRows) ARGB *pargbBand,
+        LONGLONG qpcFrequency
+        )
+    {
+        m_pfnGenerateColors = pfnGenerateColors;
+        m_pPixelShaderState = pPixelShaderState;
+        m_nX = nX;
+        m_nY = nY;
+        m_nCount = nCount;
+        m_nRows = nRows;
+        m_pargbBand = pargbBand;
+        m_qpcFrequency = qpcFrequency;
+    }
+
+    HRESULT Execute(UINT uItem) override
+    {
+        INT nFirstRow = uItem * c_nShaderEffectRowsPerItem;
+        INT nRows = min(c_nShaderEffectRowsPerItem, m_nRows - nFirstRow);
+        LARGE_INTEGER qpcStart = { 0 };
+
+        Assert(nRows > 0);
+
+        if (m_qpcFrequency)
+        {
+            QueryPerformanceCounter(&qpcStart);
+        }
+
+        GenerateColorsEffectParams params;
+        params.pPixelShaderState = m_pPixelShaderState;
+        params.nX = m_nX;
+        params.nCount = m_nCount;
+
+        for (INT i = nFirstRow; i < nFirstRow + nRows; i++)
+        {
+            params.nY = m_nY + i;
+            params.pPargbBuffer = reinterpret_cast<unsigned *>(m_pargbBand + i * m_nCount);
+
+            (*m_pfnGenerateColors)(&params);
+        }
+
+        if (m_qpcFrequency)
+        {
+            LARGE_INTEGER qpcEnd;
+            QueryPerformanceCounter(&qpcEnd);
+
+            EventWriteSwShaderEffectBand(
+                uItem,
+                m_nY + nFirstRow,
+                nRows,
+                static_cast<UINT>((qpcEnd.QuadPart - qpcStart.QuadPart) * 1000000 / m_qpcFrequency)
+                );
+        }
+
+        return S_OK;
+    }
+
+private:
+    GenerateColorsEffect *m_pfnGenerateColors;
+    CPixelShaderState *m_pPixelShaderState;
+    INT m_nX;
+    INT m_nY;
+    INT m_nCount;
+    INT m_nRows;
+    ARGB *m_pargbBand;
+    LONGLONG m_qpcFrequency;
+};
+
 //+-----------------------------------------------------------------------------
 //
 //  CShaderEffectBrushSpan::ctor
@@ -1646,6 +2503,27 @@ CShaderEffectBrushSpan::CShaderEffectBrushSpan()
     m_pfnGenerateColorsEffectWeakRef = NULL;
     m_pShaderEffectBrushNoRef = NULL;
     m_pPixelShaderCompiler = NULL;
+
+    m_pargbBand = NULL;
+    m_cBandPixelsAllocated = 0;
+    m_nBandX = 0;
+    m_nBandY = 0;
+    m_nBandCount = 0;
+    m_nBandRows = 0;
+    m_nBandRowsUsed = 0;
+    m_nShapeBottom = INT_MAX;
+    m_fBandingDisabled = false;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  CShaderEffectBrushSpan::dtor
+//
+//------------------------------------------------------------------------------
+
+CShaderEffectBrushSpan::~CShaderEffectBrushSpan()
+{
+    FreeBand();
 }
 
 //+-----------------------------------------------------------------------------
@@ -1660,6 +2538,26 @@ CShaderEffectBrushSpan::ReleaseExpensiveResources()
     m_pfnGenerateColorsEffectWeakRef = NULL;
     ReleaseInterface(m_pPixelShaderCompiler);
     m_pShaderEffectBrushNoRef = NULL;
+    FreeBand();
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  CShaderEffectBrushSpan::FreeBand
+//
+//------------------------------------------------------------------------------
+
+void
+CShaderEffectBrushSpan::FreeBand()
+{
+    if (m_pargbBand)
+    {
+        WPFFree(ProcessHeap, m_pargbBand);
+        m_pargbBand = NULL;
+    }
+
+    m_cBandPixelsAllocated = 0;
+    m_nBandRows = 0;
 }
 
 //+-----------------------------------------------------------------------------
@@ -1688,6 +2586,28 @@ CShaderEffectBrushSpan::Initialize(
     
     m_pfnGenerateColorsEffectWeakRef = m_pPixelShaderCompiler->GetGenerateColorsFunction();
 
+    //
+    // Colors generated ahead are only valid for this pass.  Rows below the
+    // shape are never requested, so bands don't need to extend past them.
+    //
+
+    m_nBandRows = 0;
+    m_nBandRowsUsed = 0;
+    m_fBandingDisabled = (g_uMaxSwShaderEffectThreads <= 1);
+    m_nShapeBottom = INT_MAX;
+
+    {
+        CRectF<CoordinateSpace::RealizationSampling> rcShape(0, 0, 1.0f, 1.0f, LTRB_Parameters);
+        CRectF<CoordinateSpace::DeviceHPC> rcDevice;
+
+        pRealizationSamplingToDevice->Transform2DBoundsConservative(rcShape, rcDevice);
+
+        if (rcDevice.bottom < static_cast<float>(INT_MAX / 2))
+        {
+            m_nShapeBottom = CFloatFPU::Ceiling(rcDevice.bottom) + 1;
+        }
+    }
+
 Cleanup:
     
     RRETURN(hr);
@@ -1710,7 +2630,29 @@ CShaderEffectBrushSpan::GenerateColors(
     __out_ecount_full(nCount) ARGB *pArgbDest)
 {
     Assert(m_pfnGenerateColorsEffectWeakRef);
-    
+
+    if (CopyColorsFromBand(nX, nY, nCount, pArgbDest))
+    {
+        return;
+    }
+
+    if (!m_fBandingDisabled && nCount >= c_nMinShaderEffectBandWidth)
+    {
+        //
+        // If most of the previous band went unused the requests don't
+        // follow a rectangle, and generating ahead would only add work.
+        //
+        if (m_nBandRows > 0 && 2 * m_nBandRowsUsed < m_nBandRows)
+        {
+            m_fBandingDisabled = true;
+        }
+        else if (   SUCCEEDED(GenerateBand(nX, nY, nCount))
+                 && CopyColorsFromBand(nX, nY, nCount, pArgbDest))
+        {
+            return;
+        }
+    }
+
     GenerateColorsEffectParams params;
     params.pPixelShaderState = &m_pixelShaderState;
     params.nX = nX;
@@ -1721,6 +2663,135 @@ CShaderEffectBrushSpan::GenerateColors(
     (*m_pfnGenerateColorsEffectWeakRef)(&params);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  CShaderEffectBrushSpan::CopyColorsFromBand
+//
+//  Synopsis:
+//      Copy the colors of a span from the band generated ahead, if the band
+//      covers it.
+//
+//------------------------------------------------------------------------------
+
+bool
+CShaderEffectBrushSpan::CopyColorsFromBand(
+    __in INT nX, 
+    __in INT nY, 
+    __in INT nCount, 
+    __out_ecount_full(nCount) ARGB *pArgbDest
+    )
+{
+    if (   nY < m_nBandY
+        || nY >= m_nBandY + m_nBandRows
+        || nX < m_nBandX
+        || nX + nCount > m_nBandX + m_nBandCount)
+    {
+        return false;
+    }
+
+    const ARGB *pargbSource = m_pargbBand
+                            + (nY - m_nBandY) * m_nBandCount
+                            + (nX - m_nBandX);
+
+    RtlCopyMemory(pArgbDest, pargbSource, nCount * sizeof(ARGB));
+
+    m_nBandRowsUsed++;
+
+    return true;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  CShaderEffectBrushSpan::GenerateBand
+//
+//  Synopsis:
+//      Generate colors for a band of rows starting with the given span on
+//      the worker pool.  Each work item reports its timing through the
+//      SwShaderEffectBand event.
+//
+//  Returns:
+//      S_FALSE if the band would be too small to split.
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CShaderEffectBrushSpan::GenerateBand(
+    __in INT nX, 
+    __in INT nY, 
+    __in INT nCount
+    )
+{
+    HRESULT hr = S_OK;
+    LARGE_INTEGER qpcFrequency = { 0 };
+
+    Assert(nCount > 0);
+
+    m_nBandRows = 0;
+    m_nBandRowsUsed = 0;
+
+    INT nRows = static_cast<INT>(min(
+        g_uMaxSwShaderEffectThreads * c_uShaderEffectItemsPerThread * c_nShaderEffectRowsPerItem,
+        c_uMaxShaderEffectBandPixels / static_cast<UINT>(nCount)
+        ));
+
+    // In 64 bits: the shape bottom and the span row are both unbounded.
+    INT64 nRowsToShapeBottom = static_cast<INT64>(m_nShapeBottom) - nY;
+
+    if (nRowsToShapeBottom < nRows)
+    {
+        nRows = static_cast<INT>(max(nRowsToShapeBottom, 0LL));
+    }
+
+    // Too little work to be worth splitting.
+    if (nRows <= c_nShaderEffectRowsPerItem)
+    {
+        hr = S_FALSE;
+        goto Cleanup;
+    }
+
+    UINT cPixels = static_cast<UINT>(nRows * nCount);
+
+    if (cPixels > m_cBandPixelsAllocated)
+    {
+        FreeBand();
+
+        m_pargbBand = static_cast<ARGB *>(WPFAlloc(ProcessHeap, Mt(MShaderEffectBand), cPixels * sizeof(ARGB)));
+        IFCOOM(m_pargbBand);
+
+        m_cBandPixelsAllocated = cPixels;
+    }
+
+    if (EventEnabledSwShaderEffectBand())
+    {
+        QueryPerformanceFrequency(&qpcFrequency);
+    }
+
+    {
+        CShaderEffectBandWork work(
+            m_pfnGenerateColorsEffectWeakRef,
+            &m_pixelShaderState,
+            nX,
+            nY,
+            nCount,
+            nRows,
+            m_pargbBand,
+            qpcFrequency.QuadPart
+            );
+
+        UINT cItems = (nRows + c_nShaderEffectRowsPerItem - 1) / c_nShaderEffectRowsPerItem;
+
+        IFC(CParallelWorkPool::Execute(cItems, &work));
+    }
+
+    m_nBandX = nX;
+    m_nBandY = nY;
+    m_nBandCount = nCount;
+    m_nBandRows = nRows;
+
+Cleanup:
+    RRETURN1(hr, S_FALSE);
+}
+
 
 
 
@@ -20,6 +20,46 @@
 //------------------------------------------------------------------------------
 #include "precomp.hpp"
 
+//
+// Fusions for rendering pipelines, tried after the common ones in
+// ScanPipelineBuilder. Each pairs a blend source operation with the
+// SrcOverAL_32bppPARGB_32bppPARGB variant that GetOp_SrcOver_or_SrcOverAL
+// may choose, so the fused operation blends with the same code.
+//
+// ScalePPAACoverage keeps its op-specific data (the filler), so
+// SetAntialiasedFiller still finds it through m_idxosdAAFiller.
+//
+
+static const ScanOpFusion sc_rgRenderingFusions[] =
+{
+    { ScalePPAACoverage_32bppPBGRA,     SrcOverAL_32bppPARGB_32bppPARGB,        ScalePPAACoverage_SrcOverAL_32bppPBGRA,             ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ScalePPAACoverage_32bppPBGRA,     SrcOverAL_32bppPARGB_32bppPARGB_MMX,    ScalePPAACoverage_SrcOverAL_32bppPBGRA_MMX,         ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ScalePPAACoverage_32bppPBGRA,     SrcOverAL_32bppPARGB_32bppPARGB_SSE2,   ScalePPAACoverage_SrcOverAL_32bppPBGRA_SSE2,        ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ScalePPAACoverage_32bppPBGRA,     SrcOverAL_32bppPARGB_32bppPARGB_AVX2,   ScalePPAACoverage_SrcOverAL_32bppPBGRA_AVX2,        ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ColorSource_Constant_32bppPARGB,  SrcOverAL_32bppPARGB_32bppPARGB,        ColorSource_Constant_SrcOverAL_32bppPARGB,          ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ColorSource_Constant_32bppPARGB,  SrcOverAL_32bppPARGB_32bppPARGB_MMX,    ColorSource_Constant_SrcOverAL_32bppPARGB_MMX,      ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ColorSource_Constant_32bppPARGB,  SrcOverAL_32bppPARGB_32bppPARGB_SSE2,   ColorSource_Constant_SrcOverAL_32bppPARGB_SSE2,     ScanOpFusion::FK_UNARY_PTERNARY, true },
+    { ColorSource_Constant_32bppPARGB,  SrcOverAL_32bppPARGB_32bppPARGB_AVX2,   ColorSource_Constant_SrcOverAL_32bppPARGB_AVX2,     ScanOpFusion::FK_UNARY_PTERNARY, true },
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      RenderingBuilder::RenderingBuilder
+//
+//  Synopsis:
+//      Constructs the builder and registers the rendering fusions.
+//
+
+RenderingBuilder::RenderingBuilder(
+    __in_ecount(1) CScanPipelineRendering *pSP,
+    __inout_ecount(1) CSPIntermediateBuffers *pIntermediateBuffers,
+    BuilderMode eBuilderMode
+    ) : ScanPipelineBuilder(pSP, pIntermediateBuffers, eBuilderMode)
+{
+    SetExtraFusions(sc_rgRenderingFusions, ARRAYSIZE(sc_rgRenderingFusions));
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
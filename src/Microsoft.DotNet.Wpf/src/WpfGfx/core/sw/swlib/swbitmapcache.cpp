@@ -176,6 +176,7 @@ CSwBitmapCache::CSwBitmapCache(
 #else
     m_pIBitmapSourceNoRef = NULL;
 #endif
+    m_pMipChain = NULL;
 }
 
 //+----------------------------------------------------------------------------
@@ -190,6 +191,7 @@ CSwBitmapCache::CSwBitmapCache(
 
 CSwBitmapCache::~CSwBitmapCache()
 {
+    ReleaseInterfaceNoNULL(m_pMipChain);
 }
 
 
@@ -245,7 +247,13 @@ CSwBitmapCache::ChooseBitmapColorSource(
 
     if (!pbcs)
     {
-        IFC(CSwBitmapColorSource::Create(m_pBitmap, &pbcs));
+        if (!m_pMipChain)
+        {
+            // Without a mip chain realizations prefilter from the bitmap
+            IGNORE_HR(CSwBitmapMipChain::Create(&m_pMipChain));
+        }
+
+        IFC(CSwBitmapColorSource::Create(m_pBitmap, m_pMipChain, &pbcs));
 
         // Try to place this new color source in the cache
         oFormatCachedEntry.GetSetBitmapColorSource(IN oParams, IN pbcs);
@@ -35,6 +35,100 @@
 
 MtDefine(CSwBitmapColorSource, MILRender, "CSwBitmapColorSource");
 
+// Format conversions of fewer pixels than this run on the calling thread.
+static const UINT c_uMinStripedConversionPixels = 1024 * 1024;
+
+// Smallest stripe, so that the per-stripe converter set up stays negligible.
+static const UINT c_uMinRowsPerConversionStripe = 64;
+
+// Stripes per thread, so that a thread finishing early can take another.
+static const UINT c_uConversionStripesPerThread = 2;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:     CFormatConversionStripeWork
+//
+//  Synopsis:  Converts horizontal stripes of a source rectangle into the
+//             realization bitmap.  Each stripe builds its own format
+//             converter, since a converter keeps per-call state and can't be
+//             shared between threads.  The stripes write disjoint rows of the
+//             realization.
+//
+//------------------------------------------------------------------------------
+
+class CFormatConversionStripeWork : public IParallelWorkItems
+{
+public:
+    CFormatConversionStripeWork(
+        __in_ecount(1) IWICImagingFactory *pIWICFactory,
+        __in_ecount(1) IWICBitmapSource *pIUnconvertedSource,
+        MilPixelFormat::Enum fmtTexture,
+        __in_ecount(1) CSystemMemoryBitmap *pRealizationBitmap,
+        __in_ecount(1) const CMilRectU &rcSource,
+        UINT uDstLeft,
+        UINT uDstTop,
+        UINT uRowsPerStripe
+        ) : m_rcSource(rcSource)
+    {
+        m_pIWICFactory = pIWICFactory;
+        m_pIUnconvertedSource = pIUnconvertedSource;
+        m_fmtTexture = fmtTexture;
+        m_pRealizationBitmap = pRealizationBitmap;
+        m_uDstLeft = uDstLeft;
+        m_uDstTop = uDstTop;
+        m_uRowsPerStripe = uRowsPerStripe;
+    }
+
+    HRESULT Execute(UINT uItem) override
+    {
+        HRESULT hr = S_OK;
+
+        IWICFormatConverter *pConverter = NULL;
+        IWGXBitmapSource *pIWICWrapperBitmapSource = NULL;
+
+        CMilRectU rcStripe(m_rcSource);
+        rcStripe.top = m_rcSource.top + uItem * m_uRowsPerStripe;
+        rcStripe.bottom = min(rcStripe.top + m_uRowsPerStripe, m_rcSource.bottom);
+
+        Assert(rcStripe.top < rcStripe.bottom);
+
+        IFC(m_pIWICFactory->CreateFormatConverter(&pConverter));
+        IFC(pConverter->Initialize(
+            m_pIUnconvertedSource,
+            MilPfToWic(m_fmtTexture),
+            WICBitmapDitherTypeNone,
+            NULL,
+            0.0f,
+            WICBitmapPaletteTypeCustom
+            ));
+
+        IFC(WrapInClosestBitmapInterface(pConverter, &pIWICWrapperBitmapSource));
+
+        IFC(m_pRealizationBitmap->UnsafeUpdateFromSource(
+            pIWICWrapperBitmapSource,
+            rcStripe,
+            m_uDstLeft,
+            m_uDstTop + (rcStripe.top - m_rcSource.top)
+            ));
+
+    Cleanup:
+        ReleaseInterfaceNoNULL(pIWICWrapperBitmapSource);
+        ReleaseInterfaceNoNULL(pConverter);
+
+        RRETURN(hr);
+    }
+
+private:
+    IWICImagingFactory *m_pIWICFactory;
+    IWICBitmapSource *m_pIUnconvertedSource;
+    MilPixelFormat::Enum m_fmtTexture;
+    CSystemMemoryBitmap *m_pRealizationBitmap;
+    CMilRectU m_rcSource;
+    UINT m_uDstLeft;
+    UINT m_uDstTop;
+    UINT m_uRowsPerStripe;
+};
+
 
 
 //+-----------------------------------------------------------------------------
@@ -63,7 +157,7 @@ CSwBitmapColorSource::DeriveFromBitmapAndContext(
     IWGXBitmap *pIWGXBitmap = NULL;
 
     // Local bitmap color source in case cache access utterly fails
-    CSwBitmapColorSource oSwBitmapColorSourceLocal(NULL);
+    CSwBitmapColorSource oSwBitmapColorSourceLocal(NULL, NULL);
 
     CSwBitmapColorSource *pSwBitmapColorSource = NULL;
 
@@ -121,7 +215,7 @@ CSwBitmapColorSource::DeriveFromBitmapAndContext(
             oRealizationParams
             );
 
-        IFC(pSwBitmapColorSource->Realize());
+        IFC(pSwBitmapColorSource->Realize(ppBitmap));
 
         //
         // Further adjust bitmap to sample space tranform as needed.
@@ -131,21 +225,14 @@ CSwBitmapColorSource::DeriveFromBitmapAndContext(
             static_cast<REAL>(oRealizationParams.rcSourceContained.left),
             static_cast<REAL>(oRealizationParams.rcSourceContained.top)
             );
-
-        //
-        // Update return bitmap
-        //
-
-        *ppBitmap = pSwBitmapColorSource->m_pRealizationBitmap; // AddRef below
     }
     else
     {
         // Given source is good enough
         *ppBitmap = pIWGXBitmap;
+        (*ppBitmap)->AddRef();
     }
 
-    (*ppBitmap)->AddRef();
-
 Cleanup:
     // If QI succeeded, we need to remove the extra ref. If it didn't, pIWGXBitmap 
     // is still NULL
@@ -294,12 +381,13 @@ Cleanup:
 HRESULT
 CSwBitmapColorSource::Create(
     __in_ecount_opt(1) IWGXBitmap *pBitmap,
+    __in_ecount_opt(1) CSwBitmapMipChain *pMipChain,
     __deref_out_ecount(1) CSwBitmapColorSource ** const ppSwBitmapCS
     )
 {
     HRESULT hr = S_OK;
 
-    *ppSwBitmapCS = new CSwBitmapColorSource(pBitmap);
+    *ppSwBitmapCS = new CSwBitmapColorSource(pBitmap, pMipChain);
     IFCOOM(*ppSwBitmapCS);
     (*ppSwBitmapCS)->AddRef();
 
@@ -322,16 +410,27 @@ Cleanup:
 //------------------------------------------------------------------------------
 
 CSwBitmapColorSource::CSwBitmapColorSource(
-    __in_ecount_opt(1) IWGXBitmap *pBitmap
+    __in_ecount_opt(1) IWGXBitmap *pBitmap,
+    __in_ecount_opt(1) CSwBitmapMipChain *pMipChain
     ) :
     m_pBitmap(pBitmap)
 {
     m_uRealizationWidth = UINT_MAX;   // Unreasonable->invalid default
     m_uRealizationHeight = UINT_MAX;  // Unreasonable->invalid default
     m_pRealizationBitmap = NULL;
+    m_pMipChain = pMipChain;
+    if (m_pMipChain)
+    {
+        m_pMipChain->AddRef();
+    }
     m_pIBitmapSource = NULL;
     m_uCachedUniquenessToken = 0;
     m_fValidRealization = false;
+    m_pMoreRecent = NULL;
+    m_pLessRecent = NULL;
+    m_cbListedRealization = 0;
+    m_uLastUsedFrame = 0;
+    m_cUses = 0;
     
 #if DBG
     // Set the source here to enable an assertion in SetBitmapAndContext that
@@ -352,7 +451,10 @@ CSwBitmapColorSource::CSwBitmapColorSource(
 
 CSwBitmapColorSource::~CSwBitmapColorSource()
 {
+    CSwRealizationManager::Remove(this);
+
     ReleaseInterfaceNoNULL(m_pRealizationBitmap);
+    ReleaseInterfaceNoNULL(m_pMipChain);
 }
 
 
@@ -497,6 +599,12 @@ CSwBitmapColorSource::FillTexture(
     IWICBitmapScaler *pIWICScaler = NULL;
     IWICImagingFactory *pIWICFactory = NULL;
     IWICFormatConverter *pConverter = NULL;
+    IWICBitmapSource *pIUnconvertedSourceNoRef = NULL;
+    IWGXBitmapSource *pIMipLevel = NULL;
+    IWICBitmapSource *pIWGXWrapperMipLevel = NULL;
+
+    MilPixelFormat::Enum fmtBitmap;
+    IFC(m_pIBitmapSource->GetPixelFormat(&fmtBitmap));
 
     IFC(WrapInClosestBitmapInterface(m_pIBitmapSource, &pIWGXWrapperBitmapSource));
     pIWICBitmapSourceNoRef = pIWGXWrapperBitmapSource; // No ref changes
@@ -522,6 +630,28 @@ CSwBitmapColorSource::FillTexture(
     if (   (m_uBitmapWidth  != m_uPrefilterWidth)
         || (m_uBitmapHeight != m_uPrefilterHeight))
     {
+        //
+        // For heavy shrinks start from the smallest mip level that is still
+        // at least the prefiltered size.  It is already in the texture
+        // format.  If the level can't be built prefilter the bitmap itself.
+        //
+
+        if (   m_pMipChain
+            && SUCCEEDED(m_pMipChain->GetLevelForSize(
+                   m_pIBitmapSource,
+                   m_pBitmap,
+                   m_fmtTexture,
+                   m_uPrefilterWidth,
+                   m_uPrefilterHeight,
+                   &pIMipLevel
+                   ))
+            && pIMipLevel)
+        {
+            IFC(WrapInClosestBitmapInterface(pIMipLevel, &pIWGXWrapperMipLevel));
+            pIWICBitmapSourceNoRef = pIWGXWrapperMipLevel; // No ref changes
+            fmtBitmap = m_fmtTexture;
+        }
+
         IFC(WICCreateImagingFactory_Proxy(WINCODEC_SDK_VERSION_WPF, &pIWICFactory));
         IFC(pIWICFactory->CreateBitmapScaler(&pIWICScaler));
 
@@ -537,9 +667,6 @@ CSwBitmapColorSource::FillTexture(
     // Convert all pixel formats to a format appropriate for rendering.
     //
 
-    MilPixelFormat::Enum fmtBitmap;
-    IFC(m_pIBitmapSource->GetPixelFormat(&fmtBitmap));
-
     if (fmtBitmap != m_fmtTexture)
     {
         if (!pIWICFactory)
@@ -547,6 +674,18 @@ CSwBitmapColorSource::FillTexture(
             IFC(WICCreateImagingFactory_Proxy(WINCODEC_SDK_VERSION_WPF, &pIWICFactory));
         }
 
+        //
+        // Large conversions may be split into stripes converted
+        // concurrently.  That needs a source which allows concurrent
+        // CopyPixels calls, as IWGXBitmap read locks do, and no scaler,
+        // since a scaled row depends on its neighbours.
+        //
+
+        if (m_pBitmap && !pIWICScaler)
+        {
+            pIUnconvertedSourceNoRef = pIWICBitmapSourceNoRef;
+        }
+
         IFC(pIWICFactory->CreateFormatConverter(&pConverter));
         IFC(pConverter->Initialize(
             pIWICBitmapSourceNoRef,
@@ -582,7 +721,8 @@ CSwBitmapColorSource::FillTexture(
     IFC(WrapInClosestBitmapInterface(pIWICBitmapSourceNoRef, &pIWICWrapperBitmapSource));
 
     IFC(FillTextureWithTransformedSource(
-        pIWICWrapperBitmapSource
+        pIWICWrapperBitmapSource,
+        pIUnconvertedSourceNoRef
         ));
 
 Cleanup:
@@ -591,6 +731,8 @@ Cleanup:
     ReleaseInterfaceNoNULL(pIWICScaler);
     ReleaseInterfaceNoNULL(pConverter);
     ReleaseInterfaceNoNULL(pIWICWrapperBitmapSource);
+    ReleaseInterfaceNoNULL(pIWGXWrapperMipLevel);
+    ReleaseInterfaceNoNULL(pIMipLevel);
 
     RRETURN(hr);
 }
@@ -628,10 +770,14 @@ ScaleIntervalToPrefiltered(
 //      be in the format of the texture and it should already have a prefilter
 //      transformation applied if necessary.
 //
+//      If pIUnconvertedSource is given, pIBitmapSource is a format conversion
+//      of it, and large rectangles are converted in stripes instead.
+//
 
 HRESULT
 CSwBitmapColorSource::FillTextureWithTransformedSource(
-    __in_ecount(1) IWGXBitmapSource *pIBitmapSource
+    __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+    __in_ecount_opt(1) IWICBitmapSource *pIUnconvertedSource
     )
 {
     HRESULT hr = S_OK;
@@ -703,12 +849,25 @@ CSwBitmapColorSource::FillTextureWithTransformedSource(
             // Update realization bitmap
             //
 
-            IFC(m_pRealizationBitmap->UnsafeUpdateFromSource(
-                pIBitmapSource,
-                rc,
-                rc.left - m_rcPrefilteredBitmap.left,
-                rc.top - m_rcPrefilteredBitmap.top
-                ));
+            if (   pIUnconvertedSource
+                && static_cast<UINT64>(rc.Width()) * rc.Height() >= c_uMinStripedConversionPixels
+                && CParallelWorkPool::GetMaxConcurrency() > 1
+               )
+            {
+                IFC(FillTextureRectInStripes(
+                    pIUnconvertedSource,
+                    rc
+                    ));
+            }
+            else
+            {
+                IFC(m_pRealizationBitmap->UnsafeUpdateFromSource(
+                    pIBitmapSource,
+                    rc,
+                    rc.left - m_rcPrefilteredBitmap.left,
+                    rc.top - m_rcPrefilteredBitmap.top
+                    ));
+            }
         }
         // continue with next dirty rect
     }
@@ -719,6 +878,60 @@ Cleanup:
     RRETURN(hr);
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapColorSource::FillTextureRectInStripes
+//
+//  Synopsis:
+//      Converts a rectangle of the source into the texture, splitting it into
+//      row stripes which are converted on the worker pool.
+//
+
+HRESULT
+CSwBitmapColorSource::FillTextureRectInStripes(
+    __in_ecount(1) IWICBitmapSource *pIUnconvertedSource,
+    __in_ecount(1) const CMilRectU &rcSource
+    )
+{
+    HRESULT hr = S_OK;
+
+    IWICImagingFactory *pIWICFactory = NULL;
+
+    UINT cRows = rcSource.Height();
+
+    UINT cStripes = min(
+        CParallelWorkPool::GetMaxConcurrency() * c_uConversionStripesPerThread,
+        (cRows + c_uMinRowsPerConversionStripe - 1) / c_uMinRowsPerConversionStripe
+        );
+    Assert(cStripes > 0);
+
+    UINT uRowsPerStripe = (cRows + cStripes - 1) / cStripes;
+    cStripes = (cRows + uRowsPerStripe - 1) / uRowsPerStripe;
+
+    IFC(WICCreateImagingFactory_Proxy(WINCODEC_SDK_VERSION_WPF, &pIWICFactory));
+
+    {
+        CFormatConversionStripeWork work(
+            pIWICFactory,
+            pIUnconvertedSource,
+            m_fmtTexture,
+            m_pRealizationBitmap,
+            rcSource,
+            rcSource.left - m_rcPrefilteredBitmap.left,
+            rcSource.top - m_rcPrefilteredBitmap.top,
+            uRowsPerStripe
+            );
+
+        IFC(CParallelWorkPool::Execute(cStripes, &work));
+    }
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pIWICFactory);
+
+    RRETURN(hr);
+}
+
 //+-----------------------------------------------------------------------------
 //
 //  Member:
@@ -826,15 +1039,24 @@ CSwBitmapColorSource::IsOpaque(
 //      If already in the cache, just make sure the current realization still
 //      works in this context.
 //
+//      The realization is returned with a reference so that it stays usable
+//      if CSwRealizationManager releases it from this color source.
+//
 
 HRESULT
 CSwBitmapColorSource::Realize(
+    __deref_out_ecount(1) IWGXBitmap **ppRealization
     )
 {
     HRESULT hr = S_OK;
+    bool fReused = true;
 
     Assert(m_pIBitmapSource);
 
+    *ppRealization = NULL;
+
+    CSwRealizationManager::BeginUse(this);
+
 #if DBG
     if (m_pRealizationBitmap)
     {
@@ -858,6 +1080,8 @@ CSwBitmapColorSource::Realize(
         // Create a new texture
         //
 
+        fReused = false;
+
         IFC(CreateTexture());
 
         // Anytime a new texture is allocated, a realization is needed.
@@ -879,13 +1103,20 @@ CSwBitmapColorSource::Realize(
         // Populate the texture
         //
 
+        fReused = false;
+
         IFC(FillTexture());
 
         // Successful population means there is a valid realization.
         m_fValidRealization = true;
     }
 
+    *ppRealization = m_pRealizationBitmap;
+    (*ppRealization)->AddRef();
+
 Cleanup:
+    CSwRealizationManager::EndUse(this, fReused);
+
     RRETURN(hr);
 }
 
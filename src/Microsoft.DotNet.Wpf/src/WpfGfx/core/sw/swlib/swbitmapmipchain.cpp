@@ -0,0 +1,785 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_software
+//      $Keywords:
+//
+//  $Description:
+//      Implementation for CSwBitmapMipChain which holds area-averaged
+//      reductions of a bitmap used as the starting point of heavy
+//      prefiltering
+//
+//  $Notes:
+//      Each level is an exact area average of the previous one: a level
+//      pixel covers the corresponding 1/Width (1/Height) of the level above,
+//      so fractional source pixels are weighted by their coverage and the
+//      level spans exactly the same image extent as the bitmap.  Because
+//      levels are only ever built from the bitmap, results don't depend on
+//      which sizes were realized before.  Dirty rect updates compute each
+//      pixel they touch exactly as a full build would, so they don't change
+//      that either.
+//
+//  $ENDTAG
+//
+//------------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+
+MtDefine(CSwBitmapMipChain, MILRender, "CSwBitmapMipChain");
+MtDefine(MSwBitmapMipChainBuffers, MILRawMemory, "MSwBitmapMipChainBuffers");
+
+// Level rows generated from each band of source rows copied out of the level
+// above.  A band covers about twice as many source rows.
+static const UINT c_uMipLevelRowsPerBand = 32;
+
+//+-----------------------------------------------------------------------------
+//
+//  Structure:
+//      AreaTaps
+//
+//  Synopsis:
+//      Source samples, and their coverage, of one level sample in one
+//      dimension.  A level halves the size (rounding up), so a level sample
+//      covers between 1 and 2 source samples and touches at most 3.
+//
+//------------------------------------------------------------------------------
+
+struct AreaTaps
+{
+    UINT uFirst;            // First source sample
+    UINT cTaps;             // Number of source samples
+    UINT rguWeight[3];      // 0.16 fixed point coverage, summing to 1.0
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ComputeAreaTaps
+//
+//  Synopsis:
+//      Computes the area averaging taps for reducing uSourceSize samples to
+//      uLevelSize samples.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+ComputeAreaTaps(
+    UINT uSourceSize,
+    UINT uLevelSize,
+    __out_ecount(uLevelSize) AreaTaps *rgTaps
+    )
+{
+    Assert(uLevelSize > 0);
+    Assert(uLevelSize <= uSourceSize);
+    Assert(uSourceSize <= 2 * static_cast<UINT64>(uLevelSize));
+
+    //
+    // Work in units of 1/uLevelSize source samples, so that level sample i
+    // covers [i*uSourceSize, (i+1)*uSourceSize) and source sample j covers
+    // [j*uLevelSize, (j+1)*uLevelSize).
+    //
+
+    for (UINT i = 0; i < uLevelSize; i++)
+    {
+        UINT64 ullStart = static_cast<UINT64>(i) * uSourceSize;
+        UINT64 ullEnd = ullStart + uSourceSize;
+
+        AreaTaps &taps = rgTaps[i];
+
+        taps.uFirst = static_cast<UINT>(ullStart / uLevelSize);
+        taps.cTaps = static_cast<UINT>((ullEnd - 1) / uLevelSize) - taps.uFirst + 1;
+
+        Assert(taps.cTaps <= ARRAYSIZE(taps.rguWeight));
+
+        UINT uTotalWeight = 0;
+
+        for (UINT j = 1; j < taps.cTaps; j++)
+        {
+            UINT64 ullSampleStart = static_cast<UINT64>(taps.uFirst + j) * uLevelSize;
+            UINT64 ullSampleEnd = min(ullSampleStart + uLevelSize, ullEnd);
+
+            taps.rguWeight[j] =
+                static_cast<UINT>(((ullSampleEnd - ullSampleStart) << 16) / uSourceSize);
+
+            uTotalWeight += taps.rguWeight[j];
+        }
+
+        // The first tap takes the rounding error so the weights sum to 1.0
+        taps.rguWeight[0] = (1u << 16) - uTotalWeight;
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::Create
+//
+//  Synopsis:
+//      Creates an empty mip chain
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::Create(
+    __deref_out_ecount(1) CSwBitmapMipChain ** const ppMipChain
+    )
+{
+    HRESULT hr = S_OK;
+
+    *ppMipChain = new CSwBitmapMipChain();
+    IFCOOM(*ppMipChain);
+    (*ppMipChain)->AddRef();
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::CSwBitmapMipChain
+//
+//  Synopsis:
+//      ctor
+//
+//------------------------------------------------------------------------------
+
+CSwBitmapMipChain::CSwBitmapMipChain()
+{
+    m_pIBitmapSourceNoRef = NULL;
+    m_fmtLevels = MilPixelFormat::Undefined;
+    m_uCachedUniquenessToken = 0;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::~CSwBitmapMipChain
+//
+//  Synopsis:
+//      dtor
+//
+//------------------------------------------------------------------------------
+
+CSwBitmapMipChain::~CSwBitmapMipChain()
+{
+    ReleaseLevels();
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::ReleaseLevels
+//
+//  Synopsis:
+//      Releases all levels
+//
+//------------------------------------------------------------------------------
+
+VOID
+CSwBitmapMipChain::ReleaseLevels()
+{
+    for (UINT i = 0; i < m_rgLevels.GetCount(); i++)
+    {
+        ReleaseInterfaceNoNULL(m_rgLevels[i]);
+    }
+
+    m_rgLevels.Reset();
+
+    m_pIBitmapSourceNoRef = NULL;
+    m_fmtLevels = MilPixelFormat::Undefined;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::GetLevelSize
+//
+//  Synopsis:
+//      Returns the size of the level built from a uWidth x uHeight level
+//
+//------------------------------------------------------------------------------
+
+VOID
+CSwBitmapMipChain::GetLevelSize(
+    UINT uWidth,
+    UINT uHeight,
+    __out_ecount(1) UINT &uLevelWidth,
+    __out_ecount(1) UINT &uLevelHeight
+    )
+{
+    uLevelWidth = uWidth / 2 + (uWidth & 1);
+    uLevelHeight = uHeight / 2 + (uHeight & 1);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::GetLevelForSize
+//
+//  Synopsis:
+//      Returns the smallest level which is at least uMinWidth x uMinHeight,
+//      building it as needed.  Returns NULL when no level is smaller than the
+//      bitmap in both dimensions while still large enough, or when the
+//      texture format isn't supported.
+//
+//  Notes:
+//      When the bitmap has changed only within the dirty rects it reports,
+//      as WriteableBitmap and InteropBitmap updates do, just the level
+//      pixels covering those rects are recomputed.  Otherwise all levels are
+//      dropped and rebuilt.
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::GetLevelForSize(
+    __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+    __in_ecount_opt(1) IWGXBitmap *pBitmap,
+    MilPixelFormat::Enum fmtTexture,
+    UINT uMinWidth,
+    UINT uMinHeight,
+    __deref_out_ecount_opt(1) IWGXBitmapSource **ppILevel
+    )
+{
+    HRESULT hr = S_OK;
+
+    IWGXBitmapSource *pISourceInTextureFormat = NULL;
+    CSystemMemoryBitmap *pLevel = NULL;
+
+    UINT uWidth, uHeight;
+    UINT cLevels = 0;
+
+    *ppILevel = NULL;
+
+    //
+    // Levels average whole pixels, so only 32bpp formats with premultiplied
+    // or no alpha are supported.
+    //
+
+    if (   fmtTexture != MilPixelFormat::PBGRA32bpp
+        && fmtTexture != MilPixelFormat::BGR32bpp)
+    {
+        goto Cleanup;
+    }
+
+    //
+    // Drop levels built from different content, or bring them up to date
+    // when the bitmap can tell what changed.
+    //
+
+    if (   m_pIBitmapSourceNoRef != pIBitmapSource
+        || m_fmtLevels != fmtTexture)
+    {
+        ReleaseLevels();
+
+        m_pIBitmapSourceNoRef = pIBitmapSource;
+        m_fmtLevels = fmtTexture;
+        m_uCachedUniquenessToken = 0;
+
+        if (pBitmap)
+        {
+            pBitmap->GetUniquenessToken(&m_uCachedUniquenessToken);
+        }
+    }
+    else if (pBitmap)
+    {
+        MilRectU const *rgDirtyRects;
+        UINT cDirtyRects;
+
+        if (!pBitmap->GetDirtyRects(
+                OUT &rgDirtyRects,
+                OUT &cDirtyRects,
+                IN OUT &m_uCachedUniquenessToken
+                ))
+        {
+            ReleaseLevels();
+
+            m_pIBitmapSourceNoRef = pIBitmapSource;
+            m_fmtLevels = fmtTexture;
+        }
+        else if (cDirtyRects > 0 && m_rgLevels.GetCount() > 0)
+        {
+            IFC(GetSourceInTextureFormat(
+                pIBitmapSource,
+                fmtTexture,
+                &pISourceInTextureFormat
+                ));
+
+            if (FAILED(UpdateLevels(
+                    pISourceInTextureFormat,
+                    rgDirtyRects,
+                    cDirtyRects
+                    )))
+            {
+                // Some levels may be partially updated
+                ReleaseLevels();
+
+                m_pIBitmapSourceNoRef = pIBitmapSource;
+                m_fmtLevels = fmtTexture;
+            }
+        }
+    }
+
+    //
+    // Find the deepest level which is still large enough
+    //
+
+    IFC(pIBitmapSource->GetSize(&uWidth, &uHeight));
+
+    for (;;)
+    {
+        UINT uLevelWidth, uLevelHeight;
+        GetLevelSize(uWidth, uHeight, OUT uLevelWidth, OUT uLevelHeight);
+
+        if (   uLevelWidth < uMinWidth
+            || uLevelHeight < uMinHeight
+            || (uLevelWidth == uWidth && uLevelHeight == uHeight))
+        {
+            break;
+        }
+
+        uWidth = uLevelWidth;
+        uHeight = uLevelHeight;
+        cLevels++;
+    }
+
+    if (cLevels == 0)
+    {
+        goto Cleanup;
+    }
+
+    //
+    // Build the missing levels, each from the one above it
+    //
+
+    while (m_rgLevels.GetCount() < cLevels)
+    {
+        IWGXBitmapSource *pISourceNoRef;
+        UINT uSourceWidth, uSourceHeight;
+
+        if (m_rgLevels.GetCount() == 0)
+        {
+            // The first level reads the bitmap itself
+            if (!pISourceInTextureFormat)
+            {
+                IFC(GetSourceInTextureFormat(
+                    pIBitmapSource,
+                    fmtTexture,
+                    &pISourceInTextureFormat
+                    ));
+            }
+
+            pISourceNoRef = pISourceInTextureFormat;
+        }
+        else
+        {
+            pISourceNoRef = m_rgLevels.Last();
+        }
+
+        IFC(pISourceNoRef->GetSize(&uSourceWidth, &uSourceHeight));
+
+        UINT uLevelWidth, uLevelHeight;
+        GetLevelSize(uSourceWidth, uSourceHeight, OUT uLevelWidth, OUT uLevelHeight);
+
+        IFC(BuildLevel(
+            pISourceNoRef,
+            fmtTexture,
+            uSourceWidth,
+            uSourceHeight,
+            uLevelWidth,
+            uLevelHeight,
+            &pLevel
+            ));
+
+        IFC(m_rgLevels.Add(pLevel));
+        pLevel = NULL;  // Steal the reference
+    }
+
+    *ppILevel = m_rgLevels[cLevels - 1];
+    (*ppILevel)->AddRef();
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pLevel);
+    ReleaseInterfaceNoNULL(pISourceInTextureFormat);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::GetSourceInTextureFormat
+//
+//  Synopsis:
+//      Returns the bitmap source, converted to the texture format as needed,
+//      that the first level is built from
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::GetSourceInTextureFormat(
+    __in_ecount(1) IWGXBitmapSource *pIBitmapSource,
+    MilPixelFormat::Enum fmtTexture,
+    __deref_out_ecount(1) IWGXBitmapSource **ppISource
+    )
+{
+    HRESULT hr = S_OK;
+
+    IWICImagingFactory *pIWICFactory = NULL;
+    IWICBitmapSource *pIWGXWrapperBitmapSource = NULL;
+    IWICFormatConverter *pConverter = NULL;
+
+    *ppISource = NULL;
+
+    MilPixelFormat::Enum fmtBitmap;
+    IFC(pIBitmapSource->GetPixelFormat(&fmtBitmap));
+
+    if (fmtBitmap == fmtTexture)
+    {
+        *ppISource = pIBitmapSource;
+        (*ppISource)->AddRef();
+    }
+    else
+    {
+        IFC(WrapInClosestBitmapInterface(pIBitmapSource, &pIWGXWrapperBitmapSource));
+
+        IFC(WICCreateImagingFactory_Proxy(WINCODEC_SDK_VERSION_WPF, &pIWICFactory));
+        IFC(pIWICFactory->CreateFormatConverter(&pConverter));
+        IFC(pConverter->Initialize(
+            pIWGXWrapperBitmapSource,
+            MilPfToWic(fmtTexture),
+            WICBitmapDitherTypeNone,
+            NULL,
+            0.0f,
+            WICBitmapPaletteTypeCustom
+            ));
+
+        IFC(WrapInClosestBitmapInterface(pConverter, ppISource));
+    }
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pConverter);
+    ReleaseInterfaceNoNULL(pIWGXWrapperBitmapSource);
+    ReleaseInterfaceNoNULL(pIWICFactory);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::UpdateLevels
+//
+//  Synopsis:
+//      Recomputes the pixels of every built level that cover the given dirty
+//      rects of the bitmap
+//
+//  Notes:
+//      Each rect is carried down the chain on its own.  A level pixel that
+//      reads a pixel of the level above which another rect has yet to
+//      refresh lies within that rect's footprint on this level too, so it is
+//      recomputed again when that rect gets here.
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::UpdateLevels(
+    __in_ecount(1) IWGXBitmapSource *pISourceInTextureFormat,
+    __in_ecount(cDirtyRects) MilRectU const *rgDirtyRects,
+    UINT cDirtyRects
+    )
+{
+    HRESULT hr = S_OK;
+
+    UINT uBitmapWidth, uBitmapHeight;
+    IFC(pISourceInTextureFormat->GetSize(&uBitmapWidth, &uBitmapHeight));
+
+    for (UINT i = 0; i < cDirtyRects; i++)
+    {
+        IWGXBitmapSource *pISourceNoRef = pISourceInTextureFormat;
+        UINT uSourceWidth = uBitmapWidth;
+        UINT uSourceHeight = uBitmapHeight;
+
+        MilRectU rcDirty = {
+            min(rgDirtyRects[i].left, uBitmapWidth),
+            min(rgDirtyRects[i].top, uBitmapHeight),
+            min(rgDirtyRects[i].right, uBitmapWidth),
+            min(rgDirtyRects[i].bottom, uBitmapHeight)
+            };
+
+        for (UINT uLevel = 0;
+             uLevel < m_rgLevels.GetCount()
+             && rcDirty.left < rcDirty.right
+             && rcDirty.top < rcDirty.bottom;
+             uLevel++)
+        {
+            CSystemMemoryBitmap *pLevelNoRef = m_rgLevels[uLevel];
+
+            UINT uLevelWidth, uLevelHeight;
+            GetLevelSize(uSourceWidth, uSourceHeight, OUT uLevelWidth, OUT uLevelHeight);
+
+            //
+            // Level pixel i covers source samples [i*S/L, (i+1)*S/L), so the
+            // level pixels touching source samples [l, r) are
+            // [floor(l*L/S), ceil(r*L/S)).
+            //
+
+            MilRectU rcLevel = {
+                static_cast<UINT>(static_cast<UINT64>(rcDirty.left) * uLevelWidth / uSourceWidth),
+                static_cast<UINT>(static_cast<UINT64>(rcDirty.top) * uLevelHeight / uSourceHeight),
+                static_cast<UINT>((static_cast<UINT64>(rcDirty.right) * uLevelWidth + uSourceWidth - 1) / uSourceWidth),
+                static_cast<UINT>((static_cast<UINT64>(rcDirty.bottom) * uLevelHeight + uSourceHeight - 1) / uSourceHeight)
+                };
+
+            IFC(FilterLevelRect(
+                pISourceNoRef,
+                pLevelNoRef,
+                uSourceWidth,
+                uSourceHeight,
+                uLevelWidth,
+                uLevelHeight,
+                rcLevel
+                ));
+
+            pISourceNoRef = pLevelNoRef;
+            uSourceWidth = uLevelWidth;
+            uSourceHeight = uLevelHeight;
+            rcDirty = rcLevel;
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::BuildLevel
+//
+//  Synopsis:
+//      Builds a uLevelWidth x uLevelHeight level by area averaging the 32bpp
+//      source
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::BuildLevel(
+    __in_ecount(1) IWGXBitmapSource *pISource,
+    MilPixelFormat::Enum fmtTexture,
+    UINT uSourceWidth,
+    UINT uSourceHeight,
+    UINT uLevelWidth,
+    UINT uLevelHeight,
+    __deref_out_ecount(1) CSystemMemoryBitmap **ppLevel
+    )
+{
+    HRESULT hr = S_OK;
+
+    CSystemMemoryBitmap *pLevel = NULL;
+
+    *ppLevel = NULL;
+
+    IFC(CSystemMemoryBitmap::Create(
+        uLevelWidth,
+        uLevelHeight,
+        fmtTexture,
+        /* fClear = */ FALSE,
+        /* fIsDynamic = */ FALSE,
+        &pLevel
+        ));
+
+    {
+        MilRectU rcLevel = { 0, 0, uLevelWidth, uLevelHeight };
+
+        IFC(FilterLevelRect(
+            pISource,
+            pLevel,
+            uSourceWidth,
+            uSourceHeight,
+            uLevelWidth,
+            uLevelHeight,
+            rcLevel
+            ));
+    }
+
+    *ppLevel = pLevel;  // Steal the reference
+    pLevel = NULL;
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pLevel);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwBitmapMipChain::FilterLevelRect
+//
+//  Synopsis:
+//      Computes the pixels of rcLevel in a uLevelWidth x uLevelHeight level
+//      by area averaging the 32bpp source.  The source samples under the
+//      rect are copied out a band of rows at a time.
+//
+//  Notes:
+//      Every byte of a pixel is averaged the same way.  A horizontal pass
+//      produces 8.8 fixed point values, and the vertical pass accumulates
+//      those times 0.16 weights, which fits in 32 bits:
+//          255 * 2^8 * 2^16 < 2^32
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwBitmapMipChain::FilterLevelRect(
+    __in_ecount(1) IWGXBitmapSource *pISource,
+    __in_ecount(1) CSystemMemoryBitmap *pLevel,
+    UINT uSourceWidth,
+    UINT uSourceHeight,
+    UINT uLevelWidth,
+    UINT uLevelHeight,
+    __in_ecount(1) MilRectU const &rcLevel
+    )
+{
+    HRESULT hr = S_OK;
+
+    IWGXBitmapLock *pILock = NULL;
+    AreaTaps *rgColumnTaps = NULL;
+    AreaTaps *rgRowTaps = NULL;
+    BYTE *pbBand = NULL;
+    UINT *rguAccum = NULL;
+
+    Assert(rcLevel.left < rcLevel.right && rcLevel.right <= uLevelWidth);
+    Assert(rcLevel.top < rcLevel.bottom && rcLevel.bottom <= uLevelHeight);
+
+    UINT uRectWidth = rcLevel.right - rcLevel.left;
+
+    IFC(HrMalloc(Mt(MSwBitmapMipChainBuffers), sizeof(AreaTaps), uLevelWidth, (void **)&rgColumnTaps));
+    IFC(HrMalloc(Mt(MSwBitmapMipChainBuffers), sizeof(AreaTaps), uLevelHeight, (void **)&rgRowTaps));
+    IFC(HrMalloc(Mt(MSwBitmapMipChainBuffers), 4 * sizeof(UINT), uRectWidth, (void **)&rguAccum));
+
+    ComputeAreaTaps(uSourceWidth, uLevelWidth, rgColumnTaps);
+    ComputeAreaTaps(uSourceHeight, uLevelHeight, rgRowTaps);
+
+    //
+    // Source columns under the rect
+    //
+
+    const AreaTaps &lastColumnTaps = rgColumnTaps[rcLevel.right - 1];
+
+    UINT uSourceLeft = rgColumnTaps[rcLevel.left].uFirst;
+    UINT uSourceRight = lastColumnTaps.uFirst + lastColumnTaps.cTaps;
+
+    // A band of c_uMipLevelRowsPerBand level rows reads at most
+    // 2 * c_uMipLevelRowsPerBand + 1 source rows.
+
+    UINT cbSourceStride;
+    IFC(UIntMult(uSourceRight - uSourceLeft, static_cast<UINT>(sizeof(ARGB)), &cbSourceStride));
+
+    UINT cbBand;
+    IFC(UIntMult(cbSourceStride, 2 * c_uMipLevelRowsPerBand + 1, &cbBand));
+
+    IFC(HrMalloc(Mt(MSwBitmapMipChainBuffers), 1, cbBand, (void **)&pbBand));
+
+    {
+        WICRect rcLock = {
+            static_cast<INT>(rcLevel.left),
+            static_cast<INT>(rcLevel.top),
+            static_cast<INT>(uRectWidth),
+            static_cast<INT>(rcLevel.bottom - rcLevel.top)
+            };
+        IFC(pLevel->Lock(&rcLock, MilBitmapLock::Write, &pILock));
+    }
+
+    UINT cbLevelStride;
+    UINT cbLevelBuffer;
+    BYTE *pbLevel;
+
+    IFC(pILock->GetStride(&cbLevelStride));
+    IFC(pILock->GetDataPointer(&cbLevelBuffer, &pbLevel));
+
+    for (UINT uBandTop = rcLevel.top; uBandTop < rcLevel.bottom; uBandTop += c_uMipLevelRowsPerBand)
+    {
+        UINT uBandBottom = min(uBandTop + c_uMipLevelRowsPerBand, rcLevel.bottom);
+
+        const AreaTaps &lastRowTaps = rgRowTaps[uBandBottom - 1];
+
+        UINT uSourceTop = rgRowTaps[uBandTop].uFirst;
+        UINT uSourceBottom = lastRowTaps.uFirst + lastRowTaps.cTaps;
+
+        Assert(uSourceBottom - uSourceTop <= 2 * c_uMipLevelRowsPerBand + 1);
+
+        MILRect rcCopy = {
+            static_cast<INT>(uSourceLeft),
+            static_cast<INT>(uSourceTop),
+            static_cast<INT>(uSourceRight - uSourceLeft),
+            static_cast<INT>(uSourceBottom - uSourceTop)
+            };
+
+        IFC(pISource->CopyPixels(&rcCopy, cbSourceStride, cbBand, pbBand));
+
+        for (UINT y = uBandTop; y < uBandBottom; y++)
+        {
+            const AreaTaps &rowTaps = rgRowTaps[y];
+
+            ZeroMemory(rguAccum, 4 * sizeof(UINT) * uRectWidth);
+
+            for (UINT j = 0; j < rowTaps.cTaps; j++)
+            {
+                const BYTE *pbSourceRow =
+                    pbBand + (rowTaps.uFirst + j - uSourceTop) * cbSourceStride;
+                UINT uRowWeight = rowTaps.rguWeight[j];
+
+                UINT *puAccum = rguAccum;
+
+                for (UINT x = rcLevel.left; x < rcLevel.right; x++)
+                {
+                    const AreaTaps &columnTaps = rgColumnTaps[x];
+                    const BYTE *pbSource =
+                        pbSourceRow + (columnTaps.uFirst - uSourceLeft) * sizeof(ARGB);
+
+                    for (UINT c = 0; c < 4; c++)
+                    {
+                        UINT uSum = 0;
+
+                        for (UINT i = 0; i < columnTaps.cTaps; i++)
+                        {
+                            uSum += columnTaps.rguWeight[i] * pbSource[i * sizeof(ARGB) + c];
+                        }
+
+                        // 8.8 horizontal average, then weighted by row coverage
+                        puAccum[c] += uRowWeight * ((uSum + (1u << 7)) >> 8);
+                    }
+
+                    puAccum += 4;
+                }
+            }
+
+            BYTE *pbLevelRow = pbLevel + (y - rcLevel.top) * cbLevelStride;
+
+            for (UINT x = 0; x < 4 * uRectWidth; x++)
+            {
+                pbLevelRow[x] = static_cast<BYTE>((rguAccum[x] + (1u << 23)) >> 24);
+            }
+        }
+    }
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pILock);
+
+    GpFree(pbBand);
+    GpFree(rguAccum);
+    GpFree(rgRowTaps);
+    GpFree(rgColumnTaps);
+
+    RRETURN(hr);
+}
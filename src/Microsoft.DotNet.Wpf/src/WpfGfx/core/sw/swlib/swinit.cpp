@@ -23,6 +23,13 @@
 
 bool g_fUseMMX = false;
 bool g_fUseSSE2 = false;
+bool g_fPreferAVX2Spans = false;
+bool g_fUseBandedAARasterization = false;
+bool g_fUseAACoverageCells = false;
+UINT g_uMaxSwShaderEffectThreads = 1;
+bool g_fAssembleGlyphRuns = false;
+bool g_fUseAsyncGlyphRasterization = false;
+bool g_fApproximateSwGaussianBlur = false;
 
 //+-----------------------------------------------------------------------------
 //
@@ -39,6 +46,20 @@ SwStartup()
     HRESULT hr = S_OK;
     DWORD dwDisableMMX = 0;
     DWORD dwDisableSSE2 = 0;
+    DWORD dwEnableBandedRast = 0;
+    DWORD dwMaxWorkerThreads = 0;
+    DWORD dwUseCoverageCells = 0;
+    DWORD dwDisableAVX = 0;
+    DWORD dwEnableAVX2Spans = 0;
+    DWORD dwMaxShaderEffectThreads = 0;
+    DWORD dwDisableScanOpFusion = 0;
+    DWORD dwDisableParallelWidening = 0;
+    DWORD dwEnableAnalyticFlattening = 0;
+    DWORD dwDisableActiveListIndex = 0;
+    DWORD dwRealizationBudgetMB = 0;
+    DWORD dwEnableGlyphRunAssembly = 0;
+    DWORD dwDisableAsyncGlyphRasterization = 0;
+    DWORD dwEnableApproximateBlur = 0;
 
 #if PRERELEASE
     HKEY hKeyAvalonGraphics = NULL;
@@ -90,6 +111,76 @@ SwStartup()
     }
 #endif
 
+    {
+        // Open HKEY_CURRENT_USER\\Software\\Microsoft\\Avalon.Graphics
+        CDisplayRegKey keyGraphics(HKEY_CURRENT_USER, _T(""));
+
+        if (keyGraphics.IsValid())
+        {
+            keyGraphics.ReadDWORD(_T("EnableBandedSwRast"), &dwEnableBandedRast);
+            keyGraphics.ReadDWORD(_T("MaxSwWorkerThreads"), &dwMaxWorkerThreads);
+            keyGraphics.ReadDWORD(_T("UseSwAACoverageCells"), &dwUseCoverageCells);
+            keyGraphics.ReadDWORD(_T("DisableAVXForSwEffects"), &dwDisableAVX);
+            keyGraphics.ReadDWORD(_T("EnableAVX2ForSwRast"), &dwEnableAVX2Spans);
+            keyGraphics.ReadDWORD(_T("MaxSwShaderEffectThreads"), &dwMaxShaderEffectThreads);
+            keyGraphics.ReadDWORD(_T("DisableSwScanOpFusion"), &dwDisableScanOpFusion);
+            keyGraphics.ReadDWORD(_T("DisableParallelWidening"), &dwDisableParallelWidening);
+            keyGraphics.ReadDWORD(_T("EnableAnalyticBezierFlattening"), &dwEnableAnalyticFlattening);
+            keyGraphics.ReadDWORD(_T("DisableScannerActiveListIndex"), &dwDisableActiveListIndex);
+            keyGraphics.ReadDWORD(_T("MaxSwRealizationCacheMB"), &dwRealizationBudgetMB);
+            keyGraphics.ReadDWORD(_T("EnableGlyphRunAssembly"), &dwEnableGlyphRunAssembly);
+            keyGraphics.ReadDWORD(_T("DisableAsyncGlyphRasterization"), &dwDisableAsyncGlyphRasterization);
+            keyGraphics.ReadDWORD(_T("EnableApproximateSwGaussianBlur"), &dwEnableApproximateBlur);
+        }
+    }
+
+    CParallelWorkPool::SetMaxConcurrency(dwMaxWorkerThreads);
+
+    // Banded rasterization records the coverage of each band on the workers
+    // and still emits the spans on the render thread. It stays opt-in until
+    // it is measured to pay for the recording.
+    if (dwEnableBandedRast != 0 && CParallelWorkPool::GetMaxConcurrency() > 1)
+    {
+        g_fUseBandedAARasterization = true;
+    }
+
+    g_fUseAACoverageCells = (dwUseCoverageCells != 0);
+
+    // Zero means as many threads as the worker pool allows; one executes
+    // software pixel shaders on the render thread only.
+    g_uMaxSwShaderEffectThreads = CParallelWorkPool::GetMaxConcurrency();
+    if (dwMaxShaderEffectThreads != 0)
+    {
+        g_uMaxSwShaderEffectThreads = min(g_uMaxSwShaderEffectThreads, static_cast<UINT>(dwMaxShaderEffectThreads));
+    }
+
+    ScanPipelineBuilder::EnableFusion(dwDisableScanOpFusion == 0);
+
+    CShapeBase::EnableParallelWidening(
+        dwDisableParallelWidening == 0 && CParallelWorkPool::GetMaxConcurrency() > 1
+        );
+
+    // Analytic flattening stays opt-in until its output has been compared
+    // against HFD flattening (see tools\geombench -flatten) on real content.
+    CBezierFlattener::EnableAnalyticFlattening(dwEnableAnalyticFlattening != 0);
+
+    CScanner::EnableActiveListIndex(dwDisableActiveListIndex == 0);
+
+    // Glyph run alpha maps assembled from cached glyphs are placed at
+    // quarter pixel phases, so they differ slightly from those DWrite
+    // rasterizes for the whole run. Assembly stays opt-in.
+    g_fAssembleGlyphRuns = (dwEnableGlyphRunAssembly != 0);
+
+    // Glyphs missing from the glyph cache are rasterized on the worker pool
+    // while the run draws a placeholder realization.
+    g_fUseAsyncGlyphRasterization =
+        dwDisableAsyncGlyphRasterization == 0 && CParallelWorkPool::GetMaxConcurrency() > 1;
+
+    // Large software Gaussian blurs approximated by box passes don't match
+    // the exact kernel, so even with the Performance rendering bias they
+    // are only approximated on request.
+    g_fApproximateSwGaussianBlur = (dwEnableApproximateBlur != 0);
+
     if (dwDisableMMX == 0 && CCPUInfo::HasMMX())
     {
         g_fUseMMX = true;
@@ -100,8 +191,25 @@ SwStartup()
         g_fUseSSE2 = true;
     }
 
+    // Spans with AVX2 kernels are picked over the MMX spans only on request:
+    // their output is not bit-identical to what those spans produce.
+    if (dwEnableAVX2Spans != 0 && CCPUInfo::HasAVX2())
+    {
+        g_fPreferAVX2Spans = true;
+    }
+
     IFC(CMilShaderEffectDuce::InitializeJitterLock());
 
+    // Let blur and pixel shader code generated by the jitter use the
+    // non-destructive VEX forms of its 128-bit SSE instructions.
+    CJitterAccess::SetUseVEX(dwDisableAVX == 0 && CCPUInfo::HasAVX2());
+
+    IFC(CMilPixelShaderDuce::InitializeSwPixelShaderCache());
+    IFC(CSwJitterCodeCache::Initialize());
+
+    // Zero means the default budget.
+    IFC(CSwRealizationManager::Initialize(dwRealizationBudgetMB));
+
 Cleanup:
     return hr;
 }
@@ -109,6 +217,9 @@ Cleanup:
 void
 SwShutdown()
 {
+    CSwRealizationManager::DeInitialize();
+    CSwJitterCodeCache::DeInitialize();
+    CMilPixelShaderDuce::DeInitializeSwPixelShaderCache();
     CMilShaderEffectDuce::DeInitializeJitterLock();
 }
 
@@ -1044,6 +1044,16 @@ HRESULT CResampleSpanCreator_sRGB::GetCS_Resample(
             // is disabled for 64-bit targets because intrinsics
             // are causing compile errors.
             fSupportsSSE2 = g_fUseSSE2;
+#endif
+#if !defined(_ARM_) && !defined(_ARM64_)
+            // CBilinearSpan generates its interior runs with AVX2 on both
+            // x86 and x64, which beats the MMX span.  Its filtering rounds
+            // differently from the MMX span though, so it is only preferred
+            // when EnableAVX2ForSwRast asks for it.
+            if (g_fPreferAVX2Spans)
+            {
+                fSupportsSSE2 = TRUE;
+            }
 #endif
             // Check for MMX acceleration on machines that don't
             // support SSE2.
@@ -1309,11 +1319,16 @@ CColorSourceCreator_sRGB::GetCS_LinearGradient(
 {
     HRESULT hr = S_OK;
 
+    // CLinearGradientBrushSpan generates 8 pixels at a time with AVX2, which
+    // beats the MMX span.  Its output is not known to match the MMX span's,
+    // so it is only preferred when EnableAVX2ForSwRast asks for it.
+    bool fUseMMX = g_fUseMMX && !g_fPreferAVX2Spans;
+
     Assert(nColorCount >= 2);
 
     if (m_pLinearGradientSpan == NULL)
     {
-        if (g_fUseMMX)
+        if (fUseMMX)
         {
             m_pLinearGradientSpan = new CLinearGradientBrushSpan_MMX;
         }
@@ -1330,7 +1345,7 @@ CColorSourceCreator_sRGB::GetCS_LinearGradient(
 
     if (SUCCEEDED(hr))
     {
-        if (g_fUseMMX)
+        if (fUseMMX)
         {
             MIL_THR(((CLinearGradientBrushSpan_MMX *)m_pLinearGradientSpan)->Initialize(
                 pmatWorldHPCToDeviceHPC,
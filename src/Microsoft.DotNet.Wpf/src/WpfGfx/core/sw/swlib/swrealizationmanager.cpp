@@ -0,0 +1,346 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+
+//
+//  $TAG ENGR
+
+//      $Module:    win_mil_graphics_software
+//      $Keywords:
+//
+//  $Description:
+//      Implementation of CSwRealizationManager
+//
+//  $ENDTAG
+//
+//------------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+CCriticalSection CSwRealizationManager::s_csRealizations;
+CSwBitmapColorSource *CSwRealizationManager::s_pMostRecent = NULL;
+CSwBitmapColorSource *CSwRealizationManager::s_pLeastRecent = NULL;
+UINT64 CSwRealizationManager::s_cbBudget = 0;
+UINT64 CSwRealizationManager::s_cbResident = 0;
+UINT CSwRealizationManager::s_uFrame = 0;
+UINT CSwRealizationManager::s_cHits = 0;
+UINT CSwRealizationManager::s_cMisses = 0;
+UINT CSwRealizationManager::s_cEvictions = 0;
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::Initialize
+//
+//  Synopsis:
+//      Set the budget and create the lock
+//
+//------------------------------------------------------------------------------
+
+HRESULT
+CSwRealizationManager::Initialize(
+    UINT uBudgetMB
+    )
+{
+    if (uBudgetMB == 0)
+    {
+        uBudgetMB = c_uDefaultBudgetMB;
+    }
+
+    s_cbBudget = static_cast<UINT64>(uBudgetMB) * 1024 * 1024;
+
+    RRETURN(s_csRealizations.Init());
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::DeInitialize
+//
+//  Synopsis:
+//      Forget the listed realizations and delete the lock.  Color sources
+//      still alive keep their realizations until they are destroyed.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::DeInitialize()
+{
+    if (s_csRealizations.IsValid())
+    {
+        while (s_pLeastRecent)
+        {
+            CSwBitmapColorSource *pbcs = s_pLeastRecent;
+
+            Unlink(pbcs);
+            pbcs->m_cbListedRealization = 0;
+        }
+
+        s_cbResident = 0;
+
+        s_csRealizations.DeInit();
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::AdvanceFrame
+//
+//  Synopsis:
+//      Start a new frame.  Realizations held over budget by the last frame
+//      may be released now.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::AdvanceFrame()
+{
+    CGuard<CCriticalSection> guard(s_csRealizations);
+
+    s_uFrame++;
+
+    EvictOverBudget();
+
+    EventWriteSwRealizationCacheStats(
+        static_cast<UINT>(min(s_cbResident / 1024, static_cast<UINT64>(UINT_MAX))),
+        s_cHits,
+        s_cMisses,
+        s_cEvictions
+        );
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::BeginUse
+//
+//  Synopsis:
+//      Called before a color source touches its realization.  Until the
+//      matching EndUse the realization will not be released.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::BeginUse(
+    __inout_ecount(1) CSwBitmapColorSource *pbcs
+    )
+{
+    CGuard<CCriticalSection> guard(s_csRealizations);
+
+    pbcs->m_cUses++;
+    pbcs->m_uLastUsedFrame = s_uFrame;
+
+    if (pbcs->m_cbListedRealization != 0 && pbcs != s_pMostRecent)
+    {
+        Unlink(pbcs);
+        LinkFirst(pbcs);
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::EndUse
+//
+//  Synopsis:
+//      Called after a color source has realized.  A new realization is
+//      listed, and realizations over the budget are released.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::EndUse(
+    __inout_ecount(1) CSwBitmapColorSource *pbcs,
+    bool fReused
+    )
+{
+    CGuard<CCriticalSection> guard(s_csRealizations);
+
+    Assert(pbcs->m_cUses > 0);
+    pbcs->m_cUses--;
+
+    if (fReused)
+    {
+        s_cHits++;
+    }
+    else
+    {
+        s_cMisses++;
+    }
+
+    if (pbcs->m_pRealizationBitmap && pbcs->m_cbListedRealization == 0)
+    {
+        pbcs->m_cbListedRealization =
+            static_cast<UINT64>(pbcs->m_uRealizationWidth)
+            * pbcs->m_uRealizationHeight
+            * (GetPixelFormatSize(pbcs->m_fmtTexture) / 8);
+
+        // Keep zero meaning "not listed"
+        if (pbcs->m_cbListedRealization == 0)
+        {
+            pbcs->m_cbListedRealization = 1;
+        }
+
+        s_cbResident += pbcs->m_cbListedRealization;
+
+        LinkFirst(pbcs);
+
+        EvictOverBudget();
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::Remove
+//
+//  Synopsis:
+//      Called when a color source is destroyed
+//
+//  Notes:
+//      Only eviction can unlist a color source behind its owner's back, so
+//      a color source found unlisted without the lock stays unlisted.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::Remove(
+    __inout_ecount(1) CSwBitmapColorSource *pbcs
+    )
+{
+    if (pbcs->m_cbListedRealization != 0 && s_csRealizations.IsValid())
+    {
+        CGuard<CCriticalSection> guard(s_csRealizations);
+
+        if (pbcs->m_cbListedRealization != 0)
+        {
+            Unlink(pbcs);
+
+            s_cbResident -= pbcs->m_cbListedRealization;
+            pbcs->m_cbListedRealization = 0;
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::Unlink
+//
+//  Synopsis:
+//      Take a color source out of the list, leaving its bytes counted.
+//      Caller holds the lock.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::Unlink(
+    __inout_ecount(1) CSwBitmapColorSource *pbcs
+    )
+{
+    Assert(pbcs->m_cbListedRealization != 0);
+
+    if (pbcs->m_pMoreRecent)
+    {
+        pbcs->m_pMoreRecent->m_pLessRecent = pbcs->m_pLessRecent;
+    }
+    else
+    {
+        Assert(s_pMostRecent == pbcs);
+        s_pMostRecent = pbcs->m_pLessRecent;
+    }
+
+    if (pbcs->m_pLessRecent)
+    {
+        pbcs->m_pLessRecent->m_pMoreRecent = pbcs->m_pMoreRecent;
+    }
+    else
+    {
+        Assert(s_pLeastRecent == pbcs);
+        s_pLeastRecent = pbcs->m_pMoreRecent;
+    }
+
+    pbcs->m_pMoreRecent = NULL;
+    pbcs->m_pLessRecent = NULL;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::LinkFirst
+//
+//  Synopsis:
+//      Put a color source at the most recently used end of the list.  Caller
+//      holds the lock.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::LinkFirst(
+    __inout_ecount(1) CSwBitmapColorSource *pbcs
+    )
+{
+    Assert(pbcs->m_pMoreRecent == NULL);
+    Assert(pbcs->m_pLessRecent == NULL);
+
+    pbcs->m_pLessRecent = s_pMostRecent;
+
+    if (s_pMostRecent)
+    {
+        s_pMostRecent->m_pMoreRecent = pbcs;
+    }
+    else
+    {
+        s_pLeastRecent = pbcs;
+    }
+
+    s_pMostRecent = pbcs;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Member:
+//      CSwRealizationManager::EvictOverBudget
+//
+//  Synopsis:
+//      Release least recently used realizations until the budget is met or
+//      only realizations of the current frame are left.  Caller holds the
+//      lock.
+//
+//------------------------------------------------------------------------------
+
+void
+CSwRealizationManager::EvictOverBudget()
+{
+    CSwBitmapColorSource *pbcs = s_pLeastRecent;
+
+    while (   s_cbResident > s_cbBudget
+           && pbcs
+           && pbcs->m_uLastUsedFrame != s_uFrame)
+    {
+        CSwBitmapColorSource *pbcsMoreRecent = pbcs->m_pMoreRecent;
+
+        // Color sources being realized on another thread keep theirs
+        if (pbcs->m_cUses == 0)
+        {
+            Unlink(pbcs);
+
+            Assert(s_cbResident >= pbcs->m_cbListedRealization);
+            s_cbResident -= pbcs->m_cbListedRealization;
+            pbcs->m_cbListedRealization = 0;
+
+            pbcs->m_fValidRealization = false;
+            ReleaseInterface(pbcs->m_pRealizationBitmap);
+
+            s_cEvictions++;
+        }
+
+        pbcs = pbcsMoreRecent;
+    }
+}
+
@@ -62,7 +62,7 @@ protected:
     HRESULT ShouldPresent(
         __in_ecount(1) RECT const *pInputRect,
         __out_ecount(1) CMILSurfaceRect *pResultRect,
-        __inout_bcount((CDirtyRegion2::MaxDirtyRegionCount) * sizeof(RECT) + sizeof(RGNDATA)) RGNDATA **ppDirtyRegion,
+        __deref_out_opt RGNDATA **ppDirtyRegion,
         __out bool *fPresent
         );
       
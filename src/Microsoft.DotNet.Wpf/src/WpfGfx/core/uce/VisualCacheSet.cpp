@@ -17,6 +17,16 @@ MtDefine(BrushCacheToken,  VisualCacheSetResource, "BrushCacheToken struct");
 
 
 CMilBitmapCacheDuce* CMilVisualCacheSet::s_pDefaultCacheMode = NULL;
+INIT_ONCE CMilVisualCacheSet::s_initOnceDefaultCacheMode = INIT_ONCE_STATIC_INIT;
+
+//
+// Passed to the INIT_ONCE callback that creates the default cache mode
+//
+struct VisualCacheSetStaticInitialization
+{
+    CComposition *pComposition;
+    HRESULT hr;
+};
 
 //+----------------------------------------------------------------------------
 //
@@ -401,7 +411,9 @@ CMilVisualCacheSet::BeginPartialInvalidate(
     )
 {        
     CMilRectF rect = CMilRectF::sc_rcInfinite;
-    m_dirtyRegion.Initialize(&rect, allowedDirtyRegionOverhead);
+    // Cache dirty regions are re-added to the parent's dirty region, which
+    // does the banding if it is enabled.
+    m_dirtyRegion.Initialize(&rect, allowedDirtyRegionOverhead, 0 /* uRectBudget */);
     *ppDirtyRegionsNoRef = &m_dirtyRegion;
 }
 
@@ -575,6 +587,38 @@ CMilVisualCacheSet::AddCache(
     RRETURN(AddCacheInternal(pBitmapCacheMode, 1));
 }
 
+//+----------------------------------------------------------------------------
+//
+// CMilVisualCacheSet::CreateDefaultCacheMode
+//
+// Synopsis: 
+//    INIT_ONCE callback creating the default cache mode.
+//
+//-----------------------------------------------------------------------------
+
+BOOL CALLBACK
+CMilVisualCacheSet::CreateDefaultCacheMode(
+    __inout PINIT_ONCE pInitOnce,
+    __inout PVOID pvParameter,
+    __deref_opt_out PVOID *ppvContext
+    )
+{
+    VisualCacheSetStaticInitialization *pInit = static_cast<VisualCacheSetStaticInitialization *>(pvParameter);
+
+    UNREFERENCED_PARAMETER(pInitOnce);
+    UNREFERENCED_PARAMETER(ppvContext);
+
+    pInit->hr = CMilBitmapCacheDuce::Create(
+        pInit->pComposition,
+        1.0,
+        false,
+        false,
+        &s_pDefaultCacheMode
+        );
+
+    return SUCCEEDED(pInit->hr);
+}
+
 //+----------------------------------------------------------------------------
 //
 // CMilVisualCacheSet::AddCacheInternal
@@ -612,16 +656,13 @@ CMilVisualCacheSet::AddCacheInternal(
         else
         {
             // Use the default cache if there is no node cache.
-            if (s_pDefaultCacheMode == NULL)
+            VisualCacheSetStaticInitialization init = { m_pCompositionNoRef, S_OK };
+
+            // Lazily create the static default cache mode. Compositions may
+            // render on several threads, so it is created only once.
+            if (!InitOnceExecuteOnce(&s_initOnceDefaultCacheMode, &CMilVisualCacheSet::CreateDefaultCacheMode, &init, NULL))
             {
-                // Lazily create the static default cache mode.
-                IFC(CMilBitmapCacheDuce::Create(
-                    m_pCompositionNoRef,
-                    1.0,
-                    false,
-                    false,
-                    &s_pDefaultCacheMode
-                    ));
+                IFC(FAILED(init.hr) ? init.hr : E_FAIL);
             }
 
             pCacheModeForLookup = s_pDefaultCacheMode;
@@ -152,6 +152,12 @@ private:
     __out_opt BrushCacheToken* LookupCache (
         __in CMilBitmapCacheDuce const *pCacheMode
         );
+
+    static BOOL CALLBACK CreateDefaultCacheMode(
+        __inout PINIT_ONCE pInitOnce,
+        __inout PVOID pvParameter,
+        __deref_opt_out PVOID *ppvContext
+        );
     
     
 private:
@@ -174,7 +180,9 @@ private:
     // The visual we are caching.
     CMilVisual *m_pVisualNoRef;
 
-    // The default cache mode specifier.
+    // The default cache mode specifier, shared by all compositions and
+    // created once under s_initOnceDefaultCacheMode.
     static CMilBitmapCacheDuce *s_pDefaultCacheMode;
+    static INIT_ONCE s_initOnceDefaultCacheMode;
 };
 
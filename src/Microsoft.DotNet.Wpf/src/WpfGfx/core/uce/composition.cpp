@@ -778,8 +778,9 @@ CComposition::Compose(
 {
     HRESULT hr = S_OK;
 
-    // Increment the composition frame counter
-    s_frameLastComposed++;
+    // Increment the composition frame counter. It is process-wide and
+    // partitions may be composed on several worker threads.
+    InterlockedIncrement64(reinterpret_cast<volatile LONGLONG *>(&s_frameLastComposed));
 
 #if ENABLE_PARTITION_MANAGER_LOG
     CPartitionManager::LogEvent(PartitionManagerEvent::Composing, static_cast<DWORD>(reinterpret_cast<UINT_PTR>(this)));
@@ -120,6 +120,7 @@ CDirtyRegion2::CDirtyRegion2()
         InitializeListHead(&(m_dirtyRegionLists[i]));
     }
     m_fMaxSurfaceFallback = false;
+    m_uRectBudget = 0;
 }
 
 //+-----------------------------------------------------------------------------
@@ -136,7 +137,7 @@ CDirtyRegion2::~CDirtyRegion2()
 
 bool CDirtyRegion2::IsEmpty() const
 {
-    bool fIsEmpty = true;
+    bool fIsEmpty = (m_bandRects.GetCount() == 0);
 
     for (UINT i = 0; i < MaxDirtyRegionCount; i++)
     {
@@ -157,7 +158,8 @@ bool CDirtyRegion2::IsEmpty() const
 void 
 CDirtyRegion2::Initialize(
     __in_ecount_opt(1) const CMilRectF* prcNewSurfaceBounds,
-    float allowedDirtyRegionOverhead
+    float allowedDirtyRegionOverhead,
+    UINT uRectBudget
     )
 {
     m_ignoreCount = 0;
@@ -167,6 +169,8 @@ CDirtyRegion2::Initialize(
     m_accumulatedOverhead = 0;
     m_fOptimized = false;
     m_fMaxSurfaceFallback = false;
+    m_uRectBudget = (uRectBudget > MaxDirtyRegionCount) ? uRectBudget : 0;
+    m_bandRects.Reset(FALSE);
 
     //
     // surface bounds kept in floating point to allow for intersection
@@ -298,7 +302,7 @@ CDirtyRegion2::Add(
         // Remove all dirty regions from this object, since
         // they're no longer relevant.
         //
-        Initialize(&m_rcSurfaceBoundsF, c_allowedDirtyRegionOverhead);
+        Initialize(&m_rcSurfaceBoundsF, c_allowedDirtyRegionOverhead, m_uRectBudget);
 
         m_fMaxSurfaceFallback = true;
         m_regionCount = 1;
@@ -325,6 +329,12 @@ CDirtyRegion2::Add(
             g_pAddedRectStatistics->Inc();
         }       
 
+        if (IsBanded())
+        {
+            IFC(AddBanded(clippedNewRegion));
+            goto Cleanup;
+        }
+
         // Compute the overhead for the new region combined with all the other existing regions.
 
         for (UINT n = 0; n < MaxDirtyRegionCount; n++)
@@ -420,6 +430,18 @@ CDirtyRegion2::Add(
     
 Cleanup:
 
+    if (FAILED(hr) && IsBanded())
+    {
+        // The banded region may be left incomplete; dirty the whole surface instead.
+        Initialize(&m_rcSurfaceBoundsF, c_allowedDirtyRegionOverhead, m_uRectBudget);
+
+        m_fMaxSurfaceFallback = true;
+        m_regionCount = 1;
+
+        // The full surface is a valid dirty region, so the caller can go on.
+        hr = S_OK;
+    }
+
     RRETURN(hr);
 }
 
@@ -441,6 +463,470 @@ CDirtyRegion2::UpdateOverhead(UINT regionIndex)
     }
 }
 
+//+-----------------------------------------------------------------------------
+//
+//  Banded dirty region
+//
+//  In banded mode the dirty region is kept exact: it is stored as Y-banded
+//  rectangles like a GDI region, so that many small scattered updates do not
+//  get merged into a few large rectangles. Only when the number of rectangles
+//  exceeds the budget are the neighbors with the least overhead merged.
+//
+//  All rectangles have integer coordinates, so comparing them as floats is
+//  exact.
+//
+//------------------------------------------------------------------------------
+
+//+-----------------------------------------------------------------------------
+// GetBandEnd
+//
+//     Returns the index past the last rectangle of the band starting at uStart.
+//------------------------------------------------------------------------------
+
+static UINT
+GetBandEnd(
+    __in_ecount(cRects) const CMilRectF *prgRects,
+    UINT cRects,
+    UINT uStart
+    )
+{
+    UINT uEnd = uStart + 1;
+
+    while (uEnd < cRects && prgRects[uEnd].top == prgRects[uStart].top)
+    {
+        uEnd++;
+    }
+
+    return uEnd;
+}
+
+//+-----------------------------------------------------------------------------
+// AppendSpan
+//
+//     Appends the horizontal span [left, right) to a list of spans sorted by
+//     left, merging it into the last span if the two touch.
+//------------------------------------------------------------------------------
+
+static HRESULT
+AppendSpan(
+    __inout_ecount(1) DynArray<CMilRectF> &rgSpans,
+    float left,
+    float right
+    )
+{
+    HRESULT hr = S_OK;
+    UINT cSpans = rgSpans.GetCount();
+
+    if (cSpans > 0 && rgSpans[cSpans - 1].right >= left)
+    {
+        if (rgSpans[cSpans - 1].right < right)
+        {
+            rgSpans[cSpans - 1].right = right;
+        }
+    }
+    else
+    {
+        IFC(rgSpans.Add(CMilRectF(left, 0, right, 0, LTRB_Parameters)));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+// UnionSpans
+//
+//     Computes the union of two span lists sorted by left.
+//------------------------------------------------------------------------------
+
+static HRESULT
+UnionSpans(
+    __in_ecount(cSpans0) const CMilRectF *prgSpans0,
+    UINT cSpans0,
+    __in_ecount(cSpans1) const CMilRectF *prgSpans1,
+    UINT cSpans1,
+    __inout_ecount(1) DynArray<CMilRectF> &rgUnion
+    )
+{
+    HRESULT hr = S_OK;
+    UINT i0 = 0;
+    UINT i1 = 0;
+
+    rgUnion.Reset(FALSE);
+
+    while (i0 < cSpans0 || i1 < cSpans1)
+    {
+        const CMilRectF *pSpan;
+
+        if (i1 == cSpans1 || (i0 < cSpans0 && prgSpans0[i0].left <= prgSpans1[i1].left))
+        {
+            pSpan = &prgSpans0[i0++];
+        }
+        else
+        {
+            pSpan = &prgSpans1[i1++];
+        }
+
+        IFC(AppendSpan(rgUnion, pSpan->left, pSpan->right));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+// AppendBand
+//
+//     Appends the band [top, bottom) with the given spans to a banded region.
+//     If the last band of the region ends at top and has the same spans, it is
+//     extended instead.
+//------------------------------------------------------------------------------
+
+static HRESULT
+AppendBand(
+    __inout_ecount(1) DynArray<CMilRectF> &rgRegion,
+    __inout_ecount(1) UINT *puLastBandStart,
+    float top,
+    float bottom,
+    __in_ecount(cSpans) const CMilRectF *prgSpans,
+    UINT cSpans
+    )
+{
+    HRESULT hr = S_OK;
+    UINT cRects = rgRegion.GetCount();
+    UINT uLastBandStart = *puLastBandStart;
+
+    if (cSpans == 0 || top >= bottom)
+    {
+        goto Cleanup;
+    }
+
+    if (   cRects > 0
+        && rgRegion[uLastBandStart].bottom == top
+        && cRects - uLastBandStart == cSpans)
+    {
+        bool fSameSpans = true;
+
+        for (UINT i = 0; i < cSpans; i++)
+        {
+            if (   rgRegion[uLastBandStart + i].left != prgSpans[i].left
+                || rgRegion[uLastBandStart + i].right != prgSpans[i].right)
+            {
+                fSameSpans = false;
+                break;
+            }
+        }
+
+        if (fSameSpans)
+        {
+            for (UINT i = uLastBandStart; i < cRects; i++)
+            {
+                rgRegion[i].bottom = bottom;
+            }
+            goto Cleanup;
+        }
+    }
+
+    for (UINT i = 0; i < cSpans; i++)
+    {
+        IFC(rgRegion.Add(CMilRectF(prgSpans[i].left, top, prgSpans[i].right, bottom, LTRB_Parameters)));
+    }
+
+    *puLastBandStart = cRects;
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+// CDirtyRegion2::CommitBandScratch
+//
+//     Makes the region built in m_bandScratch the current dirty region.
+//------------------------------------------------------------------------------
+
+HRESULT
+CDirtyRegion2::CommitBandScratch()
+{
+    HRESULT hr = S_OK;
+
+    m_bandRects.Reset(FALSE);
+    IFC(m_bandRects.AddMultipleAndSet(m_bandScratch.GetDataBuffer(), m_bandScratch.GetCount()));
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+// CDirtyRegion2::AddBanded
+//
+//     Unions an integer, clipped rectangle into the banded dirty region.
+//------------------------------------------------------------------------------
+
+HRESULT
+CDirtyRegion2::AddBanded(
+    __in_ecount(1) const CMilRectF &rcNew
+    )
+{
+    HRESULT hr = S_OK;
+    const CMilRectF *prgRects = m_bandRects.GetDataBuffer();
+    UINT cRects = m_bandRects.GetCount();
+    UINT uLastBandStart = 0;
+    CMilRectF rcNewSpan(rcNew.left, 0, rcNew.right, 0, LTRB_Parameters);
+
+    // First row of the new rectangle not yet added to the region
+    float yNext = rcNew.top;
+
+    for (UINT i = 0; i < cRects; i++)
+    {
+        if (prgRects[i].DoesContain(rcNew))
+        {
+            // Nothing to do
+            goto Cleanup;
+        }
+    }
+
+    m_bandScratch.Reset(FALSE);
+
+    for (UINT uStart = 0; uStart < cRects; )
+    {
+        UINT uEnd = GetBandEnd(prgRects, cRects, uStart);
+        float top = prgRects[uStart].top;
+        float bottom = prgRects[uStart].bottom;
+
+        // Rows of the new rectangle above this band
+        if (yNext < top && yNext < rcNew.bottom)
+        {
+            float yGapEnd = min(top, rcNew.bottom);
+            IFC(AppendBand(m_bandScratch, &uLastBandStart, yNext, yGapEnd, &rcNewSpan, 1));
+            yNext = yGapEnd;
+        }
+
+        if (bottom <= rcNew.top || top >= rcNew.bottom)
+        {
+            IFC(AppendBand(m_bandScratch, &uLastBandStart, top, bottom, &prgRects[uStart], uEnd - uStart));
+        }
+        else
+        {
+            float yOverlapTop = max(top, rcNew.top);
+            float yOverlapBottom = min(bottom, rcNew.bottom);
+
+            IFC(AppendBand(m_bandScratch, &uLastBandStart, top, yOverlapTop, &prgRects[uStart], uEnd - uStart));
+
+            IFC(UnionSpans(&prgRects[uStart], uEnd - uStart, &rcNewSpan, 1, m_spanScratch));
+            IFC(AppendBand(
+                m_bandScratch,
+                &uLastBandStart,
+                yOverlapTop,
+                yOverlapBottom,
+                m_spanScratch.GetDataBuffer(),
+                m_spanScratch.GetCount()
+                ));
+
+            IFC(AppendBand(m_bandScratch, &uLastBandStart, yOverlapBottom, bottom, &prgRects[uStart], uEnd - uStart));
+
+            yNext = yOverlapBottom;
+        }
+
+        uStart = uEnd;
+    }
+
+    IFC(AppendBand(m_bandScratch, &uLastBandStart, yNext, rcNew.bottom, &rcNewSpan, 1));
+
+    IFC(CommitBandScratch());
+
+    if (m_bandRects.GetCount() > m_uRectBudget)
+    {
+        IFC(ReduceBandedToBudget());
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+// CDirtyRegion2::ReduceBandedToBudget
+//
+//     Merges neighboring rectangles of the banded region until it fits the
+//     rectangle budget. Each step picks the merge that adds the least area:
+//     either two neighboring rectangles of a band, or two consecutive bands.
+//     Every step removes a rectangle or a band, so the region shrinks to a
+//     single band and then to a single rectangle if it has to.
+//------------------------------------------------------------------------------
+
+HRESULT
+CDirtyRegion2::ReduceBandedToBudget()
+{
+    HRESULT hr = S_OK;
+
+    while (m_bandRects.GetCount() > m_uRectBudget)
+    {
+        const CMilRectF *prgRects = m_bandRects.GetDataBuffer();
+        UINT cRects = m_bandRects.GetCount();
+
+        float minimalOverhead = FLT_MAX;
+        UINT uBestIndex = 0;
+        bool fMergeBands = false;
+        bool fMatchFound = false;
+
+        for (UINT uStart = 0; uStart < cRects; )
+        {
+            UINT uEnd = GetBandEnd(prgRects, cRects, uStart);
+            float height = prgRects[uStart].bottom - prgRects[uStart].top;
+
+            // Merge two neighboring rectangles of this band
+            for (UINT i = uStart; i + 1 < uEnd; i++)
+            {
+                float overhead = (prgRects[i + 1].left - prgRects[i].right) * height;
+
+                if (overhead < minimalOverhead)
+                {
+                    minimalOverhead = overhead;
+                    uBestIndex = i;
+                    fMergeBands = false;
+                    fMatchFound = true;
+                }
+            }
+
+            // Merge this band with the next one
+            if (uEnd < cRects)
+            {
+                UINT uNextEnd = GetBandEnd(prgRects, cRects, uEnd);
+
+                IFC(UnionSpans(
+                    &prgRects[uStart],
+                    uEnd - uStart,
+                    &prgRects[uEnd],
+                    uNextEnd - uEnd,
+                    m_spanScratch
+                    ));
+
+                // The union never has more spans than the two bands together,
+                // so merging bands never adds rectangles. Even bands whose
+                // spans don't overlap, as in a staircase, lose a band.
+                float mergedHeight = prgRects[uEnd].bottom - prgRects[uStart].top;
+                float overhead = 0;
+
+                for (UINT i = 0; i < m_spanScratch.GetCount(); i++)
+                {
+                    overhead += (m_spanScratch[i].right - m_spanScratch[i].left) * mergedHeight;
+                }
+
+                for (UINT i = uStart; i < uNextEnd; i++)
+                {
+                    overhead -= RectArea(&prgRects[i]);
+                }
+
+                if (overhead < minimalOverhead)
+                {
+                    minimalOverhead = overhead;
+                    uBestIndex = uStart;
+                    fMergeBands = true;
+                    fMatchFound = true;
+                }
+            }
+
+            uStart = uEnd;
+        }
+
+        if (!fMatchFound)
+        {
+            // Only a single rectangle can't be merged, and it fits any
+            // budget. Should that ever not hold, meet the budget with the
+            // bounding box.
+            Assert(FALSE);
+
+            CMilRectF rcBounds = prgRects[0];
+            float area = 0;
+
+            for (UINT i = 0; i < cRects; i++)
+            {
+                rcBounds.Union(prgRects[i]);
+                area += RectArea(&prgRects[i]);
+            }
+
+            m_accumulatedOverhead += RectArea(&rcBounds) - area;
+
+            m_bandRects.Reset(FALSE);
+            IFC(m_bandRects.Add(rcBounds));
+            break;
+        }
+
+        m_accumulatedOverhead += minimalOverhead;
+
+        // Rebuild the region with the chosen merge applied.
+        UINT uLastBandStart = 0;
+        m_bandScratch.Reset(FALSE);
+
+        for (UINT uStart = 0; uStart < cRects; )
+        {
+            UINT uEnd = GetBandEnd(prgRects, cRects, uStart);
+            float top = prgRects[uStart].top;
+
+            if (fMergeBands && uStart == uBestIndex)
+            {
+                UINT uNextEnd = GetBandEnd(prgRects, cRects, uEnd);
+
+                IFC(UnionSpans(
+                    &prgRects[uStart],
+                    uEnd - uStart,
+                    &prgRects[uEnd],
+                    uNextEnd - uEnd,
+                    m_spanScratch
+                    ));
+
+                IFC(AppendBand(
+                    m_bandScratch,
+                    &uLastBandStart,
+                    top,
+                    prgRects[uEnd].bottom,
+                    m_spanScratch.GetDataBuffer(),
+                    m_spanScratch.GetCount()
+                    ));
+
+                uEnd = uNextEnd;
+            }
+            else if (!fMergeBands && uStart <= uBestIndex && uBestIndex < uEnd)
+            {
+                m_spanScratch.Reset(FALSE);
+
+                for (UINT i = uStart; i < uEnd; i++)
+                {
+                    float right = (i == uBestIndex) ? prgRects[i + 1].right : prgRects[i].right;
+
+                    IFC(AppendSpan(m_spanScratch, prgRects[i].left, right));
+                }
+
+                IFC(AppendBand(
+                    m_bandScratch,
+                    &uLastBandStart,
+                    top,
+                    prgRects[uStart].bottom,
+                    m_spanScratch.GetDataBuffer(),
+                    m_spanScratch.GetCount()
+                    ));
+            }
+            else
+            {
+                IFC(AppendBand(
+                    m_bandScratch,
+                    &uLastBandStart,
+                    top,
+                    prgRects[uStart].bottom,
+                    &prgRects[uStart],
+                    uEnd - uStart
+                    ));
+            }
+
+            uStart = uEnd;
+        }
+
+        IFC(CommitBandScratch());
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
 //+--------------------------------------------------------------------------------------
 // GetUninflatedDirtyRegions
 //
@@ -459,6 +945,21 @@ CDirtyRegion2::GetUninflatedDirtyRegions()
         return &m_rcSurfaceBoundsF;
     }
 
+    if (IsBanded())
+    {
+        m_regionCount = m_bandRects.GetCount();
+        m_fOptimized = true;
+
+        if (m_regionCount == 0)
+        {
+            // Callers expect a valid array even if it is empty.
+            memset(m_resolvedRegions, 0, sizeof(m_resolvedRegions));
+            return m_resolvedRegions;
+        }
+
+        return m_bandRects.GetDataBuffer();
+    }
+
     if (!m_fOptimized)
     {
         memset(m_resolvedRegions, 0, sizeof(m_resolvedRegions));
@@ -506,6 +1007,7 @@ CDirtyRegion2::GetUninflatedDirtyRegions()
                     {
                         //Merge N and K
                         CUnionResult ur = CDirtyRegion2::Union(&(m_dirtyRegions[n]), &(m_dirtyRegions[k]));
+                        m_accumulatedOverhead += ur.m_overhead;
                         
                         //Place merged region in slot N
                         m_dirtyRegions[n] = ur.m_union;
@@ -539,6 +1041,35 @@ CDirtyRegion2::GetUninflatedDirtyRegions()
     return m_resolvedRegions;
 }
 
+//+--------------------------------------------------------------------------------------
+// GetChangedArea
+//
+//     Returns the area of the resolved dirty region less the overhead accumulated when
+//     rectangles were merged. Regions of the classic mode may overlap, so there the
+//     result is an upper bound.
+//---------------------------------------------------------------------------------------
+
+float
+CDirtyRegion2::GetChangedArea() const
+{
+    if (m_fMaxSurfaceFallback)
+    {
+        return RectArea(&m_rcSurfaceBoundsF);
+    }
+
+    const MilRectF *prgRegions = IsBanded() ? m_bandRects.GetDataBuffer() : m_resolvedRegions;
+    float area = 0;
+
+    for (UINT i = 0; i < m_regionCount; i++)
+    {
+        area += RectArea(&prgRegions[i]);
+    }
+
+    area -= m_accumulatedOverhead;
+
+    return (area > 0) ? area : 0;
+}
+
 //+--------------------------------------------------------------------------------------
 // Disable
 // Disables the dirty region collection. It basically turns Add into a no-op.
@@ -49,9 +49,14 @@ public:
     // Initialize must be called before adding dirty rects. Initialize can also be called to
     // reset the dirty region.
     //
+    // If uRectBudget is larger than MaxDirtyRegionCount the dirty region is kept as an
+    // exact Y-banded region of up to uRectBudget rectangles instead of being merged
+    // into MaxDirtyRegionCount rectangles.
+    //
     void Initialize(
             __in_ecount_opt(1) const CMilRectF *prcNewSurfaceBounds,
-            float allowedDirtyRegionOverhead
+            float allowedDirtyRegionOverhead,
+            UINT uRectBudget
             );
 
     // 
@@ -107,6 +112,21 @@ public:
     //
     UINT GetRegionCount() const { return m_regionCount; }
 
+    //
+    // Returns the area that has actually been reported dirty, that is the area of the
+    // dirty region less the overhead introduced by merging rectangles.
+    // NOTE: The area is NOT VALID until GetDirtyRegion is called.
+    //
+    float GetChangedArea() const;
+
+    //
+    // Returns the maximum number of rectangles this dirty region resolves to.
+    //
+    UINT GetMaxRegionCount() const
+    {
+        return IsBanded() ? m_uRectBudget : MaxDirtyRegionCount;
+    }
+
     //
     // Allow external objects to determine what the maximum number
     // of dirty regions that will be returned is.
@@ -139,6 +159,12 @@ private:
 
     void UpdateOverhead(UINT regionIndex);
 
+    bool IsBanded() const { return m_uRectBudget != 0; }
+
+    HRESULT AddBanded(__in_ecount(1) const CMilRectF &rcNew);
+    HRESULT ReduceBandedToBudget();
+    HRESULT CommitBandScratch();
+
 private:
     CMilRectF m_dirtyRegions[MaxDirtyRegionCount];
     CMilRectF m_resolvedRegions[MaxDirtyRegionCount];
@@ -159,6 +185,16 @@ private:
     //
     bool m_fMaxSurfaceFallback;
 
+    //
+    // Banded mode state. m_bandRects holds the dirty region as bands of equal top
+    // and bottom, sorted by top, with the rectangles of each band sorted by left
+    // and not touching each other.
+    //
+    UINT m_uRectBudget;
+    DynArray<CMilRectF> m_bandRects;
+    DynArray<CMilRectF> m_bandScratch;
+    DynArray<CMilRectF> m_spanScratch;
+
 private:
     static CPerformanceCounter* g_pAddedRectStatistics;    
 };
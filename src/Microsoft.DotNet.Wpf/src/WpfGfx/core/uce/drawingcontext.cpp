@@ -73,13 +73,6 @@ CDrawingContext::CDrawingContext(
 
     m_pScratchBitmapBrush = NULL;
 
-    m_renderedRegionCount = 0;
-
-    for (UINT i = 0; i < CDirtyRegion2::MaxDirtyRegionCount; i++)
-    {
-        m_renderedRegions[i] = CMilRectF::sc_rcEmpty;
-    }
-
     m_fClearTypeHint = false;
 }
 
@@ -1981,7 +1974,34 @@ CDrawingContext::DrawGlyphRun(
 
                     EventWriteDWMDraw_Info(pars.rcBounds.AnySpace().left, pars.rcBounds.AnySpace().top, pars.rcBounds.AnySpace().right, pars.rcBounds.AnySpace().bottom);
 
+                    pGlyphRun->ResetAwaitingRealization();
+
                     IFC(m_pIRenderTarget->DrawGlyphs(pars));
+
+                    if (pGlyphRun->IsAwaitingRealization() && !IsBounding())
+                    {
+                        //
+                        // The glyphs are being rasterized in the background
+                        // and no other realization could stand in. Draw the
+                        // outlines for now; the glyph run is notified when
+                        // the realization is ready.
+                        //
+                        pGlyphRun->EnsureGeometry();
+
+                        if (pGlyphRun->GetGeometryRes())
+                        {
+                            MilAntiAliasMode::Enum oldAntiAliasMode = m_renderState.AntiAliasMode;
+                            m_renderState.AntiAliasMode = MilAntiAliasMode::EightByEight;
+
+                            MIL_THR(DrawGeometry(
+                                pBrush,
+                                NULL, // Pen
+                                pGlyphRun->GetGeometryRes()
+                                ));
+
+                            m_renderState.AntiAliasMode = oldAntiAliasMode;
+                        }
+                    }
                 }
             }
         }
@@ -5903,7 +5923,7 @@ CDrawingContext::Render(
 
     Assert(pIRenderTarget);
 
-    m_renderedRegionCount = 0;
+    m_renderedRegions.Reset(FALSE);
 
     if (pRoot != NULL)
     {
@@ -5997,8 +6017,25 @@ CDrawingContext::Render(
                         {
                             IFC(DrawRectangleOverlay(&renderBounds));
                         }
-                        m_renderedRegions[m_renderedRegionCount++] = renderBounds;
+                        IFC(m_renderedRegions.Add(renderBounds));
+                    }
+                }
+
+                if (EventEnabledDirtyRegionStats())
+                {
+                    float redrawnArea = 0;
+
+                    for (UINT i = 0; i < m_renderedRegions.GetCount(); i++)
+                    {
+                        redrawnArea += m_renderedRegions[i].Width() * m_renderedRegions[i].Height();
                     }
+
+                    EventWriteDirtyRegionStats(
+                        dirtyRegionCount,
+                        m_pPreComputeContext->GetMaxDirtyRegionCount(),
+                        static_cast<UINT>(CFloatFPU::Round(m_pPreComputeContext->GetDirtyRegionChangedArea())),
+                        static_cast<UINT>(CFloatFPU::Round(redrawnArea))
+                        );
                 }
             }
         }
@@ -6006,8 +6043,7 @@ CDrawingContext::Render(
         {
             IFC(DrawVisualTree(pRoot, pClearColor, rcSurfaceBounds));
 
-            m_renderedRegions[0] = rcSurfaceBounds;
-            m_renderedRegionCount = 1;
+            IFC(m_renderedRegions.Add(rcSurfaceBounds));
         }
 
         EventWriteWClientUceRenderEnd(data);
@@ -387,12 +387,12 @@ public:
         __in_ecount(1) CMilRectF const &clip
         );
 
-    __out_xcount(m_renderedRegionCount) const CMilRectF* GetRenderedRegions(
+    __out_xcount(m_renderedRegions.GetCount()) const CMilRectF* GetRenderedRegions(
         __out_ecount(1) UINT *renderedRegionCount
         ) const
     {
-        *renderedRegionCount = m_renderedRegionCount;
-        return m_renderedRegions;
+        *renderedRegionCount = m_renderedRegions.GetCount();
+        return m_renderedRegions.GetDataBuffer();
     }
 
     void GetClippedWorldSpaceBounds(
@@ -657,8 +657,7 @@ protected:
     //
     // Regions that have been rendered this frame.
     //
-    CMilRectF m_renderedRegions[CDirtyRegion2::MaxDirtyRegionCount];
-    UINT m_renderedRegionCount;
+    DynArray<CMilRectF> m_renderedRegions;
 
     // Flags
     bool m_fTransformChanged            : 1;
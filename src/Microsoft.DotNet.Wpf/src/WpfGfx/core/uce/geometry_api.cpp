@@ -328,6 +328,135 @@ Cleanup:
     RRETURN(hr);
 }
 
+/*++
+
+Routine Description:
+
+    MilUtility_CreateAnimationPath
+
+    Sets up an animation path once, so that points along it can be queried
+    repeatedly with MilUtility_GetPointsAtLengthFractions without flattening
+    the path and measuring its segments on every call.
+
+    The animation path keeps its own copy of the points, so pPathData need not
+    outlive it.  It must be freed with MilUtility_ReleaseAnimationPath.
+
+--*/
+
+HRESULT WINAPI MilUtility_CreateAnimationPath(
+    __in_ecount_opt(1) MilMatrix3x2D *pMatrix,
+    IN MilFillMode::Enum fillRule,
+    __in_bcount(nSize) MilPathGeometry *pPathData,
+    IN UINT32 nSize,
+    __deref_out_ecount(1) CAnimationPath **ppAnimationPath)
+{
+    HRESULT hr = S_OK;
+
+    CAnimationPath *pAnimationPath = NULL;
+
+    Assert(nSize >= sizeof(MilPathGeometry));
+
+    IFCNULL(pPathData);
+    IFCNULL(ppAnimationPath);
+
+    *ppAnimationPath = NULL;
+
+    {
+        CMILMatrix matrix(pMatrix);
+
+        PathGeometryData pathGeometry(
+            pPathData,
+            nSize,
+            fillRule,
+            matrix.IsIdentity() ? NULL : &matrix);
+
+        IFCOOM(pAnimationPath = new CAnimationPath);
+        IFC(pAnimationPath->SetUp(pathGeometry));
+    }
+
+    *ppAnimationPath = pAnimationPath;
+    pAnimationPath = NULL;
+
+Cleanup:
+    delete pAnimationPath;
+    RRETURN(hr);
+}
+
+/*++
+
+Routine Description:
+
+    MilUtility_GetPointsAtLengthFractions
+
+    Gets the points, and optionally the unit tangents, at several fractions of
+    the length of an animation path created by MilUtility_CreateAnimationPath.
+
+    The path remembers the segment of the last query, so fractions in
+    increasing order (as from successive animation ticks) are found without a
+    search.  For the same reason a path must not be queried on two threads at
+    once.
+
+--*/
+
+HRESULT WINAPI MilUtility_GetPointsAtLengthFractions(
+    __inout_ecount(1) CAnimationPath *pAnimationPath,
+    __in_ecount(cFractions) const double *rgFractions,
+    IN UINT32 cFractions,
+    __out_ecount(cFractions) MilPoint2D *rgPoints,
+    __out_ecount_opt(cFractions) MilPoint2D *rgVecTangents)
+{
+    HRESULT hr = S_OK;
+
+    IFCNULL(pAnimationPath);
+
+    if (cFractions > 0)
+    {
+        IFCNULL(rgFractions);
+        IFCNULL(rgPoints);
+    }
+
+    for (UINT i = 0; i < cFractions; i++)
+    {
+        MilPoint2F ptF;
+        MilPoint2F vecTangentF;
+
+        pAnimationPath->GetPointAtLengthFraction(
+            static_cast<FLOAT>(rgFractions[i]),
+            ptF,
+            rgVecTangents ? &vecTangentF : NULL
+            );
+
+        rgPoints[i].X = static_cast<DOUBLE>(ptF.X);
+        rgPoints[i].Y = static_cast<DOUBLE>(ptF.Y);
+
+        if (rgVecTangents)
+        {
+            rgVecTangents[i].X = static_cast<DOUBLE>(vecTangentF.X);
+            rgVecTangents[i].Y = static_cast<DOUBLE>(vecTangentF.Y);
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+/*++
+
+Routine Description:
+
+    MilUtility_ReleaseAnimationPath
+
+    Frees an animation path created by MilUtility_CreateAnimationPath.
+
+--*/
+
+HRESULT WINAPI MilUtility_ReleaseAnimationPath(
+    __in_ecount_opt(1) CAnimationPath *pAnimationPath)
+{
+    delete pAnimationPath;
+    RRETURN(S_OK);
+}
+
 
 HRESULT WINAPI MilUtility_PathGeometryCombine(
     __in_ecount_opt(1) MilMatrix3x2D *pGeometryMatrix,
@@ -749,6 +878,183 @@ HRESULT WINAPI MilUtility_PathGeometryHitTest(
 Cleanup:
     RRETURN(hr);
 }
+
+//+-----------------------------------------------------------------------------
+//
+//  Function: MilUtility_PolygonPrepareHitTest
+//
+//  Synopsis: Set up for hit testing many points against the fill or a stroke
+//            of a given path
+//
+//  Notes:    The arguments are as in MilUtility_PolygonHitTest.  Test points
+//            with MilUtility_PreparedHitTestPoints, and free the result with
+//            MilUtility_ReleasePreparedHitTest.
+//
+//------------------------------------------------------------------------------
+
+HRESULT WINAPI MilUtility_PolygonPrepareHitTest(
+    __in_ecount_opt(1) MilMatrix3x2D       *pMatrix,    // Geometry (and not pen) transformation
+    __in_ecount_opt(1) MilPenData         *pPenData,   // Pen, hit test the stroke if not null
+    __in_bcount_opt(pPenData->DashArraySize) double* pDashArray, // Dash array
+    __in_ecount(cPoints) MilPoint2D       *pPoints,    // Points defining the path
+    __in_ecount(cSegments) byte             *pTypes,     // Types defining the path
+    __in UINT                               cPoints,     // Number of points
+    __in UINT                               cSegments,   // Number of segments
+    __in double                             rThreshold,  // Distance considered a hit
+    __in bool                               fRelative,   // True if the threashold is relative
+    __deref_out_ecount(1) CPreparedHitTest **ppHitTest) // The prepared hit test
+{
+    HRESULT hr = S_OK;
+    CMILMatrix matrix(pMatrix);
+    CShape shape;
+
+    IFCNULL(pPoints);
+    IFCNULL(pTypes);
+    IFCNULL(ppHitTest);
+
+    *ppHitTest = NULL;
+
+    // Construct a CShape
+    IFC(shape.AddFigureFromRawData(cPoints, cSegments, pPoints, pTypes, &matrix));
+
+    if (pPenData)
+    {
+        // Hit testing a stroke
+        CPlainPen pen;
+        IFC(InitializePen(&pen, pPenData, pDashArray));
+
+        IFC(shape.PrepareHitTest(&pen, rThreshold, fRelative, ppHitTest));
+    }
+    else
+    {
+        // Hit testing a fill
+        IFC(shape.PrepareHitTest(NULL, rThreshold, fRelative, ppHitTest));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function: MilUtility_PathGeometryPrepareHitTest
+//
+//  Synopsis: Set up for hit testing many points against the fill or a stroke
+//            of a given path
+//
+//  Notes:    The arguments are as in MilUtility_PathGeometryHitTest.  The
+//            result keeps its own copy of the flattened path, so pPathData
+//            need not outlive it.
+//
+//------------------------------------------------------------------------------
+
+HRESULT WINAPI MilUtility_PathGeometryPrepareHitTest(
+    __in_ecount_opt(1) MilMatrix3x2D       *pMatrix,    // Transformation matrix
+    __in_ecount_opt(1) MilPenData         *pPenData,   // Pen, hit test the stroke if not null
+    __in_bcount_opt(pPenData->DashArraySize) double* pDashArray, // Dash array
+    __in MilFillMode::Enum                      fillRule,    // Fill mode
+    __in_bcount(nSize) MilPathGeometry     *pPathData,  // The path data
+    __in UINT32                             nSize,       // The size of the above in bytes
+    __in double                             rThreshold,  // Distance considered a hit
+    __in bool                               fRelative,   // =true if the threshold is relative
+    __deref_out_ecount(1) CPreparedHitTest **ppHitTest) // The prepared hit test
+{
+    HRESULT hr = S_OK;
+
+    Assert(nSize >= sizeof(MilPathGeometry));
+
+    IFCNULL(pPathData);
+    IFCNULL(ppHitTest);
+
+    *ppHitTest = NULL;
+
+    {
+        CMILMatrix matrix(pMatrix);
+
+        // Construct a CShapeBase
+        PathGeometryData pathGeometry(
+            pPathData,
+            nSize,
+            fillRule,
+            matrix.IsIdentity() ? NULL : &matrix);
+
+        if (pPenData)
+        {
+            // Hit testing a stroke
+            CPlainPen pen;
+            IFC(InitializePen(&pen, pPenData, pDashArray));
+
+            IFC(pathGeometry.PrepareHitTest(&pen, rThreshold, fRelative, ppHitTest));
+        }
+        else
+        {
+            // Hit testing a fill
+            IFC(pathGeometry.PrepareHitTest(NULL, rThreshold, fRelative, ppHitTest));
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function: MilUtility_PreparedHitTestPoints
+//
+//  Synopsis: Hit test a batch of points against a prepared fill or stroke
+//
+//  Notes:    rgfIsHit[i] is what MilUtility_PolygonHitTest or
+//            MilUtility_PathGeometryHitTest would return for rgHitPoints[i].
+//            A prepared hit test is not modified here, so it may be used on
+//            several threads at once.
+//
+//------------------------------------------------------------------------------
+
+HRESULT WINAPI MilUtility_PreparedHitTestPoints(
+    __in_ecount(1) CPreparedHitTest        *pHitTest,    // The prepared hit test
+    __in_ecount(cHitPoints) MilPoint2D    *rgHitPoints, // The points to hit with
+    __in UINT32                             cHitPoints,  // Number of points
+    __out_ecount(cHitPoints) BOOL           *rgfIsHit)   // True for each point hit
+{
+    HRESULT hr = S_OK;
+
+    IFCNULL(pHitTest);
+
+    if (cHitPoints > 0)
+    {
+        IFCNULL(rgHitPoints);
+        IFCNULL(rgfIsHit);
+    }
+
+    for (UINT i = 0; i < cHitPoints; i++)
+    {
+        // Convert the hit point to floats
+        MilPoint2F hitPt;
+        hitPt.X = (FLOAT) rgHitPoints[i].X;
+        hitPt.Y = (FLOAT) rgHitPoints[i].Y;
+
+        IFC(pHitTest->HitTest(hitPt, rgfIsHit[i]));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function: MilUtility_ReleasePreparedHitTest
+//
+//  Synopsis: Free a hit test prepared by MilUtility_PolygonPrepareHitTest or
+//            MilUtility_PathGeometryPrepareHitTest
+//
+//------------------------------------------------------------------------------
+
+HRESULT WINAPI MilUtility_ReleasePreparedHitTest(
+    __in_ecount_opt(1) CPreparedHitTest *pHitTest)
+{
+    delete pHitTest;
+    RRETURN(S_OK);
+}
 #undef DASH_COUNT
 
 HRESULT WINAPI MilUtility_PathGeometryHitTestPathGeometry(
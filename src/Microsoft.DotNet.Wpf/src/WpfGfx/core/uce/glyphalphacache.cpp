@@ -0,0 +1,1239 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------
+//
+
+//
+//  Description:
+//
+//    class CGlyphAlphaCache implementation.
+//    See comments in glyphalphacache.h.
+//
+
+#include "precomp.hpp"
+
+MtDefine(GlyphAlphaCacheEntry, CMilSlaveGlyphCache, "Glyph alpha cache entry");
+MtDefine(GlyphRasterizationJob, CMilSlaveGlyphCache, "Glyph rasterization job");
+MtDefine(GlyphAlphaCachePins, CMilSlaveGlyphCache, "Glyphs pinned for pending runs");
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::CGlyphAlphaCache()
+//
+//  Synopsis:   Constructor
+//
+//-------------------------------------------------------------------------
+CGlyphAlphaCache::CGlyphAlphaCache()
+{
+    memset(m_rgpBuckets, 0, sizeof(m_rgpBuckets));
+
+    m_totalStorageSize = 0;
+
+    // Allow for the cache to expand up to 2MB of glyph textures
+    m_cMaximumStorageSize = 2000000;
+    // Then trim to 1.6MB
+    m_cTargetStorageSize = 1600000;
+
+    m_cHits = 0;
+    m_cMisses = 0;
+    m_cEvictions = 0;
+
+    m_fAsyncDisabled = false;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::~CGlyphAlphaCache()
+//
+//  Synopsis:   Destructor
+//
+//-------------------------------------------------------------------------
+CGlyphAlphaCache::~CGlyphAlphaCache()
+{
+    for (UINT i = 0; i < m_rgpJobs.GetCount(); i++)
+    {
+        RasterizationJob *pJob = m_rgpJobs[i];
+
+        if (pJob->pWork)
+        {
+            WaitForThreadpoolWorkCallbacks(pJob->pWork, FALSE);
+        }
+
+        CompleteJob(pJob);
+    }
+
+    m_rgpJobs.Reset(FALSE);
+
+    while (m_rgpPinnedRuns.GetCount() > 0)
+    {
+        ReleasePinnedRun(m_rgpPinnedRuns.GetCount() - 1);
+    }
+
+    while (!m_entryList.IsEmpty())
+    {
+        RemoveEntry(m_entryList.PeekAtHead());
+    }
+
+    Assert(m_totalStorageSize == 0);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::RealizeRunAlphaMap
+//
+//  Synopsis:   Builds the alpha map of a glyph run from cached glyphs,
+//              rasterizing the glyphs not cached yet.
+//
+//  Notes:      Each glyph is placed at its position in the run snapped to
+//              1/c_subpixelPhases of a pixel. The glyph's texture for that
+//              phase is added into the run's map at the whole pixel part of
+//              the position. ClearType filtering is linear, so adding the
+//              glyphs' filtered textures gives what filtering the run would
+//              as long as their outlines don't overlap: coverage of
+//              separate outlines adds up, so where the filter fringes of
+//              neighbouring glyphs meet their sum is what filtering both
+//              outlines together gives. The remaining difference from
+//              DWrite's rendering of the run is the rounding of each glyph's
+//              texture to 8 bits before the sum, at most one level per glyph
+//              in a shared pixel.
+//              Contrast enhancement is not linear; it is applied once to the
+//              assembled map, like
+//              CGlyphRunRealization::RealizeAlphaBoundsAndTextures does to
+//              DWrite's.
+//
+//              DWrite covers the union of overlapping outlines, which adding
+//              would count twice and show as dark seams, for instance where
+//              a script font's letters join or a mark sits on its base. So
+//              a run is only assembled when the ink extent of each
+//              ClearType glyph, from its metrics, starts at or past the end
+//              of all the glyphs before it in the run's direction. Any
+//              other run is reported overlapping, without an alpha map.
+//
+//              Bilevel glyphs are expanded to 3 bytes per pixel and combined
+//              with the ClearType ones, as in
+//              CGlyphRunRealization::EnsureValidAlphaMap. Their coverage is
+//              0 or 255, so taking the maximum is exactly the union and they
+//              may overlap.
+//
+//              The run must not be sideways and the transform must be a
+//              pure scale.
+//
+//              With fAllowAsync, glyphs not cached yet are rasterized on the
+//              thread pool and the run is reported pending, as it is while
+//              any of its glyphs are still being rasterized for another run.
+//              The caller asks again on a later frame. Every glyph of a
+//              pending run is pinned for pvRequester until then, so the
+//              glyphs that are in by the next call are still there however
+//              much else has been cached meanwhile.
+//
+//-------------------------------------------------------------------------
+HRESULT
+CGlyphAlphaCache::RealizeRunAlphaMap(
+    __in const void *pvRequester,
+    __in IDWriteFactory *pIDWriteFactory,
+    __in IDWriteFont *pIDWriteFont,
+    __in const DWRITE_GLYPH_RUN *pGlyphRun,
+    float scaleX,
+    float scaleY,
+    DWRITE_RENDERING_MODE renderingMode,
+    DWRITE_MEASURING_MODE measuringMode,
+    __in_opt const EnhancedContrastTable *pECT,
+    bool fAllowAsync,
+    __out bool *pfPending,
+    __out bool *pfOverlapping,
+    __deref_out_ecount_opt(*pTextureSize) BYTE **ppAlphaMap,
+    __out UINT32 *pTextureSize,
+    __out RECT *pBoundingBox,
+    __out bool *pfIsBiLevelOnly
+    )
+{
+    HRESULT hr = S_OK;
+    BYTE *pAlphaMap = NULL;
+    RasterizationJob *pJob = NULL;
+    bool fPending = false;
+    bool fOverlapping = false;
+
+    Assert(!pGlyphRun->isSideways);
+
+    CompleteRasterizations();
+
+    fAllowAsync = fAllowAsync && !m_fAsyncDisabled;
+
+    *pfPending = false;
+    *pfOverlapping = false;
+    *ppAlphaMap = NULL;
+    *pTextureSize = 0;
+    memset(pBoundingBox, 0, sizeof(*pBoundingBox));
+    *pfIsBiLevelOnly = false;
+
+    GlyphKey key;
+    memset(&key, 0, sizeof(key));
+    key.pIDWriteFont = pIDWriteFont;
+    key.emSize = pGlyphRun->fontEmSize;
+    key.scaleX = scaleX;
+    key.scaleY = scaleY;
+    key.renderingMode = renderingMode;
+    key.measuringMode = measuringMode;
+
+    // Same transform CGlyphRunResource::CreateRealization gives DWrite
+    float m11 = scaleX / pGlyphRun->fontEmSize;
+    float m22 = scaleY / pGlyphRun->fontEmSize;
+
+    bool fRightToLeft = (pGlyphRun->bidiLevel & 1) != 0;
+
+    CMilRectL rcClearType;
+    CMilRectL rcBiLevel;
+    rcClearType.SetEmpty();
+    rcBiLevel.SetEmpty();
+
+    // Ink extent of the ClearType glyphs placed so far
+    float rInkLeft = FLT_MAX;
+    float rInkRight = -FLT_MAX;
+
+    //
+    // Find every glyph and where it goes
+    //
+    m_rgPlacedGlyphs.Reset(FALSE);
+    m_rgpRunGlyphs.Reset(FALSE);
+
+    float penPosition = 0.0f;
+
+    for (UINT32 i = 0; i < pGlyphRun->glyphCount; i++)
+    {
+        float advance = pGlyphRun->glyphAdvances[i];
+        float glyphX;
+        float glyphY = 0.0f;
+
+        //
+        // DWrite positions glyphs of a right-to-left run leftward from the
+        // origin, and moves them left by a positive advance offset
+        //
+        if (fRightToLeft)
+        {
+            penPosition -= advance;
+            glyphX = penPosition;
+        }
+        else
+        {
+            glyphX = penPosition;
+            penPosition += advance;
+        }
+
+        if (pGlyphRun->glyphOffsets)
+        {
+            const DWRITE_GLYPH_OFFSET &offset = pGlyphRun->glyphOffsets[i];
+
+            glyphX += fRightToLeft ? -offset.advanceOffset : offset.advanceOffset;
+            glyphY = -offset.ascenderOffset;
+        }
+
+        PlacedGlyph placed;
+
+        SnapToPhase(m11 * glyphX, &placed.x, &key.phaseX);
+        SnapToPhase(m22 * glyphY, &placed.y, &key.phaseY);
+        key.glyphIndex = pGlyphRun->glyphIndices[i];
+
+        UINT uHash = HashKey(key);
+        placed.pEntry = FindGlyph(key, uHash);
+
+        if (placed.pEntry)
+        {
+            IFC(m_rgpRunGlyphs.Add(placed.pEntry));
+
+            if (placed.pEntry->fPending)
+            {
+                fPending = true;
+                continue;
+            }
+
+            m_cHits++;
+
+            // New items are inserted at the tail, keep the list ordered by use
+            if (placed.pEntry->cPins == 0)
+            {
+                m_entryList.RemoveFromList(placed.pEntry);
+                m_entryList.InsertAtTail(placed.pEntry);
+            }
+        }
+        else
+        {
+            m_cMisses++;
+
+            if (fAllowAsync)
+            {
+                if (!pJob)
+                {
+                    pJob = new RasterizationJob;
+                    IFCOOM(pJob);
+
+                    pJob->pIDWriteFactory = pIDWriteFactory;
+                    pJob->pIDWriteFactory->AddRef();
+                    pJob->pIDWriteFontFace = pGlyphRun->fontFace;
+                    pJob->pIDWriteFontFace->AddRef();
+                }
+
+                IFC(AddPendingGlyph(pJob, key, uHash, &placed.pEntry));
+                IFC(m_rgpRunGlyphs.Add(placed.pEntry));
+
+                fPending = true;
+                continue;
+            }
+
+            IFC(RasterizeGlyph(pIDWriteFactory, pGlyphRun->fontFace, key, uHash, &placed.pEntry));
+            AddEntry(placed.pEntry);
+            IFC(m_rgpRunGlyphs.Add(placed.pEntry));
+        }
+
+        if (fPending)
+        {
+            // Only looking for glyphs to queue now
+            continue;
+        }
+
+        if (!IsRectEmpty(placed.pEntry->rcClearType))
+        {
+            CMilRectL rcGlyph(placed.pEntry->rcClearType);
+            rcGlyph.Offset(placed.x, placed.y);
+            rcClearType.Union(rcGlyph);
+
+            if (placed.pEntry->rInkLeft < placed.pEntry->rInkRight)
+            {
+                float rGlyphLeft = placed.x + placed.pEntry->rInkLeft;
+                float rGlyphRight = placed.x + placed.pEntry->rInkRight;
+
+                if (fRightToLeft ? rGlyphRight > rInkLeft : rGlyphLeft < rInkRight)
+                {
+                    fOverlapping = true;
+                }
+
+                rInkLeft = min(rInkLeft, rGlyphLeft);
+                rInkRight = max(rInkRight, rGlyphRight);
+            }
+        }
+
+        if (!IsRectEmpty(placed.pEntry->rcBiLevel))
+        {
+            CMilRectL rcGlyph(placed.pEntry->rcBiLevel);
+            rcGlyph.Offset(placed.x, placed.y);
+            rcBiLevel.Union(rcGlyph);
+        }
+
+        IFC(m_rgPlacedGlyphs.Add(placed));
+    }
+
+    if (pJob)
+    {
+        IFC(SubmitJob(pJob));
+        pJob = NULL;
+    }
+
+    if (fPending)
+    {
+        IFC(PinRunGlyphs(pvRequester));
+
+        *pfPending = true;
+        goto Cleanup;
+    }
+
+    CMilRectL rcUnion(rcClearType);
+    rcUnion.Union(rcBiLevel);
+
+    if (fOverlapping)
+    {
+        *pfOverlapping = true;
+    }
+    else if (!rcUnion.IsEmpty())
+    {
+        //
+        // Assemble the glyphs
+        //
+        UINT32 stride;
+        UINT32 textureSize;
+        if (!WpfGfxSwitches::IsWpfGfxBoundsCheckProtectionDisabled())
+        {
+            UINT64 stride64 = (UINT64)rcUnion.Width() * 3;
+            UINT64 textureSize64 = stride64 * rcUnion.Height();
+            if (textureSize64 > UINT32_MAX)
+            {
+                IFC(WGXERR_BADNUMBER);
+            }
+            stride = (UINT32)stride64;
+            textureSize = (UINT32)textureSize64;
+        }
+        else
+        {
+            stride = rcUnion.Width() * 3;
+            textureSize = stride * rcUnion.Height();
+        }
+
+        pAlphaMap = (BYTE*)WPFAlloc(ProcessHeap,
+                                    Mt(GlyphBitmapClearType),
+                                    textureSize
+                                    );
+        IFCOOM(pAlphaMap);
+        memset(pAlphaMap, 0, textureSize);
+
+        for (UINT i = 0; i < m_rgPlacedGlyphs.GetCount(); i++)
+        {
+            const PlacedGlyph &placed = m_rgPlacedGlyphs[i];
+            const GlyphEntry *pEntry = placed.pEntry;
+
+            if (!IsRectEmpty(pEntry->rcClearType))
+            {
+                const RECT &rc = pEntry->rcClearType;
+                UINT srcStride = (rc.right - rc.left) * 3;
+                const BYTE *pSource = pEntry->pClearTypeAlpha;
+                BYTE *pDestLine = pAlphaMap
+                                  + (rc.top + placed.y - rcUnion.top) * stride
+                                  + (rc.left + placed.x - rcUnion.left) * 3;
+
+                for (INT y = rc.top; y < rc.bottom; y++)
+                {
+                    for (UINT j = 0; j < srcStride; j++)
+                    {
+                        UINT sum = pDestLine[j] + pSource[j];
+                        pDestLine[j] = static_cast<BYTE>(min(sum, 255u));
+                    }
+
+                    pDestLine += stride;
+                    pSource += srcStride;
+                }
+            }
+
+            if (!IsRectEmpty(pEntry->rcBiLevel))
+            {
+                const RECT &rc = pEntry->rcBiLevel;
+                UINT srcWidth = rc.right - rc.left;
+                const BYTE *pSource = pEntry->pBiLevelAlpha;
+                BYTE *pDestLine = pAlphaMap
+                                  + (rc.top + placed.y - rcUnion.top) * stride
+                                  + (rc.left + placed.x - rcUnion.left) * 3;
+
+                for (INT y = rc.top; y < rc.bottom; y++)
+                {
+                    BYTE *pDest = pDestLine;
+
+                    for (UINT j = 0; j < srcWidth; j++)
+                    {
+                        BYTE alpha = pSource[j];
+
+                        pDest[0] = max(pDest[0], alpha);
+                        pDest[1] = max(pDest[1], alpha);
+                        pDest[2] = max(pDest[2], alpha);
+                        pDest += 3;
+                    }
+
+                    pDestLine += stride;
+                    pSource += srcWidth;
+                }
+            }
+        }
+
+        if (!rcClearType.IsEmpty())
+        {
+            // pECT may be NULL if the contrast enhancement value is 0.
+            // Bilevel values are 0 or 255, which the table leaves alone.
+            if (pECT)
+            {
+                pECT->RenormalizeAndApplyContrast(pAlphaMap, stride, rcUnion.Height(), stride, textureSize);
+            }
+        }
+        else
+        {
+            *pfIsBiLevelOnly = true;
+        }
+
+        //
+        // Bounding box in the subpixel space the alpha maps are rendered in
+        //
+        pBoundingBox->left = rcUnion.left * 3;
+        pBoundingBox->top = rcUnion.top;
+        pBoundingBox->right = rcUnion.right * 3;
+        pBoundingBox->bottom = rcUnion.bottom;
+
+        *ppAlphaMap = pAlphaMap;
+        pAlphaMap = NULL;
+        *pTextureSize = textureSize;
+    }
+
+    // The run no longer needs its glyphs held
+    ReleasePins(pvRequester);
+
+Cleanup:
+    if (pJob)
+    {
+        // Never submitted; drop its pending glyphs
+        CompleteJob(pJob);
+    }
+
+    WPFFree(ProcessHeap, pAlphaMap);
+    m_rgPlacedGlyphs.Reset(FALSE);
+    m_rgpRunGlyphs.Reset(FALSE);
+
+    // Glyphs are not released while they are being placed, so trim now
+    TrimCache();
+
+    RRETURN(hr);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::FindGlyph
+//
+//  Synopsis:   Finds a glyph in the cache, pending or not
+//
+//-------------------------------------------------------------------------
+CGlyphAlphaCache::GlyphEntry *
+CGlyphAlphaCache::FindGlyph(__in const GlyphKey &key, UINT uHash)
+{
+    GlyphEntry *pEntry = m_rgpBuckets[uHash & (c_cBuckets - 1)];
+
+    while (pEntry && !(pEntry->uHash == uHash && KeysEqual(pEntry->key, key)))
+    {
+        pEntry = pEntry->pNextInBucket;
+    }
+
+    return pEntry;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::RasterizeGlyph
+//
+//  Synopsis:   Has DWrite rasterize one glyph at the key's size and phase.
+//              The new entry is not added to the cache.
+//
+//  Notes:      Called on the thread pool for background rasterization, so
+//              this must not touch the cache.
+//
+//-------------------------------------------------------------------------
+HRESULT
+CGlyphAlphaCache::RasterizeGlyph(
+    __in IDWriteFactory *pIDWriteFactory,
+    __in IDWriteFontFace *pIDWriteFontFace,
+    __in const GlyphKey &key,
+    UINT uHash,
+    __deref_out_ecount(1) GlyphEntry **ppEntry
+    )
+{
+    HRESULT hr = S_OK;
+    IDWriteGlyphRunAnalysis *pIDWriteGlyphRunAnalysis = NULL;
+    GlyphEntry *pEntry = NULL;
+
+    UINT16 glyphIndex = key.glyphIndex;
+    FLOAT glyphAdvance = 0.0f;
+
+    DWRITE_FONT_METRICS fontMetrics;
+    DWRITE_GLYPH_METRICS glyphMetrics;
+
+    DWRITE_GLYPH_RUN glyphRun;
+    glyphRun.fontFace = pIDWriteFontFace;
+    glyphRun.fontEmSize = key.emSize;
+    glyphRun.glyphCount = 1;
+    glyphRun.glyphIndices = &glyphIndex;
+    glyphRun.glyphAdvances = &glyphAdvance;
+    glyphRun.glyphOffsets = NULL;
+    glyphRun.isSideways = FALSE;
+    glyphRun.bidiLevel = 0;
+
+    DWRITE_MATRIX transform;
+    transform.m11 = key.scaleX / key.emSize;
+    transform.m12 = 0.0f;
+    transform.m21 = 0.0f;
+    transform.m22 = key.scaleY / key.emSize;
+    transform.dx = static_cast<float>(key.phaseX) / c_subpixelPhases;
+    transform.dy = static_cast<float>(key.phaseY) / c_subpixelPhases;
+
+    IFC(pIDWriteFactory->CreateGlyphRunAnalysis(
+        &glyphRun,
+        1,                                      // pixelsPerDip,
+        &transform,
+        key.renderingMode,
+        key.measuringMode,
+        0.0,
+        0.0,
+        &pIDWriteGlyphRunAnalysis
+        ));
+
+    //
+    // Measure the outline the way the run is laid out, so that overlaps can
+    // be found without looking at the textures
+    //
+    pIDWriteFontFace->GetMetrics(&fontMetrics);
+
+    if (key.measuringMode == DWRITE_MEASURING_MODE_NATURAL)
+    {
+        IFC(pIDWriteFontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &glyphMetrics, FALSE));
+    }
+    else
+    {
+        DWRITE_MATRIX scale = transform;
+        scale.dx = 0.0f;
+        scale.dy = 0.0f;
+
+        IFC(pIDWriteFontFace->GetGdiCompatibleGlyphMetrics(
+            key.emSize,
+            1,                                  // pixelsPerDip
+            &scale,
+            key.measuringMode == DWRITE_MEASURING_MODE_GDI_NATURAL,
+            &glyphIndex,
+            1,
+            &glyphMetrics,
+            FALSE
+            ));
+    }
+
+    RECT rcClearType;
+    RECT rcBiLevel;
+
+    IFC(pIDWriteGlyphRunAnalysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, &rcClearType));
+    IFC(pIDWriteGlyphRunAnalysis->GetAlphaTextureBounds(DWRITE_TEXTURE_ALIASED_1x1, &rcBiLevel));
+
+    if (IsRectEmpty(rcClearType))
+    {
+        memset(&rcClearType, 0, sizeof(rcClearType));
+    }
+
+    if (IsRectEmpty(rcBiLevel))
+    {
+        memset(&rcBiLevel, 0, sizeof(rcBiLevel));
+    }
+
+    UINT32 cbClearType = 0;
+    UINT32 cbBiLevel = 0;
+    UINT32 cbSize = 0;
+    if (!WpfGfxSwitches::IsWpfGfxBoundsCheckProtectionDisabled())
+    {
+        UINT64 cbClearType64 = (UINT64)(rcClearType.right - rcClearType.left) * 3 * (rcClearType.bottom - rcClearType.top);
+        UINT64 cbBiLevel64 = (UINT64)(rcBiLevel.right - rcBiLevel.left) * (rcBiLevel.bottom - rcBiLevel.top);
+        UINT64 cbSize64 = sizeof(GlyphEntry) + cbClearType64 + cbBiLevel64;
+        if (cbSize64 > UINT32_MAX)
+        {
+            IFC(WGXERR_BADNUMBER);
+        }
+        cbClearType = (UINT32)cbClearType64;
+        cbBiLevel = (UINT32)cbBiLevel64;
+        cbSize = (UINT32)cbSize64;
+    }
+    else
+    {
+        cbClearType = (rcClearType.right - rcClearType.left) * 3 * (rcClearType.bottom - rcClearType.top);
+        cbBiLevel = (rcBiLevel.right - rcBiLevel.left) * (rcBiLevel.bottom - rcBiLevel.top);
+        cbSize = sizeof(GlyphEntry) + cbClearType + cbBiLevel;
+    }
+
+    pEntry = (GlyphEntry *)WPFAlloc(ProcessHeap,
+                                    Mt(GlyphAlphaCacheEntry),
+                                    cbSize
+                                    );
+    IFCOOM(pEntry);
+    memset(pEntry, 0, sizeof(GlyphEntry));
+
+    pEntry->key = key;
+    pEntry->uHash = uHash;
+    pEntry->rcClearType = rcClearType;
+    pEntry->rcBiLevel = rcBiLevel;
+    pEntry->cbSize = cbSize;
+
+    {
+        float pixelsPerDesignUnit = key.scaleX / fontMetrics.designUnitsPerEm;
+
+        pEntry->rInkLeft = transform.dx + glyphMetrics.leftSideBearing * pixelsPerDesignUnit;
+        pEntry->rInkRight = transform.dx
+                            + (static_cast<INT32>(glyphMetrics.advanceWidth) - glyphMetrics.rightSideBearing)
+                              * pixelsPerDesignUnit;
+    }
+
+    if (cbClearType)
+    {
+        pEntry->pClearTypeAlpha = reinterpret_cast<BYTE *>(pEntry + 1);
+
+        IFC(pIDWriteGlyphRunAnalysis->CreateAlphaTexture(
+            DWRITE_TEXTURE_CLEARTYPE_3x1,
+            &rcClearType,
+            pEntry->pClearTypeAlpha,
+            cbClearType
+            ));
+    }
+
+    if (cbBiLevel)
+    {
+        pEntry->pBiLevelAlpha = reinterpret_cast<BYTE *>(pEntry + 1) + cbClearType;
+
+        IFC(pIDWriteGlyphRunAnalysis->CreateAlphaTexture(
+            DWRITE_TEXTURE_ALIASED_1x1,
+            &rcBiLevel,
+            pEntry->pBiLevelAlpha,
+            cbBiLevel
+            ));
+    }
+
+    *ppEntry = pEntry;
+    pEntry = NULL;
+
+Cleanup:
+    WPFFree(ProcessHeap, pEntry);
+    ReleaseInterface(pIDWriteGlyphRunAnalysis);
+
+    RRETURN(hr);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::AddEntry
+//
+//  Synopsis:   Adds a rasterized glyph to the cache as the most recently
+//              used
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::AddEntry(__inout_ecount(1) GlyphEntry *pEntry)
+{
+    Assert(!pEntry->fPending);
+
+    UINT uBucket = pEntry->uHash & (c_cBuckets - 1);
+    pEntry->pNextInBucket = m_rgpBuckets[uBucket];
+    m_rgpBuckets[uBucket] = pEntry;
+
+    if (pEntry->cPins == 0)
+    {
+        m_entryList.InsertAtTail(pEntry);
+    }
+
+    m_totalStorageSize += pEntry->cbSize;
+
+    pEntry->key.pIDWriteFont->AddRef();
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::AddPendingGlyph
+//
+//  Synopsis:   Holds a glyph's place in the cache and adds it to a job
+//
+//-------------------------------------------------------------------------
+HRESULT
+CGlyphAlphaCache::AddPendingGlyph(
+    __inout_ecount(1) RasterizationJob *pJob,
+    __in const GlyphKey &key,
+    UINT uHash,
+    __deref_out_ecount(1) GlyphEntry **ppEntry
+    )
+{
+    HRESULT hr = S_OK;
+
+    GlyphEntry *pEntry = (GlyphEntry *)WPFAlloc(ProcessHeap,
+                                                Mt(GlyphAlphaCacheEntry),
+                                                sizeof(GlyphEntry)
+                                                );
+    IFCOOM(pEntry);
+    memset(pEntry, 0, sizeof(GlyphEntry));
+
+    pEntry->key = key;
+    pEntry->uHash = uHash;
+    pEntry->fPending = true;
+
+    // The worker fills the slot with the same index
+    IFC(pJob->rgpRasterized.Add(NULL));
+    IFC(pJob->rgpPending.Add(pEntry));
+
+    UINT uBucket = uHash & (c_cBuckets - 1);
+    pEntry->pNextInBucket = m_rgpBuckets[uBucket];
+    m_rgpBuckets[uBucket] = pEntry;
+
+    pEntry->key.pIDWriteFont->AddRef();
+
+    *ppEntry = pEntry;
+    pEntry = NULL;
+
+Cleanup:
+    WPFFree(ProcessHeap, pEntry);
+
+    RRETURN(hr);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::SubmitJob
+//
+//  Synopsis:   Starts rasterizing a job's glyphs on the thread pool. If
+//              thread pool work cannot be created the job is executed here.
+//
+//-------------------------------------------------------------------------
+HRESULT
+CGlyphAlphaCache::SubmitJob(__inout_ecount(1) RasterizationJob *pJob)
+{
+    HRESULT hr = S_OK;
+
+    IFC(m_rgpJobs.Add(pJob));
+
+    pJob->pWork = CreateThreadpoolWork(&CGlyphAlphaCache::JobCallback, pJob, NULL);
+
+    if (pJob->pWork)
+    {
+        SubmitThreadpoolWork(pJob->pWork);
+    }
+    else
+    {
+        ExecuteJob(pJob);
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::ExecuteJob
+//
+//  Synopsis:   Rasterizes a job's glyphs. Runs on the thread pool.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::ExecuteJob(__inout_ecount(1) RasterizationJob *pJob)
+{
+    HRESULT hr = S_OK;
+
+    for (UINT i = 0; i < pJob->rgpPending.GetCount(); i++)
+    {
+        const GlyphEntry *pPending = pJob->rgpPending[i];
+
+        IFC(RasterizeGlyph(
+            pJob->pIDWriteFactory,
+            pJob->pIDWriteFontFace,
+            pPending->key,
+            pPending->uHash,
+            &pJob->rgpRasterized[i]
+            ));
+    }
+
+Cleanup:
+    pJob->hr = hr;
+
+    // Publishes the results to the render thread
+    InterlockedExchange(&pJob->fDone, TRUE);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::JobCallback
+//
+//  Synopsis:   Thread pool entry point
+//
+//-------------------------------------------------------------------------
+VOID CALLBACK
+CGlyphAlphaCache::JobCallback(
+    __inout PTP_CALLBACK_INSTANCE pInstance,
+    __inout_opt PVOID pvContext,
+    __inout PTP_WORK pWork
+    )
+{
+    UNREFERENCED_PARAMETER(pInstance);
+    UNREFERENCED_PARAMETER(pWork);
+
+    ExecuteJob(static_cast<RasterizationJob *>(pvContext));
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::CompleteRasterizations
+//
+//  Synopsis:   Adds the glyphs of finished jobs to the cache
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::CompleteRasterizations()
+{
+    UINT i = m_rgpJobs.GetCount();
+
+    while (i > 0)
+    {
+        i--;
+
+        RasterizationJob *pJob = m_rgpJobs[i];
+
+        if (pJob->fDone)
+        {
+            if (pJob->pWork)
+            {
+                // Let the callback return before the work is closed
+                WaitForThreadpoolWorkCallbacks(pJob->pWork, FALSE);
+            }
+
+            CompleteJob(pJob);
+            VerifySUCCEEDED(m_rgpJobs.RemoveAt(i));
+        }
+    }
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::CompleteJob
+//
+//  Synopsis:   Replaces a job's pending glyphs with the rasterized ones and
+//              deletes the job. Glyphs that were not rasterized are dropped
+//              so the next run needing them asks again.
+//
+//  Notes:      Pins move to the rasterized glyphs, which then stay out of
+//              the LRU list until the runs waiting for them are assembled.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::CompleteJob(__inout_ecount(1) RasterizationJob *pJob)
+{
+    for (UINT i = 0; i < pJob->rgpPending.GetCount(); i++)
+    {
+        GlyphEntry *pPending = pJob->rgpPending[i];
+        GlyphEntry *pEntry = pJob->rgpRasterized[i];
+
+        if (pPending->cPins > 0)
+        {
+            RetargetPins(pPending, pEntry);
+        }
+
+        RemoveEntry(pPending);
+
+        if (pEntry)
+        {
+            AddEntry(pEntry);
+            pJob->rgpRasterized[i] = NULL;
+        }
+    }
+
+    if (FAILED(pJob->hr))
+    {
+        m_fAsyncDisabled = true;
+    }
+
+    DeleteJob(pJob);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::DeleteJob
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::DeleteJob(__inout_ecount(1) RasterizationJob *pJob)
+{
+    for (UINT i = 0; i < pJob->rgpRasterized.GetCount(); i++)
+    {
+        WPFFree(ProcessHeap, pJob->rgpRasterized[i]);
+    }
+
+    if (pJob->pWork)
+    {
+        CloseThreadpoolWork(pJob->pWork);
+    }
+
+    ReleaseInterface(pJob->pIDWriteFactory);
+    ReleaseInterface(pJob->pIDWriteFontFace);
+
+    delete pJob;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::RemoveEntry
+//
+//  Synopsis:   Takes a glyph out of the cache and frees it
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::RemoveEntry(__inout_ecount(1) GlyphEntry *pEntry)
+{
+    GlyphEntry **ppLink = &m_rgpBuckets[pEntry->uHash & (c_cBuckets - 1)];
+
+    while (*ppLink != pEntry)
+    {
+        Assert(*ppLink);
+        ppLink = &(*ppLink)->pNextInBucket;
+    }
+
+    *ppLink = pEntry->pNextInBucket;
+
+    Assert(pEntry->cPins == 0);
+
+    if (!pEntry->fPending)
+    {
+        m_entryList.RemoveFromList(pEntry);
+
+        Assert(m_totalStorageSize >= pEntry->cbSize);
+        m_totalStorageSize -= pEntry->cbSize;
+    }
+
+    ReleaseInterface(pEntry->key.pIDWriteFont);
+
+    WPFFree(ProcessHeap, pEntry);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::TrimCache
+//
+//  Synopsis:   Frees glyphs according to LRU once the cache is over its
+//              limit.
+//
+//  Notes:      Run alpha maps are copies, so any glyph in the list may
+//              go. Pending and pinned glyphs are not in the list; they may
+//              keep the cache over its limit until the runs needing them
+//              are assembled.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::TrimCache()
+{
+    if (m_totalStorageSize > m_cMaximumStorageSize)
+    {
+        while (m_totalStorageSize > m_cTargetStorageSize && !m_entryList.IsEmpty())
+        {
+            RemoveEntry(m_entryList.PeekAtHead());
+            m_cEvictions++;
+        }
+    }
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::PinRunGlyphs
+//
+//  Synopsis:   Pins the glyphs of the run just reported pending, gathered
+//              in m_rgpRunGlyphs, in place of what was pinned for the
+//              requester before.
+//
+//-------------------------------------------------------------------------
+HRESULT
+CGlyphAlphaCache::PinRunGlyphs(__in const void *pvRequester)
+{
+    HRESULT hr = S_OK;
+    UINT oldIndex = FindPinnedRun(pvRequester);
+
+    PinnedRun *pPins = new PinnedRun;
+    IFCOOM(pPins);
+
+    pPins->pvRequester = pvRequester;
+    IFC(pPins->rgpEntries.Copy(m_rgpRunGlyphs));
+    IFC(m_rgpPinnedRuns.Add(pPins));
+
+    for (UINT i = 0; i < pPins->rgpEntries.GetCount(); i++)
+    {
+        PinEntry(pPins->rgpEntries[i]);
+    }
+
+    pPins = NULL;
+
+    // Pin the new set before the old one is let go so the glyphs in both
+    // stay out of the list
+    if (oldIndex != UINT_MAX)
+    {
+        ReleasePinnedRun(oldIndex);
+    }
+
+Cleanup:
+    delete pPins;
+
+    RRETURN(hr);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::ReleasePins
+//
+//  Synopsis:   Unpins the glyphs held for a requester, if any
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::ReleasePins(__in const void *pvRequester)
+{
+    UINT index = FindPinnedRun(pvRequester);
+
+    if (index != UINT_MAX)
+    {
+        ReleasePinnedRun(index);
+    }
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::FindPinnedRun
+//
+//  Returns:    Index of the requester's pinned run, or UINT_MAX
+//
+//-------------------------------------------------------------------------
+UINT
+CGlyphAlphaCache::FindPinnedRun(__in const void *pvRequester) const
+{
+    for (UINT i = 0; i < m_rgpPinnedRuns.GetCount(); i++)
+    {
+        if (m_rgpPinnedRuns[i]->pvRequester == pvRequester)
+        {
+            return i;
+        }
+    }
+
+    return UINT_MAX;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::ReleasePinnedRun
+//
+//  Synopsis:   Unpins a run's glyphs and forgets the run
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::ReleasePinnedRun(UINT index)
+{
+    PinnedRun *pPins = m_rgpPinnedRuns[index];
+
+    for (UINT i = 0; i < pPins->rgpEntries.GetCount(); i++)
+    {
+        if (pPins->rgpEntries[i])
+        {
+            UnpinEntry(pPins->rgpEntries[i]);
+        }
+    }
+
+    VerifySUCCEEDED(m_rgpPinnedRuns.RemoveAtOrderNotPreserved(index));
+
+    delete pPins;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::RetargetPins
+//
+//  Synopsis:   Moves the pins of a pending glyph to its rasterized entry,
+//              or drops them if the glyph could not be rasterized.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::RetargetPins(
+    __inout_ecount(1) GlyphEntry *pOldEntry,
+    __inout_ecount_opt(1) GlyphEntry *pNewEntry
+    )
+{
+    for (UINT i = 0; i < m_rgpPinnedRuns.GetCount(); i++)
+    {
+        DynArray<GlyphEntry *> &rgpEntries = m_rgpPinnedRuns[i]->rgpEntries;
+
+        for (UINT j = 0; j < rgpEntries.GetCount(); j++)
+        {
+            if (rgpEntries[j] == pOldEntry)
+            {
+                rgpEntries[j] = pNewEntry;
+            }
+        }
+    }
+
+    if (pNewEntry)
+    {
+        // Not in the cache yet, so not in the list either
+        pNewEntry->cPins = pOldEntry->cPins;
+    }
+
+    pOldEntry->cPins = 0;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::PinEntry
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::PinEntry(__inout_ecount(1) GlyphEntry *pEntry)
+{
+    if (pEntry->cPins++ == 0 && !pEntry->fPending)
+    {
+        m_entryList.RemoveFromList(pEntry);
+    }
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::UnpinEntry
+//
+//  Synopsis:   Drops a pin; the last one puts the glyph back in the list
+//              as the most recently used.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::UnpinEntry(__inout_ecount(1) GlyphEntry *pEntry)
+{
+    Assert(pEntry->cPins > 0);
+
+    if (--pEntry->cPins == 0 && !pEntry->fPending)
+    {
+        m_entryList.InsertAtTail(pEntry);
+    }
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::HashKey
+//
+//-------------------------------------------------------------------------
+UINT
+CGlyphAlphaCache::HashKey(__in const GlyphKey &key)
+{
+    UINT uHash = static_cast<UINT>(reinterpret_cast<UINT_PTR>(key.pIDWriteFont) >> 4);
+
+    uHash = uHash * 31 + *reinterpret_cast<const UINT *>(&key.emSize);
+    uHash = uHash * 31 + *reinterpret_cast<const UINT *>(&key.scaleX);
+    uHash = uHash * 31 + *reinterpret_cast<const UINT *>(&key.scaleY);
+    uHash = uHash * 31 + static_cast<UINT>(key.renderingMode);
+    uHash = uHash * 31 + static_cast<UINT>(key.measuringMode);
+    uHash = uHash * 31 + key.glyphIndex;
+    uHash = uHash * 31 + key.phaseX * c_subpixelPhases + key.phaseY;
+
+    // Fold the high bits into the bits that pick the bucket
+    return uHash ^ (uHash >> 10) ^ (uHash >> 20);
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::KeysEqual
+//
+//-------------------------------------------------------------------------
+bool
+CGlyphAlphaCache::KeysEqual(
+    __in const GlyphKey &key1,
+    __in const GlyphKey &key2
+    )
+{
+    return key1.pIDWriteFont == key2.pIDWriteFont
+        && key1.emSize == key2.emSize
+        && key1.scaleX == key2.scaleX
+        && key1.scaleY == key2.scaleY
+        && key1.renderingMode == key2.renderingMode
+        && key1.measuringMode == key2.measuringMode
+        && key1.glyphIndex == key2.glyphIndex
+        && key1.phaseX == key2.phaseX
+        && key1.phaseY == key2.phaseY;
+}
+
+//+------------------------------------------------------------------------
+//
+//  Member:     CGlyphAlphaCache::SnapToPhase
+//
+//  Synopsis:   Splits a device space coordinate into a whole pixel and the
+//              nearest subpixel phase.
+//
+//-------------------------------------------------------------------------
+void
+CGlyphAlphaCache::SnapToPhase(
+    float position,
+    __out INT *pPixel,
+    __out BYTE *pPhase
+    )
+{
+    INT snapped = CFloatFPU::Floor(position * c_subpixelPhases + 0.5f);
+    INT pixel = CFloatFPU::Floor(static_cast<float>(snapped) / c_subpixelPhases);
+
+    *pPixel = pixel;
+    *pPhase = static_cast<BYTE>(snapped - pixel * static_cast<INT>(c_subpixelPhases));
+}
+
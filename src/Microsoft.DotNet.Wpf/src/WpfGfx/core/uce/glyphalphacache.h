@@ -0,0 +1,272 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------
+//
+
+//
+//  Description:
+//
+//    Cache of DWrite alpha textures for single glyphs, shared by all the
+//    glyph runs of a composition. With the EnableGlyphRunAssembly switch
+//    set, glyph run alpha maps are assembled from the cached glyphs so that
+//    a glyph is rasterized once per size and subpixel phase instead of once
+//    per run containing it.
+//
+//    Missing glyphs may be rasterized on the thread pool. The run is then
+//    reported pending, and assembled by a later call once its glyphs have
+//    arrived. The glyphs a pending run needs are pinned until then so that
+//    trimming the cache can't take them away in between.
+//
+//------------------------------------------------------------------------
+
+#pragma once
+
+MtExtern(GlyphAlphaCacheEntry);
+MtExtern(GlyphRasterizationJob);
+MtExtern(GlyphAlphaCachePins);
+
+class CGlyphAlphaCache
+{
+public:
+    CGlyphAlphaCache();
+    ~CGlyphAlphaCache();
+
+    //
+    // Build the alpha map of a horizontal glyph run rendered with a scale
+    // only transform, in the layout CGlyphRunRealization::GetAlphaMap
+    // returns. If fAllowAsync is set and glyphs are missing, they are
+    // queued for rasterization and *pfPending is set instead; the glyphs
+    // of the run stay pinned for pvRequester until it asks again and the
+    // run is assembled. If the ink of its glyphs may overlap, the run
+    // can't be assembled and *pfOverlapping is set instead; the caller
+    // has the run rasterized as a whole.
+    //
+    HRESULT RealizeRunAlphaMap(
+        __in const void *pvRequester,
+        __in IDWriteFactory *pIDWriteFactory,
+        __in IDWriteFont *pIDWriteFont,
+        __in const DWRITE_GLYPH_RUN *pGlyphRun,
+        float scaleX,
+        float scaleY,
+        DWRITE_RENDERING_MODE renderingMode,
+        DWRITE_MEASURING_MODE measuringMode,
+        __in_opt const EnhancedContrastTable *pECT,
+        bool fAllowAsync,
+        __out bool *pfPending,
+        __out bool *pfOverlapping,
+        __deref_out_ecount_opt(*pTextureSize) BYTE **ppAlphaMap,
+        __out UINT32 *pTextureSize,
+        __out RECT *pBoundingBox,
+        __out bool *pfIsBiLevelOnly
+        );
+
+    //
+    // Add the glyphs of finished background rasterizations to the cache
+    //
+    void CompleteRasterizations();
+
+    //
+    // Release the glyphs pinned for a requester that won't ask again
+    //
+    void ReleasePins(__in const void *pvRequester);
+
+    UINT32 GetStorageSize() const
+    {
+        return m_totalStorageSize;
+    }
+
+    UINT GetHitCount() const { return m_cHits; }
+    UINT GetMissCount() const { return m_cMisses; }
+    UINT GetEvictionCount() const { return m_cEvictions; }
+
+    // Number of horizontal and vertical positions a glyph is rasterized at
+    // within a pixel
+    static const UINT c_subpixelPhases = 4;
+
+private:
+
+    struct GlyphKey
+    {
+        IDWriteFont *pIDWriteFont;      // Referenced while the entry is cached
+        float emSize;
+        float scaleX;
+        float scaleY;
+        DWRITE_RENDERING_MODE renderingMode;
+        DWRITE_MEASURING_MODE measuringMode;
+        UINT16 glyphIndex;
+        BYTE phaseX;
+        BYTE phaseY;
+    };
+
+    //
+    // One rasterized glyph. The ClearType texture has 3 bytes and the
+    // bilevel texture 1 byte per pixel; both follow the entry in the same
+    // allocation. Bounds are in pixels relative to the glyph's snapped
+    // origin.
+    //
+    struct GlyphEntry : public LIST_ENTRY
+    {
+        GlyphKey key;
+        UINT uHash;
+        GlyphEntry *pNextInBucket;
+
+        // A pending entry only holds a place in its bucket while the glyph
+        // is rasterized in the background. It has no textures and is not
+        // in the LRU list.
+        bool fPending;
+
+        // Number of pending runs that need the glyph. Pinned entries are
+        // not in the LRU list, so they can't be trimmed.
+        UINT cPins;
+
+        RECT rcClearType;
+        RECT rcBiLevel;
+        BYTE *pClearTypeAlpha;
+
+        // Horizontal extent of the glyph's outline from its metrics, in
+        // pixels relative to the snapped origin, phase included
+        float rInkLeft;
+        float rInkRight;
+
+        BYTE *pBiLevelAlpha;
+
+        UINT32 cbSize;              // Bytes held by the entry
+    };
+
+    //
+    // A glyph of the run being assembled and where it goes
+    //
+    struct PlacedGlyph
+    {
+        GlyphEntry *pEntry;
+        INT x;
+        INT y;
+    };
+
+    //
+    // Glyphs rasterized on the thread pool for one run. The worker only
+    // reads the keys of the pending entries and fills rgpRasterized; the
+    // render thread takes the results once fDone is set.
+    //
+    struct RasterizationJob
+    {
+        DECLARE_METERHEAP_CLEAR(ProcessHeap, Mt(GlyphRasterizationJob));
+
+        IDWriteFactory *pIDWriteFactory;
+        IDWriteFontFace *pIDWriteFontFace;
+        DynArray<GlyphEntry *> rgpPending;
+        DynArray<GlyphEntry *> rgpRasterized;
+        PTP_WORK pWork;
+        HRESULT hr;
+        volatile LONG fDone;
+    };
+
+    //
+    // Glyphs pinned for a run that was reported pending. Entries may be
+    // NULL once a glyph whose rasterization failed has been dropped.
+    //
+    struct PinnedRun
+    {
+        DECLARE_METERHEAP_CLEAR(ProcessHeap, Mt(GlyphAlphaCachePins));
+
+        const void *pvRequester;
+        DynArray<GlyphEntry *> rgpEntries;
+    };
+
+    GlyphEntry *FindGlyph(__in const GlyphKey &key, UINT uHash);
+
+    static HRESULT RasterizeGlyph(
+        __in IDWriteFactory *pIDWriteFactory,
+        __in IDWriteFontFace *pIDWriteFontFace,
+        __in const GlyphKey &key,
+        UINT uHash,
+        __deref_out_ecount(1) GlyphEntry **ppEntry
+        );
+
+    HRESULT AddPendingGlyph(
+        __inout_ecount(1) RasterizationJob *pJob,
+        __in const GlyphKey &key,
+        UINT uHash,
+        __deref_out_ecount(1) GlyphEntry **ppEntry
+        );
+
+    HRESULT SubmitJob(__inout_ecount(1) RasterizationJob *pJob);
+
+    static void ExecuteJob(__inout_ecount(1) RasterizationJob *pJob);
+
+    static VOID CALLBACK JobCallback(
+        __inout PTP_CALLBACK_INSTANCE pInstance,
+        __inout_opt PVOID pvContext,
+        __inout PTP_WORK pWork
+        );
+
+    void CompleteJob(__inout_ecount(1) RasterizationJob *pJob);
+
+    static void DeleteJob(__inout_ecount(1) RasterizationJob *pJob);
+
+    void AddEntry(__inout_ecount(1) GlyphEntry *pEntry);
+
+    void RemoveEntry(__inout_ecount(1) GlyphEntry *pEntry);
+
+    void TrimCache();
+
+    HRESULT PinRunGlyphs(__in const void *pvRequester);
+
+    UINT FindPinnedRun(__in const void *pvRequester) const;
+
+    void ReleasePinnedRun(UINT index);
+
+    void RetargetPins(
+        __inout_ecount(1) GlyphEntry *pOldEntry,
+        __inout_ecount_opt(1) GlyphEntry *pNewEntry
+        );
+
+    void PinEntry(__inout_ecount(1) GlyphEntry *pEntry);
+
+    void UnpinEntry(__inout_ecount(1) GlyphEntry *pEntry);
+
+    static UINT HashKey(__in const GlyphKey &key);
+
+    static bool KeysEqual(
+        __in const GlyphKey &key1,
+        __in const GlyphKey &key2
+        );
+
+    static void SnapToPhase(
+        float position,
+        __out INT *pPixel,
+        __out BYTE *pPhase
+        );
+
+    static const UINT c_cBuckets = 1024;    // Power of two
+
+    GlyphEntry *m_rgpBuckets[c_cBuckets];
+
+    CDoubleLinkedList<GlyphEntry> m_entryList;  // Least recently used at the head
+
+    DynArray<PlacedGlyph> m_rgPlacedGlyphs;     // Scratch for RealizeRunAlphaMap
+    DynArray<GlyphEntry *> m_rgpRunGlyphs;      // Scratch for RealizeRunAlphaMap
+
+    DynArray<PinnedRun *> m_rgpPinnedRuns;
+
+    DynArray<RasterizationJob *> m_rgpJobs;     // Submitted, not completed
+
+    // Set once a background rasterization fails; glyphs are then only
+    // rasterized synchronously, where failures reach the caller
+    bool m_fAsyncDisabled;
+
+    UINT32 m_totalStorageSize;
+
+    // If glyph storage exceeds m_cMaximumStorageSize we trim down to
+    // m_cTargetStorageSize
+    UINT32 m_cMaximumStorageSize;
+    UINT32 m_cTargetStorageSize;
+
+    UINT m_cHits;
+    UINT m_cMisses;
+    UINT m_cEvictions;
+};
+
@@ -92,9 +92,22 @@ CMilSlaveGlyphCache::~CMilSlaveGlyphCache()
 //
 //  Synopsis:   Trims bitmaps from the cache according to LRU.
 //
+//  Notes:      The glyph alpha cache trims itself as glyphs are added; its
+//              background rasterizations are collected and its state is
+//              reported here once per frame.
+//
 //-------------------------------------------------------------------------
 void CMilSlaveGlyphCache::TrimCache()
 {
+    m_glyphAlphaCache.CompleteRasterizations();
+
+    EventWriteGlyphAlphaCacheStats(
+        m_glyphAlphaCache.GetStorageSize() / 1024,
+        m_glyphAlphaCache.GetHitCount(),
+        m_glyphAlphaCache.GetMissCount(),
+        m_glyphAlphaCache.GetEvictionCount()
+        );
+
     if (m_totalGlyphBitmapStorageSize > m_cMaximumBitmapStorageSize)
     {
         if ((!m_realizationListNoRef.IsEmpty()) && (static_cast<LONG>(GetCurrentRealizationFrame() - m_realizationListNoRef.PeekAtHead()->LastUsedFrame()) > static_cast<LONG>(m_cFrameDelayBeforeCleanup)))
@@ -12,7 +12,9 @@
 //    Originally stored bitmaps for individual glyphs, now this class
 //    holds onto realizations which own bitmaps for entire glyph runs, 
 //    and this class remembers their sizes, and if necessary
-//    walks through them and trims bitmaps.
+//    walks through them and trims bitmaps. The bitmaps of individual
+//    glyphs that realizations are assembled from live in the
+//    CGlyphAlphaCache this class owns.
 //
 //------------------------------------------------------------------------
 
@@ -76,6 +78,11 @@ public:
         return m_pDWriteFactory;        
     }
 
+    __out CGlyphAlphaCache *GetGlyphAlphaCache()
+    {
+        return &m_glyphAlphaCache;
+    }
+
     void AddRealization(__in CGlyphRunRealization *pRealization, UINT32 textureSize);
     void RemoveRealization(__in CGlyphRunRealization *pRealization, UINT32 textureSize);
         
@@ -110,5 +117,8 @@ private:
     UTC_TIME m_currentRealizationFrame;  // Increments each time we compose AND process realizations
 
     IDWriteFactory *m_pDWriteFactory;    
+
+    // Single glyph textures that realizations are assembled from
+    CGlyphAlphaCache m_glyphAlphaCache;
 };
 
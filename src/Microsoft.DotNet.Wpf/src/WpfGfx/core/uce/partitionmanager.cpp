@@ -102,6 +102,7 @@ CPartitionManager::CPartitionManager()
     m_hevBeat = NULL;
     m_cEvents = 0;
     m_nWorkerThreadPriority = THREAD_PRIORITY_ERROR_RETURN;
+    m_cWorkerThreads = NUM_WORKER_THREADS;
 }
 
 
@@ -199,6 +200,7 @@ CPartitionManager::Initialize(
     Assert(m_hevWork == NULL);
     HRESULT hr = S_OK;
     DWORD fEnableDebugControl = 0;
+    DWORD fParallelPartitionRendering = 0;
     HKEY hRegAvalonGraphics = NULL;
 
     g_pMediaControl = NULL;
@@ -214,6 +216,27 @@ CPartitionManager::Initialize(
         RegReadDWORD(hRegAvalonGraphics,
             _T("EnableDebugControl"),
             &fEnableDebugControl);
+
+        RegReadDWORD(hRegAvalonGraphics,
+            _T("ParallelPartitionRendering"),
+            &fParallelPartitionRendering);
+    }
+
+    //
+    // Parallel partition rendering is opt-in: it lets several windows
+    // compose and render at the same time, one worker per processor.
+    // Process-wide state that rendering creates on first use, like the
+    // shared effect shaders and jitted blur functions, must then be created
+    // under InitOnce or the jitter lock.
+    //
+
+    if (fParallelPartitionRendering)
+    {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+
+        m_cWorkerThreads = max(static_cast<UINT>(si.dwNumberOfProcessors), static_cast<UINT>(NUM_WORKER_THREADS));
+        m_cWorkerThreads = min(m_cWorkerThreads, static_cast<UINT>(MAX_WORKER_THREADS));
     }
 
     if (fEnableDebugControl)
@@ -747,7 +770,8 @@ CPartitionManager::CurrentThreadIsWorkerThread()
 void
 CPartitionManager::StopWorkerThreads()
 {
-    HANDLE hWorkerThread = INVALID_HANDLE_VALUE;
+    HANDLE rghWorkerThreads[MAX_WORKER_THREADS];
+    DWORD cWorkerThreads = 0;
 
     {
         //
@@ -769,23 +793,20 @@ CPartitionManager::StopWorkerThreads()
         // for the threads to shut down. We need to do it here, because each 
         // thread will delete its entry before exiting.
         //
-        // This logic currently supports at
-        //  most one worker thread. Locking and special logic will need to
-        //  be added to support multiple worker threads.
-        //
 
-        Assert(m_rgpThread.GetCount() <= 1);
+        Assert(m_rgpThread.GetCount() <= MAX_WORKER_THREADS);
 
-        if (m_rgpThread.GetCount() == 1) 
+        for (UINT i = 0, n = m_rgpThread.GetCount(); i < n; i++)
         {
-            hWorkerThread = m_rgpThread[0]->GetHandle();
+            rghWorkerThreads[cWorkerThreads++] = m_rgpThread[i]->GetHandle();
         }
         
         Unlock();
     }
 
     //
-    // Trigger the worker threads to wake on the next heartbeat and shutdown.
+    // Trigger the worker threads to wake and shutdown. The work event is
+    // auto-reset, so each thread passes the wakeup on as it leaves GetWork.
     //    
     
     SetEvent(m_hevWork);
@@ -796,11 +817,14 @@ CPartitionManager::StopWorkerThreads()
     // worker threads which are also taking the CS.
     //
     
-    if (hWorkerThread != INVALID_HANDLE_VALUE)
+    if (cWorkerThreads > 0)
     {
-        ::WaitForSingleObject(hWorkerThread, INFINITE);
+        ::WaitForMultipleObjects(cWorkerThreads, rghWorkerThreads, TRUE, INFINITE);
 
-        ::CloseHandle(hWorkerThread);
+        for (DWORD i = 0; i < cWorkerThreads; i++)
+        {
+            ::CloseHandle(rghWorkerThreads[i]);
+        }
     }
     
     //
@@ -867,6 +891,7 @@ CPartitionManager::GetWork(
         Partition *pPartitionToRender = NULL;
         Partition *pPartitionToPresent = NULL;
         Partition *pPartitionToZombie = NULL;
+        UINT cReadyPartitions = 0;
         bool fNeedsBatchProcessing = false;
         bool fNeedsCompositionPass = false;
 
@@ -892,12 +917,14 @@ CPartitionManager::GetWork(
                 // be done before executing rendering requests
                 if (pPartitionToPresent == NULL)
                     pPartitionToPresent = pPartition;
+                cReadyPartitions++;
             }
             else if (pPartition->NeedsRender())
             {
                 // this partition is ready for rendering
                 if (pPartitionToRender == NULL)
                     pPartitionToRender = pPartition;
+                cReadyPartitions++;
             }
             else if (pPartition->NeedsBatchProcessing())
             {
@@ -918,6 +945,7 @@ CPartitionManager::GetWork(
                 {
                     pPartitionToZombie = pPartition;
                 }
+                cReadyPartitions++;
             }
             else
             {
@@ -961,7 +989,18 @@ CPartitionManager::GetWork(
 
         // If we have found the work then we are done
         if (*ppPartition != NULL)
+        {
+            //
+            // The work event is auto-reset and wakes a single thread. If other
+            // partitions are ready, pass the wakeup on to an idle worker so
+            // they get processed concurrently with this one.
+            //
+            if (m_cWorkerThreads > 1 && cReadyPartitions > 1)
+            {
+                SetEvent(m_hevWork);
+            }
             break;
+        }
 
         //
         // There is no immediate work to do but there might be deferred requests.
@@ -995,6 +1034,12 @@ CPartitionManager::GetWork(
 
     }
 
+    if (m_fShutdown)
+    {
+        // Let the next worker thread see the shutdown, see StopWorkerThreads.
+        SetEvent(m_hevWork);
+    }
+
     return workType;
 }
 
@@ -1038,8 +1083,6 @@ HRESULT CPartitionManager::UpdateSchedulerSettings(
 
     if (GetWorkerThreadPriority() != nPriority) 
     {
-        C_ASSERT(NUM_WORKER_THREADS == 1);
-
         Assert(GetWorkerThreadCount() == 0);
         
         if (m_hevWork != NULL)
@@ -1064,7 +1107,10 @@ HRESULT CPartitionManager::UpdateSchedulerSettings(
         m_rgEvents[m_cEvents++] = m_hevWork;
         m_hevBeat = NULL;
 
-        IFC(CreateWorkerThread(nPriority));
+        for (UINT i = 0; i < m_cWorkerThreads; i++)
+        {
+            IFC(CreateWorkerThread(nPriority));
+        }
     }
 
 Cleanup:
@@ -35,7 +35,14 @@ enum WorkType
 };
 
 
+//
+// Number of worker threads started by default. When parallel partition
+// rendering is enabled one worker per processor is started instead, up to
+// MAX_WORKER_THREADS; see CPartitionManager::Initialize.
+//
+
 #define NUM_WORKER_THREADS 1
+#define MAX_WORKER_THREADS MAXIMUM_WAIT_OBJECTS
 
 
 #if ENABLE_PARTITION_MANAGER_LOG
@@ -352,6 +359,15 @@ private:
     // Keep track of the threads
     DynArray<CPartitionThread *> m_rgpThread;
 
+    //
+    // Number of worker threads to start. Every partition is processed by at
+    // most one thread at a time (see PartitionIsBeingProcessed), so with more
+    // than one worker independent partitions render concurrently while the
+    // work of any single partition stays ordered.
+    //
+
+    UINT m_cWorkerThreads;
+
     //    
     // Worker threads wake up when both the pending work event and the heartbeat
     // timer are signalled. Currently the heartbeat event is a simple 10ms
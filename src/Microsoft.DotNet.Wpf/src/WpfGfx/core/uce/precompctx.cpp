@@ -95,7 +95,11 @@ CPreComputeContext::PreCompute(
     m_allowedDirtyRegionOverhead = allowedDirtyRegionOverhead;
 
     // Initialize our dirty region accumulator stack.
-    m_rootDirtyRegion.Initialize(prcSurfaceBounds, allowedDirtyRegionOverhead);
+    m_rootDirtyRegion.Initialize(
+        prcSurfaceBounds,
+        allowedDirtyRegionOverhead,
+        CCommonRegistryData::GetDirtyRegionRectBudget()
+        );
     m_dirtyRegionStack.Push(&m_rootDirtyRegion);
 
     m_pScrollAreaParameters = pScrollArea;
@@ -129,6 +133,10 @@ CPreComputeContext::PreCompute(
     Assert(m_fScrollHasBegun == false);
     m_effectCount = 0;
 
+    m_cNodesVisited = 0;
+    m_cNodesProcessed = 0;
+    m_cBoundsUpdated = 0;
+
     //
     // Start the walk from the root.
     //
@@ -140,6 +148,13 @@ CPreComputeContext::PreCompute(
         m_rootDirtyRegion.Enable();
     }
 
+    EventWritePrecomputeStats(
+        pRoot->GetSubtreeNodeCount(),
+        m_cNodesVisited,
+        m_cNodesProcessed,
+        m_cBoundsUpdated
+        );
+
     Assert(m_effectCount == 0);
     Assert(m_dirtyRegionStack.GetSize() == 1);
     m_dirtyRegionStack.Clear();
@@ -179,6 +194,19 @@ CPreComputeContext::PreSubgraph(
     CMilVisual* pNode = static_cast<CMilVisual*>(m_pGraphIterator->CurrentNode());
     Assert(pNode);
 
+    m_cNodesVisited++;
+
+    // Nodes are visited even if only a sibling changed, e.g. to union their
+    // bounds into the parent. Their cached bounds are still valid, so skip all
+    // other work for them.
+    if (CanSkipNode(pNode))
+    {
+        *pfVisitChildren = FALSE;
+        goto Cleanup;
+    }
+
+    m_cNodesProcessed++;
+
     if (pNode->HasEffects())
     {
         PushEffect();
@@ -316,6 +344,8 @@ CPreComputeContext::PreSubgraph(
         // This node's bbox needs to be updated. We start out by setting his bbox to the bbox of its content. All its
         // children will union their bbox into their parent's bbox. PostSubgraph will clip the bbox and transform it
         // to outer space.
+        m_cBoundsUpdated++;
+
         IFC(pNode->GetContentBounds(
             m_pContentBounder,
             OUT &(pNode->m_Bounds)
@@ -344,6 +374,20 @@ CPreComputeContext::PostSubgraph()
     // Store the inner bounds since we might need them for comparison later on.
     CMilRectF currentInnerBounds = pNode->m_Bounds;
     
+    if (CanSkipNode(pNode))
+    {
+        // Skipped in PreSubgraph; only contribute the cached bounds.
+        if (pParent && pParent->m_fNeedsBoundingBoxUpdate)
+        {
+            pParent->m_Bounds.Union(pNode->m_Bounds);
+        }
+
+        pNode->m_fHasStateOtherThanOffsetChanged = FALSE;
+        pNode->m_fAdditionalDirtyRectsExceeded = FALSE;
+
+        goto Cleanup;
+    }
+
     CDirtyRegion2 *pDirtyRegion;
     IFC(m_dirtyRegionStack.Top(&pDirtyRegion));
 
@@ -504,6 +548,29 @@ Cleanup:
     RRETURN(hr);
 }
 
+//-----------------------------------------------------------------------------
+// CPreComputeContext::CanSkipNode
+//
+//   Returns true if nothing changed in the subgraph of the node, so that the
+//   bounds computed in an earlier walk are valid and the node can not add to
+//   the dirty region. After a scroll every node has to be checked against the
+//   scrolled area, so no node is skipped then.
+//-----------------------------------------------------------------------------
+
+bool
+CPreComputeContext::CanSkipNode(
+    __in CMilVisual const *pNode
+    ) const
+{
+    return !(   pNode->m_fIsDirtyForRender
+             || pNode->m_fIsDirtyForRenderInSubgraph
+             || pNode->m_fNeedsBoundingBoxUpdate
+             || pNode->m_fHasAdditionalDirtyRegion
+             || pNode->m_fHasContentChanged
+             || pNode->m_pScrollBag != NULL
+             || ScrollHasCompleted());
+}
+
 //=============================================================================
 
 HRESULT
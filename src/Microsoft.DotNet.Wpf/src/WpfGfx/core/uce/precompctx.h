@@ -110,6 +110,18 @@ public:
         return m_rootDirtyRegion.GetRegionCount(); 
     }
 
+    // Returns the area reported dirty, see CDirtyRegion2::GetChangedArea.
+    float GetDirtyRegionChangedArea() const
+    {
+        return m_rootDirtyRegion.GetChangedArea();
+    }
+
+    // Returns the maximum number of rectangles in the dirty region.
+    UINT GetMaxDirtyRegionCount() const
+    {
+        return m_rootDirtyRegion.GetMaxRegionCount();
+    }
+
     // PreCompute the specified node. (Make sure to reset the PreComputeContext)
     HRESULT PreCompute(
         __in_ecount(1) CMilVisual *pRoot,
@@ -180,6 +192,10 @@ private:
         __in CMilVisual const *pNode
         );
 
+    bool CanSkipNode(
+        __in CMilVisual const *pNode
+        ) const;
+
     bool EffectsInParentChain() const 
     {
         return m_effectCount != 0;
@@ -235,5 +251,10 @@ private:
     // CMilVisual::HasEffects
     int m_effectCount;
 
+    // Walk statistics, reported through the PrecomputeStats event.
+    UINT m_cNodesVisited;
+    UINT m_cNodesProcessed;
+    UINT m_cBoundsUpdated;
+
 };
 
@@ -1085,6 +1085,10 @@ void
 CRenderTargetManager::AdvanceFrame()
 {
     ++m_uFrameNumber;
+
+    // Software realizations are budgeted across all targets and partitions
+    CSwRealizationManager::AdvanceFrame();
+
     UINT count = m_rgpTarget.GetCount();
     for (UINT i = 0; i < count; i++)
     {
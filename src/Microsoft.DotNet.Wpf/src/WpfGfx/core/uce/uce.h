@@ -52,6 +52,7 @@ Environment:
 #include "crossthreadcomposition.h"
 #include "samethreadcomposition.h"
 
+#include "glyphalphacache.h"
 #include "glyphcacheslave.h"
 
 //
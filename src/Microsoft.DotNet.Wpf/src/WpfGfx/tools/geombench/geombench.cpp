@@ -0,0 +1,1618 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+//  Description:
+//      Stress benchmark for the geometry scanner (CScanner), which computes
+//      outlines and Boolean operations.
+//
+//      Each case builds a synthetic shape with many edges crossing every
+//      scan line, and times Outline or Combine with the scanner's active
+//      list index enabled and disabled. Both modes must produce the same
+//      result; a mismatch is reported.
+//
+//      With -flatten it instead compares the analytic Bezier flattener with
+//      the HFD (hybrid forward differencing) one on fixed sets of curves.
+//
+//      With -widen it compares figure-parallel widening with the serial
+//      widener, which must produce exactly the same shape.
+//
+//      With -hittest it compares prepared (banded) hit testing with the
+//      direct HitTestFill and HitTestStroke on a grid of points.
+//
+//      See README.md for usage.
+//
+//------------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+// Each timing is repeated and the fastest run reported, to filter out
+// interruptions.
+
+static const UINT sc_cRuns = 3;
+
+enum BenchOperation
+{
+    BO_OUTLINE,             // CShapeBase::Outline
+    BO_INTERSECT            // CShapeBase::Combine with a clip rectangle
+};
+
+typedef HRESULT (*BuildShapeFunc)(UINT cFigures, __inout_ecount(1) CShape *pShape);
+
+struct BenchCase
+{
+    const char *pszName;
+    BuildShapeFunc pfnBuild;
+    UINT cDefaultFigures;
+    BenchOperation eOperation;
+};
+
+enum BenchMode
+{
+    BM_SCAN,                    // Scanner with and without the active list index
+    BM_FLATTEN,                 // Analytic and HFD Bezier flattening
+    BM_WIDEN,                   // Parallel and serial widening
+    BM_HITTEST                  // Prepared and direct hit testing
+};
+
+struct BenchOptions
+{
+    const char *pszFilter;      // Substring of the case names to run
+    UINT uScale;                // Multiplier for the figure counts
+    bool fCSV;
+    BenchMode eMode;
+};
+
+struct BenchResult
+{
+    double rMilliseconds;
+    UINT cFigures;              // Figures in the result
+    UINT cPoints;               // Points in the result
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildHatch
+//
+//  Synopsis:
+//      Adds parallel slanted strips which all span the same rows, so every
+//      scan line crosses two edges per strip and no edges intersect.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+BuildHatch(
+    UINT cFigures,
+    __inout_ecount(1) CShape *pShape
+    )
+{
+    HRESULT hr = S_OK;
+
+    for (UINT i = 0; i < cFigures; i++)
+    {
+        REAL x = 4.0f * i;
+        MilPoint2F rgPoints[4] =
+        {
+            { x,            0 },
+            { x + 2,        0 },
+            { x + 502,   1000 },
+            { x + 500,   1000 }
+        };
+
+        IFC(pShape->AddPolygon(rgPoints, ARRAYSIZE(rgPoints)));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildCrosshatch
+//
+//  Synopsis:
+//      Adds two sets of slanted strips leaning in opposite directions, so
+//      that each strip of one set crosses every strip of the other. The
+//      number of intersections grows with the square of cFigures.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+BuildCrosshatch(
+    UINT cFigures,
+    __inout_ecount(1) CShape *pShape
+    )
+{
+    HRESULT hr = S_OK;
+
+    REAL rWidth = 8.0f * cFigures;
+
+    for (UINT i = 0; i < cFigures; i++)
+    {
+        REAL x = 8.0f * i;
+        MilPoint2F rgForward[4] =
+        {
+            { x,                    0 },
+            { x + 3,                0 },
+            { x + rWidth + 3,    1000 },
+            { x + rWidth,        1000 }
+        };
+        MilPoint2F rgBackward[4] =
+        {
+            { x + rWidth,           0 },
+            { x + rWidth + 3,       0 },
+            { x + 3,             1000 },
+            { x,                 1000 }
+        };
+
+        IFC(pShape->AddPolygon(rgForward, ARRAYSIZE(rgForward)));
+        IFC(pShape->AddPolygon(rgBackward, ARRAYSIZE(rgBackward)));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildRandom
+//
+//  Synopsis:
+//      Adds small overlapping triangles scattered over a wide, short band.
+//      The positions come from a fixed linear congruential sequence, so
+//      every run and every build times the same shape.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+BuildRandom(
+    UINT cFigures,
+    __inout_ecount(1) CShape *pShape
+    )
+{
+    HRESULT hr = S_OK;
+
+    UINT uSeed = 12345;
+    REAL rWidth = 20.0f * cFigures;
+
+    for (UINT i = 0; i < cFigures; i++)
+    {
+        MilPoint2F rgPoints[3];
+
+        for (UINT j = 0; j < ARRAYSIZE(rgPoints); j++)
+        {
+            uSeed = uSeed * 1664525 + 1013904223;
+            REAL rX = (uSeed >> 8) * (1.0f / (1 << 24));
+            uSeed = uSeed * 1664525 + 1013904223;
+            REAL rY = (uSeed >> 8) * (1.0f / (1 << 24));
+
+            if (j == 0)
+            {
+                rgPoints[j].X = rX * rWidth;
+                rgPoints[j].Y = rY * 100;
+            }
+            else
+            {
+                rgPoints[j].X = rgPoints[0].X + (rX - 0.5f) * 30;
+                rgPoints[j].Y = rgPoints[0].Y + (rY - 0.5f) * 30;
+            }
+        }
+
+        IFC(pShape->AddPolygon(rgPoints, ARRAYSIZE(rgPoints)));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildRings
+//
+//  Synopsis:
+//      Adds overlapping ellipses in rows, so the shape is made of Bezier
+//      curves that the widener has to flatten.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+BuildRings(
+    UINT cFigures,
+    __inout_ecount(1) CShape *pShape
+    )
+{
+    HRESULT hr = S_OK;
+
+    for (UINT i = 0; i < cFigures; i++)
+    {
+        REAL x = 15.0f * (i % 100);
+        REAL y = 15.0f * (i / 100);
+
+        IFC(pShape->AddEllipse(x, y, 10.0f + (i % 7), 8.0f + (i % 5), CR_Parameters));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+struct FlattenCase
+{
+    const char *pszName;
+    GpReal rExtent;             // Size of the box the control points lie in
+    UINT cDefaultCurves;
+};
+
+struct FlattenResult
+{
+    double rMilliseconds;
+    UINT cPoints;               // Points generated for all the curves
+    GpReal rMaxDeviation;       // Largest distance of the curve from a chord
+    UINT cMalformed;            // Curves whose flattening breaks the sink contract
+};
+
+struct WidenCase
+{
+    const char *pszName;
+    BuildShapeFunc pfnBuild;
+    UINT cDefaultFigures;
+    bool fDashed;               // Stroke with a dashed pen
+};
+
+static const BenchCase sc_rgCases[] =
+{
+    { "hatch_outline",          BuildHatch,         5000,   BO_OUTLINE   },
+    { "hatch_intersect",        BuildHatch,         5000,   BO_INTERSECT },
+    { "crosshatch_outline",     BuildCrosshatch,     150,   BO_OUTLINE   },
+    { "crosshatch_intersect",   BuildCrosshatch,     150,   BO_INTERSECT },
+    { "random_outline",         BuildRandom,        5000,   BO_OUTLINE   },
+    { "random_intersect",       BuildRandom,        5000,   BO_INTERSECT },
+};
+
+// Extents span glyph-sized curves to ones large enough to reach the
+// flatteners' step limit.
+
+static const FlattenCase sc_rgFlattenCases[] =
+{
+    { "flatten_small",          4,          20000 },
+    { "flatten_medium",         200,        20000 },
+    { "flatten_large",          10000,      5000  },
+    { "flatten_huge",           1000000,    1000  },
+};
+
+// The shapes have enough figures for the parallel widener to split them
+// into several runs.
+
+static const WidenCase sc_rgWidenCases[] =
+{
+    { "hatch_widen",            BuildHatch,         5000,   false },
+    { "hatch_widen_dashed",     BuildHatch,         1000,   true  },
+    { "rings_widen",            BuildRings,         5000,   false },
+    { "rings_widen_dashed",     BuildRings,         1000,   true  },
+    { "random_widen",           BuildRandom,        5000,   false },
+};
+
+struct HitTestCase
+{
+    const char *pszName;
+    BuildShapeFunc pfnBuild;
+    UINT cDefaultFigures;
+    bool fStroke;               // Hit test the stroke instead of the fill
+};
+
+// The direct hit test walks the whole shape for every point, so these
+// shapes are much smaller than the scanner's.
+
+static const HitTestCase sc_rgHitTestCases[] =
+{
+    { "hatch_hit_fill",         BuildHatch,         200,    false },
+    { "crosshatch_hit_fill",    BuildCrosshatch,    100,    false },
+    { "rings_hit_fill",         BuildRings,         300,    false },
+    { "rings_hit_stroke",       BuildRings,         100,    true  },
+    { "random_hit_fill",        BuildRandom,        300,    false },
+    { "random_hit_stroke",      BuildRandom,        100,    true  },
+};
+
+// Points tested along each side of the grid, and the hit test threshold
+
+static const UINT sc_cHitTestGridSide = 60;
+static const double sc_rHitTestThreshold = 0.5;
+
+// A point where the two hit tests disagree is only accepted if the direct
+// hit test itself changes its answer when the threshold changes by this
+// fraction, i.e. if the point is within rounding of the edge of the
+// threshold band.
+
+static const double sc_rHitTestBorderline = 1e-3;
+
+struct HitTestResult
+{
+    double rDirectMilliseconds;
+    double rPreparedMilliseconds;   // Including the preparation
+    UINT cHits;                     // Points hit by the direct test
+    UINT cBorderline;               // Disagreements within rounding
+    UINT cMismatches;               // Other disagreements
+};
+
+// Points of the curve checked between the ends of each chord
+
+static const UINT sc_cDeviationSamples = 8;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CCollectingSink
+//
+//  Synopsis:
+//      Flattening sink that keeps the points and their parameters
+//
+//------------------------------------------------------------------------------
+
+class CCollectingSink : public CFlatteningSink
+{
+public:
+    void Reset()
+    {
+        m_rgPoints.Reset(FALSE);
+        m_rgParameters.Reset(FALSE);
+    }
+
+    override HRESULT AcceptPoint(
+        __in_ecount(1) const GpPointR &pt,
+        IN GpReal t,
+        __out_ecount(1) bool &fAborted
+        )
+    {
+        HRESULT hr = S_OK;
+
+        fAborted = false;
+
+        IFC(m_rgPoints.Add(pt));
+        IFC(m_rgParameters.Add(t));
+
+    Cleanup:
+        RRETURN(hr);
+    }
+
+    DynArray<GpPointR> m_rgPoints;
+    DynArray<GpReal> m_rgParameters;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildCurves
+//
+//  Synopsis:
+//      Fills rgControlPoints with cCurves cubic Beziers in a box of the given
+//      extent.  The first curves are the awkward cases: a straight line with
+//      uneven control points, a cusp, a loop and a single point.  The rest
+//      come from a fixed linear congruential sequence, so every run and
+//      every build flattens the same curves.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+BuildCurves(
+    GpReal rExtent,
+    UINT cCurves,
+    __out_ecount(4 * cCurves) GpPointR *rgControlPoints
+    )
+{
+    static const GpReal sc_rgSpecial[][8] =
+    {
+        { 0, 0,     0.9, 0.9,   0.1, 0.1,   1, 1 },     // Line
+        { 0, 0,     1, 1,       0, 1,       1, 0 },     // Cusp
+        { 0, 0,     1.5, 1,     -0.5, 1,    1, 0 },     // Loop
+        { 0.5, 0.5, 0.5, 0.5,   0.5, 0.5,   0.5, 0.5 }, // Point
+    };
+
+    UINT uSeed = 12345;
+
+    for (UINT i = 0; i < cCurves; i++)
+    {
+        for (UINT j = 0; j < 4; j++)
+        {
+            GpPointR &pt = rgControlPoints[4 * i + j];
+
+            if (i < ARRAYSIZE(sc_rgSpecial))
+            {
+                pt.X = sc_rgSpecial[i][2 * j] * rExtent;
+                pt.Y = sc_rgSpecial[i][2 * j + 1] * rExtent;
+            }
+            else
+            {
+                uSeed = uSeed * 1664525 + 1013904223;
+                pt.X = (uSeed >> 8) * (rExtent / (1 << 24));
+                uSeed = uSeed * 1664525 + 1013904223;
+                pt.Y = (uSeed >> 8) * (rExtent / (1 << 24));
+            }
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      EvaluateBezier
+//
+//------------------------------------------------------------------------------
+
+static GpPointR
+EvaluateBezier(
+    __in_ecount(4) const GpPointR *rgControlPoints,
+    GpReal t
+    )
+{
+    GpReal s = 1 - t;
+
+    return rgControlPoints[0] * (s * s * s) +
+           rgControlPoints[1] * (3 * s * s * t) +
+           rgControlPoints[2] * (3 * s * t * t) +
+           rgControlPoints[3] * (t * t * t);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetMaxDeviation
+//
+//  Synopsis:
+//      Returns the largest distance between the curve and the chords of its
+//      flattening, sampled at sc_cDeviationSamples - 1 points per chord.
+//
+//------------------------------------------------------------------------------
+
+static GpReal
+GetMaxDeviation(
+    __in_ecount(4) const GpPointR *rgControlPoints,
+    __in_ecount(1) const CCollectingSink &sink
+    )
+{
+    GpReal rMaxDeviation = 0;
+    GpPointR ptStart = rgControlPoints[0];
+    GpReal rStart = 0;
+
+    for (UINT i = 0; i < sink.m_rgPoints.GetCount(); i++)
+    {
+        GpPointR ptEnd = sink.m_rgPoints[i];
+        GpReal rEnd = sink.m_rgParameters[i];
+        GpPointR vecChord = ptEnd - ptStart;
+        GpReal rChordSquared = vecChord * vecChord;
+
+        for (UINT j = 1; j < sc_cDeviationSamples; j++)
+        {
+            GpReal t = rStart + (rEnd - rStart) * j / sc_cDeviationSamples;
+            GpPointR vecToCurve = EvaluateBezier(rgControlPoints, t) - ptStart;
+
+            // Distance to the nearest point of the chord segment
+            GpReal rAlong = 0;
+
+            if (rChordSquared > 0)
+            {
+                rAlong = max(0.0, min(1.0, (vecToCurve * vecChord) / rChordSquared));
+            }
+
+            GpReal rDeviation = (vecToCurve - vecChord * rAlong).Norm();
+
+            if (rDeviation > rMaxDeviation)
+            {
+                rMaxDeviation = rDeviation;
+            }
+        }
+
+        ptStart = ptEnd;
+        rStart = rEnd;
+    }
+
+    return rMaxDeviation;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      IsFlatteningWellFormed
+//
+//  Synopsis:
+//      Returns true if the flattening keeps to what the sinks rely on: the
+//      parameters increase strictly within (0, 1], and the last point is
+//      the end control point, exactly, at parameter 1.
+//
+//------------------------------------------------------------------------------
+
+static bool
+IsFlatteningWellFormed(
+    __in_ecount(4) const GpPointR *rgControlPoints,
+    __in_ecount(1) const CCollectingSink &sink
+    )
+{
+    UINT cPoints = sink.m_rgPoints.GetCount();
+    GpReal rPrevious = 0;
+
+    if (cPoints == 0)
+    {
+        return false;
+    }
+
+    for (UINT i = 0; i < cPoints; i++)
+    {
+        GpReal t = sink.m_rgParameters[i];
+
+        if (!(t > rPrevious && t <= 1))
+        {
+            return false;
+        }
+
+        rPrevious = t;
+    }
+
+    const GpPointR &ptLast = sink.m_rgPoints[cPoints - 1];
+
+    return sink.m_rgParameters[cPoints - 1] == 1
+        && ptLast.X == rgControlPoints[3].X
+        && ptLast.Y == rgControlPoints[3].Y;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      FlattenCurves
+//
+//  Synopsis:
+//      Flattens every curve repeatedly with the given flattener, and reports
+//      the fastest run, the number of points, the largest deviation and the
+//      number of malformed flattenings.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+FlattenCurves(
+    __in_ecount(4 * cCurves) const GpPointR *rgControlPoints,
+    UINT cCurves,
+    bool fAnalytic,
+    __out_ecount(1) FlattenResult *pResult
+    )
+{
+    HRESULT hr = S_OK;
+
+    CCollectingSink sink;
+    CBezierFlattener flattener(&sink, DEFAULT_FLATTENING_TOLERANCE);
+    LARGE_INTEGER liFrequency;
+    double rBestSeconds = 0;
+
+    QueryPerformanceFrequency(&liFrequency);
+
+    CBezierFlattener::EnableAnalyticFlattening(fAnalytic);
+
+    pResult->cPoints = 0;
+    pResult->rMaxDeviation = 0;
+    pResult->cMalformed = 0;
+
+    for (UINT uRun = 0; uRun < sc_cRuns; uRun++)
+    {
+        LARGE_INTEGER liStart, liEnd;
+
+        QueryPerformanceCounter(&liStart);
+
+        for (UINT i = 0; i < cCurves; i++)
+        {
+            sink.Reset();
+
+            for (UINT j = 0; j < 4; j++)
+            {
+                flattener.SetPoint(j, rgControlPoints[4 * i + j]);
+            }
+
+            IFC(flattener.Flatten(false));
+        }
+
+        QueryPerformanceCounter(&liEnd);
+
+        double rSeconds =
+            static_cast<double>(liEnd.QuadPart - liStart.QuadPart) / liFrequency.QuadPart;
+
+        if (uRun == 0 || rSeconds < rBestSeconds)
+        {
+            rBestSeconds = rSeconds;
+        }
+    }
+
+    // Measure the output outside the timed runs
+
+    for (UINT i = 0; i < cCurves; i++)
+    {
+        sink.Reset();
+
+        for (UINT j = 0; j < 4; j++)
+        {
+            flattener.SetPoint(j, rgControlPoints[4 * i + j]);
+        }
+
+        IFC(flattener.Flatten(false));
+
+        pResult->cPoints += sink.m_rgPoints.GetCount();
+        pResult->rMaxDeviation = max(
+            pResult->rMaxDeviation,
+            GetMaxDeviation(&rgControlPoints[4 * i], sink)
+            );
+
+        if (!IsFlatteningWellFormed(&rgControlPoints[4 * i], sink))
+        {
+            pResult->cMalformed++;
+        }
+    }
+
+    pResult->rMilliseconds = rBestSeconds * 1000;
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunFlattenCases
+//
+//  Synopsis:
+//      Flattens each set of curves with the HFD and the analytic flattener.
+//      A set fails when the analytic flattener strays further from the curve
+//      than both the tolerance and the HFD flattener, or when either
+//      flattener produces a malformed flattening.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunFlattenCases(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcMismatches
+    )
+{
+    HRESULT hr = S_OK;
+
+    GpPointR *rgControlPoints = NULL;
+
+    *pcMismatches = 0;
+
+    for (UINT uCase = 0; uCase < ARRAYSIZE(sc_rgFlattenCases); uCase++)
+    {
+        const FlattenCase &fc = sc_rgFlattenCases[uCase];
+
+        if (pOptions->pszFilter != NULL && strstr(fc.pszName, pOptions->pszFilter) == NULL)
+        {
+            continue;
+        }
+
+        FlattenResult hfd, analytic;
+        UINT cCurves = fc.cDefaultCurves * pOptions->uScale;
+
+        delete [] rgControlPoints;
+        rgControlPoints = new GpPointR[4 * cCurves];
+        IFCOOM(rgControlPoints);
+
+        BuildCurves(fc.rExtent, cCurves, rgControlPoints);
+
+        IFC(FlattenCurves(rgControlPoints, cCurves, false, &hfd));
+        IFC(FlattenCurves(rgControlPoints, cCurves, true, &analytic));
+
+        // Allow for rounding in the deviation measurement itself
+        GpReal rAllowed = max(DEFAULT_FLATTENING_TOLERANCE, hfd.rMaxDeviation) * (1 + 1e-6);
+        bool fWellFormed = hfd.cMalformed == 0 && analytic.cMalformed == 0;
+        bool fMatch = !(analytic.rMaxDeviation > rAllowed) && fWellFormed;
+
+        if (!fMatch)
+        {
+            (*pcMismatches)++;
+        }
+
+        double rSpeedup =
+            analytic.rMilliseconds > 0 ? hfd.rMilliseconds / analytic.rMilliseconds : 0;
+
+        if (pOptions->fCSV)
+        {
+            printf("%s,%u,%.3f,%.3f,%.2f,%u,%u,%.6f,%.6f,%s\n",
+                fc.pszName,
+                cCurves,
+                hfd.rMilliseconds,
+                analytic.rMilliseconds,
+                rSpeedup,
+                hfd.cPoints,
+                analytic.cPoints,
+                hfd.rMaxDeviation,
+                analytic.rMaxDeviation,
+                fMatch ? "ok" : (fWellFormed ? "MISMATCH" : "MALFORMED")
+                );
+        }
+        else
+        {
+            printf("%-24s %7u %10.2f %10.2f %7.2fx %9u %9u %9.4f %9.4f %s\n",
+                fc.pszName,
+                cCurves,
+                hfd.rMilliseconds,
+                analytic.rMilliseconds,
+                rSpeedup,
+                hfd.cPoints,
+                analytic.cPoints,
+                hfd.rMaxDeviation,
+                analytic.rMaxDeviation,
+                fMatch ? "" : (fWellFormed ? "MISMATCH" : "MALFORMED")
+                );
+        }
+    }
+
+Cleanup:
+    delete [] rgControlPoints;
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      AreShapesIdentical
+//
+//  Synopsis:
+//      Returns true if the shapes have the same figures, with the same
+//      points, segment types and flags, in the same order.
+//
+//------------------------------------------------------------------------------
+
+static bool
+AreShapesIdentical(
+    __in_ecount(1) const CShape &shape1,
+    __in_ecount(1) const CShape &shape2
+    )
+{
+    if (shape1.GetFigureCount() != shape2.GetFigureCount())
+    {
+        return false;
+    }
+
+    for (UINT i = 0; i < shape1.GetFigureCount(); i++)
+    {
+        const CFigureData &figure1 = shape1.GetFigureData(i);
+        const CFigureData &figure2 = shape2.GetFigureData(i);
+
+        if (   figure1.GetPointCount() != figure2.GetPointCount()
+            || figure1.GetSegCount() != figure2.GetSegCount()
+            || figure1.IsClosed() != figure2.IsClosed()
+            || figure1.IsFillable() != figure2.IsFillable())
+        {
+            return false;
+        }
+
+        if (   memcmp(figure1.GetRawPoints(),
+                      figure2.GetRawPoints(),
+                      figure1.GetPointCount() * sizeof(MilPoint2F)) != 0
+            || memcmp(figure1.GetRawTypes(),
+                      figure2.GetRawTypes(),
+                      figure1.GetSegCount() * sizeof(BYTE)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      TimeWiden
+//
+//  Synopsis:
+//      Widens the shape repeatedly with parallel widening enabled or
+//      disabled, and reports the fastest run and the widened shape.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+TimeWiden(
+    __in_ecount(1) const CShape *pShape,
+    __in_ecount(1) const CPlainPen &pen,
+    bool fParallel,
+    __inout_ecount(1) CShape *pWidened,
+    __out_ecount(1) BenchResult *pResult
+    )
+{
+    HRESULT hr = S_OK;
+
+    LARGE_INTEGER liFrequency;
+    double rBestSeconds = 0;
+
+    QueryPerformanceFrequency(&liFrequency);
+
+    CShapeBase::EnableParallelWidening(fParallel);
+
+    for (UINT uRun = 0; uRun < sc_cRuns; uRun++)
+    {
+        LARGE_INTEGER liStart, liEnd;
+
+        pWidened->Reset();
+
+        QueryPerformanceCounter(&liStart);
+        IFC(pShape->WidenToShape(
+            pen,
+            DEFAULT_FLATTENING_TOLERANCE,
+            false,      // Absolute tolerance
+            *pWidened,
+            NULL,       // No transform
+            NULL        // No viewable rectangle
+            ));
+        QueryPerformanceCounter(&liEnd);
+
+        double rSeconds =
+            static_cast<double>(liEnd.QuadPart - liStart.QuadPart) / liFrequency.QuadPart;
+
+        if (uRun == 0 || rSeconds < rBestSeconds)
+        {
+            rBestSeconds = rSeconds;
+        }
+    }
+
+    pResult->rMilliseconds = rBestSeconds * 1000;
+    pResult->cFigures = pWidened->GetFigureCount();
+    pResult->cPoints = 0;
+
+    for (UINT i = 0; i < pResult->cFigures; i++)
+    {
+        pResult->cPoints += pWidened->GetFigureData(i).GetPointCount();
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunWidenCases
+//
+//  Synopsis:
+//      Widens each shape serially and on the worker pool. The parallel
+//      result must be identical to the serial one.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunWidenCases(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcMismatches
+    )
+{
+    HRESULT hr = S_OK;
+
+    *pcMismatches = 0;
+
+    for (UINT uCase = 0; uCase < ARRAYSIZE(sc_rgWidenCases); uCase++)
+    {
+        const WidenCase &wc = sc_rgWidenCases[uCase];
+
+        if (pOptions->pszFilter != NULL && strstr(wc.pszName, pOptions->pszFilter) == NULL)
+        {
+            continue;
+        }
+
+        CShape shape;
+        CShape serialWidened, parallelWidened;
+        CPlainPen pen;
+        BenchResult serial, parallel;
+        UINT cFigures = wc.cDefaultFigures * pOptions->uScale;
+
+        IFC(wc.pfnBuild(cFigures, &shape));
+
+        pen.Set(3.0f, 3.0f, 0.0f);
+        pen.SetJoin(MilLineJoin::Round);
+
+        if (wc.fDashed)
+        {
+            IFC(pen.SetDashStyle(MilDashStyle::Dash));
+        }
+
+        IFC(TimeWiden(&shape, pen, false, &serialWidened, &serial));
+        IFC(TimeWiden(&shape, pen, true, &parallelWidened, &parallel));
+
+        bool fMatch = AreShapesIdentical(serialWidened, parallelWidened);
+
+        if (!fMatch)
+        {
+            (*pcMismatches)++;
+        }
+
+        double rSpeedup =
+            parallel.rMilliseconds > 0 ? serial.rMilliseconds / parallel.rMilliseconds : 0;
+
+        if (pOptions->fCSV)
+        {
+            printf("%s,%u,%.3f,%.3f,%.2f,%u,%u,%s\n",
+                wc.pszName,
+                cFigures,
+                serial.rMilliseconds,
+                parallel.rMilliseconds,
+                rSpeedup,
+                serial.cFigures,
+                serial.cPoints,
+                fMatch ? "ok" : "MISMATCH"
+                );
+        }
+        else
+        {
+            printf("%-24s %7u %10.2f %10.2f %7.2fx %8u %9u %s\n",
+                wc.pszName,
+                cFigures,
+                serial.rMilliseconds,
+                parallel.rMilliseconds,
+                rSpeedup,
+                serial.cFigures,
+                serial.cPoints,
+                fMatch ? "" : "MISMATCH"
+                );
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      HitTestDirect
+//
+//  Synopsis:
+//      Hit tests one point with HitTestFill, or with HitTestStroke if there
+//      is a pen.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+HitTestDirect(
+    __in_ecount(1) const CShape *pShape,
+    __in_ecount_opt(1) const CPlainPen *pPen,
+    __in_ecount(1) const MilPoint2F &pt,
+    double rThreshold,
+    __out_ecount(1) BOOL *pfHit
+    )
+{
+    HRESULT hr = S_OK;
+
+    BOOL fIsNear;
+
+    if (pPen != NULL)
+    {
+        IFC(pShape->HitTestStroke(*pPen, pt, rThreshold, false, NULL, *pfHit, fIsNear));
+    }
+    else
+    {
+        IFC(pShape->HitTestFill(pt, rThreshold, false, NULL, *pfHit, fIsNear));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetHitTestPoint
+//
+//  Synopsis:
+//      Returns point (i, j) of a grid that covers the bounds with a margin.
+//      The offsets are not round, so the points don't fall exactly on the
+//      shapes' vertices.
+//
+//------------------------------------------------------------------------------
+
+static MilPoint2F
+GetHitTestPoint(
+    __in_ecount(1) const CMilRectF &rcBounds,
+    UINT i,
+    UINT j
+    )
+{
+    REAL rMargin = 5.0f;
+    REAL rStepX = (rcBounds.right - rcBounds.left + 2 * rMargin) / sc_cHitTestGridSide;
+    REAL rStepY = (rcBounds.bottom - rcBounds.top + 2 * rMargin) / sc_cHitTestGridSide;
+    MilPoint2F pt;
+
+    pt.X = rcBounds.left - rMargin + (i + 0.371f) * rStepX;
+    pt.Y = rcBounds.top - rMargin + (j + 0.613f) * rStepY;
+
+    return pt;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      CompareHitTests
+//
+//  Synopsis:
+//      Hit tests every point of the grid directly and with a prepared hit
+//      test, times both, and counts the points where they disagree.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+CompareHitTests(
+    __in_ecount(1) const CShape *pShape,
+    __in_ecount_opt(1) const CPlainPen *pPen,
+    __out_ecount(1) HitTestResult *pResult
+    )
+{
+    HRESULT hr = S_OK;
+
+    CPreparedHitTest *pPrepared = NULL;
+    BOOL *rgfDirectHits = NULL;
+    DynArray<UINT> rguDisagreements;    // Grid indices of the points
+    CMilRectF rcBounds;
+    LARGE_INTEGER liFrequency, liStart, liEnd;
+    UINT cPoints = sc_cHitTestGridSide * sc_cHitTestGridSide;
+
+    QueryPerformanceFrequency(&liFrequency);
+
+    pResult->cHits = 0;
+    pResult->cBorderline = 0;
+    pResult->cMismatches = 0;
+
+    IFC(pShape->GetTightBounds(rcBounds, pPen, NULL));
+
+    rgfDirectHits = new BOOL[cPoints];
+    IFCOOM(rgfDirectHits);
+
+    QueryPerformanceCounter(&liStart);
+
+    for (UINT j = 0; j < sc_cHitTestGridSide; j++)
+    {
+        for (UINT i = 0; i < sc_cHitTestGridSide; i++)
+        {
+            IFC(HitTestDirect(
+                pShape,
+                pPen,
+                GetHitTestPoint(rcBounds, i, j),
+                sc_rHitTestThreshold,
+                &rgfDirectHits[j * sc_cHitTestGridSide + i]
+                ));
+        }
+    }
+
+    QueryPerformanceCounter(&liEnd);
+
+    pResult->rDirectMilliseconds =
+        static_cast<double>(liEnd.QuadPart - liStart.QuadPart) * 1000 / liFrequency.QuadPart;
+
+    QueryPerformanceCounter(&liStart);
+
+    IFC(pShape->PrepareHitTest(pPen, sc_rHitTestThreshold, false, &pPrepared));
+
+    for (UINT j = 0; j < sc_cHitTestGridSide; j++)
+    {
+        for (UINT i = 0; i < sc_cHitTestGridSide; i++)
+        {
+            BOOL fPreparedHit;
+            BOOL fDirectHit = rgfDirectHits[j * sc_cHitTestGridSide + i];
+
+            IFC(pPrepared->HitTest(GetHitTestPoint(rcBounds, i, j), fPreparedHit));
+
+            if (fDirectHit)
+            {
+                pResult->cHits++;
+            }
+
+            if (!fPreparedHit != !fDirectHit)
+            {
+                // Classified after the timing
+                IFC(rguDisagreements.Add(j * sc_cHitTestGridSide + i));
+            }
+        }
+    }
+
+    QueryPerformanceCounter(&liEnd);
+
+    pResult->rPreparedMilliseconds =
+        static_cast<double>(liEnd.QuadPart - liStart.QuadPart) * 1000 / liFrequency.QuadPart;
+
+    for (UINT k = 0; k < rguDisagreements.GetCount(); k++)
+    {
+        UINT uIndex = rguDisagreements[k];
+        MilPoint2F pt = GetHitTestPoint(
+            rcBounds,
+            uIndex % sc_cHitTestGridSide,
+            uIndex / sc_cHitTestGridSide
+            );
+        BOOL fHitNarrower, fHitWider;
+
+        IFC(HitTestDirect(pShape, pPen, pt,
+            sc_rHitTestThreshold * (1 - sc_rHitTestBorderline), &fHitNarrower));
+        IFC(HitTestDirect(pShape, pPen, pt,
+            sc_rHitTestThreshold * (1 + sc_rHitTestBorderline), &fHitWider));
+
+        if (!fHitNarrower != !fHitWider)
+        {
+            pResult->cBorderline++;
+        }
+        else
+        {
+            pResult->cMismatches++;
+        }
+    }
+
+Cleanup:
+    delete pPrepared;
+    delete [] rgfDirectHits;
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunHitTestCases
+//
+//  Synopsis:
+//      Hit tests a grid of points against each shape directly and with a
+//      prepared hit test.  The prepared hit test must agree with the direct
+//      one, except within rounding of the threshold.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunHitTestCases(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcMismatches
+    )
+{
+    HRESULT hr = S_OK;
+
+    *pcMismatches = 0;
+
+    for (UINT uCase = 0; uCase < ARRAYSIZE(sc_rgHitTestCases); uCase++)
+    {
+        const HitTestCase &hc = sc_rgHitTestCases[uCase];
+
+        if (pOptions->pszFilter != NULL && strstr(hc.pszName, pOptions->pszFilter) == NULL)
+        {
+            continue;
+        }
+
+        CShape shape;
+        CPlainPen pen;
+        HitTestResult result;
+        UINT cFigures = hc.cDefaultFigures * pOptions->uScale;
+
+        IFC(hc.pfnBuild(cFigures, &shape));
+
+        pen.Set(3.0f, 3.0f, 0.0f);
+        pen.SetJoin(MilLineJoin::Round);
+
+        IFC(CompareHitTests(&shape, hc.fStroke ? &pen : NULL, &result));
+
+        bool fMatch = result.cMismatches == 0;
+
+        if (!fMatch)
+        {
+            (*pcMismatches)++;
+        }
+
+        double rSpeedup =
+            result.rPreparedMilliseconds > 0 ?
+            result.rDirectMilliseconds / result.rPreparedMilliseconds : 0;
+
+        if (pOptions->fCSV)
+        {
+            printf("%s,%u,%.3f,%.3f,%.2f,%u,%u,%u,%s\n",
+                hc.pszName,
+                cFigures,
+                result.rDirectMilliseconds,
+                result.rPreparedMilliseconds,
+                rSpeedup,
+                result.cHits,
+                result.cBorderline,
+                result.cMismatches,
+                fMatch ? "ok" : "MISMATCH"
+                );
+        }
+        else
+        {
+            printf("%-24s %7u %10.2f %10.2f %7.2fx %8u %8u %8u %s\n",
+                hc.pszName,
+                cFigures,
+                result.rDirectMilliseconds,
+                result.rPreparedMilliseconds,
+                rSpeedup,
+                result.cHits,
+                result.cBorderline,
+                result.cMismatches,
+                fMatch ? "" : "MISMATCH"
+                );
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunOperation
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunOperation(
+    BenchOperation eOperation,
+    __in_ecount(1) const CShape *pShape,
+    __in_ecount(1) const CShape *pClip,
+    __inout_ecount(1) CShape *pResult
+    )
+{
+    HRESULT hr = S_OK;
+
+    pResult->Reset();
+
+    if (eOperation == BO_OUTLINE)
+    {
+        IFC(pShape->Outline(
+            *pResult,
+            DEFAULT_FLATTENING_TOLERANCE,
+            false,      // Absolute tolerance
+            NULL,       // No transform
+            false       // Don't retrieve curves
+            ));
+    }
+    else
+    {
+        IFC(CShapeBase::Combine(
+            pShape,
+            pClip,
+            MilCombineMode::Intersect,
+            false,      // Don't retrieve curves
+            pResult
+            ));
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      TimeCase
+//
+//  Synopsis:
+//      Runs one case repeatedly with the scanner's active list index in the
+//      given state, and reports the fastest run and its result.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+TimeCase(
+    __in_ecount(1) const BenchCase *pCase,
+    __in_ecount(1) const CShape *pShape,
+    __in_ecount(1) const CShape *pClip,
+    bool fIndexed,
+    __inout_ecount(1) CShape *pOutput,
+    __out_ecount(1) BenchResult *pResult
+    )
+{
+    HRESULT hr = S_OK;
+
+    LARGE_INTEGER liFrequency;
+    double rBestSeconds = 0;
+
+    QueryPerformanceFrequency(&liFrequency);
+
+    CScanner::EnableActiveListIndex(fIndexed);
+
+    for (UINT uRun = 0; uRun < sc_cRuns; uRun++)
+    {
+        LARGE_INTEGER liStart, liEnd;
+
+        QueryPerformanceCounter(&liStart);
+        IFC(RunOperation(pCase->eOperation, pShape, pClip, pOutput));
+        QueryPerformanceCounter(&liEnd);
+
+        double rSeconds =
+            static_cast<double>(liEnd.QuadPart - liStart.QuadPart) / liFrequency.QuadPart;
+
+        if (uRun == 0 || rSeconds < rBestSeconds)
+        {
+            rBestSeconds = rSeconds;
+        }
+    }
+
+    pResult->rMilliseconds = rBestSeconds * 1000;
+    pResult->cFigures = pOutput->GetFigureCount();
+    pResult->cPoints = 0;
+
+    for (UINT i = 0; i < pResult->cFigures; i++)
+    {
+        pResult->cPoints += pOutput->GetFigureData(i).GetPointCount();
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunCases
+//
+//  Synopsis:
+//      Times each case with and without the active list index.  The index
+//      locates vertices with the same tests as the linear walk, so the two
+//      results must be identical.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunCases(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcMismatches
+    )
+{
+    HRESULT hr = S_OK;
+
+    *pcMismatches = 0;
+
+    for (UINT uCase = 0; uCase < ARRAYSIZE(sc_rgCases); uCase++)
+    {
+        const BenchCase &bc = sc_rgCases[uCase];
+
+        if (pOptions->pszFilter != NULL && strstr(bc.pszName, pOptions->pszFilter) == NULL)
+        {
+            continue;
+        }
+
+        CShape shape;
+        CShape clip;
+        CShape indexedOutput, linearOutput;
+        CMilRectF rcBounds;
+        BenchResult indexed, linear;
+        UINT cFigures = bc.cDefaultFigures * pOptions->uScale;
+
+        IFC(bc.pfnBuild(cFigures, &shape));
+
+        // Clip away a margin on every side, so the intersection has work to
+        // do on each edge.
+
+        IFC(shape.GetTightBounds(rcBounds));
+        IFC(clip.AddRectangle(
+            rcBounds.left + 10,
+            rcBounds.top + 10,
+            rcBounds.right - rcBounds.left - 20,
+            rcBounds.bottom - rcBounds.top - 20
+            ));
+
+        IFC(TimeCase(&bc, &shape, &clip, true, &indexedOutput, &indexed));
+        IFC(TimeCase(&bc, &shape, &clip, false, &linearOutput, &linear));
+
+        bool fMatch = AreShapesIdentical(indexedOutput, linearOutput);
+
+        if (!fMatch)
+        {
+            (*pcMismatches)++;
+        }
+
+        double rSpeedup =
+            indexed.rMilliseconds > 0 ? linear.rMilliseconds / indexed.rMilliseconds : 0;
+
+        if (pOptions->fCSV)
+        {
+            printf("%s,%u,%.3f,%.3f,%.2f,%u,%u,%s\n",
+                bc.pszName,
+                cFigures,
+                indexed.rMilliseconds,
+                linear.rMilliseconds,
+                rSpeedup,
+                indexed.cFigures,
+                indexed.cPoints,
+                fMatch ? "ok" : "MISMATCH"
+                );
+        }
+        else
+        {
+            printf("%-24s %7u %10.2f %10.2f %7.2fx %8u %9u %s\n",
+                bc.pszName,
+                cFigures,
+                indexed.rMilliseconds,
+                linear.rMilliseconds,
+                rSpeedup,
+                indexed.cFigures,
+                indexed.cPoints,
+                fMatch ? "" : "MISMATCH"
+                );
+        }
+    }
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ParseOptions
+//
+//------------------------------------------------------------------------------
+
+static bool
+ParseOptions(
+    int argc,
+    __in_ecount(argc) char **argv,
+    __out_ecount(1) BenchOptions *pOptions
+    )
+{
+    pOptions->pszFilter = NULL;
+    pOptions->uScale = 1;
+    pOptions->fCSV = false;
+    pOptions->eMode = BM_SCAN;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *pszArg = argv[i];
+
+        if (pszArg[0] != '-' && pszArg[0] != '/')
+        {
+            return false;
+        }
+
+        pszArg++;
+
+        if (strncmp(pszArg, "case:", 5) == 0)
+        {
+            pOptions->pszFilter = pszArg + 5;
+        }
+        else if (strncmp(pszArg, "scale:", 6) == 0)
+        {
+            pOptions->uScale = max(1U, static_cast<UINT>(strtoul(pszArg + 6, NULL, 10)));
+        }
+        else if (strcmp(pszArg, "csv") == 0)
+        {
+            pOptions->fCSV = true;
+        }
+        else if (strcmp(pszArg, "flatten") == 0)
+        {
+            pOptions->eMode = BM_FLATTEN;
+        }
+        else if (strcmp(pszArg, "widen") == 0)
+        {
+            pOptions->eMode = BM_WIDEN;
+        }
+        else if (strcmp(pszArg, "hittest") == 0)
+        {
+            pOptions->eMode = BM_HITTEST;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int __cdecl
+main(
+    int argc,
+    __in_ecount(argc) char **argv
+    )
+{
+    HRESULT hr = S_OK;
+
+    BenchOptions options;
+    UINT cMismatches = 0;
+
+    // The analytic flattener evaluates curves with AVX2 when the processor
+    // has it, as in the product.
+
+    CCPUInfo::Initialize();
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        printf("Usage: geombench [-flatten | -widen | -hittest] [-case:<name substring>] [-scale:<n>] [-csv]\n");
+        return 1;
+    }
+
+    if (options.eMode == BM_FLATTEN)
+    {
+        if (options.fCSV)
+        {
+            printf("name,curves,hfd_ms,analytic_ms,speedup,hfd_points,analytic_points,hfd_deviation,analytic_deviation,check\n");
+        }
+        else
+        {
+            printf("%-24s %7s %10s %10s %8s %9s %9s %9s %9s\n",
+                "name", "curves", "hfd", "analytic", "speedup", "hfd pts", "anl pts", "hfd dev", "anl dev");
+        }
+
+        IFC(RunFlattenCases(&options, &cMismatches));
+    }
+    else if (options.eMode == BM_WIDEN)
+    {
+        if (CParallelWorkPool::GetMaxConcurrency() < 2)
+        {
+            printf("Only one worker thread: shapes are widened serially in both modes.\n");
+        }
+
+        if (options.fCSV)
+        {
+            printf("name,figures,serial_ms,parallel_ms,speedup,result_figures,result_points,check\n");
+        }
+        else
+        {
+            printf("%-24s %7s %10s %10s %8s %8s %9s\n",
+                "name", "figures", "serial", "parallel", "speedup", "res figs", "res pts");
+        }
+
+        IFC(RunWidenCases(&options, &cMismatches));
+    }
+    else if (options.eMode == BM_HITTEST)
+    {
+        if (options.fCSV)
+        {
+            printf("name,figures,direct_ms,prepared_ms,speedup,hits,borderline,mismatches,check\n");
+        }
+        else
+        {
+            printf("%-24s %7s %10s %10s %8s %8s %8s %8s\n",
+                "name", "figures", "direct", "prepared", "speedup", "hits", "border", "mismatch");
+        }
+
+        IFC(RunHitTestCases(&options, &cMismatches));
+    }
+    else
+    {
+        if (options.fCSV)
+        {
+            printf("name,figures,indexed_ms,linear_ms,speedup,result_figures,result_points,check\n");
+        }
+        else
+        {
+            printf("%-24s %7s %10s %10s %8s %8s %9s\n",
+                "name", "figures", "indexed", "linear", "speedup", "res figs", "res pts");
+        }
+
+        IFC(RunCases(&options, &cMismatches));
+    }
+
+Cleanup:
+    if (FAILED(hr))
+    {
+        printf("geombench failed: 0x%08x\n", hr);
+        return 1;
+    }
+
+    if (cMismatches > 0)
+    {
+        switch (options.eMode)
+        {
+        case BM_FLATTEN:
+            printf("geombench: %u case(s) where analytic flattening strays further than HFD or is malformed\n", cMismatches);
+            break;
+
+        case BM_WIDEN:
+            printf("geombench: %u case(s) differ between parallel and serial widening\n", cMismatches);
+            break;
+
+        case BM_HITTEST:
+            printf("geombench: %u case(s) where prepared and direct hit testing disagree\n", cMismatches);
+            break;
+
+        default:
+            printf("geombench: %u case(s) differ between the indexed and linear active list\n", cMismatches);
+            break;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
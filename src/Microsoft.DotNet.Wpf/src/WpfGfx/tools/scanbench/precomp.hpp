@@ -0,0 +1,38 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+//  Description:
+//      Precompiled header for the scan operation benchmark.
+//
+//------------------------------------------------------------------------------
+
+#include <wpfsdl.h>
+
+#include "std.h"
+#include "d2d1.h"
+
+#include "strsafe.h"
+
+#include "common\common.h"
+
+#include "scanop\scanop.h"
+
+#include "glyph\glyph.h"
+
+#include "geometry\geometry.h"
+
+#include "api\api_include.h"
+
+#include "targets\targets.h"
+
+#include "meta\meta.h"
+
+#include "sw\sw.h"
+#include "uce\glyphalphacache.h"
+
+#include <intrin.h>
+
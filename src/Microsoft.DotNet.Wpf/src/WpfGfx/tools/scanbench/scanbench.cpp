@@ -0,0 +1,1841 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+
+//+-----------------------------------------------------------------------------
+//
+//  Description:
+//      Micro-benchmark for the software rasterizer's scan operations and
+//      color source spans.
+//
+//      Each scan operation is called directly, outside of any CScanPipeline,
+//      over synthetic scan-line buffers of varied widths and alignments. Every
+//      dispatch variant the CPU supports (C, MMX, SSE2, AVX2) is timed
+//      separately, so a regression in one kernel is visible even when the
+//      dispatcher would pick a different one on the machine being used.
+//
+//      With -realizations it instead checks the eviction order of the
+//      software bitmap realization budget (CSwRealizationManager) against
+//      a reference LRU list.
+//
+//      With -glyphs it checks glyph run assembly (CGlyphAlphaCache) against
+//      DWrite's rasterization of the whole run.
+//
+//      See README.md for usage.
+//
+//------------------------------------------------------------------------------
+
+#include "precomp.hpp"
+
+// The widest pixel format we benchmark is 128bpp.
+
+#define MAX_BENCH_PIXEL_SIZE 16
+
+// Scan widths to time. Small odd widths exercise the scalar head/tail code
+// of the vectorized kernels; the large ones measure their steady state.
+
+static const UINT sc_rguWidths[] = { 1, 3, 16, 61, 256, 1024, 4000 };
+static const UINT sc_uMaxWidth = 4000;
+
+// Byte offsets applied to every buffer, relative to a 64-byte boundary.
+
+static const UINT sc_rguMisalignments[] = { 0, 4, 12 };
+
+// Each timing is repeated and the fastest run reported, to filter out
+// interruptions.
+
+static const UINT sc_cRuns = 3;
+static const UINT sc_cMinIterations = 16;
+static const UINT sc_uDefaultTargetPixels = 1 << 24;
+
+enum BenchVariant
+{
+    BV_C,
+    BV_MMX,
+    BV_SSE2,
+    BV_AVX2,
+    BV_NUM
+};
+
+static const char * const sc_rgszVariantNames[BV_NUM] = { "c", "mmx", "sse2", "avx2" };
+
+enum BenchOpKind
+{
+    BOK_BINARY,             // Reads m_pvSrc1, writes m_pvDest
+    BOK_PTERNARY            // Blends m_pvSrc1 onto m_pvSrc2 == m_pvDest
+};
+
+// How to fill a buffer before timing it.
+
+enum BenchData
+{
+    BD_BYTES,               // Arbitrary bytes
+    BD_32BPP_PARGB,         // Valid premultiplied 32bpp pixels
+    BD_128BPP_PABGR         // Valid premultiplied float pixels
+};
+
+struct BenchScanOp
+{
+    const char *pszName;
+    BenchVariant eVariant;
+    ScanOpFunc pfnScanOp;
+    BenchOpKind eKind;
+    UINT cbDestPixel;
+    BenchData eDestData;
+    UINT cbSrcPixel;
+    BenchData eSrcData;
+};
+
+#define BENCH_OP(op, variant, kind, cbDest, dataDest, cbSrc, dataSrc) \
+    { #op, variant, op, kind, cbDest, dataDest, cbSrc, dataSrc }
+
+static const BenchScanOp sc_rgScanOps[] =
+{
+    BENCH_OP(Copy_32,                               BV_C,    BOK_BINARY,   4,  BD_BYTES,        4,  BD_BYTES),
+
+    BENCH_OP(Convert_555_32bppARGB,                 BV_C,    BOK_BINARY,   4,  BD_BYTES,        2,  BD_BYTES),
+    BENCH_OP(Convert_565_32bppARGB,                 BV_C,    BOK_BINARY,   4,  BD_BYTES,        2,  BD_BYTES),
+    BENCH_OP(Convert_24_32bppARGB,                  BV_C,    BOK_BINARY,   4,  BD_BYTES,        3,  BD_BYTES),
+    BENCH_OP(Convert_24_32bppARGB_AVX2,             BV_AVX2, BOK_BINARY,   4,  BD_BYTES,        3,  BD_BYTES),
+    BENCH_OP(Convert_24BGR_32bppARGB,               BV_C,    BOK_BINARY,   4,  BD_BYTES,        3,  BD_BYTES),
+    BENCH_OP(Convert_32RGB_32bppARGB,               BV_C,    BOK_BINARY,   4,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Convert_32RGB_32bppARGB_AVX2,          BV_AVX2, BOK_BINARY,   4,  BD_BYTES,        4,  BD_BYTES),
+
+    BENCH_OP(Quantize_32bppARGB_555,                BV_C,    BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Quantize_32bppARGB_565,                BV_C,    BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Quantize_32bppARGB_24,                 BV_C,    BOK_BINARY,   3,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Quantize_32bppARGB_24_AVX2,            BV_AVX2, BOK_BINARY,   3,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Quantize_32bppPARGB_24,                BV_C,    BOK_BINARY,   3,  BD_BYTES,        4,  BD_32BPP_PARGB),
+
+    BENCH_OP(Dither_32bppARGB_555,                  BV_C,    BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Dither_32bppARGB_555_MMX,              BV_MMX,  BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Dither_32bppARGB_565,                  BV_C,    BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(Dither_32bppARGB_565_MMX,              BV_MMX,  BOK_BINARY,   2,  BD_BYTES,        4,  BD_BYTES),
+
+    BENCH_OP(AlphaMultiply_32bppARGB,               BV_C,    BOK_BINARY,   4,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(AlphaMultiply_32bppARGB_AVX2,          BV_AVX2, BOK_BINARY,   4,  BD_BYTES,        4,  BD_BYTES),
+    BENCH_OP(AlphaDivide_32bppPARGB,                BV_C,    BOK_BINARY,   4,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(AlphaDivide_32bppPARGB_AVX2,           BV_AVX2, BOK_BINARY,   4,  BD_BYTES,        4,  BD_32BPP_PARGB),
+
+    BENCH_OP(SrcOverAL_32bppPARGB_32bppPARGB,       BV_C,    BOK_PTERNARY, 4,  BD_32BPP_PARGB,  4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_32bppPARGB_MMX,   BV_MMX,  BOK_PTERNARY, 4,  BD_32BPP_PARGB,  4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_32bppPARGB_SSE2,  BV_SSE2, BOK_PTERNARY, 4,  BD_32BPP_PARGB,  4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_32bppPARGB_AVX2,  BV_AVX2, BOK_PTERNARY, 4,  BD_32BPP_PARGB,  4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_555,              BV_C,    BOK_PTERNARY, 2,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_555_MMX,          BV_MMX,  BOK_PTERNARY, 2,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_565,              BV_C,    BOK_PTERNARY, 2,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_565_MMX,          BV_MMX,  BOK_PTERNARY, 2,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_24,               BV_C,    BOK_PTERNARY, 3,  BD_BYTES,        4,  BD_32BPP_PARGB),
+    BENCH_OP(SrcOverAL_32bppPARGB_24BGR,            BV_C,    BOK_PTERNARY, 3,  BD_BYTES,        4,  BD_32BPP_PARGB),
+
+    BENCH_OP(SrcOver_128bppPABGR_128bppPABGR,       BV_C,    BOK_PTERNARY, 16, BD_128BPP_PABGR, 16, BD_128BPP_PABGR),
+    BENCH_OP(SrcOver_128bppPABGR_128bppPABGR_SSE2,  BV_SSE2, BOK_PTERNARY, 16, BD_128BPP_PABGR, 16, BD_128BPP_PABGR),
+};
+
+// Color source spans are created at run time; see CreateSpans.
+
+struct BenchSpan
+{
+    const char *pszName;
+    BenchVariant eVariant;
+    CColorSource *pColorSource;
+};
+
+#define MAX_BENCH_SPANS 16
+
+struct BenchOptions
+{
+    const char *pszFilter;      // Substring of the operation names to run
+    int iVariant;               // Variant to run, or -1 for all
+    UINT uWidth;                // Width to run, or 0 for all
+    UINT uTargetPixels;         // Pixels per timing run
+    bool fCSV;
+    bool fRealizations;         // Check the realization budget instead
+    bool fGlyphs;               // Check glyph run assembly instead
+};
+
+struct BenchResult
+{
+    double rMegaPixelsPerSecond;
+    double rCyclesPerPixel;     // Negative if the CPU has no cycle counter
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      IsVariantSupported
+//
+//  Synopsis:
+//      Returns true if this CPU can run the given dispatch variant.
+//
+//------------------------------------------------------------------------------
+
+static bool
+IsVariantSupported(
+    BenchVariant eVariant
+    )
+{
+    switch (eVariant)
+    {
+    case BV_MMX:
+#if defined(_X86_)
+        return CCPUInfo::HasMMX();
+#else
+        // The MMX operations are inline assembly and only do work on x86.
+        return false;
+#endif
+
+    case BV_SSE2:
+        return CCPUInfo::HasSSE2();
+
+    case BV_AVX2:
+        return CCPUInfo::HasAVX2();
+
+    default:
+        return true;
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      FillBuffer
+//
+//  Synopsis:
+//      Fills a buffer with deterministic pseudo-random pixels.
+//
+//  Notes:
+//      Premultiplied data is a mix of transparent, opaque and translucent
+//      pixels, since the blend operations have fast paths for the first two.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+FillBuffer(
+    __out_bcount(cbBuffer) BYTE *pbBuffer,
+    UINT cbBuffer,
+    BenchData eData
+    )
+{
+    UINT uSeed = 0x2545f491;
+
+    switch (eData)
+    {
+    case BD_BYTES:
+        for (UINT i = 0; i < cbBuffer; i++)
+        {
+            uSeed = uSeed * 1664525 + 1013904223;
+            pbBuffer[i] = static_cast<BYTE>(uSeed >> 24);
+        }
+        break;
+
+    case BD_32BPP_PARGB:
+        {
+            ARGB *pargb = reinterpret_cast<ARGB *>(pbBuffer);
+
+            for (UINT i = 0; i < cbBuffer / sizeof(ARGB); i++)
+            {
+                uSeed = uSeed * 1664525 + 1013904223;
+
+                UINT uAlpha;
+
+                switch (uSeed >> 30)
+                {
+                case 0:  uAlpha = 0;                      break;
+                case 1:  uAlpha = 255;                    break;
+                default: uAlpha = (uSeed >> 16) & 0xff;   break;
+                }
+
+                UINT uRed = ((uSeed >> 8) & 0xff) * uAlpha / 255;
+                UINT uGreen = (uSeed & 0xff) * uAlpha / 255;
+                UINT uBlue = ((uSeed >> 4) & 0xff) * uAlpha / 255;
+
+                pargb[i] = (uAlpha << 24) | (uRed << 16) | (uGreen << 8) | uBlue;
+            }
+        }
+        break;
+
+    case BD_128BPP_PABGR:
+        {
+            MilColorF *pcol = reinterpret_cast<MilColorF *>(pbBuffer);
+
+            for (UINT i = 0; i < cbBuffer / sizeof(MilColorF); i++)
+            {
+                uSeed = uSeed * 1664525 + 1013904223;
+
+                FLOAT rAlpha;
+
+                switch (uSeed >> 30)
+                {
+                case 0:  rAlpha = 0.0f;                                  break;
+                case 1:  rAlpha = 1.0f;                                  break;
+                default: rAlpha = ((uSeed >> 16) & 0xff) / 255.0f;      break;
+                }
+
+                pcol[i].a = rAlpha;
+                pcol[i].r = ((uSeed >> 8) & 0xff) / 255.0f * rAlpha;
+                pcol[i].g = (uSeed & 0xff) / 255.0f * rAlpha;
+                pcol[i].b = ((uSeed >> 4) & 0xff) / 255.0f * rAlpha;
+            }
+        }
+        break;
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ReadCycleCounter
+//
+//------------------------------------------------------------------------------
+
+static UINT64
+ReadCycleCounter()
+{
+#if defined(_X86_) || defined(_AMD64_)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      TimeScanOp
+//
+//  Synopsis:
+//      Runs a scan operation repeatedly over the same scan, and reports its
+//      throughput.
+//
+//  Notes:
+//      The cycle count comes from the time stamp counter, which on modern
+//      CPUs ticks at the nominal frequency rather than the current core
+//      clock. Compare cycles/pixel only between runs on the same machine.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+TimeScanOp(
+    ScanOpFunc pfnScanOp,
+    __inout_ecount(1) PipelineParams *pPP,
+    __in_ecount(1) const ScanOpParams *pSOP,
+    UINT uTargetPixels,
+    __out_ecount(1) BenchResult *pResult
+    )
+{
+    UINT cIterations = max(sc_cMinIterations, uTargetPixels / pPP->m_uiCount);
+
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+
+    double rBestSeconds = 0;
+    UINT64 cBestCycles = 0;
+
+    // Warm the caches and branch predictors before timing.
+
+    pfnScanOp(pPP, pSOP);
+
+    for (UINT uRun = 0; uRun < sc_cRuns; uRun++)
+    {
+        LARGE_INTEGER liStart, liEnd;
+
+        QueryPerformanceCounter(&liStart);
+        UINT64 cStartCycles = ReadCycleCounter();
+
+        for (UINT i = 0; i < cIterations; i++)
+        {
+            // Vary the row, for the operations which dither or sample
+            // according to the scan position.
+
+            pPP->m_iY = static_cast<INT>(i & 63);
+            pfnScanOp(pPP, pSOP);
+        }
+
+        UINT64 cEndCycles = ReadCycleCounter();
+        QueryPerformanceCounter(&liEnd);
+
+        double rSeconds =
+            static_cast<double>(liEnd.QuadPart - liStart.QuadPart) / liFrequency.QuadPart;
+
+        if (uRun == 0 || rSeconds < rBestSeconds)
+        {
+            rBestSeconds = rSeconds;
+            cBestCycles = cEndCycles - cStartCycles;
+        }
+    }
+
+    double rPixels = static_cast<double>(cIterations) * pPP->m_uiCount;
+
+    pResult->rMegaPixelsPerSecond =
+        rBestSeconds > 0 ? rPixels / rBestSeconds / 1e6 : 0;
+
+#if defined(_X86_) || defined(_AMD64_)
+    pResult->rCyclesPerPixel = cBestCycles / rPixels;
+#else
+    pResult->rCyclesPerPixel = -1;
+#endif
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      PrintResult
+//
+//------------------------------------------------------------------------------
+
+static VOID
+PrintResult(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __in_ecount(1) const char *pszName,
+    BenchVariant eVariant,
+    UINT uWidth,
+    UINT uMisalignment,
+    __in_ecount(1) const BenchResult *pResult
+    )
+{
+    if (pOptions->fCSV)
+    {
+        printf("%s,%s,%u,%u,%.2f,%.3f\n",
+               pszName,
+               sc_rgszVariantNames[eVariant],
+               uWidth,
+               uMisalignment,
+               pResult->rMegaPixelsPerSecond,
+               pResult->rCyclesPerPixel
+               );
+    }
+    else if (pResult->rCyclesPerPixel < 0)
+    {
+        printf("%-44s %-5s %6u %4u %10.1f %10s\n",
+               pszName,
+               sc_rgszVariantNames[eVariant],
+               uWidth,
+               uMisalignment,
+               pResult->rMegaPixelsPerSecond,
+               "n/a"
+               );
+    }
+    else
+    {
+        printf("%-44s %-5s %6u %4u %10.1f %10.2f\n",
+               pszName,
+               sc_rgszVariantNames[eVariant],
+               uWidth,
+               uMisalignment,
+               pResult->rMegaPixelsPerSecond,
+               pResult->rCyclesPerPixel
+               );
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ShouldRun
+//
+//------------------------------------------------------------------------------
+
+static bool
+ShouldRun(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __in_ecount(1) const char *pszName,
+    BenchVariant eVariant
+    )
+{
+    if (pOptions->pszFilter != NULL && strstr(pszName, pOptions->pszFilter) == NULL)
+    {
+        return false;
+    }
+
+    if (pOptions->iVariant >= 0 && pOptions->iVariant != eVariant)
+    {
+        return false;
+    }
+
+    return IsVariantSupported(eVariant);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunScanOps
+//
+//  Synopsis:
+//      Times each scan operation at each width and misalignment.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+RunScanOps(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __inout_ecount(2) BYTE * const *rgpbBuffers
+    )
+{
+    for (UINT uOp = 0; uOp < ARRAYSIZE(sc_rgScanOps); uOp++)
+    {
+        const BenchScanOp &op = sc_rgScanOps[uOp];
+
+        if (!ShouldRun(pOptions, op.pszName, op.eVariant))
+        {
+            continue;
+        }
+
+        for (UINT uMisalign = 0; uMisalign < ARRAYSIZE(sc_rguMisalignments); uMisalign++)
+        {
+            UINT uMisalignment = sc_rguMisalignments[uMisalign];
+
+            BYTE *pbDest = rgpbBuffers[0] + uMisalignment;
+            BYTE *pbSrc = rgpbBuffers[1] + uMisalignment;
+
+            FillBuffer(pbSrc, sc_uMaxWidth * op.cbSrcPixel, op.eSrcData);
+
+            ScanOpParams sop;
+
+            sop.m_pvDest = pbDest;
+            sop.m_pvSrc1 = pbSrc;
+            sop.m_pvSrc2 = (op.eKind == BOK_PTERNARY) ? pbDest : NULL;
+            sop.m_posd = NULL;
+
+            for (UINT uWidth = 0; uWidth < ARRAYSIZE(sc_rguWidths); uWidth++)
+            {
+                if (pOptions->uWidth != 0 && pOptions->uWidth != sc_rguWidths[uWidth])
+                {
+                    continue;
+                }
+
+                // Blends modify their destination in place, so refill it
+                // for every width.
+
+                FillBuffer(pbDest, sc_uMaxWidth * op.cbDestPixel, op.eDestData);
+
+                PipelineParams pp;
+
+                pp.m_iX = 0;
+                pp.m_iY = 0;
+                pp.m_uiCount = sc_rguWidths[uWidth];
+                pp.m_fDither16bpp = TRUE;
+
+                BenchResult result;
+
+                TimeScanOp(op.pfnScanOp, &pp, &sop, pOptions->uTargetPixels, &result);
+
+                PrintResult(pOptions, op.pszName, op.eVariant, pp.m_uiCount, uMisalignment, &result);
+            }
+        }
+    }
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      CreateTexture
+//
+//  Synopsis:
+//      Creates a 256x256 PBGRA texture for the resampling spans.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+CreateTexture(
+    __deref_out_ecount(1) CSystemMemoryBitmap **ppTexture
+    )
+{
+    HRESULT hr = S_OK;
+
+    CSystemMemoryBitmap *pTexture = NULL;
+    IWGXBitmapLock *pLock = NULL;
+
+    IFC(CSystemMemoryBitmap::Create(
+        256,
+        256,
+        MilPixelFormat::PBGRA32bpp,
+        /* fClear = */ FALSE,
+        /* fIsDynamic = */ FALSE,
+        &pTexture
+        ));
+
+    IFC(pTexture->Lock(NULL, MilBitmapLock::Write, &pLock));
+
+    {
+        BYTE *pbData;
+        UINT cbData;
+
+        IFC(pLock->GetDataPointer(&cbData, &pbData));
+
+        FillBuffer(pbData, cbData, BD_32BPP_PARGB);
+    }
+
+    *ppTexture = pTexture;
+    pTexture = NULL;
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pLock);
+    ReleaseInterfaceNoNULL(pTexture);
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      CreateSpans
+//
+//  Synopsis:
+//      Creates and initializes every color source span we benchmark.
+//
+//  Notes:
+//      The glyph run painter's scan operations are not included. They need
+//      a realized glyph run, which needs the font stack.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+CreateSpans(
+    __out_ecount_part(MAX_BENCH_SPANS, *pcSpans) BenchSpan *rgSpans,
+    __out_ecount(1) UINT *pcSpans
+    )
+{
+    HRESULT hr = S_OK;
+
+    UINT cSpans = 0;
+    CSystemMemoryBitmap *pTexture = NULL;
+
+    static const MilColorF sc_rgColors[] =
+    {
+        { 1.0f, 0.0f, 0.0f, 1.0f },
+        { 0.0f, 1.0f, 0.0f, 0.5f },
+        { 0.0f, 0.0f, 1.0f, 1.0f },
+    };
+    static const FLOAT sc_rgPositions[] = { 0.0f, 0.4f, 1.0f };
+
+    static const MilPoint2F sc_rgLinearPoints[3] =
+    {
+        { 0.0f, 0.0f }, { 400.0f, 100.0f }, { -100.0f, 400.0f }
+    };
+    static const MilPoint2F sc_rgRadialPoints[3] =
+    {
+        { 200.0f, 200.0f }, { 500.0f, 200.0f }, { 200.0f, 400.0f }
+    };
+    static const MilPoint2F sc_ptFocal = { 260.0f, 240.0f };
+
+    CMatrix<CoordinateSpace::BaseSamplingHPC,CoordinateSpace::DeviceHPC> matWorldToDevice(true);
+
+    // A non-integer scale and offset keep the resampling spans off their
+    // identity fast paths.
+
+    CMatrix<CoordinateSpace::RealizationSampling,CoordinateSpace::Device> matTextureToDevice(true);
+    matTextureToDevice.Scale(1.37f, 1.37f);
+    matTextureToDevice.SetDx(0.3f);
+
+    MilColorF colBrush = { 0.2f, 0.4f, 0.6f, 0.75f };
+
+    {
+        CConstantColorBrushSpan *pSpan = new CConstantColorBrushSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CConstantColorBrushSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(&colBrush));
+    }
+
+    {
+        CLinearGradientBrushSpan *pSpan = new CLinearGradientBrushSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CLinearGradientBrushSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(
+            &matWorldToDevice,
+            sc_rgLinearPoints,
+            sc_rgColors,
+            sc_rgPositions,
+            ARRAYSIZE(sc_rgColors),
+            MilGradientWrapMode::Pad,
+            MilColorInterpolationMode::SRgbLinearInterpolation
+            ));
+    }
+
+    if (IsVariantSupported(BV_MMX))
+    {
+        CLinearGradientBrushSpan_MMX *pSpan = new CLinearGradientBrushSpan_MMX;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CLinearGradientBrushSpan";
+        rgSpans[cSpans].eVariant = BV_MMX;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(
+            &matWorldToDevice,
+            sc_rgLinearPoints,
+            sc_rgColors,
+            sc_rgPositions,
+            ARRAYSIZE(sc_rgColors),
+            MilGradientWrapMode::Pad,
+            MilColorInterpolationMode::SRgbLinearInterpolation
+            ));
+    }
+
+    {
+        CRadialGradientBrushSpan *pSpan = new CRadialGradientBrushSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CRadialGradientBrushSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(
+            &matWorldToDevice,
+            sc_rgRadialPoints,
+            sc_rgColors,
+            sc_rgPositions,
+            ARRAYSIZE(sc_rgColors),
+            MilGradientWrapMode::Reflect,
+            MilColorInterpolationMode::SRgbLinearInterpolation
+            ));
+    }
+
+    {
+        CFocalGradientBrushSpan *pSpan = new CFocalGradientBrushSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CFocalGradientBrushSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(
+            &matWorldToDevice,
+            sc_rgRadialPoints,
+            sc_rgColors,
+            sc_rgPositions,
+            ARRAYSIZE(sc_rgColors),
+            MilGradientWrapMode::Reflect,
+            MilColorInterpolationMode::SRgbLinearInterpolation,
+            &sc_ptFocal
+            ));
+    }
+
+    IFC(CreateTexture(&pTexture));
+
+    {
+        CNearestNeighborSpan *pSpan = new CNearestNeighborSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CNearestNeighborSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(pTexture, MilBitmapWrapMode::Tile, NULL, &matTextureToDevice));
+    }
+
+    {
+        CUnoptimizedBilinearSpan *pSpan = new CUnoptimizedBilinearSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CUnoptimizedBilinearSpan";
+        rgSpans[cSpans].eVariant = BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(pTexture, MilBitmapWrapMode::Tile, NULL, &matTextureToDevice));
+    }
+
+    if (IsVariantSupported(BV_MMX))
+    {
+        CBilinearSpan_MMX *pSpan = new CBilinearSpan_MMX;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CBilinearSpan_MMX";
+        rgSpans[cSpans].eVariant = BV_MMX;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(pTexture, MilBitmapWrapMode::Tile, NULL, &matTextureToDevice));
+    }
+
+    {
+        // CBilinearSpan picks its SSE2 path itself when g_fUseSSE2 is set.
+
+        CBilinearSpan *pSpan = new CBilinearSpan;
+        IFCOOM(pSpan);
+        rgSpans[cSpans].pszName = "CBilinearSpan";
+        rgSpans[cSpans].eVariant = g_fUseSSE2 ? BV_SSE2 : BV_C;
+        rgSpans[cSpans].pColorSource = pSpan;
+        cSpans++;
+
+        IFC(pSpan->Initialize(pTexture, MilBitmapWrapMode::Tile, NULL, &matTextureToDevice));
+    }
+
+    Assert(cSpans <= MAX_BENCH_SPANS);
+
+Cleanup:
+    *pcSpans = cSpans;
+    ReleaseInterfaceNoNULL(pTexture);
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunSpans
+//
+//  Synopsis:
+//      Times the scan operation of each color source span.
+//
+//------------------------------------------------------------------------------
+
+static VOID
+RunSpans(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __in_ecount(cSpans) const BenchSpan *rgSpans,
+    UINT cSpans,
+    __inout_ecount(2) BYTE * const *rgpbBuffers
+    )
+{
+    for (UINT uSpan = 0; uSpan < cSpans; uSpan++)
+    {
+        const BenchSpan &span = rgSpans[uSpan];
+
+        if (!ShouldRun(pOptions, span.pszName, span.eVariant))
+        {
+            continue;
+        }
+
+        ScanOpFunc pfnScanOp = span.pColorSource->GetScanOp();
+
+        for (UINT uMisalign = 0; uMisalign < ARRAYSIZE(sc_rguMisalignments); uMisalign++)
+        {
+            UINT uMisalignment = sc_rguMisalignments[uMisalign];
+
+            ScanOpParams sop;
+
+            sop.m_pvDest = rgpbBuffers[0] + uMisalignment;
+            sop.m_pvSrc1 = NULL;
+            sop.m_pvSrc2 = NULL;
+            sop.m_posd = span.pColorSource;
+
+            for (UINT uWidth = 0; uWidth < ARRAYSIZE(sc_rguWidths); uWidth++)
+            {
+                if (pOptions->uWidth != 0 && pOptions->uWidth != sc_rguWidths[uWidth])
+                {
+                    continue;
+                }
+
+                PipelineParams pp;
+
+                pp.m_iX = 17;
+                pp.m_iY = 0;
+                pp.m_uiCount = sc_rguWidths[uWidth];
+                pp.m_fDither16bpp = FALSE;
+
+                BenchResult result;
+
+                TimeScanOp(pfnScanOp, &pp, &sop, pOptions->uTargetPixels, &result);
+
+                PrintResult(pOptions, span.pszName, span.eVariant, pp.m_uiCount, uMisalignment, &result);
+            }
+        }
+    }
+}
+
+// The realization check uses small bitmaps and a 1MB budget.  Each bitmap
+// is realized in 128bpp float, so the budget holds exactly
+// sc_cBudgetedRealizations of them.
+
+static const UINT sc_uRealizationBitmapSize = 64;
+static const UINT sc_uRealizationBudgetMB = 1;
+static const UINT sc_cBudgetedRealizations =
+    sc_uRealizationBudgetMB * 1024 * 1024
+    / (sc_uRealizationBitmapSize * sc_uRealizationBitmapSize * 16);
+
+static const UINT sc_cRealizationBitmaps = 40;
+static const UINT sc_cRealizationFrames = 60;
+static const UINT sc_cUsesPerFrame = 8;
+
+// One frame uses more bitmaps than fit in the budget.  None of them may be
+// released until the next frame.
+
+static const UINT sc_uBurstFrame = 20;
+static const UINT sc_cBurstUses = 24;
+
+//+-----------------------------------------------------------------------------
+//
+//  Class:
+//      CReferenceLRU
+//
+//  Synopsis:
+//      The eviction policy CSwRealizationManager is meant to follow, kept
+//      as plainly as possible: a most recently used first array of bitmap
+//      indices, each stamped with the frame it was last used in.
+//
+//------------------------------------------------------------------------------
+
+class CReferenceLRU
+{
+public:
+    CReferenceLRU()
+    {
+        m_cListed = 0;
+        m_uFrame = 0;
+        m_cEvictions = 0;
+    }
+
+    void AdvanceFrame()
+    {
+        m_uFrame++;
+        EvictOverBudget();
+    }
+
+    // Returns true if the bitmap's realization was still listed
+    bool Use(UINT uBitmap)
+    {
+        bool fListed = false;
+        UINT uPosition = m_cListed;
+
+        for (UINT i = 0; i < m_cListed; i++)
+        {
+            if (m_rguListed[i] == uBitmap)
+            {
+                fListed = true;
+                uPosition = i;
+                break;
+            }
+        }
+
+        if (!fListed)
+        {
+            Assert(m_cListed < ARRAYSIZE(m_rguListed));
+            m_cListed++;
+        }
+
+        memmove(&m_rguListed[1], &m_rguListed[0], uPosition * sizeof(m_rguListed[0]));
+        m_rguListed[0] = uBitmap;
+        m_rguLastUsedFrame[uBitmap] = m_uFrame;
+
+        if (!fListed)
+        {
+            EvictOverBudget();
+        }
+
+        return fListed;
+    }
+
+    UINT GetEvictionCount() const
+    {
+        return m_cEvictions;
+    }
+
+private:
+    void EvictOverBudget()
+    {
+        while (   m_cListed > sc_cBudgetedRealizations
+               && m_rguLastUsedFrame[m_rguListed[m_cListed - 1]] != m_uFrame)
+        {
+            m_cListed--;
+            m_cEvictions++;
+        }
+    }
+
+    UINT m_rguListed[sc_cRealizationBitmaps];
+    UINT m_rguLastUsedFrame[sc_cRealizationBitmaps];
+    UINT m_cListed;
+    UINT m_uFrame;
+    UINT m_cEvictions;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetRealizationUse
+//
+//  Synopsis:
+//      Returns the bitmap used at step uUse of frame uFrame.  Most uses go
+//      to a hot set of 8 bitmaps and the rest are spread over all of them,
+//      from a fixed sequence.
+//
+//------------------------------------------------------------------------------
+
+static UINT
+GetRealizationUse(
+    UINT uFrame,
+    UINT uUse
+    )
+{
+    if (uFrame == sc_uBurstFrame)
+    {
+        return uUse;
+    }
+
+    UINT uSeed = (uFrame * sc_cUsesPerFrame + uUse + 1) * 2654435761U;
+
+    uSeed ^= uSeed >> 13;
+
+    return (uSeed & 3) != 0 ? (uSeed >> 8) % 8 : (uSeed >> 8) % sc_cRealizationBitmaps;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunRealizationCheck
+//
+//  Synopsis:
+//      Realizes bitmaps through CSwBitmapColorSource in a fixed pattern of
+//      frames, and checks every use against CReferenceLRU: a use must find
+//      its realization still there exactly when the reference list still
+//      has it.
+//
+//  Notes:
+//      A realization is reused if Realize returns the bitmap it returned
+//      last time.  We hold a reference on that bitmap, so a realization
+//      made after an eviction can't get the same address.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunRealizationCheck(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcMismatches
+    )
+{
+    HRESULT hr = S_OK;
+
+    CSystemMemoryBitmap *rgpBitmaps[sc_cRealizationBitmaps] = { NULL };
+    IWGXBitmap *rgpRealizations[sc_cRealizationBitmaps] = { NULL };
+    CColorSourceCreator_scRGB oCreator;
+    CReferenceLRU oReference;
+    UINT cUses = 0;
+    UINT cHits = 0;
+
+    *pcMismatches = 0;
+
+    IFC(CSwRealizationManager::Initialize(sc_uRealizationBudgetMB));
+
+    for (UINT i = 0; i < sc_cRealizationBitmaps; i++)
+    {
+        IFC(CSystemMemoryBitmap::Create(
+            sc_uRealizationBitmapSize,
+            sc_uRealizationBitmapSize,
+            MilPixelFormat::PBGRA32bpp,
+            /* fClear = */ TRUE,
+            /* fIsDynamic = */ FALSE,
+            &rgpBitmaps[i]
+            ));
+    }
+
+    for (UINT uFrame = 0; uFrame < sc_cRealizationFrames; uFrame++)
+    {
+        UINT cFrameUses = uFrame == sc_uBurstFrame ? sc_cBurstUses : sc_cUsesPerFrame;
+
+        if (uFrame > 0)
+        {
+            CSwRealizationManager::AdvanceFrame();
+            oReference.AdvanceFrame();
+        }
+
+        for (UINT uUse = 0; uUse < cFrameUses; uUse++)
+        {
+            UINT uBitmap = GetRealizationUse(uFrame, uUse);
+            IWGXBitmap *pRealization = NULL;
+
+            // Identity, so the realization is only a format conversion
+            CMatrix<CoordinateSpace::RealizationSampling,CoordinateSpace::Device> matBitmapToDevice(true);
+
+            IFC(CSwBitmapColorSource::DeriveFromBitmapAndContext(
+                rgpBitmaps[uBitmap],
+                &matBitmapToDevice,
+                &oCreator,
+                false,      // No prefiltering
+                0.0f,
+                NULL,       // The bitmap is its own resource cache
+                &pRealization
+                ));
+
+            bool fReused = (pRealization == rgpRealizations[uBitmap]);
+            bool fExpected = oReference.Use(uBitmap);
+
+            ReplaceInterface(rgpRealizations[uBitmap], pRealization);
+            ReleaseInterface(pRealization);
+
+            cUses++;
+
+            if (fReused)
+            {
+                cHits++;
+            }
+
+            if (fReused != fExpected)
+            {
+                (*pcMismatches)++;
+
+                if (!pOptions->fCSV)
+                {
+                    printf("frame %u, bitmap %u: realization %s, reference list %s\n",
+                        uFrame,
+                        uBitmap,
+                        fReused ? "reused" : "made again",
+                        fExpected ? "kept it" : "evicted it"
+                        );
+                }
+            }
+        }
+    }
+
+    if (pOptions->fCSV)
+    {
+        printf("uses,hits,misses,reference_evictions,mismatches\n");
+        printf("%u,%u,%u,%u,%u\n",
+            cUses, cHits, cUses - cHits, oReference.GetEvictionCount(), *pcMismatches);
+    }
+    else
+    {
+        printf("%u uses of %u bitmaps over %u frames, budget of %u realizations\n",
+            cUses, sc_cRealizationBitmaps, sc_cRealizationFrames, sc_cBudgetedRealizations);
+        printf("%u hits, %u misses, %u evictions in the reference list, %u mismatches\n",
+            cHits, cUses - cHits, oReference.GetEvictionCount(), *pcMismatches);
+    }
+
+Cleanup:
+    for (UINT i = 0; i < sc_cRealizationBitmaps; i++)
+    {
+        ReleaseInterfaceNoNULL(rgpRealizations[i]);
+        ReleaseInterfaceNoNULL(rgpBitmaps[i]);
+    }
+
+    CSwRealizationManager::DeInitialize();
+
+    RRETURN(hr);
+}
+
+// The glyph check lays out runs of capitals with 2 pixels between their
+// advance boxes, so that their ink doesn't overlap.
+
+static const WCHAR sc_szGlyphFamily[] = L"Segoe UI";
+static const WCHAR sc_szGlyphText[] = L"HOMEBUNDLE";
+static const UINT sc_cGlyphs = ARRAYSIZE(sc_szGlyphText) - 1;
+static const float sc_rgGlyphSizes[] = { 11.0f, 16.0f, 27.0f };
+
+// Glyphs repeated to check the cache keys; the run holds two glyphs at each
+// subpixel phase.
+
+static const UINT sc_cRepeatedGlyphs = 2 * CGlyphAlphaCache::c_subpixelPhases;
+
+// Assembly rounds each glyph's texture to 8 bits before adding them up, so
+// it may differ from DWrite by one level per glyph sharing a pixel.
+
+static const UINT sc_uGlyphTolerance = 2;
+
+struct BenchGlyphRun
+{
+    UINT16 rgIndices[sc_cRepeatedGlyphs + sc_cGlyphs];
+    float rgAdvances[sc_cRepeatedGlyphs + sc_cGlyphs];
+    DWRITE_GLYPH_RUN run;
+};
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      CreateGlyphFont
+//
+//  Synopsis:
+//      Creates a DWrite factory and the regular face of sc_szGlyphFamily.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+CreateGlyphFont(
+    __deref_out_ecount(1) IDWriteFactory **ppFactory,
+    __deref_out_ecount(1) IDWriteFont **ppFont,
+    __deref_out_ecount(1) IDWriteFontFace **ppFontFace
+    )
+{
+    HRESULT hr = S_OK;
+
+    IUnknown *pIUnknown = NULL;
+    IDWriteFontCollection *pCollection = NULL;
+    IDWriteFontFamily *pFamily = NULL;
+    UINT32 uFamily;
+    BOOL fExists;
+
+    IFC(g_DWriteLoader.Startup());
+
+    IFC(g_DWriteLoader.DWriteCreateFactory(
+        DWRITE_FACTORY_TYPE_SHARED,
+        __uuidof(IDWriteFactory),
+        &pIUnknown
+        ));
+
+    IFC(pIUnknown->QueryInterface(
+        __uuidof(IDWriteFactory),
+        reinterpret_cast<void**>(ppFactory)
+        ));
+
+    IFC((*ppFactory)->GetSystemFontCollection(&pCollection, FALSE));
+    IFC(pCollection->FindFamilyName(sc_szGlyphFamily, &uFamily, &fExists));
+
+    if (!fExists)
+    {
+        printf("The %S font is not installed\n", sc_szGlyphFamily);
+        IFC(E_FAIL);
+    }
+
+    IFC(pCollection->GetFontFamily(uFamily, &pFamily));
+    IFC(pFamily->GetFirstMatchingFont(
+        DWRITE_FONT_WEIGHT_NORMAL,
+        DWRITE_FONT_STRETCH_NORMAL,
+        DWRITE_FONT_STYLE_NORMAL,
+        ppFont
+        ));
+    IFC((*ppFont)->CreateFontFace(ppFontFace));
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pIUnknown);
+    ReleaseInterfaceNoNULL(pCollection);
+    ReleaseInterfaceNoNULL(pFamily);
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      BuildGlyphRun
+//
+//  Synopsis:
+//      Lays out the glyphs of pszText at emSize with 2 pixels between their
+//      advance boxes.  With fPhased, the glyphs are also moved a quarter
+//      pixel further each, so that they land on every subpixel phase.
+//
+//      The positions are multiples of a quarter pixel, so the cache's
+//      snapping to phases doesn't move them and its result is comparable
+//      with DWrite's rendering of the run.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+BuildGlyphRun(
+    __in_ecount(1) IDWriteFontFace *pFontFace,
+    float emSize,
+    __in PCWSTR pszText,
+    UINT cGlyphs,
+    bool fPhased,
+    __out_ecount(1) BenchGlyphRun *pRun
+    )
+{
+    HRESULT hr = S_OK;
+
+    UINT32 rguCodePoints[ARRAYSIZE(pRun->rgIndices)];
+    DWRITE_GLYPH_METRICS rgMetrics[ARRAYSIZE(pRun->rgIndices)];
+    DWRITE_FONT_METRICS fontMetrics;
+
+    Assert(cGlyphs <= ARRAYSIZE(pRun->rgIndices));
+
+    for (UINT i = 0; i < cGlyphs; i++)
+    {
+        rguCodePoints[i] = pszText[i];
+    }
+
+    pFontFace->GetMetrics(&fontMetrics);
+
+    IFC(pFontFace->GetGlyphIndices(rguCodePoints, cGlyphs, pRun->rgIndices));
+    IFC(pFontFace->GetDesignGlyphMetrics(pRun->rgIndices, cGlyphs, rgMetrics, FALSE));
+
+    for (UINT i = 0; i < cGlyphs; i++)
+    {
+        float rAdvance = rgMetrics[i].advanceWidth * emSize / fontMetrics.designUnitsPerEm;
+
+        pRun->rgAdvances[i] = ceilf(rAdvance) + 2.0f;
+
+        if (fPhased)
+        {
+            pRun->rgAdvances[i] += 1.0f / CGlyphAlphaCache::c_subpixelPhases;
+        }
+    }
+
+    pRun->run.fontFace = pFontFace;
+    pRun->run.fontEmSize = emSize;
+    pRun->run.glyphCount = cGlyphs;
+    pRun->run.glyphIndices = pRun->rgIndices;
+    pRun->run.glyphAdvances = pRun->rgAdvances;
+    pRun->run.glyphOffsets = NULL;
+    pRun->run.isSideways = FALSE;
+    pRun->run.bidiLevel = 0;
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RasterizeWholeRun
+//
+//  Synopsis:
+//      Rasterizes the run with a single DWrite analysis, as
+//      CGlyphRunResource does when the run is not assembled.  The texture
+//      is ClearType, 3 bytes per pixel; *prc is in pixels.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RasterizeWholeRun(
+    __in_ecount(1) IDWriteFactory *pFactory,
+    __in_ecount(1) const DWRITE_GLYPH_RUN *pRun,
+    __out_ecount(1) RECT *prc,
+    __deref_out_ecount_opt(1) BYTE **ppTexture
+    )
+{
+    HRESULT hr = S_OK;
+
+    IDWriteGlyphRunAnalysis *pAnalysis = NULL;
+    DWRITE_MATRIX transform = { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    UINT32 cbTexture;
+
+    *ppTexture = NULL;
+
+    IFC(pFactory->CreateGlyphRunAnalysis(
+        pRun,
+        1,                                  // pixelsPerDip
+        &transform,
+        DWRITE_RENDERING_MODE_CLEARTYPE_NATURAL,
+        DWRITE_MEASURING_MODE_NATURAL,
+        0.0f,
+        0.0f,
+        &pAnalysis
+        ));
+
+    IFC(pAnalysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, prc));
+
+    if (IsRectEmpty(prc))
+    {
+        memset(prc, 0, sizeof(*prc));
+        goto Cleanup;
+    }
+
+    cbTexture = (prc->right - prc->left) * 3 * (prc->bottom - prc->top);
+
+    *ppTexture = new BYTE[cbTexture];
+    IFCOOM(*ppTexture);
+
+    IFC(pAnalysis->CreateAlphaTexture(DWRITE_TEXTURE_CLEARTYPE_3x1, prc, *ppTexture, cbTexture));
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pAnalysis);
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetTextureValue
+//
+//  Synopsis:
+//      Returns channel c of pixel (x, y) of a 3 byte per pixel texture
+//      covering rc, or 0 outside it.
+//
+//------------------------------------------------------------------------------
+
+static BYTE
+GetTextureValue(
+    __in_ecount_opt(1) const BYTE *pTexture,
+    __in_ecount(1) const RECT &rc,
+    INT x,
+    INT y,
+    UINT c
+    )
+{
+    if (!pTexture || x < rc.left || x >= rc.right || y < rc.top || y >= rc.bottom)
+    {
+        return 0;
+    }
+
+    return pTexture[((y - rc.top) * (rc.right - rc.left) + (x - rc.left)) * 3 + c];
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      GetMaxTextureDifference
+//
+//  Synopsis:
+//      Returns the largest difference between two ClearType textures over
+//      the union of their bounds.
+//
+//------------------------------------------------------------------------------
+
+static UINT
+GetMaxTextureDifference(
+    __in_ecount_opt(1) const BYTE *pTexture1,
+    __in_ecount(1) const RECT &rc1,
+    __in_ecount_opt(1) const BYTE *pTexture2,
+    __in_ecount(1) const RECT &rc2
+    )
+{
+    UINT uMaxDifference = 0;
+    RECT rcUnion;
+
+    UnionRect(&rcUnion, &rc1, &rc2);
+
+    for (INT y = rcUnion.top; y < rcUnion.bottom; y++)
+    {
+        for (INT x = rcUnion.left; x < rcUnion.right; x++)
+        {
+            for (UINT c = 0; c < 3; c++)
+            {
+                INT iDifference =
+                    GetTextureValue(pTexture1, rc1, x, y, c) - GetTextureValue(pTexture2, rc2, x, y, c);
+
+                uMaxDifference = max(uMaxDifference, static_cast<UINT>(abs(iDifference)));
+            }
+        }
+    }
+
+    return uMaxDifference;
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      AssembleRun
+//
+//  Synopsis:
+//      Has the cache assemble the run synchronously.  *prc is in pixels;
+//      the cache reports the bounds in subpixels.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+AssembleRun(
+    __inout_ecount(1) CGlyphAlphaCache *pCache,
+    __in_ecount(1) IDWriteFactory *pFactory,
+    __in_ecount(1) IDWriteFont *pFont,
+    __in_ecount(1) const DWRITE_GLYPH_RUN *pRun,
+    __out_ecount(1) bool *pfOverlapping,
+    __out_ecount(1) RECT *prc,
+    __deref_out_ecount_opt(1) BYTE **ppAlphaMap
+    )
+{
+    HRESULT hr = S_OK;
+
+    bool fPending;
+    bool fIsBiLevelOnly;
+    UINT32 cbAlphaMap;
+
+    IFC(pCache->RealizeRunAlphaMap(
+        pCache,                             // Requester
+        pFactory,
+        pFont,
+        pRun,
+        pRun->fontEmSize,                   // One pixel per DIP
+        pRun->fontEmSize,
+        DWRITE_RENDERING_MODE_CLEARTYPE_NATURAL,
+        DWRITE_MEASURING_MODE_NATURAL,
+        NULL,                               // No contrast enhancement
+        false,                              // Synchronous
+        &fPending,
+        pfOverlapping,
+        ppAlphaMap,
+        &cbAlphaMap,
+        prc,
+        &fIsBiLevelOnly
+        ));
+
+    Assert(!fPending);
+
+    prc->left /= 3;
+    prc->right /= 3;
+
+Cleanup:
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      CheckGlyphSize
+//
+//  Synopsis:
+//      Runs the glyph checks at one size with a new cache, and returns the
+//      number that failed:
+//
+//      1. The assembled map of a run with glyphs at every phase is within
+//         sc_uGlyphTolerance of DWrite's rendering of the whole run.
+//      2. Assembling the run again only hits the cache and gives the same
+//         map.
+//      3. A glyph repeated at every phase is rasterized once per phase:
+//         a run with two of it at each phase misses once per phase, and
+//         the same glyph at whole pixel positions then only hits.
+//      4. A run with the same glyph twice at one position is reported
+//         overlapping, without a map.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+CheckGlyphSize(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __in_ecount(1) IDWriteFactory *pFactory,
+    __in_ecount(1) IDWriteFont *pFont,
+    __in_ecount(1) IDWriteFontFace *pFontFace,
+    float emSize,
+    __out_ecount(1) UINT *pcFailures
+    )
+{
+    HRESULT hr = S_OK;
+
+    CGlyphAlphaCache *pCache = NULL;
+    BenchGlyphRun run;
+    WCHAR rgchRepeated[sc_cRepeatedGlyphs];
+    BYTE *pWholeRun = NULL;
+    BYTE *pAssembled = NULL;
+    BYTE *pAssembledAgain = NULL;
+    BYTE *pOverlapped = NULL;
+    RECT rcWholeRun, rcAssembled, rcAssembledAgain, rcOverlapped;
+    bool fOverlapping;
+    UINT uDifference;
+    UINT cMisses, cHits;
+    bool rgfPassed[4];
+
+    *pcFailures = 0;
+
+    pCache = new CGlyphAlphaCache;
+    IFCOOM(pCache);
+
+    // 1. Assembly against the whole run
+
+    IFC(BuildGlyphRun(pFontFace, emSize, sc_szGlyphText, sc_cGlyphs, true, &run));
+    IFC(RasterizeWholeRun(pFactory, &run.run, &rcWholeRun, &pWholeRun));
+    IFC(AssembleRun(pCache, pFactory, pFont, &run.run, &fOverlapping, &rcAssembled, &pAssembled));
+
+    uDifference = GetMaxTextureDifference(pWholeRun, rcWholeRun, pAssembled, rcAssembled);
+    rgfPassed[0] = !fOverlapping && pAssembled != NULL && uDifference <= sc_uGlyphTolerance;
+
+    // 2. Assembly from the cache
+
+    cMisses = pCache->GetMissCount();
+
+    IFC(AssembleRun(pCache, pFactory, pFont, &run.run, &fOverlapping, &rcAssembledAgain, &pAssembledAgain));
+
+    rgfPassed[1] =
+           !fOverlapping
+        && pCache->GetMissCount() == cMisses
+        && pAssembledAgain != NULL
+        && GetMaxTextureDifference(pAssembled, rcAssembled, pAssembledAgain, rcAssembledAgain) == 0;
+
+    // 3. One rasterization per phase
+
+    for (UINT i = 0; i < ARRAYSIZE(rgchRepeated); i++)
+    {
+        rgchRepeated[i] = sc_szGlyphText[0];
+    }
+
+    cMisses = pCache->GetMissCount();
+    cHits = pCache->GetHitCount();
+
+    IFC(BuildGlyphRun(pFontFace, emSize, rgchRepeated, ARRAYSIZE(rgchRepeated), true, &run));
+
+    WPFFree(ProcessHeap, pAssembledAgain);
+    pAssembledAgain = NULL;
+    IFC(AssembleRun(pCache, pFactory, pFont, &run.run, &fOverlapping, &rcAssembledAgain, &pAssembledAgain));
+
+    // The text's first glyph is already cached at phase 0
+    rgfPassed[2] =
+           pCache->GetMissCount() - cMisses == CGlyphAlphaCache::c_subpixelPhases - 1
+        && pCache->GetHitCount() - cHits == sc_cRepeatedGlyphs - (CGlyphAlphaCache::c_subpixelPhases - 1);
+
+    cMisses = pCache->GetMissCount();
+    cHits = pCache->GetHitCount();
+
+    IFC(BuildGlyphRun(pFontFace, emSize, rgchRepeated, ARRAYSIZE(rgchRepeated), false, &run));
+
+    WPFFree(ProcessHeap, pAssembledAgain);
+    pAssembledAgain = NULL;
+    IFC(AssembleRun(pCache, pFactory, pFont, &run.run, &fOverlapping, &rcAssembledAgain, &pAssembledAgain));
+
+    rgfPassed[2] =
+           rgfPassed[2]
+        && pCache->GetMissCount() == cMisses
+        && pCache->GetHitCount() - cHits == sc_cRepeatedGlyphs;
+
+    // 4. Overlap
+
+    IFC(BuildGlyphRun(pFontFace, emSize, rgchRepeated, 2, false, &run));
+    run.rgAdvances[0] = 0.0f;
+
+    IFC(AssembleRun(pCache, pFactory, pFont, &run.run, &fOverlapping, &rcOverlapped, &pOverlapped));
+
+    rgfPassed[3] = fOverlapping && pOverlapped == NULL;
+
+    for (UINT i = 0; i < ARRAYSIZE(rgfPassed); i++)
+    {
+        if (!rgfPassed[i])
+        {
+            (*pcFailures)++;
+        }
+    }
+
+    if (pOptions->fCSV)
+    {
+        printf("%.0f,%u,%s,%s,%s,%s\n",
+            emSize,
+            uDifference,
+            rgfPassed[0] ? "ok" : "FAILED",
+            rgfPassed[1] ? "ok" : "FAILED",
+            rgfPassed[2] ? "ok" : "FAILED",
+            rgfPassed[3] ? "ok" : "FAILED"
+            );
+    }
+    else
+    {
+        printf("%4.0f %10u %-8s %-8s %-8s %-8s\n",
+            emSize,
+            uDifference,
+            rgfPassed[0] ? "ok" : "FAILED",
+            rgfPassed[1] ? "ok" : "FAILED",
+            rgfPassed[2] ? "ok" : "FAILED",
+            rgfPassed[3] ? "ok" : "FAILED"
+            );
+    }
+
+Cleanup:
+    delete [] pWholeRun;
+    WPFFree(ProcessHeap, pAssembled);
+    WPFFree(ProcessHeap, pAssembledAgain);
+    WPFFree(ProcessHeap, pOverlapped);
+    delete pCache;
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      RunGlyphCheck
+//
+//  Synopsis:
+//      Runs the glyph checks at every size in sc_rgGlyphSizes.
+//
+//------------------------------------------------------------------------------
+
+static HRESULT
+RunGlyphCheck(
+    __in_ecount(1) const BenchOptions *pOptions,
+    __out_ecount(1) UINT *pcFailures
+    )
+{
+    HRESULT hr = S_OK;
+
+    IDWriteFactory *pFactory = NULL;
+    IDWriteFont *pFont = NULL;
+    IDWriteFontFace *pFontFace = NULL;
+
+    *pcFailures = 0;
+
+    IFC(CreateGlyphFont(&pFactory, &pFont, &pFontFace));
+
+    if (pOptions->fCSV)
+    {
+        printf("size,max_difference,whole_run,cache_reuse,phases,overlap\n");
+    }
+    else
+    {
+        printf("%4s %10s %-8s %-8s %-8s %-8s\n", "size", "max diff", "run", "reuse", "phases", "overlap");
+    }
+
+    for (UINT i = 0; i < ARRAYSIZE(sc_rgGlyphSizes); i++)
+    {
+        UINT cFailures;
+
+        IFC(CheckGlyphSize(pOptions, pFactory, pFont, pFontFace, sc_rgGlyphSizes[i], &cFailures));
+
+        *pcFailures += cFailures;
+    }
+
+Cleanup:
+    ReleaseInterfaceNoNULL(pFontFace);
+    ReleaseInterfaceNoNULL(pFont);
+    ReleaseInterfaceNoNULL(pFactory);
+
+    RRETURN(hr);
+}
+
+//+-----------------------------------------------------------------------------
+//
+//  Function:
+//      ParseOptions
+//
+//------------------------------------------------------------------------------
+
+static bool
+ParseOptions(
+    int argc,
+    __in_ecount(argc) char **argv,
+    __out_ecount(1) BenchOptions *pOptions
+    )
+{
+    pOptions->pszFilter = NULL;
+    pOptions->iVariant = -1;
+    pOptions->uWidth = 0;
+    pOptions->uTargetPixels = sc_uDefaultTargetPixels;
+    pOptions->fCSV = false;
+    pOptions->fRealizations = false;
+    pOptions->fGlyphs = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *pszArg = argv[i];
+
+        if (pszArg[0] != '-' && pszArg[0] != '/')
+        {
+            return false;
+        }
+
+        pszArg++;
+
+        if (strncmp(pszArg, "op:", 3) == 0)
+        {
+            pOptions->pszFilter = pszArg + 3;
+        }
+        else if (strncmp(pszArg, "variant:", 8) == 0)
+        {
+            for (int iVariant = 0; iVariant < BV_NUM; iVariant++)
+            {
+                if (_stricmp(pszArg + 8, sc_rgszVariantNames[iVariant]) == 0)
+                {
+                    pOptions->iVariant = iVariant;
+                }
+            }
+
+            if (pOptions->iVariant < 0)
+            {
+                return false;
+            }
+        }
+        else if (strncmp(pszArg, "width:", 6) == 0)
+        {
+            pOptions->uWidth = strtoul(pszArg + 6, NULL, 10);
+        }
+        else if (strncmp(pszArg, "pixels:", 7) == 0)
+        {
+            pOptions->uTargetPixels = max(1U, static_cast<UINT>(strtoul(pszArg + 7, NULL, 10)));
+        }
+        else if (strcmp(pszArg, "csv") == 0)
+        {
+            pOptions->fCSV = true;
+        }
+        else if (strcmp(pszArg, "realizations") == 0)
+        {
+            pOptions->fRealizations = true;
+        }
+        else if (strcmp(pszArg, "glyphs") == 0)
+        {
+            pOptions->fGlyphs = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int __cdecl
+main(
+    int argc,
+    __in_ecount(argc) char **argv
+    )
+{
+    HRESULT hr = S_OK;
+
+    BenchOptions options;
+    BenchSpan rgSpans[MAX_BENCH_SPANS];
+    UINT cSpans = 0;
+    BYTE *rgpbBuffers[2] = { NULL, NULL };
+    UINT cMismatches = 0;
+    UINT cGlyphFailures = 0;
+
+    if (!ParseOptions(argc, argv, &options))
+    {
+        printf("Usage: scanbench [-op:<name substring>] [-variant:c|mmx|sse2|avx2]\n"
+               "                 [-width:<pixels>] [-pixels:<pixels per run>] [-csv]\n"
+               "       scanbench -realizations [-csv]\n"
+               "       scanbench -glyphs [-csv]\n");
+        return 1;
+    }
+
+    // Set up only the CPU feature globals the kernels dispatch on. We don't
+    // call SwStartup, so registry switches which disable MMX or SSE2 for
+    // the product don't affect the benchmark.
+
+    CCPUInfo::Initialize();
+    g_fUseMMX = CCPUInfo::HasMMX();
+    g_fUseSSE2 = CCPUInfo::HasSSE2();
+
+    if (options.fRealizations)
+    {
+        IFC(RunRealizationCheck(&options, &cMismatches));
+        goto Cleanup;
+    }
+
+    if (options.fGlyphs)
+    {
+        IFC(RunGlyphCheck(&options, &cGlyphFailures));
+        goto Cleanup;
+    }
+
+    for (UINT i = 0; i < ARRAYSIZE(rgpbBuffers); i++)
+    {
+        rgpbBuffers[i] = static_cast<BYTE *>(_aligned_malloc(
+            sc_uMaxWidth * MAX_BENCH_PIXEL_SIZE + 64,
+            64
+            ));
+        IFCOOM(rgpbBuffers[i]);
+    }
+
+    IFC(CreateSpans(rgSpans, &cSpans));
+
+    if (options.fCSV)
+    {
+        printf("name,variant,width,misalignment,mpixels_per_second,cycles_per_pixel\n");
+    }
+    else
+    {
+        printf("CPU features: 0x%02x\n\n", CCPUInfo::GetFeatureMask());
+        printf("%-44s %-5s %6s %4s %10s %10s\n", "name", "var", "width", "mis", "Mpix/s", "cyc/pix");
+    }
+
+    RunScanOps(&options, rgpbBuffers);
+    RunSpans(&options, rgSpans, cSpans, rgpbBuffers);
+
+Cleanup:
+    for (UINT i = 0; i < cSpans; i++)
+    {
+        delete rgSpans[i].pColorSource;
+    }
+
+    for (UINT i = 0; i < ARRAYSIZE(rgpbBuffers); i++)
+    {
+        _aligned_free(rgpbBuffers[i]);
+    }
+
+    if (FAILED(hr))
+    {
+        printf("scanbench failed: 0x%08x\n", hr);
+        return 1;
+    }
+
+    if (cMismatches > 0)
+    {
+        printf("scanbench: %u realization use(s) differ from the reference LRU list\n", cMismatches);
+        return 1;
+    }
+
+    if (cGlyphFailures > 0)
+    {
+        printf("scanbench: %u glyph check(s) failed\n", cGlyphFailures);
+        return 1;
+    }
+
+    return 0;
+}
+